@@ -2,7 +2,7 @@
 ************************************************************************
     SPATCON.C   spatial convolution routines.
     Kurt Riitters
-	Version 1.3.4 April 2026
+	Version 1.4.0 October 2026
 ************************************************************************ 
 DISCLAIMER:
 The author(s), their employer(s), the archive host(s), nor any part of the United States federal government
@@ -13,6 +13,10 @@ software or related materials.
 
 compile flags 
  * gcc -std=c99 -m64 -O2 -Wall -fopenmp spatcon.c -o spatcon -lm
+ with GeoTIFF input and output (libtiff 4 and zlib):
+ * gcc -std=c99 -m64 -O2 -Wall -fopenmp -DSPATCON_GEOTIFF spatcon.c -o spatcon -lm -ltiff -lz
+ as a shared library for IDL (CALL_EXTERNAL) and C callers, see Spatcon_Run and Spatcon_IDL:
+ * gcc -std=c99 -m64 -O2 -Wall -fopenmp -DSPATCON_LIBRARY -shared -fPIC spatcon.c -o libspatcon_lin64.so -lm
 
 ***************************************************************************
 
@@ -38,6 +42,12 @@ Classic Mode: spatcon <infile> <outfile> <parameterfile>
         Required: A text file (any name) which contains the run parameters
         Optional: If re-coding is requested, a text file "<arg1>.rec" which contains a re-coding lookup table
     Output. The program writes the output file "<arg2>.bsq" into the current directory.
+        With several window sizes or mapping rules (w or r lines) the bands follow one another in the output file.
+    GeoTIFFs (when compiled with SPATCON_GEOTIFF): an arg 1 or arg 2 ending in .tif or .tiff is used as it is.
+        The input GeoTIFF must have a single 8-bit band, in strips or tiles, and needs no .siz file; the
+        re-coding table is then "<arg1 without .tif>.rec". The output GeoTIFF is tiled and compressed
+        (parameter c), with one band for each window size and mapping rule, and has the georeferencing of
+        an input GeoTIFF. Memory-mapped I/O (parameter i) is not used for GeoTIFFs.
     Note: all filenames have a 500 character limit.
 
 Guidos Mode: spatcon
@@ -50,6 +60,12 @@ Guidos Mode: spatcon
         Optional: If recoding is requested, a text file "screcode.txt" a re-coding lookup table
     Output. The program writes the output file "scoutput" into the current directory
 
+Library: compiled with SPATCON_LIBRARY there is no program, Spatcon_Run (C) and Spatcon_IDL (IDL's
+    CALL_EXTERNAL) take the input map and the parameters in memory and fill the caller's output array.
+    The library is NOT thread-safe: its state is global, one run at a time. Calls from several threads
+    are serialized (each waits for the one before it), not run in parallel. An error returns its exit
+    code, after the message, and frees what the run allocated.
+
 ***************************************************************************
 
 	Parameter file format.
@@ -57,7 +73,14 @@ Guidos Mode: spatcon
     Use as many lines as needed, in any order; parameters that are not used are ignored.
         Required:
             r or R = mapping rule. Value must be one of these: 1,6,7,10,20,21,51,52,53,54,71,72,73,74,75,76,77,78,81,82,83
+                     Up to 16 r lines can be given, e.g. r 81, r 77, r 76, r 7. The output has one band for each rule,
+                     in the order of the r lines, and the rules share the other parameters (a, b, h, m, z). Rules that
+                     count the same thing are finished from the same frequency distns in one pass over the map.
             w or W = window size (number of pixels). The window will be a square with side length w. Must be an odd number (3,5,7...). minimum 3. No Maximum.
+                     Up to 16 w lines can be given, e.g. w 7, w 13, w 27, w 81, w 243 for a FAD series. The input is read
+                     once and the output has one band for each window size, in the order of the w lines
+                     (band-sequential, nrows x ncols for each band). With several rules too, the bands of all
+                     rules for the first window size come first, then those for the second, etc.
         Conditional:
             a or A = Some mapping rules require a "first target code". Default = 0.
             b or B = Some mapping rules require a "second target code". Default = 0.
@@ -66,6 +89,62 @@ Guidos Mode: spatcon
             z or Z = Request re-code of input data. 0 = No (default). 1 = Yes
             h or H = How are missing values handled. 1 = Ignore (default). 2 = Include in calculations.
             f or F = Output precision. 0 = 8-bit (default). 1 = 32-bit. Note 32-bit is not available for mapping rules 1, 6, 7, 10, 20, 21, 82
+            i or I = Input/output method. 0 = read and write the whole map with standard file I/O (default).
+                     1 = memory-mapped. The input file is mapped read-only and the output file is mapped and
+                     written in place. Not available on MS-Windows, where standard file I/O is used instead.
+            s or S = Streaming. 0 = the whole map is held in memory (default). N > 0 = the map is streamed through
+                     the convolution N rows at a time, holding only w + N rows of the map in memory. Use N of at
+                     least the number of threads. The output is the same either way. Except on Windows the next
+                     N rows are read and the last N output rows written by threads of their own while a band is
+                     convolved, which takes another N rows of input and of output; the log gives the time spent
+                     reading, writing and convolving, and how long the convolution waited for the disk.
+            e or E = Convolution engine. 0 = sliding window (default). 1 = column histograms for the rules that
+                     count pixels (1,6,7,10,20,21,5x,8x): the time per pixel depends on the number of pixel values
+                     instead of the window size, so it pays off for large windows on maps with few pixel values.
+                     2 = summed-area tables for rules 75-78 and 81-83: the counts of code_1, code_2 and missing in
+                     a window, or of the adjacencies between them, are read from tables of 4-byte running totals,
+                     at the same cost for any window size. The tables take 12 bytes per pixel of the map (or of
+                     the band when streaming) for rules 8x, and 32 bytes per pixel for rules 75-78.
+                     3 = sliding window with metric accumulators for rules 1, 20, 54 and 74, and for rules 51-53
+                     and 71-73 with 32-bit output (f 1): the sums of squares
+                     and of c*ln(c), the number of colors or edge types and the largest count are kept up to
+                     date as the window slides, so the metric no longer rescans every color or adjacency.
+                     For the majority (rule 1) each count has a bit for every color with that count, and the
+                     majority is the lowest color with the largest count, the same one as e 0 finds; used
+                     when the map has at least 12 pixel values for each row of the window (e.g. w 15 for 200).
+                     For the median (rule 20) a pointer to the median and the count below it follow the window,
+                     so the median moves by a few values instead of being found again; used up to w 21.
+                     4 = bit planes for maps with up to 3 pixel values besides missing, e.g. MSPA-compliant
+                     0/1/2 maps, and for rules 75-78 and 81-83 on any map: each pixel value of a row is a
+                     bit mask, 64 pixels to a word, and moving the window down only visits the pixels that
+                     change, so large patches cost little and the time per pixel does not depend on the
+                     window size. Takes half a byte per pixel of the map (or of the band when streaming).
+                     Other rules use the sliding window. The output is the same for engines 0, 1, 2 and 4. With
+                     e 3 the 8-bit output is also the same; rules 51-53 and 71-73 only use the accumulators
+                     for 32-bit output (f 1), where the sums are exact instead of accumulated in single
+                     precision, so their values differ from e 0 in the last digits.
+            t or T = Column strips. 0 = each thread convolves whole rows (default). N > 0 = the window placements
+                     are split into strips N output columns wide, and each thread convolves a strip from top to
+                     bottom, so the rows under the window stay in cache from one output row to the next. Each row
+                     of a strip seeds its first window again, about w / (2N) more work, so N should be large
+                     compared to w. Whether strips are faster depends on the caches and the number of threads;
+                     it has only been timed on one core. Used by engines 0 and 3.
+            o or O = OpenMP schedule of the rows or strips over the threads. 0 = static for rows and dynamic for
+                     strips (default). 1 = static. 2 = dynamic. 3 = guided.
+            k or K = Memory budget in megabytes. 0 = none (default). N > 0 = the whole map is held in memory if it
+                     fits in about N MB, else it is streamed (parameter s) with the largest band that fits, and
+                     if not even a band of rows fits, in column tiles with a half-window of overlap on each
+                     side, which are written into place in the output file. An s line sets the band height
+                     and leaves only the tile width to k. The output is the same either way.
+            c or C = Compression of an output GeoTIFF. 0 = DEFLATE (default), the tiles are compressed in parallel.
+                     1 = ZSTD, compressed by libtiff one tile at a time. 2 = none.
+            g or G = Grain, the step between window placements. 1 = a window at every pixel (default). N > 1 = a
+                     window at every N-th row and column only, starting with the first, for a quick coarse
+                     result: the output has (nrows + N - 1) / N rows and (ncols + N - 1) / N columns, and its
+                     pixel at row R, column C is the one at row R*N, column C*N of the g 1 output. An output
+                     GeoTIFF gets a pixel size N times that of the input, centered on the same pixels. Used
+                     by engines 0, 2 and 3 (1 and 4 fall back to the sliding window), not when streaming:
+                     s and k are ignored and the whole map is held in memory.
        Example:
                 r 81
                 a 3
@@ -228,11 +307,125 @@ Version and changes
 		and used machine dependent EPSILON from there, as a global variable, to make comaprisons. For example instead of if(p_for == 1,0), 
 		the expressions are now if(fabs(p_for - 1.0) < EPSILON).  Because this same issue potentially affects similar
 		comparisons of floats to either 0.0 or 1.0, made similar changes elsewhere. 21 total changes all labeled as 1.3.4.
-		
-		
+
+1.4.0 October 2026
+		Performance and memory work for national and continental scale maps. Output values are unchanged
+		unless noted otherwise. All changes are labeled as 1.4.0.
+		1. New parameter 'i' for memory-mapped I/O. The input bsq is mapped read-only instead of being read
+		into a calloc'd copy, and the output bsq is pre-sized and mapped so Freq_Conv writes into it directly.
+		The page cache replaces the explicit fread and fwrite copies. An error before the output is complete
+		removes the output bsq (Remove_Output) rather than leaving a full-size file of zeros.
+		2. New parameter 's' for streaming: bands of rows are read into a ring of w + s buffered rows, convolved
+		in parallel and written out, so memory no longer grows with the number of rows. The row loop of
+		Freq_Conv was moved to new subroutine Conv_Row, which works from row pointers and is shared by both.
+		3. The buffered copy of the input (mat_temp) is gone. Conv_Row reads the input rows directly and
+		treats pixels outside the map as missing; windows inside the map take a fast path without bounds
+		checks, only windows on the border are clamped. This saves one pass over the map and its memory.
+		4. New parameter 'e' to select the convolution engine. e 1 keeps a frequency distn for each column of the
+		window rows and slides whole columns (Perreault and Hebert 2007), for the rules that count pixels; the
+		cost per pixel no longer grows with the window size. New subroutines Conv_Band and Conv_Column_Hist.
+		5. e 2 for rules 81, 82 and 83: the pixel values are collapsed to code_1, code_2, other and missing, and
+		the counts in each window come from summed-area tables (new subroutine Conv_Summed_Area).
+		6. e 2 for rules 75, 76, 77 and 78: summed-area tables of the vertical and horizontal adjacencies that
+		these rules read (new subroutine Conv_Summed_Area_Edges).
+		7. e 3 for rules 51-54 and 71-74: every change to the frequency distn also updates running sums (see
+		struct metric_acc), and the metric is finished from them in Store_Tracked_Value instead of Freq_Filters
+		rescanning all colors or adjacencies. Rules 54 and 74 give the same output as e 0. For rules 51-53 and
+		71-73 the sums are exact, so 32-bit values differ from e 0 in the last digits; rounded to 8 bits they
+		would differ by one wherever a value falls on a step (e.g. 0.5), so 8-bit output of these rules keeps
+		Freq_Filters and e 3 only applies to them with f 1.
+		8. Freq_Filters is no longer called with the rule and handle_missing for every window. Select_Kernel
+		picks, once per run, a kernel generated for the rule, handle_missing and output format, in which the
+		filter is inlined with those as constants (see kernel_table). Store_Value calls it through specs->store.
+		9. Several window sizes in one run: each w line adds an output band. The map is read, re-coded and
+		given its local color codes once, then convolved for each window size (see Freq_Conv and
+		Freq_Conv_Stream). The window constants and target codes of each window are set by Use_Conv_Specs;
+		Init_Conv_Specs no longer changes parameters.code_1 and code_2.
+		10. Several mapping rules in one run: each r line adds an output band. Group_Rules puts the rules
+		that use the same color codes and count the same thing (pixels or adjacencies) in a group; each
+		group slides its frequency distns once and Store_Value finishes every rule of the group from them
+		into its own band (see conv_specs.band_offsets). The convolution now writes each band straight
+		into its place in mat_out, nrows x ncols, so the padded output and the shift back are gone.
+		With e 3 the accumulators are chosen for each rule of a group (conv_specs.tracked); the other rules
+		are finished by their kernel from the same counts, so a rule gives the same output whatever other
+		rules are in the run.
+		11. The frequency distns (and the column histograms of e 1) hold 2-byte counts when no count can pass
+		65535, which is window sizes up to 255 for the rules that count pixels and 181 for adjacencies, else
+		4-byte counts instead of long int (see conv_specs.count_width). The kernels are generated for both
+		sizes, so the adjacency matrix of a 255 color map is 128 KB instead of 512 KB.
+		12. Sparse adjacency matrix for rules 71-76 on maps with many colors: the sliding window also keeps a
+		bit for each cell of the adjacency matrix whose count is not 0 (see Mark_Pair), and new subroutine
+		Store_Sparse_Value computes these rules from the occupied cells only, in the same order as
+		Freq_Filters, so the output is unchanged. Used when the matrix has at least SPARSE_MIN_CELLS cells
+		and at least 4 cells for each edge of a window, e.g. up to w 17 for 50 colors, w 91 for 255.
+		13. The rows of the sliding window no longer calloc and free a frequency distn each. Each thread
+		gets one cache-line aligned scratch arena per run (Thread_Scratch, freed by Free_Conv_Specs), and
+		Conv_Row leaves it zero after a row by clearing only the counts of its last window (Clear_Window).
+		14. New parameters t and o: Conv_Band can hand column strips of t placements to the threads instead
+		of whole rows, each strip convolved from top to bottom so that the rows under the window stay in
+		cache, and o picks the OpenMP schedule (schedule(runtime), dynamic for strips by default).
+		Timed on one core only (300 x 40000 pixels, 2 MB L2): r 73 w 81 took 9.95 s with whole rows and 8.68 s
+		with t 4096; r 10 w 243 took 7.89 s with whole rows and no less with any t, as its rows fit in L3.
+		How strips and schedules scale with the number of threads has not been measured.
+		15. Engine 4 (e 4), bit planes for maps with up to 3 pixel values besides missing and for rules 75-78
+		and 81-83 on any map (new subroutine Conv_Bit_Planes): column counts are moved down a row by the
+		bits that change between rows, 64 pixels to a word, so the time per pixel no longer depends on w.
+		16. New parameter k, a memory budget in MB (new subroutine Plan_Memory): the map is held in memory
+		if it fits, else streamed with the largest band that fits, and if a band of whole rows does not
+		fit, in column tiles with a half-window of overlap that are written into place in the output.
+		Streaming checks the map in the same order as the whole map: its size (exit 20), the landscape
+		mosaic codes (exit 21), then the run options of Check_Conv_Options (exit 22).
+		17. Streaming (s, k) reads and writes in threads of their own (new struct io_pipe, subroutines
+		Start_Io_Pipe, Wait_For_Rows, Submit_Job, Write_Band, etc.): the next band of rows is read and
+		the last one written while the current band is convolved. The I/O and wait times are logged.
+		18. The recoding, the check of the landscape mosaic codes and the search for color codes are one
+		parallel pass over the map (new subroutines Load_Map and Number_Colors) instead of three serial
+		ones. Colors are still numbered in the order they are first found, so the output is the same.
+		The first pass of Freq_Conv_Stream reads the rows into its ring a block at a time and looks them over
+		in parallel (First_Seen_Rows); the reads stay serial, and as the recoded rows are not kept the
+		second pass recodes them again.
+		19. The majority filter (rule 1) stores the original color codes as it goes (conv_specs.color_out)
+		instead of a serial pass over its output band after the convolution.
+		20. GeoTIFF input and output when compiled with SPATCON_GEOTIFF (libtiff), for arguments ending in
+		.tif or .tiff. The input is decoded a strip or row of tiles at a time as its rows are needed, so it
+		can be streamed (s, k). The output is tiled and gets the georeferencing of the input. Only DEFLATE
+		tiles (c 0) are compressed in parallel, with zlib; ZSTD tiles (c 1) are compressed by libtiff one
+		at a time. New parameter c for the compression, new struct geotiff_io.
+		21. Library build (SPATCON_LIBRARY) for GTB: new subroutines Spatcon_Run and Spatcon_IDL convolve a map
+		held by the caller into the caller's output array, so IDL no longer writes scinput, copies and starts
+		the program and reads scoutput back. An error returns its exit code instead of ending the caller:
+		in a parallel region it is kept by Thread_Error and returned after the region, and rules without
+		float output (f 1) are rejected by Check_Run_Parameters before the convolution starts. Every return
+		frees what the run allocated (new subroutine Free_Conv_State). The run state stays at file scope, so
+		the library is not thread-safe: calls are serialized, a call from a second thread waits for the
+		first one, it does not run beside it. exit() still never returns: an error that Library_Exit cannot
+		take back to Spatcon_Run (in a parallel region, or outside a run) ends the process.
+		The parameter checks of main moved to Check_Run_Parameters and the parsing to Set_Parameter.
+		22. e 3 for the majority (rule 1): each count keeps a bit for every color with that count (new
+		metric_acc.count_colors, subroutines Track_Max and Majority_Color), so the largest count and its lowest
+		color, the one Freq_Filters picks on ties, are known without scanning the colors. Used for maps with
+		at least 12 colors per row of the window, where it is faster than the scan.
+		23. e 3 for the median (rule 20), after Huang (1979): metric_acc.median points to the median color
+		of the last window and metric_acc.below holds the count of the colors under it, kept up to date by
+		Track_Count; the new subroutine Median_Color moves the pointer to the median of the next window,
+		usually by one color or none. Byte and float output are the same as e 0. Used up to w 21.
+		24. The landscape mosaic class (rules 6 and 7) depends only on the counts of A, F and D in the window, so
+		for windows up to w 13 Mosaic_Table classifies every possible triple once and the kernels read the class
+		of a window from that table. The classification moved from Freq_Filters to the new subroutine
+		Mosaic_Class, which still does it for larger windows and makes the table, so the classes do not change.
+		25. New parameter g (grain), which brings back the grain_size of Freq_Conv (always 1 since 1.2.0): the
+		window is placed at every g-th row and column only, for a coarse map of (n + g - 1) / g rows and columns
+		whose pixel R,C is that of g 1 at R * g, C * g. Slide_Window moves the window g columns at a time, a
+		window that does not overlap the last one is seeded again, and the summed-area tables of engine 2 are
+		read at every g-th row and column. struct geotiff_io keeps the input size (in_rows, in_cols) for
+		Read_Tiff_Row apart from the output size (out_rows, out_cols) of the coarse GeoTIFF, whose pixel scale,
+		tiepoints or transformation matrix are rescaled for g.
 
 ************************************************************************ */
 
+#if !defined(_WIN32)
+#define _XOPEN_SOURCE 700   // 1.4.0, exposes mmap, ftruncate, etc. when compiling with -std=c99
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -242,18 +435,137 @@ Version and changes
 #if !defined(__APPLE__)
 #include <malloc.h>
 #endif
+#if !defined(_WIN32)     // 1.4.0, memory-mapped I/O
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#if !defined(_WIN32)     // 1.4.0, reader and writer threads when streaming (see Start_Io_Pipe)
+#include <pthread.h>
+#define IO_THREADS 1
+#else
+#define IO_THREADS 0
+#endif
+#if defined(SPATCON_GEOTIFF)     // 1.4.0, GeoTIFF input and output, see Open_Tiff_Input
+#include <stdint.h>
+#include <tiffio.h>
+#include <zlib.h>
+#define TIFF_TILE_SIZE 256          // rows and columns of the tiles of an output GeoTIFF
+#define TIFFTAG_GEOPIXELSCALE 33550
+#define TIFFTAG_GEOTIEPOINTS 33922
+#define TIFFTAG_GEOTRANSMATRIX 34264
+#define TIFFTAG_GEOKEYDIRECTORY 34735
+#define TIFFTAG_GEODOUBLEPARAMS 34736
+#define TIFFTAG_GEOASCIIPARAMS 34737
+#endif
+#if defined(SPATCON_LIBRARY)     // 1.4.0, in-process library for IDL and C callers, see Spatcon_Run
+#include <setjmp.h>
+#endif
 #define max(a,b) (((a) > (b)) ? (a) : (b))
 #define min(a,b) (((a) < (b)) ? (a) : (b))
+#if defined(SPATCON_LIBRARY)
+/* 1.4.0, an error returns its exit code from Spatcon_Run instead of ending the caller's process */
+#define exit(code) Library_Exit(code)
+#endif
 
 /* prototypes */
-long int Freq_Conv(long int,long int,long int,long int,long int,long int,long int,long int);
-unsigned char Freq_Filters(long int,long int,long int *,long int,long int,long int,long int,long int);
-float Freq_Filters_Float(long int,long int,long int *,long int,long int,long int,long int,long int);
+long int Freq_Conv(long int,long int,long int,long int,long int *,long int,long int *,long int,long int,long int,long int *);
+unsigned char Freq_Filters(long int,long int,void *,long int,long int,long int,long int,long int,long int);
+float Freq_Filters_Float(long int,long int,void *,long int,long int,long int,long int,long int,long int);
+unsigned char Mosaic_Class(long int,long int,long int,long int,long int);
+unsigned char *Mosaic_Table(long int,long int);
 long int Read_Parameter_File(FILE *);
+struct run_parameters;
+long int Set_Parameter(struct run_parameters *,char,long int);
+long int Check_Run_Parameters(void);
+unsigned char *Map_Input_File(char *, long int);
+void Release_Input(void);
+void *Map_Output_File(long int);
+long int Unmap_Output_File(long int);
+void Remove_Output(void);
+struct conv_specs;
+struct rule_group;
+long int Uses_Rule(long int);
+long int Group_Rules(struct rule_group *);
+long int Check_Conv_Options(long int,long int,long int,long int,long int);
+long int Init_Color_Tables(long int *,long int *,long int,long int);
+void Assign_Color_Codes(unsigned char *,long int,long int,long int *,long int *,long int *);
+void Load_Map(long int,long int,long int *,long int,long int *);
+void Number_Colors(long int *,long int,long int *,long int *,long int *);
+void First_Seen_Rows(unsigned char **,long int,long int,long int,long int *,long int *);
+void Set_Local_Target_Codes(long int *,long int,long int *);
+void Init_Conv_Specs(struct conv_specs *,long int,long int,long int,long int,long int *,long int,long int,long int,long int *);
+void Use_Conv_Specs(struct conv_specs *);
+void Set_Window_Constants(long int);
+struct metric_acc;
+void Conv_Row(struct conv_specs *,unsigned char **,void *,struct metric_acc *,unsigned char *,float *,long int,long int);
+void Conv_Band(struct conv_specs *,unsigned char **,long int,unsigned char *,float *,long int);
+void *Alloc_Scratch(long int);
+void Free_Scratch(void *);
+void *Thread_Scratch(struct conv_specs *);
+void Thread_Error(int,char *);
+void Check_Thread_Error(void);
+void Free_Conv_Specs(struct conv_specs *);
+void Free_Conv_State(void);
+void Conv_Column_Hist(struct conv_specs *,unsigned char **,long int,long int,void *,void *,unsigned char *,float *,long int);
+void Conv_Summed_Area(struct conv_specs *,unsigned char **,long int,unsigned char *,float *,long int);
+void Conv_Summed_Area_Edges(struct conv_specs *,unsigned char **,long int,unsigned char *,float *,long int);
+void Sum_Table_Columns(unsigned int *,long int,long int,long int,long int);
+unsigned int *Sat_Tables(long int,long int,long int);
+void Free_Sat_Tables(void);
+void Conv_Bit_Planes(struct conv_specs *,unsigned char **,long int,unsigned char *,float *,long int);
+void Set_Row_Planes(struct conv_specs *,unsigned char *,unsigned long long *,long int,long int,long int);
+void Select_Kernel(struct conv_specs *);
+long int Freq_Conv_Stream(FILE *,FILE *,long int,long int,long int *);
+void Write_Output_Rows(FILE *,long int,void *,long int,long int);
+unsigned char *Get_Input_Row(FILE *,long int,long int,long int,long int,long int *,unsigned char *);
+void Plan_Memory(long int,long int);
+struct io_pipe;
+struct band_job;
+void Tile_Columns(struct io_pipe *,long int,long int *,long int *,long int *,long int *);
+void Start_Io_Pipe(struct io_pipe *);
+void Stop_Io_Pipe(struct io_pipe *);
+void Wait_For_Rows(struct io_pipe *,long int);
+void Release_Rows(struct io_pipe *,long int);
+void Wait_For_Job(struct io_pipe *,long int);
+void Submit_Job(struct io_pipe *,long int);
+void Read_Ring_Row(struct io_pipe *);
+void Write_Band(struct io_pipe *,struct band_job *);
+void *Reader_Thread(void *);
+void *Writer_Thread(void *);
+#if defined(SPATCON_GEOTIFF)
+long int Tiff_Name(char *);
+void Open_Tiff_Input(char *,long int *,long int *);
+void Open_Tiff_Output(char *,long int,long int);
+unsigned char *Read_Tiff_Row(long int,long int);
+void Write_Tiff_Rows(long int,unsigned char *,long int);
+void Write_Tiff_Tiles(long int,long int,long int,long int);
+void Close_Tiff(void);
+#endif
+#if defined(SPATCON_LIBRARY)
+long int Spatcon_Run(struct run_parameters *,unsigned char *,long int,long int,long int *,void *);
+long int Library_Conv(struct run_parameters *,unsigned char *,long int,long int,long int *,void *);
+int Spatcon_IDL(int,void **);
+void Library_Exit(int);
+#endif
 /* The input and output data matrices visible everywhere */
 unsigned char *mat_in;
 unsigned char *mat_out; // byte version
 float *mat_outfloat;	// float version
+/* 1.4.0, bookkeeping for memory-mapped input and output files (parameter i = 1) */
+struct io_maps
+{
+    int in_fd;                  // input file descriptor, -1 if not mapped
+    int out_fd;                 // output file descriptor, -1 if not mapped
+    long int in_length;         // number of bytes mapped from the input file
+    long int out_length;        // number of bytes mapped from the output file
+    unsigned char *in_map;      // mat_in points here when the input is mapped
+    void *out_map;              // mat_out or mat_outfloat point here when the output is mapped
+    unsigned char *in_caller;   // mat_in when it is the map of the caller of Spatcon_Run, not freed
+    char *out_name;             // the output file until it is complete, removed at an error (see Remove_Output)
+};
+struct io_maps maps = {-1,-1,0,0,NULL,NULL,NULL,NULL};
 /* some useful constants that depend on window size */
 struct run_helpers
 {
@@ -263,9 +575,130 @@ struct run_helpers
     float number_of_edges_inverse;
 };
 struct run_helpers constants;
+/* 1.4.0, the output rows of one window size for a band of rows, see Write_Band */
+struct band_job
+{
+    unsigned char *data;            // the output rows of each rule, rows_size pixels apart (see io_pipe)
+    long int window;                // which window size (w line)
+    long int band_start;            // output rows band_start ... band_end - 1
+    long int band_end;
+    long int tile;                  // column tile
+    long int full;                  // 1 until the writer has written it
+};
+/* 1.4.0, the input ring and output bands that Freq_Conv_Stream shares with its reader and writer */
+struct io_pipe
+{
+    FILE *infile;
+    FILE *outfile;
+    long int *recode_table;
+    unsigned char *ring;            // input row 'row' of column tile 'tile' is ring row g % ring_rows,
+                                    // g = tile * n_rows_in + row
+    unsigned char *row_buffer;
+    long int ring_rows;
+    long int ring_cols;
+    long int n_rows_in;
+    long int n_cols_in;
+    long int n_tiles;
+    long int tile_out;              // output columns of a column tile
+    long int buff_b;                // overlap of the column tiles, half the largest window
+    long int n_windows;
+    long int n_rules;
+    long int el_size;               // bytes per output pixel
+    long int rows_size;             // pixels from the output rows of one rule to the next in band_job.data
+    long int next_read;             // g of the next input row to read
+    long int read_limit;            // rows g < read_limit have a free ring row
+    long int next_job;              // the job the writer takes next
+    long int n_jobs;                // 2 with a writer thread, else 1
+    long int stop;                  // 1 when there are no more jobs
+    struct band_job jobs[2];
+    int threads;                    // 1 if the reader and writer are threads of their own
+    double read_time;               // seconds reading, writing, and waiting for input rows or a free job
+    double write_time;
+    double input_wait;
+    double output_wait;
+#if IO_THREADS
+    pthread_t reader;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+#endif
+};
+#define MAX_WINDOWS 16     // 1.4.0, most window sizes (w lines) in one run
+#define MAX_RULES 16       // 1.4.0, most mapping rules (r lines) in one run
+#define SPARSE_MIN_CELLS 256    // 1.4.0, smallest adjacency matrix that is visited by its occupied cells
+#define MOSAIC_TABLE_MAX (1L << 20) // 1.4.0, most entries in the class table of rules 6 and 7, see Mosaic_Table
+/* 1.4.0, settings shared by every row of window placements, see Conv_Row */
+struct conv_specs
+{
+    long int window_size;
+    long int n_places_right;        // number of window placements (output pixels) in a row
+    long int n_colors_in_image;     // local color codes are 1 ... n_colors_in_image, 0 is missing
+    long int color_freq;            // 1 if counting pixels
+    long int edge_freq;             // 1 if counting adjacencies
+    long int array_length;          // number of counts in freq_ptr
+    long int count_width;           // bytes per count in freq_ptr, 2 or 4, see Init_Conv_Specs
+    long int sparse;                // 1 if freq_ptr also keeps the occupied cells of the adjacency matrix
+    long int pair_offset;           // bytes from freq_ptr to the occupied cell bits (see Mark_Pair)
+    long int pair_words;            // 64-bit words of occupied cell bits, one bit per cell
+    long int freq_bytes;            // bytes in freq_ptr for the sliding window
+    long int hist_offset;           // bytes from freq_ptr to metric_acc.count_hist in a scratch arena
+    long int colors_offset;         // bytes from freq_ptr to metric_acc.count_colors in a scratch arena
+    long int color_words;           // engine 3, rule 1, 64-bit words of color bits for each count
+    long int scratch_bytes;         // bytes in the scratch arena of a thread (see Thread_Scratch)
+    long int n_scratch;             // omp_get_max_threads() when the specs were made
+    void **scratch;                 // the scratch arena of each thread, or NULL until it is first used
+    long int n_rules;               // mapping rules finished from the same counts, one output band each
+    long int mapping_rules[MAX_RULES];
+    long int band_offsets[MAX_RULES];   // from out_row of Conv_Row to the output of each rule, in pixels
+    long int tracked[MAX_RULES];    // engine 3, 1 if the rule is finished from the metric accumulators
+    long int handle_missing;
+    long int code_1;                // local codes read by the filters, see Use_Conv_Specs
+    long int code_2;
+    long int engine;                // 0 = sliding window, 1 = column histograms, 2 = summed-area tables,
+                                    // 3 = sliding window with metric accumulators, 4 = bit planes
+    long int max_count;             // largest possible count, window_size^2 or the number of edges
+    double *clogc;                  // engine 3, c * ln(c) for c = 0 ... max_count
+    unsigned char *mosaic_table[2]; // rules 6 and 7, the class of every count of A, F and D, or NULL
+    long int buff_b;                // (window_size - 1) / 2, how far a window sticks out of the map
+    long int n_cols_in;             // columns in the input rows passed to Conv_Row
+    long int grain;                 // input rows and columns from one placement to the next (parameter g)
+    unsigned char color_lut[256];   // input byte value to local color code
+    unsigned char color_out[256];   // local color code to output byte value, for the majority (rule 1)
+    void (*store[MAX_RULES])(struct conv_specs *, void *, unsigned char *, float *, long int);
+                                    // kernels that finish a window for each rule, see Select_Kernel
+};
+/* 1.4.0, engine 3, running totals over the counts in freq_ptr that a metric uses (see Track_Count) */
+struct metric_acc
+{
+    long int start;             // 0 if missing values are included (h 2), else 1
+    long int sums;              // 0 if no rule reads the sums (rules 1 and 20 only), else 1
+    long int total;             // sum of the counts
+    long int sum_sq;            // sum of the squared counts
+    double sum_clogc;           // sum of c * ln(c) over the counts c
+    long int n_nonzero;         // colors, or edge types without regard to order, in the window
+    long int diagonal;          // edges between pixels of the same color
+    long int max_count;         // largest count (rules 1, 54)
+    long int *count_hist;       // number of colors with each count 0 ... specs.max_count (rule 54), or NULL
+    unsigned long long *count_colors;   // a bit for each color with each count, specs.color_words words
+                                        // per count (rule 1), or NULL
+    long int median;            // rule 20, the color of the median pointer, or -1 if not kept
+    long int below;             // rule 20, the sum of the counts of colors start ... median - 1
+};
+/* 1.4.0, mapping rules that are finished from the same counts, see Group_Rules */
+struct rule_group
+{
+    long int preserve;          // 1 if the original pixel values are kept (see Init_Color_Tables)
+    long int edges;             // 1 if counting adjacencies, 0 if counting pixels
+    long int n_rules;
+    long int rules[MAX_RULES];
+    long int bands[MAX_RULES];  // output band of each rule for a window size, in the order of the r lines
+    long int code_1;            // local target codes (see Set_Local_Target_Codes)
+    long int code_2;
+};
 const float EPSILON = FLT_EPSILON; // 1.3.4, EPSILON defined in float.h; can make this a global variable available to all functions
 
-/* the following two must be changed whenever a new mapping rule is added */
+/* the following two must be changed whenever a new mapping rule is added, and the rule
+   must be added to kernel_table (see Select_Kernel) */
 #define NUM_MAP_RULES_DEFINED 21
 long int ok_mapping_rule[NUM_MAP_RULES_DEFINED]  =
 {1,6,7,10,20,21,51,52,53,54,71,72,73,74,75,76,77,78,81,82,83};
@@ -280,17 +713,76 @@ struct run_parameters
     long int code_2;                // the "b" parameter
     long int recode;                // 0 = no recode, 1 = recode
     long int outfloat;              // 0 = output 8-bit chars, 1 = output 32-bit floats
+    long int io_mode;               // 0 = standard file I/O, 1 = memory-mapped input and output
+    long int stream_rows;           // 0 = whole map in memory, >0 = rows per band when streaming
+    long int engine;                // 0 = sliding window, 1 = column histograms, 2 = summed-area tables,
+                                    // 3 = metric accumulators, 4 = bit planes
+    long int n_windows;             // number of w lines, one output band for each
+    long int window_sizes[MAX_WINDOWS];
+    long int n_rules;               // number of r lines, one output band for each (for each window size)
+    long int map_rules[MAX_RULES];
+    long int tile_cols;             // 0 = whole rows per thread, >0 = output columns per column strip
+    long int schedule;              // OpenMP schedule of rows or strips, 0 = default, 1 = static,
+                                    // 2 = dynamic, 3 = guided
+    long int memory_mb;             // 0 = no memory budget, >0 = megabytes for the run, see Plan_Memory
+    long int stream_cols;           // 0 = whole rows when streaming, >0 = output columns per column tile
+    long int compression;           // of an output GeoTIFF, 0 = DEFLATE, 1 = ZSTD, 2 = none
+    long int grain;                 // rows and columns from one window placement to the next, 1 = every pixel
+};
+struct run_parameters parameters = {0,0,0,1,0,0,0,0,0,0,0,0,{0},0,{0},0,0,0,0,0,1};
+#if defined(SPATCON_GEOTIFF)
+/* 1.4.0, the input and output GeoTIFFs, see Open_Tiff_Input */
+struct geotiff_io
+{
+    long int read;                  // 1 if the input file is a GeoTIFF (a .tif or .tiff name)
+    long int write;                 // 1 if the output file is a GeoTIFF
+    TIFF *in;
+    TIFF *out;
+    long int in_rows;               // of the input map
+    long int in_cols;
+    long int out_rows;              // of the output, smaller than the input for grain g > 1
+    long int out_cols;
+    long int tiled;                 // 1 if the input is in tiles, 0 if in strips
+    long int block_height;          // rows of an input strip or tile
+    long int block_width;           // columns of an input tile
+    long int block_first;           // the input rows block_first ... are in block, -1 if none yet
+    unsigned char *block;           // a strip or a row of tiles of the input, in_cols wide
+    unsigned char *tile_in;         // an input tile
+    long int n_bands;               // output bands, one plane of the output GeoTIFF each
+    long int el_size;               // bytes per output pixel
+    unsigned char **rows;           // TIFF_TILE_SIZE output rows of each band, out_cols wide
+};
+struct geotiff_io geotiff;
+#endif
+/* 1.4.0, exit code of the first error in a parallel region, see Thread_Error */
+int thread_error = 0;
+/* 1.4.0, what Freq_Conv allocates for the convolution, at file scope so that Free_Conv_State can */
+/*   release it after an error in the library build as well */
+struct conv_state
+{
+    unsigned char **rows;           // input row pointers, see Freq_Conv
+    struct conv_specs specs;        // of the window size and rule group being convolved
+    unsigned int *sat;              // engine 2, the summed-area tables, kept from band to band (see Sat_Tables)
+    long int sat_entries;           // 4-byte entries in sat
 };
-struct run_parameters parameters = {0,0,0,1,0,0,0,0};
+struct conv_state conv_state;
+#if defined(SPATCON_LIBRARY)
+/* 1.4.0, where Library_Exit returns to with the exit code of an error, see Spatcon_Run */
+jmp_buf library_return;
+int library_exit_code = 0;
+long int library_running = 0;
+#endif
 
+#if !defined(SPATCON_LIBRARY)
 int main(int argc, char **argv)
 {
-    static long int ret_val, vnew, vold, dum;
+    static long int ret_val, vnew, vold;
     static long int recode_table[256];
+    long int first_seen_table[256], *first_seen;
     static FILE *infile, *outfile, *parfile, *recfile, *sizfile;
     static char filename_par[505], filename_in[505], filename_out[505];
     static char filename_rec[505], filename_siz[505], header_line[30];
-    static long int row, col, nrows_in, ncols_in, index, temp_int;
+    static long int nrows_in, ncols_in, nrows_out, ncols_out, index, temp_int;
 
     /* check command line to see which mode to use, classic or guidos */
     if(argc != 1 && argc != 4)
@@ -317,6 +809,21 @@ int main(int argc, char **argv)
         strcpy(filename_siz,argv[1]);
         strcat(filename_siz,".siz");
         strcpy(filename_par,argv[3]);
+#if defined(SPATCON_GEOTIFF)
+        /* 1.4.0, a name ending in .tif or .tiff is a GeoTIFF, used as it is */
+        if(Tiff_Name(argv[1]) == 1)
+        {
+            geotiff.read = 1;
+            strcpy(filename_in, argv[1]);
+            strcpy(filename_rec, argv[1]);
+            strcpy(strrchr(filename_rec, '.'), ".rec");
+        }
+        if(Tiff_Name(argv[2]) == 1)
+        {
+            geotiff.write = 1;
+            strcpy(filename_out, argv[2]);
+        }
+#endif
     }
     /* Open parameter file and read run parameters */
     if( (parfile = fopen(filename_par, "r") ) == NULL)
@@ -331,6 +838,25 @@ int main(int argc, char **argv)
         exit(12);
     }
     fclose(parfile);
+    /* 1.4.0, the checks are shared with Spatcon_Run */
+    if( (ret_val = Check_Run_Parameters()) != 0)
+    {
+        exit(ret_val);
+    }
+#if defined(SPATCON_GEOTIFF)
+    if( (parameters.io_mode == 1) && ( (geotiff.read == 1) || (geotiff.write == 1) ) )
+    {
+        printf("Spatcon: Memory-mapped I/O is not available for GeoTIFFs, using standard file I/O.\n");
+        parameters.io_mode = 0;
+    }
+#endif
+#if defined(_WIN32)
+    if(parameters.io_mode == 1)
+    {
+        printf("Spatcon: Memory-mapped I/O is not available on this platform, using standard file I/O.\n");
+        parameters.io_mode = 0;
+    }
+#endif
     /* If re-coding pixels ... */
     if(parameters.recode == 1)
     {
@@ -361,7 +887,7 @@ int main(int argc, char **argv)
             }
             recode_table[vold] = vnew;
             printf("   %8ld ---> %3ld\n", vold, vnew);
-            if(parameters.map_rule == 6)   /* doing LPT's... */
+            if(Uses_Rule(6) == 1)   /* doing LPT's... */
             {
                 if( (vnew < 0) || (vnew > 3) )
                 {
@@ -375,139 +901,294 @@ int main(int argc, char **argv)
     }
     setbuf(stdout, NULL);
     printf("Spatcon: Spatial convolution: %s ---> %s\n",filename_in, filename_out);
-    printf("Run parameters are: m %ld w %ld r %ld h %ld a %ld b %ld z %ld f %ld\n",
+    printf("Run parameters are: m %ld w %ld r %ld h %ld a %ld b %ld z %ld f %ld i %ld e %ld\n",
            parameters.missing_value_code,
            parameters.window_size, parameters.map_rule,
            parameters.handle_missing, parameters.code_1, parameters.code_2,
-           parameters.recode, parameters.outfloat);
-    /* calculate some run-specific constants */
-    constants.window_area = parameters.window_size * parameters.window_size;
-    constants.window_area_inverse = 1.0 / constants.window_area;
-    constants.number_of_edges =
-        2. * ( parameters.window_size * (parameters.window_size - 1. ) );
-    if (constants.number_of_edges > 0)
+           parameters.recode, parameters.outfloat, parameters.io_mode, parameters.engine);
+    if(parameters.n_windows > 1)
     {
-        constants.number_of_edges_inverse = 1.0 / constants.number_of_edges;
+        printf("Window sizes (one output band each):");
+        for(index = 0; index < parameters.n_windows; index++)
+        {
+            printf(" %ld", parameters.window_sizes[index]);
+        }
+        printf("\n");
     }
-    else
+    if(parameters.n_rules > 1)
     {
-        constants.number_of_edges_inverse = 0.;
+        printf("Mapping rules (one output band each%s):", (parameters.n_windows > 1) ? " for each window size" : "");
+        for(index = 0; index < parameters.n_rules; index++)
+        {
+            printf(" %ld", parameters.map_rules[index]);
+        }
+        printf("\n");
+    }
+    if( (parameters.tile_cols > 0) || (parameters.schedule > 0) )
+    {
+        printf("Column strips of %ld output columns (t), OpenMP schedule %ld (o)\n",
+               parameters.tile_cols, parameters.schedule);
+    }
+    if(parameters.grain > 1)
+    {
+        printf("Grain %ld (g): a window at every %ld-th row and column\n", parameters.grain, parameters.grain);
     }
+    /* calculate some run-specific constants */
+    Set_Window_Constants(parameters.window_size);
     /* Open the input and output files */
-    if( (infile = fopen(filename_in, "rb") ) == NULL)
+    /* 1.4.0, with memory-mapped I/O the input is opened when it is mapped, below */
+    infile = NULL;
+    outfile = NULL;
+    if(parameters.io_mode == 0)
     {
-        printf("\nSpatcon: Error opening input file %s\n", filename_in);
-        exit(15);
+#if defined(SPATCON_GEOTIFF)
+        /* 1.4.0, GeoTIFFs are opened below, when their size is known */
+        if(geotiff.read == 0)
+#endif
+        if( (infile = fopen(filename_in, "rb") ) == NULL)
+        {
+            printf("\nSpatcon: Error opening input file %s\n", filename_in);
+            exit(15);
+        }
+#if defined(SPATCON_GEOTIFF)
+        if(geotiff.write == 0)
+#endif
+        if( (outfile = fopen(filename_out, "wb") ) == NULL)
+        {
+            printf("\nSpatcon:Error opening output file %s\n", filename_out);
+            exit(16);
+        }
     }
-    if( (outfile = fopen(filename_out, "wb") ) == NULL)
+#if !defined(_WIN32)
+    if(parameters.io_mode == 1)
     {
-        printf("\nSpatcon:Error opening output file %s\n", filename_out);
-        exit(16);
+        if( (maps.out_fd = open(filename_out, O_RDWR | O_CREAT | O_TRUNC, 0644) ) < 0)
+        {
+            printf("\nSpatcon:Error opening output file %s\n", filename_out);
+            exit(16);
+        }
+        /* the output is sized for the whole map before the map and the rules are checked, so an */
+        /*   error from here on removes it instead of leaving a full-size file of zeros */
+        maps.out_name = filename_out;
+        atexit(Remove_Output);
     }
-    /* Read the siz file and save nrows and ncols */
-    if( (sizfile = fopen(filename_siz, "r") ) == NULL)
+#endif
+#if defined(SPATCON_GEOTIFF)
+    /* 1.4.0, the size of a GeoTIFF is in the file */
+    if(geotiff.read == 1)
     {
-        printf("\nSpatcon: Error opening size file %s\n", filename_siz);
-        fclose(infile);
-        fclose(outfile);
-        exit(17);
+        Open_Tiff_Input(filename_in, &nrows_in, &ncols_in);
     }
-    if(fscanf(sizfile,"%s %ld", header_line, &nrows_in) != 2)
+    else
+#endif
     {
-        exit(18);
+        /* Read the siz file and save nrows and ncols */
+        if( (sizfile = fopen(filename_siz, "r") ) == NULL)
+        {
+            printf("\nSpatcon: Error opening size file %s\n", filename_siz);
+            if(infile != NULL)
+            {
+                fclose(infile);
+                fclose(outfile);
+            }
+            exit(17);
+        }
+        if(fscanf(sizfile,"%s %ld", header_line, &nrows_in) != 2)
+        {
+            exit(18);
+        }
+        if(fscanf(sizfile,"%s %ld", header_line, &ncols_in) != 2)
+        {
+            exit(18);
+        }
+        fclose(sizfile);
     }
-    if(fscanf(sizfile,"%s %ld", header_line, &ncols_in) != 2)
+    /* 1.4.0, a window at every g-th row and column (parameter g) */
+    nrows_out = (nrows_in + parameters.grain - 1) / parameters.grain;
+    ncols_out = (ncols_in + parameters.grain - 1) / parameters.grain;
+#if defined(SPATCON_GEOTIFF)
+    if(geotiff.write == 1)
     {
-        exit(18);
+        Open_Tiff_Output(filename_out, nrows_out, ncols_out);
     }
-    fclose(sizfile);
+#endif
     printf("Spatcon: Reading %ld columns and %ld rows from file %s.\n", ncols_in, nrows_in, filename_in);
-    /* Allocate the resources for mat_in, the input map */
-    temp_int = nrows_in * ncols_in;
-    if( (mat_in = (unsigned char *)calloc( temp_int, sizeof(unsigned char) ) ) == NULL )
+    if(parameters.memory_mb > 0)
     {
-        printf("\nSpatcon: Error. Not enough memory for input data.\n");
-        fclose(infile);
-        fclose(outfile);
-        exit(19);
+        /* 1.4.0, whole map or streaming, and the band height and column tiles, within the budget */
+        Plan_Memory(nrows_in, ncols_in);
     }
-    /* read the input data*/
-    if(fread(mat_in, 1, (nrows_in * ncols_in), infile) != (nrows_in * ncols_in) )
+    if( (parameters.grain > 1) && (parameters.stream_rows > 0) )
     {
-        printf("\nSpatcon: Error reading input file. Incorrect file size.\n");
-        exit(20);
+        /* the bands of output rows of Freq_Conv_Stream are those of every input row */
+        printf("Spatcon: Streaming is not available with g > 1, holding the whole map in memory.\n");
+        parameters.stream_rows = 0;
+        parameters.stream_cols = 0;
     }
-    fclose(infile);
-    printf("Spatcon: Input file read OK.\n");
-    /* recode the pixels here if that was requested */
-    if(parameters.recode == 1)
+    if(parameters.stream_rows > 0)
     {
-        for (row=0; row < nrows_in; row++)
+        /* 1.4.0, stream the map through the convolution instead of reading all of it */
+        if(parameters.io_mode == 1)
+        {
+            mat_in = Map_Input_File(filename_in, nrows_in * ncols_in);
+        }
+        else if(infile != NULL)
         {
-            index = row * ncols_in;
-            for (col=0; col < ncols_in; col++)
+            /* the size check of the fread of the whole map, before any row is looked at */
+#if defined(_WIN32)
+            if( (_fseeki64(infile, 0, SEEK_END) != 0) || (_ftelli64(infile) < nrows_in * ncols_in) )
+#else
+            if( (fseeko(infile, 0, SEEK_END) != 0) || (ftello(infile) < (off_t)(nrows_in * ncols_in) ) )
+#endif
             {
-                dum = *(mat_in + index + col);
-                *(mat_in + index + col) = recode_table[dum];
+                printf("\nSpatcon: Error reading input file. Incorrect file size.\n");
+                exit(20);
             }
+            rewind(infile);
+        }
+        printf("Spatcon: Starting Convolution.\n");
+        ret_val = Freq_Conv_Stream(infile, outfile, nrows_in, ncols_in,
+                                   (parameters.recode == 1) ? recode_table : NULL);
+        if(ret_val !=0)
+        {
+            printf("\nSpatcon: Error in run parameters.\n");
+            exit(22);
+        }
+        printf("Spatcon: Convolution completed.\n");
+        if( (parameters.io_mode == 0) && (infile != NULL) )
+        {
+            fclose(infile);
+        }
+        if( (parameters.io_mode == 0) && (outfile != NULL) && (fclose(outfile) != 0) )
+        {
+            printf("\nSpatcon: Error writing output file.\n");
+            exit(24);
         }
+#if defined(SPATCON_GEOTIFF)
+        Close_Tiff();
+#endif
+        printf("Spatcon: File written OK.\n");
+        printf("Spatcon: Normal Finish.\n");
+        exit(0);
     }
-    /* Check, if it's lpt generator, only codes 0 thru 3 allowed*/
-    if( (parameters.map_rule == 6) || (parameters.map_rule == 7) )
+    temp_int = nrows_in * ncols_in;
+    if(parameters.io_mode == 1)
     {
-        for (row=0; row < nrows_in; row++)
+        /* 1.4.0, map the input map instead of reading a copy of it */
+        mat_in = Map_Input_File(filename_in, temp_int);
+        printf("Spatcon: Input file mapped OK.\n");
+    }
+    else
+    {
+        /* Allocate the resources for mat_in, the input map */
+        if( (mat_in = (unsigned char *)calloc( temp_int, sizeof(unsigned char) ) ) == NULL )
+        {
+            printf("\nSpatcon: Error. Not enough memory for input data.\n");
+            fclose(infile);
+            fclose(outfile);
+            exit(19);
+        }
+        /* read the input data*/
+#if defined(SPATCON_GEOTIFF)
+        for(index = 0; (geotiff.read == 1) && (index < nrows_in); index++)
+        {
+            memcpy(mat_in + (index * ncols_in), Read_Tiff_Row(index, 0), ncols_in);
+        }
+        if(geotiff.read == 0)
+#endif
         {
-            index = row * ncols_in;
-            for (col=0; col < ncols_in; col++)
+            if(fread(mat_in, 1, (nrows_in * ncols_in), infile) != (nrows_in * ncols_in) )
             {
-                dum = *(mat_in + index + col);
-                if( (dum < 0 ) || (dum > 3) )
-                {
-                    printf("\nSpatcon: Error. Input byte value must be in range [0,3] for landscape mosaics.\n");
-                    free(mat_in);
-                    fclose(outfile);
-                    exit(21);
-                }
+                printf("\nSpatcon: Error reading input file. Incorrect file size.\n");
+                exit(20);
             }
+            fclose(infile);
         }
+        printf("Spatcon: Input file read OK.\n");
+    }
+    /* 1.4.0, recode the pixels if that was requested and, if it's lpt generator, check that only codes 0 */
+    /*   thru 3 are used, in one parallel pass that also finds the color codes for Freq_Conv */
+    first_seen = NULL;
+    if( (parameters.recode == 1) || (Uses_Rule(6) == 1) || (Uses_Rule(7) == 1) )
+    {
+        first_seen = first_seen_table;
+        Load_Map(nrows_in, ncols_in, (parameters.recode == 1) ? recode_table : NULL,
+                 (Uses_Rule(6) == 1) || (Uses_Rule(7) == 1), first_seen);
     }
     /* Call the convolution subroutine */
     printf("Spatcon: Starting Convolution.\n");
     ret_val = Freq_Conv(nrows_in, ncols_in,
                         parameters.missing_value_code,
-                        parameters.window_size,
-                        parameters.map_rule,
+                        parameters.n_windows,
+                        parameters.window_sizes,
+                        parameters.n_rules,
+                        parameters.map_rules,
                         parameters.handle_missing,
                         parameters.code_1,
-                        parameters.code_2);
+                        parameters.code_2,
+                        first_seen);
     if(ret_val !=0)
     {
         printf("\nSpatcon: Error in run parameters.\n");
-        free(mat_in);
-        fclose(outfile);
+        Release_Input();
+        if(outfile != NULL)
+        {
+            fclose(outfile);
+        }
         exit(22);
     }
     printf("Spatcon: Convolution completed.\n");
     /* Do the output */
     printf("Spatcon: Writing %s.\n",filename_out);
-    if(parameters.outfloat == 1)
+    if(parameters.io_mode == 1)
     {
-        if(fwrite(mat_outfloat, sizeof(float), (ncols_in * nrows_in), outfile) != (ncols_in * nrows_in) )
+        /* 1.4.0, the output is already in the mapped file, just trim it to the output size */
+        temp_int = ncols_out * nrows_out * parameters.n_windows * parameters.n_rules;
+        if(parameters.outfloat == 1)
+        {
+            temp_int = temp_int * sizeof(float);
+        }
+        if(Unmap_Output_File(temp_int) != 0)
         {
             printf("\nSpatcon: Error writing output file.\n");
-            exit(23);
+            exit(24);
         }
+        printf("Spatcon: File written OK.\n");
+        printf("Spatcon: Normal Finish.\n");
+        exit(0);
     }
-    if(parameters.outfloat == 0)
+#if defined(SPATCON_GEOTIFF)
+    if(geotiff.write == 1)
+    {
+        /* 1.4.0, the whole output at once, compressed a row of tiles at a time */
+        temp_int = ncols_out * nrows_out * parameters.n_windows * parameters.n_rules * geotiff.el_size;
+        Write_Tiff_Rows(0, (parameters.outfloat == 1) ? (unsigned char *)mat_outfloat : mat_out, temp_int);
+        Close_Tiff();
+    }
+    else
+#endif
     {
-        if(fwrite(mat_out, 1, (ncols_in * nrows_in), outfile) != (ncols_in * nrows_in) )
+        if(parameters.outfloat == 1)
         {
-            printf("\nSpatcon: Error writing output file.\n");
-            exit(24);
+            temp_int = ncols_out * nrows_out * parameters.n_windows * parameters.n_rules;
+            if(fwrite(mat_outfloat, sizeof(float), temp_int, outfile) != temp_int)
+            {
+                printf("\nSpatcon: Error writing output file.\n");
+                exit(23);
+            }
+        }
+        if(parameters.outfloat == 0)
+        {
+            temp_int = ncols_out * nrows_out * parameters.n_windows * parameters.n_rules;
+            if(fwrite(mat_out, 1, temp_int, outfile) != temp_int)
+            {
+                printf("\nSpatcon: Error writing output file.\n");
+                exit(24);
+            }
         }
+        /* Exit nicely */
+        fclose(outfile);
     }
-    /* Exit nicely */
-    fclose(outfile);
     printf("Spatcon: File written OK.\n");
     if(parameters.outfloat == 0)
     {
@@ -520,65 +1201,241 @@ int main(int argc, char **argv)
     printf("Spatcon: Normal Finish.\n");
     exit(0);
 }
+#endif
 
-/*   *********************
-     Read_Parameter_File
-     *********************
+#if defined(SPATCON_LIBRARY)
+/*   ***********
+     Spatcon_Run
+     ***********
+    1.4.0, what main does, for a map that is already in memory: compile with -DSPATCON_LIBRARY into a
+    shared library instead of an executable, and no process is started and no file is read or written.
+    map_in is the n_rows x n_cols input map and is not changed (it is copied if it has to be recoded).
+    map_out, allocated by the caller, gets the bands of the output file, n_rows x n_cols each, bytes or
+    floats (run->outfloat), or (n_rows + g - 1) / g x (n_cols + g - 1) / g each for run->grain g > 1.
+    run holds what the parameter file would, e.g. set line by line with Set_Parameter starting from
+    {0,0,0,1,0,0,0,0,0,0,0,0,{0},0,{0},0,0,0,0,0,1}; parameters i, s, k and c have no use here and are
+    ignored. recode_table has the new value of each byte value if run->recode is 1. Returns 0, or the
+    exit code of the executable for the same error, which is also printed.
+    Not thread-safe and not reentrant: the run state (parameters, mat_in, mat_out, constants, maps,
+    conv_state, thread_error) is at file scope and read by every convolution thread, there is no
+    context per call. A lock (omp critical spatcon_library) serializes the calls, so a call from a
+    second thread waits until the first has returned instead of running beside it, and the subroutines
+    of this file must not be called from another thread while a run is on. Each call sets all of the
+    state from its own arguments, frees what it allocated on every return, also after an error
+    (Free_Conv_State, Release_Input; see Library_Exit), and leaves the caller's OpenMP schedule as it was.
 */
-long int Read_Parameter_File(FILE *parfile)
+long int Spatcon_Run(struct run_parameters *run, unsigned char *map_in, long int n_rows, long int n_cols,
+                     long int *recode_table, void *map_out)
 {
-    static char ch;
-    static long int value, flag;
-    value = -99;
-    flag = 1;
-    while(flag == 1)
+    long int ret_val;
+    #pragma omp critical (spatcon_library)
     {
-        if (fscanf(parfile,"%s %ld", &ch, &value) != 2)
+        library_running = 1;
+        thread_error = 0;
+        if(setjmp(library_return) == 0)
         {
-            flag = 0;
-            continue;
+            ret_val = Library_Conv(run, map_in, n_rows, n_cols, recode_table, map_out);
         }
-        if((ch == 'm') || (ch == 'M'))
+        else
         {
-            parameters.missing_value_code = value;
-            continue;
+            /* an error in a subroutine, after its message */
+            ret_val = library_exit_code;
         }
-        if((ch == 'w') || (ch == 'W'))
+        if( (ret_val == 0) && (thread_error != 0) )
         {
-            parameters.window_size = value;
-            continue;
+            /* an error kept by Thread_Error that no Check_Thread_Error has exited with */
+            ret_val = thread_error;
         }
-        if((ch == 'r') || (ch == 'R'))
+        thread_error = 0;
+        library_running = 0;
+        /* what the run allocated, also after an error */
+        Free_Conv_State();
+        Release_Input();
+        mat_out = NULL;
+        mat_outfloat = NULL;
+    }
+    return(ret_val);
+}
+
+/* 1.4.0, the body of Spatcon_Run, within its lock and with the return point of Library_Exit set */
+long int Library_Conv(struct run_parameters *run, unsigned char *map_in, long int n_rows, long int n_cols,
+                      long int *recode_table, void *map_out)
+{
+    long int ret_val, index, first_seen_table[256], *first_seen;
+    struct io_maps no_maps = {-1,-1,0,0,NULL,NULL,NULL,NULL};
+    parameters = (*run);
+    maps = no_maps;
+    mat_in = NULL;
+    mat_out = NULL;
+    mat_outfloat = NULL;
+    parameters.io_mode = 0;
+    parameters.stream_rows = 0;
+    parameters.memory_mb = 0;
+    parameters.stream_cols = 0;
+#if defined(SPATCON_GEOTIFF)
+    memset(&geotiff, 0, sizeof(geotiff));
+#endif
+    if( (ret_val = Check_Run_Parameters()) != 0)
+    {
+        return(ret_val);
+    }
+    if(parameters.recode == 1)
+    {
+        for(index = 0; index < 256; index++)
         {
-            parameters.map_rule = value;
-            continue;
+            if( (recode_table[index] < 0) || (recode_table[index] > 255) )
+            {
+                printf("Spatcon: error in recode table. New value must be in range [0,255].\n");
+                return(14);
+            }
         }
-        if((ch == 'h') || (ch == 'H'))
+        /* recoding is done in place, on a copy */
+        if( (mat_in = (unsigned char *)malloc(n_rows * n_cols) ) == NULL)
         {
-            parameters.handle_missing = value;
-            continue;
+            printf("\nSpatcon: Error. Not enough memory for input data.\n");
+            return(19);
         }
-        if((ch == 'a') || (ch == 'A'))
+        memcpy(mat_in, map_in, n_rows * n_cols);
+    }
+    else
+    {
+        mat_in = map_in;
+        maps.in_caller = map_in;
+    }
+    /* Freq_Conv writes into the caller's buffer instead of allocating mat_out */
+    if(parameters.outfloat == 1)
+    {
+        mat_outfloat = (float *)map_out;
+    }
+    else
+    {
+        mat_out = (unsigned char *)map_out;
+    }
+    Set_Window_Constants(parameters.window_size);
+    first_seen = NULL;
+    if( (parameters.recode == 1) || (Uses_Rule(6) == 1) || (Uses_Rule(7) == 1) )
+    {
+        first_seen = first_seen_table;
+        Load_Map(n_rows, n_cols, (parameters.recode == 1) ? recode_table : NULL,
+                 (Uses_Rule(6) == 1) || (Uses_Rule(7) == 1), first_seen);
+    }
+    ret_val = Freq_Conv(n_rows, n_cols,
+                        parameters.missing_value_code,
+                        parameters.n_windows,
+                        parameters.window_sizes,
+                        parameters.n_rules,
+                        parameters.map_rules,
+                        parameters.handle_missing,
+                        parameters.code_1,
+                        parameters.code_2,
+                        first_seen);
+    if(ret_val != 0)
+    {
+        printf("\nSpatcon: Error in run parameters.\n");
+        return(22);
+    }
+    return(0);
+}
+
+/*   ***********
+     Spatcon_IDL
+     ***********
+    1.4.0, Spatcon_Run for IDL (see PRO spatcon in guidostoolbox.pro):
+        ret = CALL_EXTERNAL(library, 'Spatcon_IDL', map_in, n_rows, n_cols, codes, values, n_pars, map_out [, recode])
+    map_in is bytarr(ncols, nrows) and map_out bytarr or fltarr(ncols, nrows, n_bands), or with a
+    g line fltarr((ncols + g - 1) / g, (nrows + g - 1) / g, n_bands) (or bytarr). codes (bytes) and
+    values (LONG64) are the n_pars lines of the parameter file, e.g. codes = byte('wrahbmf'). n_rows, n_cols
+    and n_pars are LONG64, and recode (LONG64, 256 new values) is needed with z 1. Returns 0 or the exit
+    code, as an IDL LONG.
+*/
+int Spatcon_IDL(int argc, void *argv[])
+{
+    struct run_parameters run = {0,0,0,1,0,0,0,0,0,0,0,0,{0},0,{0},0,0,0,0,0,1};
+    long long *values, *new_values;
+    unsigned char *codes;
+    long int index, n_pars, recode_table[256];
+    if( (argc != 7) && (argc != 8) )
+    {
+        printf("\nSpatcon: Error. Spatcon_IDL takes 7 or 8 arguments.\n");
+        return(10);
+    }
+    codes = (unsigned char *)argv[3];
+    values = (long long *)argv[4];
+    n_pars = (long int)(*((long long *)argv[5]));
+    for(index = 0; index < n_pars; index++)
+    {
+        if(Set_Parameter(&run, (char)codes[index], (long int)values[index]) != 0)
         {
-            parameters.code_1 = value;
-            continue;
+            printf("\nSpatcon: Error in parameter %c %lld.\n", codes[index], values[index]);
+            return(12);
         }
-        if((ch == 'b') || (ch == 'B'))
+    }
+    for(index = 0; index < 256; index++)
+    {
+        recode_table[index] = index;
+    }
+    if(argc == 8)
+    {
+        new_values = (long long *)argv[7];
+        for(index = 0; index < 256; index++)
         {
-            parameters.code_2 = value;
-            continue;
+            recode_table[index] = (long int)new_values[index];
         }
-        if((ch == 'z') || (ch == 'Z'))
+    }
+    else if(run.recode == 1)
+    {
+        printf("\nSpatcon: Error. No recode table for parameter z 1.\n");
+        return(13);
+    }
+    return((int)Spatcon_Run(&run, (unsigned char *)argv[0], (long int)(*((long long *)argv[1])),
+                            (long int)(*((long long *)argv[2])), recode_table, argv[6]));
+}
+
+/*   ************
+     Library_Exit
+     ************
+    1.4.0, exit() of the library build: back to Spatcon_Run, which returns code. Like exit() it never
+    returns, as the code after every exit() call assumes. The longjmp leaves the run between any two
+    statements, so a run keeps everything it allocates in conv_state or mat_in, which Spatcon_Run
+    frees, and opens no file, mapping or GeoTIFF (parameters i and s are ignored, see Library_Conv).
+    A thread cannot jump out of a parallel region: the subroutines that run there report errors with
+    Thread_Error instead. Should exit() still be reached from a thread, or outside Spatcon_Run, there
+    is no run to go back to and the process ends with code, as the executable would.
+*/
+void Library_Exit(int code)
+{
+    if( (library_running == 0) || (omp_in_parallel() != 0) )
+    {
+        printf("\nSpatcon: Error %d outside the serial part of Spatcon_Run, ending the process.\n", code);
+        fflush(stdout);
+        (exit)(code);
+    }
+    library_exit_code = code;
+    longjmp(library_return, 1);
+}
+#endif
+
+/*   *********************
+     Read_Parameter_File
+     *********************
+*/
+long int Read_Parameter_File(FILE *parfile)
+{
+    static char ch;
+    static long int value, flag;
+    value = -99;
+    flag = 1;
+    while(flag == 1)
+    {
+        if (fscanf(parfile,"%s %ld", &ch, &value) != 2)
         {
-            parameters.recode = value;
+            flag = 0;
             continue;
         }
-        if((ch == 'f') || (ch == 'F'))
+        if(Set_Parameter(&parameters, ch, value) != 0)
         {
-            parameters.outfloat = value;
-            continue;
+            return(1);
         }
-        return(1);
     }
     if(value == -99)
     {
@@ -586,30 +1443,363 @@ long int Read_Parameter_File(FILE *parfile)
     }
     return(0);
 }
-/*   ***********
-     Freq_Conv.C
-     ***********
-*/
-/* **********************************************************************
-  FREQCONV.C  A program to do a spatial convolution on a raster image, based
-                  on the frequency distribution of pixel values or pixel edge (adjacency) values
-                  within a spatial mask or window.
-   Parameters:
-        Number of rows and columns in the input matrix.
-        Missing value code
-        Run options (see below)
-                Window size
-                Mapping rule
-                Handling of 'missing' values
-                'Selected' code 1
-				'Selected' code 2
 
-                **********************
-                |     Run Options    |
-                **********************
-Window size:
-        3 = 3x3
-        5 = 5x5
+/*   ********************
+     Check_Run_Parameters
+     ********************
+    1.4.0, the parameter checks that used to be in main, shared with Spatcon_Run. Supplies the
+    single window size and mapping rule if there was no w or r line. Returns 0 if the parameters
+    are acceptable, otherwise the exit code of the error.
+*/
+long int Check_Run_Parameters(void)
+{
+    long int index;
+    if(parameters.n_windows == 0)
+    {
+        /* no w line, Check_Conv_Options will reject the window size */
+        parameters.window_sizes[0] = parameters.window_size;
+        parameters.n_windows = 1;
+    }
+    if(parameters.n_rules == 0)
+    {
+        /* no r line, Check_Conv_Options will reject the mapping rule */
+        parameters.map_rules[0] = parameters.map_rule;
+        parameters.n_rules = 1;
+    }
+    if( (parameters.io_mode < 0) || (parameters.io_mode > 1) )
+    {
+        printf("\nSpatcon: Error. Value for _i_ parameter is not valid.\n");
+        return(46);
+    }
+    if(parameters.stream_rows < 0)
+    {
+        printf("\nSpatcon: Error. Value for _s_ parameter is not valid.\n");
+        return(50);
+    }
+    if( (parameters.engine < 0) || (parameters.engine > 4) )
+    {
+        printf("\nSpatcon: Error. Value for _e_ parameter is not valid.\n");
+        return(51);
+    }
+    if(parameters.tile_cols < 0)
+    {
+        printf("\nSpatcon: Error. Value for _t_ parameter is not valid.\n");
+        return(55);
+    }
+    if( (parameters.schedule < 0) || (parameters.schedule > 3) )
+    {
+        printf("\nSpatcon: Error. Value for _o_ parameter is not valid.\n");
+        return(56);
+    }
+    if(parameters.memory_mb < 0)
+    {
+        printf("\nSpatcon: Error. Value for _k_ parameter is not valid.\n");
+        return(58);
+    }
+    if( (parameters.compression < 0) || (parameters.compression > 2) )
+    {
+        printf("\nSpatcon: Error. Value for _c_ parameter is not valid.\n");
+        return(62);
+    }
+    if(parameters.grain < 1)
+    {
+        printf("\nSpatcon: Error. Value for _g_ parameter is not valid.\n");
+        return(63);
+    }
+    /* before the convolution threads start, Freq_Filters_Float has no value for these */
+    for(index = 0; (parameters.outfloat == 1) && (index < parameters.n_rules); index++)
+    {
+        if( (parameters.map_rules[index] == 1) || (parameters.map_rules[index] == 6) ||
+                (parameters.map_rules[index] == 7) || (parameters.map_rules[index] == 10) )
+        {
+            printf("\nSpatcon: Error. Float output not available for this mapping rule.\n");
+            return(30);
+        }
+    }
+    return(0);
+}
+
+/*   *************
+     Set_Parameter
+     *************
+    1.4.0, one line of the parameter file, code ch and its value, into run. Returns 1 if ch is not a
+    parameter code or there are too many w or r lines, else 0. Shared with Spatcon_IDL.
+*/
+long int Set_Parameter(struct run_parameters *run, char ch, long int value)
+{
+    if((ch == 'm') || (ch == 'M'))
+    {
+        run->missing_value_code = value;
+        return(0);
+    }
+    if((ch == 'w') || (ch == 'W'))
+    {
+        /* 1.4.0, every w line adds a window size and an output band */
+        if(run->n_windows == MAX_WINDOWS)
+        {
+            printf("\nSpatcon: Error. No more than %d window sizes (_w_ lines).\n", MAX_WINDOWS);
+            return(1);
+        }
+        run->window_sizes[run->n_windows] = value;
+        run->n_windows++;
+        run->window_size = value;
+        return(0);
+    }
+    if((ch == 'r') || (ch == 'R'))
+    {
+        /* 1.4.0, every r line adds a mapping rule and an output band */
+        if(run->n_rules == MAX_RULES)
+        {
+            printf("\nSpatcon: Error. No more than %d mapping rules (_r_ lines).\n", MAX_RULES);
+            return(1);
+        }
+        run->map_rules[run->n_rules] = value;
+        run->n_rules++;
+        run->map_rule = value;
+        return(0);
+    }
+    if((ch == 'h') || (ch == 'H'))
+    {
+        run->handle_missing = value;
+        return(0);
+    }
+    if((ch == 'a') || (ch == 'A'))
+    {
+        run->code_1 = value;
+        return(0);
+    }
+    if((ch == 'b') || (ch == 'B'))
+    {
+        run->code_2 = value;
+        return(0);
+    }
+    if((ch == 'z') || (ch == 'Z'))
+    {
+        run->recode = value;
+        return(0);
+    }
+    if((ch == 'f') || (ch == 'F'))
+    {
+        run->outfloat = value;
+        return(0);
+    }
+    if((ch == 'i') || (ch == 'I'))
+    {
+        run->io_mode = value;
+        return(0);
+    }
+    if((ch == 's') || (ch == 'S'))
+    {
+        run->stream_rows = value;
+        return(0);
+    }
+    if((ch == 'e') || (ch == 'E'))
+    {
+        run->engine = value;
+        return(0);
+    }
+    if((ch == 't') || (ch == 'T'))
+    {
+        run->tile_cols = value;
+        return(0);
+    }
+    if((ch == 'o') || (ch == 'O'))
+    {
+        run->schedule = value;
+        return(0);
+    }
+    if((ch == 'k') || (ch == 'K'))
+    {
+        run->memory_mb = value;
+        return(0);
+    }
+    if((ch == 'c') || (ch == 'C'))
+    {
+        run->compression = value;
+        return(0);
+    }
+    if((ch == 'g') || (ch == 'G'))
+    {
+        run->grain = value;
+        return(0);
+    }
+    return(1);
+}
+
+/*   *****************************************
+     Memory-mapped input and output (1.4.0)
+     *****************************************
+    With parameter i = 1 the input bsq is mapped read-only (copy-on-write if it has to be recoded
+    in place) and mat_in points into the mapping. The output bsq is pre-sized with ftruncate and
+    mapped shared, so Freq_Conv fills the file pages directly and nothing is copied by fwrite.
+    The pages are backed by the files, so the kernel can drop them under memory pressure.
+    Until Unmap_Output_File has cut the output to its size, an exit removes it (Remove_Output).
+*/
+unsigned char *Map_Input_File(char *filename, long int n_bytes)
+{
+#if !defined(_WIN32)
+    struct stat file_stat;
+    int prot, flags;
+    void *address;
+    if( (maps.in_fd = open(filename, O_RDONLY) ) < 0)
+    {
+        printf("\nSpatcon: Error opening input file %s\n", filename);
+        exit(15);
+    }
+    if( (fstat(maps.in_fd, &file_stat) != 0) || (file_stat.st_size < n_bytes) )
+    {
+        printf("\nSpatcon: Error reading input file. Incorrect file size.\n");
+        exit(20);
+    }
+    /* re-coding is done in place, so those pages must be private and writable */
+    prot = PROT_READ;
+    flags = MAP_SHARED;
+    if(parameters.recode == 1)
+    {
+        prot = PROT_READ | PROT_WRITE;
+        flags = MAP_PRIVATE;
+    }
+    address = mmap(NULL, n_bytes, prot, flags, maps.in_fd, 0);
+    if(address == MAP_FAILED)
+    {
+        printf("\nSpatcon: Error. Memory mapping of input file %s failed.\n", filename);
+        exit(47);
+    }
+    /* the convolution reads rows in order, let the kernel read ahead */
+    posix_madvise(address, n_bytes, POSIX_MADV_SEQUENTIAL);
+    maps.in_length = n_bytes;
+    maps.in_map = (unsigned char *)address;
+    return(maps.in_map);
+#else
+    return(NULL);
+#endif
+}
+
+void Release_Input(void)
+{
+    if( (maps.in_caller != NULL) && (mat_in == maps.in_caller) )
+    {
+        /* 1.4.0, the caller of Spatcon_Run owns the map */
+        maps.in_caller = NULL;
+        mat_in = NULL;
+        return;
+    }
+#if !defined(_WIN32)
+    if(maps.in_map != NULL)
+    {
+        munmap(maps.in_map, maps.in_length);
+        close(maps.in_fd);
+        maps.in_map = NULL;
+        maps.in_fd = -1;
+        mat_in = NULL;
+        return;
+    }
+#endif
+    free(mat_in);
+    mat_in = NULL;
+}
+
+void *Map_Output_File(long int n_bytes)
+{
+#if !defined(_WIN32)
+    void *address;
+    /* a freshly extended file reads as zeros, the same as the calloc it replaces */
+    if(ftruncate(maps.out_fd, n_bytes) != 0)
+    {
+        printf("\nSpatcon: Error. Not enough disk space for the output file.\n");
+        exit(48);
+    }
+    address = mmap(NULL, n_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, maps.out_fd, 0);
+    if(address == MAP_FAILED)
+    {
+        printf("\nSpatcon: Error. Memory mapping of the output file failed.\n");
+        exit(48);
+    }
+    maps.out_length = n_bytes;
+    maps.out_map = address;
+    return(address);
+#else
+    return(NULL);
+#endif
+}
+
+/* Unmap the output and cut the file back to n_bytes (the buffer around the map is at the end) */
+long int Unmap_Output_File(long int n_bytes)
+{
+#if !defined(_WIN32)
+    long int ret_val;
+    ret_val = 0;
+    if(munmap(maps.out_map, maps.out_length) != 0)
+    {
+        ret_val = 1;
+    }
+    if(ftruncate(maps.out_fd, n_bytes) != 0)
+    {
+        ret_val = 1;
+    }
+    if(close(maps.out_fd) != 0)
+    {
+        ret_val = 1;
+    }
+    maps.out_map = NULL;
+    maps.out_fd = -1;
+    if(ret_val == 0)
+    {
+        /* the output is complete */
+        maps.out_name = NULL;
+    }
+    return(ret_val);
+#else
+    return(1);
+#endif
+}
+
+/* Remove the output file of i = 1 at an exit before it was complete (registered with atexit by main) */
+void Remove_Output(void)
+{
+#if !defined(_WIN32)
+    if(maps.out_name == NULL)
+    {
+        return;
+    }
+    if(maps.out_map != NULL)
+    {
+        munmap(maps.out_map, maps.out_length);
+        maps.out_map = NULL;
+    }
+    if(maps.out_fd >= 0)
+    {
+        close(maps.out_fd);
+        maps.out_fd = -1;
+    }
+    unlink(maps.out_name);
+    maps.out_name = NULL;
+#endif
+}
+/*   ***********
+     Freq_Conv.C
+     ***********
+*/
+/* **********************************************************************
+  FREQCONV.C  A program to do a spatial convolution on a raster image, based
+                  on the frequency distribution of pixel values or pixel edge (adjacency) values
+                  within a spatial mask or window.
+   Parameters:
+        Number of rows and columns in the input matrix.
+        Missing value code
+        Run options (see below)
+                Number of window sizes and the window sizes (1.4.0, one output band each)
+                Number of mapping rules and the mapping rules (1.4.0, one output band each)
+                Handling of 'missing' values
+                'Selected' code 1
+				'Selected' code 2
+
+                **********************
+                |     Run Options    |
+                **********************
+Window size:
+        3 = 3x3
+        5 = 5x5
           ...
 
 Mapping rule
@@ -669,7 +1859,8 @@ If n1 < n2 the value decreases with n2 from 127 to 2.
 ******************************
         1. Window size is odd, minimum 3, no maximum.
         2. The window is square.
-        3. Output grain size is 1. (used to allow grain size = window size)
+        3. Output grain size is parameter g, 1 by default: a window at every g-th row and column,
+           each window giving one output pixel (see g in the parameter file format).
         4. The output grain is square. (obsolete)
         5. The window size must be <= # rows and # columns of the data matrix
         7. The diversity values are calculated so that they end up on a
@@ -705,600 +1896,4148 @@ NOTES:
            Code 0 is returned whenever the window is all missing.
 
 *********************************************************************** */
-long int Freq_Conv(long int n_rows_in, long int n_cols_in, long int missing, long int window_size,
-                   long int mapping_rule, long int handle_missing, long int code_1, long int code_2)
-{
-    long int okay, counter, n_colors_in_image, edge_freq,
-         color_freq, array_length, preserve_original_colors, t1, t2;
-    long int n_rows, n_cols, buff_b, temp_int,
-         n_places_right, n_places_down, row, col, index, pos_in,
-         grain_row, grain_col, grain_size, r, c, r_min, r_max, c_min, c_max,
-         grain_start_row, grain_start_col, new_c_min, new_c_max;
-    unsigned char map_value;
-    float map_value_float;
-    long int in_to_out[256], out_to_in[256];
-    unsigned char *mat_temp;
+long int Freq_Conv(long int n_rows_in, long int n_cols_in, long int missing, long int n_windows,
+                   long int *window_sizes, long int n_rules, long int *map_rules, long int handle_missing,
+                   long int code_1, long int code_2, long int *first_seen)
+{
+    long int counter, n_colors_in_image[2], preserve_original_colors, ret_val;
+    long int n_rows, buff_b, temp_int,
+         n_places_right, n_places_down, row, index,
+         grain_size, window_size, max_window_size, band, band_size, out_length, n_groups, group, rule;
+    long int in_to_out[2][256], out_to_in[2][256], first_table[256];
+    unsigned char **rows;
+    struct conv_specs *specs;
+    struct rule_group groups[4];
     // for omp, declare this inside the loop over rows
 //	 long int *freq_ptr;
-    grain_size = 1; /* this used to be variable but is fixed now*/
+    grain_size = parameters.grain; /* 1.4.0, variable again (parameter g), 1 by default */
 
-    for(temp_int=0; temp_int<256; temp_int++)
-    {
-        in_to_out[temp_int] = -9;
-        out_to_in[temp_int] = -9;
-    }
-    /* Process hardwired restrictions */
-    /* Window size is odd, minimum 3 */
-    if( (temp_int = window_size % 2) == 0)
-    {
-        return(1);
-    }
-    if( window_size < 3)
+    /* Process hardwired restrictions and check the run options */
+    max_window_size = 0;
+    for(band = 0; band < n_windows; band++)
     {
-        return (2);
-    }
-    /* Window size must be <= # rows and # columns of the data matrix */
-    if( (window_size > n_rows_in) || (window_size > n_cols_in) )
-    {
-        printf("\nSpatcon: Error. Window dimension is larger than the input map dimension(s).\n");
-        return(5);
-    }
-    /* See if original or local color codes will be used */
-    /* if it's lpts, don't recode again, but later just use first three
-       positions in array.  the arithmetic operators need to know real value*/
-    if( ( (mapping_rule > 19) && (mapping_rule < 30) ) || /* avgs and medians need real numbers*/
-           (mapping_rule == 6) || (mapping_rule == 7) )
-    {
-        preserve_original_colors = 1;   
-        for(temp_int=0; temp_int<256; temp_int++)
+        for(rule = 0; rule < n_rules; rule++)
         {
-            in_to_out[temp_int] = temp_int;
-            out_to_in[temp_int] = temp_int;
+            if( (ret_val = Check_Conv_Options(n_rows_in, n_cols_in, window_sizes[band], map_rules[rule],
+                                              handle_missing)) != 0)
+            {
+                return(ret_val);
+            }
         }
-        in_to_out[0] = missing;
-        out_to_in[missing] = 0;
+        max_window_size = max(max_window_size, window_sizes[band]);
     }
-    else
+    /* 1.4.0, rules that use the same color codes and counts are convolved together */
+    n_groups = Group_Rules(groups);
+    /* See if original or local color codes will be used, [0] = local codes, [1] = original */
+    for(group = 0; group < n_groups; group++)
     {
-        preserve_original_colors = 0;
+        preserve_original_colors = groups[group].preserve;
+        Init_Color_Tables(in_to_out[preserve_original_colors], out_to_in[preserve_original_colors],
+                          groups[group].rules[0], missing);
     }
-    /* Check code for handling missing values of the matrix */
-    if( (handle_missing > 2) || (handle_missing < 1) )
+    /* Initialize some resources and other preparations */
+    /* 1.4.0, the data matrix is no longer copied to a buffered matrix with local color codes. */
+    /*   Conv_Row reads mat_in directly, treating pixels outside the map as missing, and writes */
+    /*   the output of each rule and window size to its band of mat_out, nrows x ncols */
+    /* The convolution proceeds in steps of grain_size rows and columns, the first window */
+    /*   centered on the first pixel, and there is one output pixel for each window placement */
+    /* The number of placements from left to right is... */
+    if( (temp_int = n_cols_in % grain_size) == 0)
     {
-        printf("\nSpatcon: Error. Value for _h_ parameter is not valid.\n");
-        return(7);
+        n_places_right = n_cols_in / grain_size;
     }
-    /* Check for acceptable code for mapping rule */
-    okay=0;
-    for(temp_int = 0; temp_int < NUM_MAP_RULES_DEFINED; temp_int++)
+    else
     {
-        if(mapping_rule == ok_mapping_rule[temp_int])
-        {
-            okay=1;
-            break;
-        }
+        n_places_right = (n_cols_in / grain_size) + 1;
     }
-    if(!okay)
+    /* The number of placements from top to bottom is... */
+    if( (temp_int = n_rows_in % grain_size) == 0)
     {
-        printf("\nSpatcon: Error. Value for parameter _r_ is not valid.\n");
-        return(8);
+        n_places_down = n_rows_in / grain_size;
     }
-    /* Initialize some resources and other preparations */
-    /* First, make a copy of the data matrix, buffering it all around, */
-    /*   sizing it to a full multiple of window_size, and re-coding colors */
-    /*   if required */
-    buff_b = (window_size - 1) / 2;  /* one side of image */
-    n_cols = n_cols_in + (2 * buff_b);
-    n_rows = n_rows_in + (2 * buff_b);
-    printf("Spatcon: Convolution specs:\n     - Padded matrix has %ld cols and %ld rows.\n",
-           n_cols, n_rows);
-    /* Allocate resources for the mat_temp to hold buffered input map */
-    if( (mat_temp = (unsigned char *)calloc( (n_rows*n_cols), sizeof(unsigned char) ) ) == NULL )
-    {
-        printf("\nSpatcon: Error. Not enough memory for output data.\n");
-        exit(25);
-    }
-    /* Copy over the data matrix, buffering all around */
-    printf("          - moving input data to padded matrix\n");
-    /*  Zero is used locally for the missing value code */
-    for(row = 0; row < buff_b; row++)            /* buffer the top */
+    else
     {
-        index = row * n_cols;
-        for(col = 0; col < n_cols; col++)
-        {
-            *(mat_temp + index + col) = 0;
-        }
+        n_places_down = (n_rows_in / grain_size) + 1;
     }
+    band_size = n_places_down * n_places_right;
+    out_length = n_windows * n_rules * band_size;
+    printf("Spatcon: Convolution specs:\n     - Output matrix has %ld cols and %ld rows, %ld band(s).\n",
+           n_places_right, n_places_down, n_windows * n_rules);
+    /*  Zero is used locally for the missing value code */
+    n_colors_in_image[1] = 255;  /* original colors */
     counter = 0;  /* if recoding,incremented when new colors are found, starting at 1*/
-    for(row = buff_b; row < (buff_b + n_rows_in); row++)
+    for(group = 0; group < n_groups; group++)
     {
-        index = row * n_cols;
-        for(col = 0; col < buff_b; col++)      /* buffer the left */
-        {
-            *(mat_temp + index + col) = 0;
-        }
-        if(preserve_original_colors == 0)      /* permit re-coding */
-        {
-            for(col = buff_b; col < (buff_b + n_cols_in); col++)
-            {
-                /* equivalent position in mat_in */
-                pos_in = ((row - buff_b) * n_cols_in) + (col - buff_b);
-                /* Assign new type code if needed, checking for missing */
-                temp_int = (*(mat_in + pos_in));
-                if( out_to_in[temp_int] == -9)
-                {
-                    /* A new code was found */
-                    if( temp_int == missing)
-                    {
-                        out_to_in[temp_int] = 0;
-                        in_to_out[0] = temp_int;
-                    }
-                    else
-                    {
-                        counter++;
-                        out_to_in[temp_int] = counter;
-                        in_to_out[counter] = temp_int;
-                    }
-                }
-                *(mat_temp + index + col) = out_to_in[temp_int];
-            }
-        }
-        else        /* just use original codes, taking care of missing values */
+        if(groups[group].preserve == 0)      /* permit re-coding */
         {
-            for(col = buff_b; col < (buff_b + n_cols_in); col++)
+            printf("          - finding color codes\n");
+            /* 1.4.0, where each byte value is first found, from main's pass over the map if it made one */
+            if(first_seen == NULL)
             {
-                /* equivalent position in mat_in */
-                pos_in = ((row - buff_b) * n_cols_in) + (col - buff_b);
-                temp_int = (*(mat_in + pos_in));
-                *(mat_temp + index + col) = out_to_in[temp_int];
+                first_seen = first_table;
+                Load_Map(n_rows_in, n_cols_in, NULL, 0, first_seen);
             }
-            counter = 255;  /* this will become n_colors_in_image below*/
-        }
-        for(col = (buff_b + n_cols_in); col < n_cols; col++)
-        {
-            *(mat_temp + index + col) = 0;   /* buffer the right */
+            Number_Colors(first_seen, missing, in_to_out[0], out_to_in[0], &counter);
+            break;
         }
     }
-    for(row = (buff_b + n_rows_in); row < n_rows; row++)   /*buffer the bottom*/
+    n_colors_in_image[0] = counter;  /* does not include missing */
+    /* alter user-specified special codes to local codes */
+    for(group = 0; group < n_groups; group++)
     {
-        index = row * n_cols;
-        for(col = 0; col < n_cols; col++)
-        {
-            *(mat_temp + index + col) = 0;
-        }
+        parameters.code_1 = code_1;
+        parameters.code_2 = code_2;
+        Set_Local_Target_Codes(out_to_in[groups[group].preserve], groups[group].n_rules, groups[group].rules);
+        groups[group].code_1 = parameters.code_1;
+        groups[group].code_2 = parameters.code_2;
     }
-    n_colors_in_image = counter;  /* does not include missing */
-    /* alter user-specified special codes to local codes */
-    parameters.code_1 = out_to_in[parameters.code_1];
-    parameters.code_2 = out_to_in[parameters.code_2];
-// Dec 2022 bug fix to ensure input map has the selected values for a and/or b;
-    if( (mapping_rule > 74) && (mapping_rule < 84) )
+    /* mat_in will be convolved to mat_out, it is released after the convolution */
+    /* Allocate resources for the mat_out or mat_outfloat, pointer declared in common area*/
+    /* mat_out -- This will always be an 8-bit map of scores, colors, etc. */
+    /* added mat_outfloat Sept08, 32-bit floats */
+    if(parameters.io_mode == 1)
     {
-        if(parameters.code_1 == -9)
+        /* 1.4.0, the output file itself is the output matrix */
+        if(parameters.outfloat == 0)
         {
-            printf("Spatcon: Error. The byte value for parameter _a_ was not found in the input data\n");
-            exit(44);
+            mat_out = (unsigned char *)Map_Output_File(out_length);
         }
-    }
-    if( (mapping_rule == 76) || (mapping_rule == 78) || (mapping_rule == 82) || (mapping_rule == 83) )
-    {
-        if(parameters.code_2 == -9)
+        if(parameters.outfloat == 1)
         {
-            printf("Spatcon: Error. The byte value for parameter _b_ was not found in the input data\n");
-            exit(45);
+            mat_outfloat = (float *)Map_Output_File(sizeof(float) * out_length);
         }
     }
-// end of Dec 2022 edits
-    printf("     - Internal codes 1 and 2 are %ld and %ld\n",
-           parameters.code_1,parameters.code_2);
-    /* The matrix with local color codes is now ready to be convolved */
-    /* mat_temp will be convolved to mat_out */
-    /* get rid of mat_in and malloc mat_out*/
-    free(mat_in);
-    /* Allocate resources for the mat_out or mat_outfloat, pointer declared in common area*/
-    /* mat_out -- This will always be an 8-bit map of scores, colors, etc. */
-    /* added mat_outfloat Sept08, 32-bit floats */
-    if(parameters.outfloat == 0)
+    else if( (parameters.outfloat == 0) && (mat_out == NULL) )    // 1.4.0, else the buffer of Spatcon_Run
     {
-        temp_int = n_rows*n_cols;
+        temp_int = out_length;
         if( (mat_out = (unsigned char *)calloc( temp_int, sizeof(unsigned char) ) ) == NULL )
         {
             printf("\nSpatcon: Error. Not enough memory for byte output data.\n");
             exit(26);
         }
     }
-    if(parameters.outfloat == 1)
+    else if( (parameters.outfloat == 1) && (mat_outfloat == NULL) )
     {
-        temp_int = sizeof(float) * n_rows * n_cols;
+        temp_int = sizeof(float) * out_length;
         if( (mat_outfloat = (float *)malloc( temp_int ) ) == NULL )
         {
             printf("\nSpatcon: Error. Not enough memory for float output data, try parameter f = 0.\n");
             exit(27);
         }
     }
-    /* The matrix has been resized and the convolution will proceed in steps of size 1 */
-    /* all of the references to grain size are for when the step size could be somththing other than 1 */
-    /* The number of placements from left to right is... */
-    if( (temp_int = n_cols_in % grain_size) == 0)
+    printf("     - Number of window placements l-->r %ld    t-->b %ld\n", n_places_right,n_places_down);
+    /* 1.4.0, input row pointers for every buffered row, NULL above and below the map */
+    n_rows = n_rows_in + max_window_size - 1;
+    if( (rows = (unsigned char **)malloc( (n_rows * sizeof(unsigned char *)) ) ) == NULL )
     {
-        n_places_right = n_cols_in / grain_size;
+        printf("\nSpatcon: Error. Not enough memory for the row pointers.\n");
+        exit(29);
     }
-    else
+    conv_state.rows = rows;
+    specs = &conv_state.specs;
+    /* Loop thru the image, top to bottom, a row of grains at a time */
+
+//	r_min = 0 - grain_size; // moved to within big do loop below
+// get (from environment) and set numthreads for omp
+    omp_set_num_threads(omp_get_max_threads());
+    printf("     - Parellel processing maximum number of threads (cores) = %d \n", omp_get_max_threads());
+    for(band = 0; band < n_windows; band++)
     {
-        n_places_right = (n_cols_in / grain_size) + 1;
+        window_size = window_sizes[band];
+        if(n_windows > 1)
+        {
+            printf("     - Window size %ld\n", window_size);
+        }
+        buff_b = (window_size - 1) / 2;
+        n_rows = n_rows_in + (2 * buff_b);
+        for(row = 0; row < n_rows; row++)
+        {
+            /* buffered row 'row' is input row row - buff_b */
+            rows[row] = NULL;
+            if( (row >= buff_b) && (row < (buff_b + n_rows_in)) )
+            {
+                rows[row] = mat_in + ((row - buff_b) * n_cols_in);
+            }
+        }
+        /* the output bands of this window size start here */
+        index = band * n_rules * band_size;
+        for(group = 0; group < n_groups; group++)
+        {
+            preserve_original_colors = groups[group].preserve;
+            /* prepare some space for tabulations of edges or colors, depending on rule*/
+            Init_Conv_Specs(specs, window_size, n_cols_in, n_colors_in_image[preserve_original_colors],
+                            groups[group].n_rules, groups[group].rules, handle_missing,
+                            groups[group].code_1, groups[group].code_2, out_to_in[preserve_original_colors]);
+            for(rule = 0; rule < groups[group].n_rules; rule++)
+            {
+                specs->band_offsets[rule] = groups[group].bands[rule] * band_size;
+            }
+            /* 1.4.0, the majority filter stores the original color codes */
+            for(temp_int = 0; temp_int < 256; temp_int++)
+            {
+                specs->color_out[temp_int] = (unsigned char)in_to_out[preserve_original_colors][temp_int];
+            }
+            Use_Conv_Specs(specs);
+            if(parameters.outfloat == 0)
+            {
+                Conv_Band(specs, rows, n_places_down, mat_out + index, NULL, n_places_right);
+            }
+            if(parameters.outfloat == 1)
+            {
+                Conv_Band(specs, rows, n_places_down, NULL, mat_outfloat + index, n_places_right);
+            }
+            Free_Conv_Specs(specs);
+        }
     }
-    /* The number of placements from top to bottom is... */
-    if( (temp_int = n_rows_in % grain_size) == 0)
+    Free_Conv_State();
+    /* get rid of mat_in */
+    Release_Input();
+    return(0);
+}
+
+/*   *******************
+     Check_Conv_Options
+     *******************
+    1.4.0, the run option checks that used to open Freq_Conv, shared with Freq_Conv_Stream.
+    Returns 0 if the options are acceptable, otherwise the Freq_Conv error code.
+*/
+long int Check_Conv_Options(long int n_rows_in, long int n_cols_in, long int window_size,
+                            long int mapping_rule, long int handle_missing)
+{
+    long int okay, temp_int;
+    /* Process hardwired restrictions */
+    /* Window size is odd, minimum 3 */
+    if( (temp_int = window_size % 2) == 0)
     {
-        n_places_down = n_rows_in / grain_size;
+        return(1);
     }
-    else
+    if( window_size < 3)
     {
-        n_places_down = (n_rows_in / grain_size) + 1;
+        return (2);
     }
-    printf("     - Number of window placements l-->r %ld    t-->b %ld\n", n_places_right,n_places_down);
-    /* prepare some space for tabulations of edges or colors, depending on rule*/
-    if( (mapping_rule > 70) && (mapping_rule < 80) )
+    /* Window size must be <= # rows and # columns of the data matrix */
+    if( (window_size > n_rows_in) || (window_size > n_cols_in) )
     {
-        /* will be counting edge types, with regard to order here */
-        printf("     - Counting adjacencies (frequency of pairs of pixel values).\n");
-        edge_freq = 1;
-        color_freq = 0;
-        array_length = (n_colors_in_image + 1) * (n_colors_in_image + 1);
-        // this block was moved to within the big do loop so that gomp can be used
-//		/* malloc an adjacency matrix, allowing for missing values */
-//		array_length = (n_colors_in_image + 1) * (n_colors_in_image + 1);
-//		if( (freq_ptr = (long int *)calloc( array_length, sizeof(long int) ) ) == NULL ) {
-//			printf("\nError: malloc failed in Freq_Conv.\n");
-//			exit(2);
-//		}
+        printf("\nSpatcon: Error. Window dimension is larger than the input map dimension(s).\n");
+        return(5);
     }
-    else     /* will be counting colors */
+    /* Check code for handling missing values of the matrix */
+    if( (handle_missing > 2) || (handle_missing < 1) )
     {
-        color_freq = 1;
-        edge_freq = 0;
-        array_length = n_colors_in_image + 1;
-        printf("     - Counting pixels (frequency of pixel values).\n");
-        // this block was moved to within the big do loop so that gomp can be used
-        /* malloc a freq distn, allowing for missing values */
-//		array_length = n_colors_in_image + 1;
-//		if( (freq_ptr = (long int *)calloc( array_length, sizeof(long int) ) ) == NULL ) {
-//			printf("\nError: malloc failed in Freq_Conv.\n");
-//			exit(2);
-//		}
+        printf("\nSpatcon: Error. Value for _h_ parameter is not valid.\n");
+        return(7);
     }
-    /* Loop thru the image, top to bottom, a row of grains at a time */
+    /* Check for acceptable code for mapping rule */
+    okay=0;
+    for(temp_int = 0; temp_int < NUM_MAP_RULES_DEFINED; temp_int++)
+    {
+        if(mapping_rule == ok_mapping_rule[temp_int])
+        {
+            okay=1;
+            break;
+        }
+    }
+    if(!okay)
+    {
+        printf("\nSpatcon: Error. Value for parameter _r_ is not valid.\n");
+        return(8);
+    }
+    return(0);
+}
 
-//	r_min = 0 - grain_size; // moved to within big do loop below
-// get (from environment) and set numthreads for omp
-    omp_set_num_threads(omp_get_max_threads());
-    printf("     - Parellel processing maximum number of threads (cores) = %d \n", omp_get_max_threads());
-    #pragma omp parallel  for  	 private ( grain_row, temp_int, r, c, c_min, r_min, c_max, r_max, t1, t2, map_value, map_value_float, grain_start_row, grain_start_col, index,  grain_col, new_c_max, new_c_min, row, col, pos_in)
-    for(grain_row = 0; grain_row < n_places_down; grain_row++)
+/*   *********
+     Uses_Rule
+     *********
+    1.4.0, returns 1 if mapping_rule is one of the r lines, else 0
+*/
+long int Uses_Rule(long int mapping_rule)
+{
+    long int index;
+    for(index = 0; index < parameters.n_rules; index++)
+    {
+        if(parameters.map_rules[index] == mapping_rule)
+        {
+            return(1);
+        }
+    }
+    return(0);
+}
+
+/*   ***********
+     Group_Rules
+     ***********
+    1.4.0, sort the mapping rules (r lines) into groups that can be finished from the same counts:
+    the rules of a group use the same color codes (original or local) and all count pixels or all
+    count adjacencies. Returns the number of groups, at most four.
+*/
+long int Group_Rules(struct rule_group *groups)
+{
+    long int n_groups, index, group, preserve, edges, mapping_rule;
+    long int in_to_out[256], out_to_in[256];
+    n_groups = 0;
+    for(index = 0; index < parameters.n_rules; index++)
+    {
+        mapping_rule = parameters.map_rules[index];
+        preserve = Init_Color_Tables(in_to_out, out_to_in, mapping_rule, parameters.missing_value_code);
+        edges = ( (mapping_rule > 70) && (mapping_rule < 80) ) ? 1 : 0;
+        for(group = 0; group < n_groups; group++)
+        {
+            if( (groups[group].preserve == preserve) && (groups[group].edges == edges) )
+            {
+                break;
+            }
+        }
+        if(group == n_groups)
+        {
+            groups[group].preserve = preserve;
+            groups[group].edges = edges;
+            groups[group].n_rules = 0;
+            n_groups++;
+        }
+        groups[group].rules[groups[group].n_rules] = mapping_rule;
+        groups[group].bands[groups[group].n_rules] = index;
+        groups[group].n_rules++;
+    }
+    return(n_groups);
+}
+
+/*   *****************
+     Init_Color_Tables
+     *****************
+    1.4.0, set up in_to_out and out_to_in. Returns preserve_original_colors.
+*/
+long int Init_Color_Tables(long int *in_to_out, long int *out_to_in, long int mapping_rule, long int missing)
+{
+    long int temp_int;
+    for(temp_int=0; temp_int<256; temp_int++)
+    {
+        in_to_out[temp_int] = -9;
+        out_to_in[temp_int] = -9;
+    }
+    /* if it's lpts, don't recode again, but later just use first three
+       positions in array.  the arithmetic operators need to know real value*/
+    if( ( (mapping_rule > 19) && (mapping_rule < 30) ) || /* avgs and medians need real numbers*/
+           (mapping_rule == 6) || (mapping_rule == 7) )
+    {
+        for(temp_int=0; temp_int<256; temp_int++)
+        {
+            in_to_out[temp_int] = temp_int;
+            out_to_in[temp_int] = temp_int;
+        }
+        in_to_out[0] = missing;
+        out_to_in[missing] = 0;
+        return(1);
+    }
+    return(0);
+}
+
+/*   ******************
+     Assign_Color_Codes
+     ******************
+    1.4.0, assign local color codes to the byte values found in one row of the input map.
+    New codes are numbered in the order they are first found, starting at 1; zero is the missing value.
+    Rows must be passed top to bottom so the numbering does not depend on how the map is read.
+*/
+void Assign_Color_Codes(unsigned char *row_in, long int n_cols_in, long int missing,
+                        long int *in_to_out, long int *out_to_in, long int *counter)
+{
+    long int col, temp_int;
+    for(col = 0; col < n_cols_in; col++)
+    {
+        temp_int = (*(row_in + col));
+        if( out_to_in[temp_int] == -9)
+        {
+            /* A new code was found */
+            if( temp_int == missing)
+            {
+                out_to_in[temp_int] = 0;
+                in_to_out[0] = temp_int;
+            }
+            else
+            {
+                (*counter)++;
+                out_to_in[temp_int] = (*counter);
+                in_to_out[(*counter)] = temp_int;
+            }
+        }
+    }
+}
+
+/*   ********
+     Load_Map
+     ********
+    1.4.0, one parallel pass over mat_in that recodes it with recode_table (unless NULL) and sets
+    first_seen[v] to the pixel index where byte value v is first found (row by row), or -1. If check_lpt
+    is 1 only codes 0 thru 3 may be found. Each thread has a contiguous block of rows (static schedule),
+    so the first index it finds of a value is its smallest, and the smallest over the threads is the
+    first in the map. Number_Colors then numbers the colors as Assign_Color_Codes would.
+*/
+void Load_Map(long int n_rows_in, long int n_cols_in, long int *recode_table, long int check_lpt,
+              long int *first_seen)
+{
+    long int row, temp_int;
+    for(temp_int = 0; temp_int < 256; temp_int++)
     {
-//  malloc of freq ptr inside loop, need to free it inside loop also
-//		/* malloc an adjacency matrix, allowing for missing values */
-        long int *freq_ptr = 0;
-        if (edge_freq == 1)
+        first_seen[temp_int] = -1;
+    }
+    #pragma omp parallel private(row, temp_int)
+    {
+        long int first[256], col;
+        unsigned char *row_in;
+        for(temp_int = 0; temp_int < 256; temp_int++)
+        {
+            first[temp_int] = -1;
+        }
+        #pragma omp for schedule(static)
+        for(row = 0; row < n_rows_in; row++)
         {
-            if( (freq_ptr = (long int *)calloc( array_length, sizeof(long int) ) ) == NULL )
+            row_in = mat_in + (row * n_cols_in);
+            if(recode_table != NULL)
+            {
+                for(col = 0; col < n_cols_in; col++)
+                {
+                    (*(row_in + col)) = recode_table[(*(row_in + col))];
+                }
+            }
+            for(col = 0; col < n_cols_in; col++)
             {
-                printf("\nSpatcon: Error. Memory allocation failed in parallel part of Freq_Conv.\n");
-                exit(28);
+                temp_int = (*(row_in + col));
+                if(first[temp_int] < 0)
+                {
+                    first[temp_int] = (row * n_cols_in) + col;
+                }
             }
         }
-        /* malloc a freq distn, allowing for missing values */
-        if(color_freq == 1)
+        #pragma omp critical
         {
-            if( (freq_ptr = (long int *)calloc( array_length, sizeof(long int) ) ) == NULL )
+            for(temp_int = 0; temp_int < 256; temp_int++)
             {
-                printf("\nSpatcon: Error. Memory allocation failed in parallel part of Freq_Conv.\n");
-                exit(29);
+                if( (first[temp_int] >= 0) && ( (first_seen[temp_int] < 0) || (first[temp_int] < first_seen[temp_int]) ) )
+                {
+                    first_seen[temp_int] = first[temp_int];
+                }
             }
         }
-        /* Always zero the freq distn at the start of grain row */
-        for(temp_int = 0; temp_int < array_length; temp_int++)
+    }
+    /* Check, if it's lpt generator, only codes 0 thru 3 allowed*/
+    for(temp_int = 4; (check_lpt == 1) && (temp_int < 256); temp_int++)
+    {
+        if(first_seen[temp_int] >= 0)
+        {
+            printf("\nSpatcon: Error. Input byte value must be in range [0,3] for landscape mosaics.\n");
+            Release_Input();
+            exit(21);
+        }
+    }
+}
+
+/*   ***************
+     First_Seen_Rows
+     ***************
+    1.4.0, the parallel pass of Load_Map for a block of n_rows rows of the map that start at row first_row
+    (the first pass of Freq_Conv_Stream): lowers first_seen[v] to the pixel index where byte value v,
+    re-coded with recode_table unless it is NULL, is first found in the block. The rows are not changed.
+*/
+void First_Seen_Rows(unsigned char **rows, long int n_rows, long int first_row, long int n_cols_in,
+                     long int *recode_table, long int *first_seen)
+{
+    long int row, temp_int;
+    #pragma omp parallel private(row, temp_int)
+    {
+        long int first[256], col;
+        unsigned char *row_in;
+        for(temp_int = 0; temp_int < 256; temp_int++)
         {
-            (*(freq_ptr + temp_int)) = 0;
+            first[temp_int] = -1;
         }
-        /* Seed with the first placement on the left */
-        c_min = 0;
-//		r_min = r_min + grain_size;
-        r_min = grain_row;
-        c_max = window_size;
-        r_max = r_min + window_size;
-        /* Get a frequency distribution of colors or edges within the window*/
-        /*  the window goes from r_min,c_min to r_max-1,c_max-1 */
-        if(color_freq)
+        #pragma omp for schedule(static)
+        for(row = 0; row < n_rows; row++)
         {
-            for(r = r_min; r < r_max; r++)
+            row_in = rows[row];
+            for(col = 0; col < n_cols_in; col++)
             {
-                for(c = c_min; c < c_max; c++)
+                temp_int = (*(row_in + col));
+                if(recode_table != NULL)
                 {
-                    temp_int = (*(mat_temp + (r * n_cols) + c));
-                    (*(freq_ptr + temp_int))++;
+                    temp_int = recode_table[temp_int];
+                }
+                if(first[temp_int] < 0)
+                {
+                    first[temp_int] = ( (first_row + row) * n_cols_in) + col;
                 }
             }
         }
-        if(edge_freq)     /* three loopsets used to avoid lots of if's */
+        #pragma omp critical
         {
-            for(r = r_min; r < r_max-1; r++)    /* all but last row in window*/
+            for(temp_int = 0; temp_int < 256; temp_int++)
             {
-                for(c = c_min; c < c_max-1; c++)    /* all but last col in window*/
+                if( (first[temp_int] >= 0) && ( (first_seen[temp_int] < 0) || (first[temp_int] < first_seen[temp_int]) ) )
                 {
-                    t1 = (*(mat_temp + (r * n_cols) + c));  /*this cell*/
-                    t2 = (*(mat_temp + ((r+1) * n_cols) + c)); /*cell below*/
-                    temp_int = (t1 * (n_colors_in_image + 1)) + t2;
-                    (*(freq_ptr + temp_int))++;
-                    t2 = (*(mat_temp + (r * n_cols) + c + 1)); /*cell at right*/
-                    temp_int = (t1 * (n_colors_in_image + 1)) + t2;
-                    (*(freq_ptr + temp_int))++;
+                    first_seen[temp_int] = first[temp_int];
                 }
             }
-            for(r = r_min; r < r_max-1; r++)    /* look at last column */
+        }
+    }
+}
+
+/*   *************
+     Number_Colors
+     *************
+    1.4.0, assign local color codes to the byte values of the map in the order they are first found
+    (first_seen, see Load_Map), starting at 1; zero is the missing value. Same codes as Assign_Color_Codes
+    given the rows top to bottom.
+*/
+void Number_Colors(long int *first_seen, long int missing, long int *in_to_out, long int *out_to_in,
+                   long int *counter)
+{
+    long int temp_int, next, done[256];
+    for(temp_int = 0; temp_int < 256; temp_int++)
+    {
+        done[temp_int] = (first_seen[temp_int] < 0);
+    }
+    while(1)
+    {
+        next = -1;
+        for(temp_int = 0; temp_int < 256; temp_int++)
+        {
+            if( (done[temp_int] == 0) && ( (next < 0) || (first_seen[temp_int] < first_seen[next]) ) )
+            {
+                next = temp_int;
+            }
+        }
+        if(next < 0)
+        {
+            break;
+        }
+        done[next] = 1;
+        if(next == missing)
+        {
+            out_to_in[next] = 0;
+            in_to_out[0] = next;
+        }
+        else
+        {
+            (*counter)++;
+            out_to_in[next] = (*counter);
+            in_to_out[(*counter)] = next;
+        }
+    }
+}
+
+/*   **********************
+     Set_Local_Target_Codes
+     **********************
+    1.4.0, alter user-specified special codes to local codes and check they are in the map
+    for the rules that need them
+*/
+void Set_Local_Target_Codes(long int *out_to_in, long int n_rules, long int *rules)
+{
+    long int index, mapping_rule;
+    parameters.code_1 = out_to_in[parameters.code_1];
+    parameters.code_2 = out_to_in[parameters.code_2];
+// Dec 2022 bug fix to ensure input map has the selected values for a and/or b;
+    for(index = 0; index < n_rules; index++)
+    {
+        mapping_rule = rules[index];
+        if( (mapping_rule > 74) && (mapping_rule < 84) )
+        {
+            if(parameters.code_1 == -9)
             {
-                t1 = (*(mat_temp + (r * n_cols) + (c_max-1)));  /*this cell*/
-                t2 = (*(mat_temp + ((r+1)*n_cols) +(c_max-1))); /*cell below*/
-                temp_int = (t1 * (n_colors_in_image + 1)) + t2;
-                (*(freq_ptr + temp_int))++;
+                printf("Spatcon: Error. The byte value for parameter _a_ was not found in the input data\n");
+                exit(44);
             }
-            for(c = c_min; c < c_max-1; c++)    /* look at last row */
+        }
+        if( (mapping_rule == 76) || (mapping_rule == 78) || (mapping_rule == 82) || (mapping_rule == 83) )
+        {
+            if(parameters.code_2 == -9)
             {
-                t1 = (*(mat_temp + ((r_max-1) * n_cols) + c));  /*this cell*/
-                t2 = (*(mat_temp + ((r_max-1) * n_cols) + c + 1)); /*cell at right*/
-                temp_int = (t1 * (n_colors_in_image + 1)) + t2;
-                (*(freq_ptr + temp_int))++;
+                printf("Spatcon: Error. The byte value for parameter _b_ was not found in the input data\n");
+                exit(45);
             }
         }
-        /* Call the convolution function for the seed window, passing the distn*/
-        /* call for char or float return depending on output format */
-        if(parameters.outfloat == 0)
+    }
+// end of Dec 2022 edits
+    printf("     - Internal codes 1 and 2 are %ld and %ld\n",
+           parameters.code_1,parameters.code_2);
+}
+
+/*   ***************
+     Init_Conv_Specs
+     ***************
+    1.4.0, collect the settings used by Conv_Row for every row of the run.
+    code_1 and code_2 are the local target codes (see Set_Local_Target_Codes).
+*/
+void Init_Conv_Specs(struct conv_specs *specs, long int window_size, long int n_cols_in,
+                     long int n_colors_in_image, long int n_rules, long int *rules, long int handle_missing,
+                     long int code_1, long int code_2, long int *out_to_in)
+{
+    long int temp_int, index, mapping_rule, all_sat, n_tracked, engine;
+    specs->window_size = window_size;
+    specs->buff_b = (window_size - 1) / 2;
+    specs->n_cols_in = n_cols_in;
+    /* a placement at every grain-th column, see Freq_Conv */
+    specs->grain = parameters.grain;
+    specs->n_places_right = (n_cols_in + specs->grain - 1) / specs->grain;
+    for(temp_int = 0; temp_int < 256; temp_int++)
+    {
+        /* byte values not in the map are never looked up */
+        specs->color_lut[temp_int] = (out_to_in[temp_int] < 0) ? 0 : out_to_in[temp_int];
+    }
+    specs->n_colors_in_image = n_colors_in_image;
+    /* the rules all count pixels or all count adjacencies (see Group_Rules) */
+    specs->n_rules = n_rules;
+    all_sat = 1;
+    n_tracked = 0;
+    for(index = 0; index < n_rules; index++)
+    {
+        mapping_rule = rules[index];
+        specs->mapping_rules[index] = mapping_rule;
+        specs->band_offsets[index] = 0;
+        /* engine 3 is chosen for each rule, so the output of a rule does not depend on the other */
+        /*   rules of the run; the others are finished by their kernel from the same counts */
+        specs->tracked[index] = 1;
+        if( (mapping_rule < 75) || ( (mapping_rule > 78) && (mapping_rule < 81) ) )
         {
-            map_value = Freq_Filters(color_freq, edge_freq, freq_ptr, n_colors_in_image,
-                                     mapping_rule, handle_missing, code_1, code_2);
-            /* Map the results back for this grain */
-            grain_start_row = r_min + buff_b;
-            grain_start_col = c_min + buff_b;
-            index = grain_start_row * n_cols;
-            (*(mat_out + index + grain_start_col)) = map_value;
-            /* End of the seed window for this grain row */
+            all_sat = 0;
         }
-        if(parameters.outfloat == 1)
+        if( ( (mapping_rule < 51) || (mapping_rule > 54) ) && ( (mapping_rule < 71) || (mapping_rule > 74) ) &&
+                (mapping_rule != 1) && (mapping_rule != 20) )
+        {
+            specs->tracked[index] = 0;
+        }
+        /* rule 1 has no float output (Freq_Filters_Float gives the error), and keeping the colors of */
+        /*   each count costs more than finding the majority among the colors of the map unless there */
+        /*   are at least 12 of them for each pixel that enters a row of the window */
+        if( (mapping_rule == 1) && ( (parameters.outfloat == 1) || (12 * window_size > n_colors_in_image) ) )
+        {
+            specs->tracked[index] = 0;
+        }
+        /* the exact sums of rules 51-53 and 71-73 land on the other side of a byte boundary than the */
+        /*   single precision sums of Freq_Filters for many windows (e.g. 0.5 for an even split of 2 */
+        /*   colors), so their 8-bit output comes from Freq_Filters */
+        if( (parameters.outfloat == 0) && ( ( (mapping_rule >= 51) && (mapping_rule <= 53) ) ||
+                                            ( (mapping_rule >= 71) && (mapping_rule <= 73) ) ) )
+        {
+            specs->tracked[index] = 0;
+        }
+        /* rule 20: updating the median pointer with every count costs more than finding the median */
+        /*   again once the window is wider than 21 pixels */
+        if( (mapping_rule == 20) && (window_size > 21) )
+        {
+            specs->tracked[index] = 0;
+        }
+        n_tracked += specs->tracked[index];
+    }
+    mapping_rule = rules[0];
+    specs->handle_missing = handle_missing;
+    specs->code_1 = code_1;
+    specs->code_2 = code_2;
+    if( (mapping_rule > 70) && (mapping_rule < 80) )
+    {
+        /* will be counting edge types, with regard to order here */
+        printf("     - Counting adjacencies (frequency of pairs of pixel values).\n");
+        specs->edge_freq = 1;
+        specs->color_freq = 0;
+        /* an adjacency matrix, allowing for missing values */
+        specs->array_length = (n_colors_in_image + 1) * (n_colors_in_image + 1);
+    }
+    else     /* will be counting colors */
+    {
+        specs->color_freq = 1;
+        specs->edge_freq = 0;
+        /* a freq distn, allowing for missing values */
+        specs->array_length = n_colors_in_image + 1;
+        printf("     - Counting pixels (frequency of pixel values).\n");
+    }
+    specs->engine = 0;
+    engine = parameters.engine;
+    if( (specs->grain > 1) && ( (engine == 1) || (engine == 4) ) )
+    {
+        /* engines 1 and 4 keep counts for every column under the window and move it down one row */
+        /*   at a time, which a coarse grain would not save */
+        printf("     - Engines 1 and 4 are not used with g > 1, using the sliding window.\n");
+        engine = 0;
+    }
+    if(engine == 1)
+    {
+        if(specs->color_freq == 1)
+        {
+            printf("     - Engine: column histograms.\n");
+            specs->engine = 1;
+        }
+        else
         {
-            map_value_float = Freq_Filters_Float(color_freq, edge_freq, freq_ptr, n_colors_in_image,
-                                                 mapping_rule, handle_missing, code_1, code_2);
-            /* Map the results back for this grain */
-            grain_start_row = r_min + buff_b;
-            grain_start_col = c_min + buff_b;
-            index = grain_start_row * n_cols;
-            (*(mat_outfloat + index + grain_start_col)) = map_value_float;
-            /* End of the seed window for this grain row */
+            printf("     - Column histograms are not used for adjacencies, using the sliding window.\n");
         }
-        /* Proceed to the right, subtracting and adding from the freq distn */
-        for(grain_col = 1; grain_col < n_places_right; grain_col++)
+    }
+    if( (engine == 2) || (engine == 4) )
+    {
+        if(all_sat == 1)
         {
-            new_c_min = c_min + grain_size;
-            new_c_max = c_max + grain_size;
-            if(color_freq)
+            /* the rules 75-78 and 8x only need the counts of code_1, code_2 and missing, or of their */
+            /*   adjacencies, so the other pixel values are collapsed to one code: */
+            /*   0 = missing, 1 = code_1, 2 = code_2, 3 = other */
+            if( (engine == 2) && (specs->edge_freq == 1) )
             {
-                for(r = r_min; r < r_max; r++)
-                {
-                    /* Subtract from the left */
-                    for(c = c_min; c < new_c_min; c++)
-                    {
-                        temp_int = (*(mat_temp + (r * n_cols) + c));
-                        (*(freq_ptr + temp_int))--;
-                    }
-                    /* Add from the right */
-                    for(c = c_max; c < new_c_max; c++)
-                    {
-                        temp_int = (*(mat_temp + (r * n_cols) + c));
-                        (*(freq_ptr + temp_int))++;
-                    }
-                }
+                printf("     - Engine: summed-area tables of the adjacencies of code_1, code_2 and missing.\n");
+                specs->engine = 2;
             }
-            if(edge_freq)
+            else if(engine == 2)
             {
-                for(r = r_min; r < r_max-1; r++)    /* all but last row in window*/
+                printf("     - Engine: summed-area tables of code_1, code_2 and missing.\n");
+                specs->engine = 2;
+            }
+            for(temp_int = 0; temp_int < 256; temp_int++)
+            {
+                if(specs->color_lut[temp_int] != 0)
                 {
-                    /* subtract from the left, doing every old column */
-                    for(c = c_min; c < new_c_min; c++)
+                    if(specs->color_lut[temp_int] == code_1)
                     {
-                        t1 = (*(mat_temp + (r * n_cols) + c));  /*this cell*/
-                        t2 = (*(mat_temp + ((r+1) * n_cols) + c)); /*cell below*/
-                        temp_int = (t1 * (n_colors_in_image + 1)) + t2;
-                        (*(freq_ptr + temp_int))--;
-                        t2 = (*(mat_temp + (r * n_cols) + c + 1)); /*cell at right*/
-                        temp_int = (t1 * (n_colors_in_image + 1)) + t2;
-                        (*(freq_ptr + temp_int))--;
+                        specs->color_lut[temp_int] = 1;
                     }
-                    /* Add from the right, doing every new column, looking left and down */
-                    /* the new material comes from the joins on the left*/
-                    for(c = c_max; c < new_c_max; c++)
+                    else if(specs->color_lut[temp_int] == code_2)
                     {
-                        t1 = (*(mat_temp + (r * n_cols) + c));  /*this cell*/
-                        t2 = (*(mat_temp + ((r+1) * n_cols) + c)); /*cell below*/
-                        temp_int = (t1 * (n_colors_in_image + 1)) + t2;
-                        (*(freq_ptr + temp_int))++;
-                        t2 = (*(mat_temp + (r * n_cols) + c -1)); /*cell at left*/
-                        /* note order of t1 and t2 switched in the following, the */
-                        /*  reason...need to store in same order as they will be */
-                        /*  deleted later... */
-                        temp_int = (t2 * (n_colors_in_image + 1)) + t1;
-                        (*(freq_ptr + temp_int))++;
+                        specs->color_lut[temp_int] = 2;
+                    }
+                    else
+                    {
+                        specs->color_lut[temp_int] = 3;
                     }
                 }
-                for(c = c_min; c < new_c_min; c++)    /* look at last row */
-                {
-                    t1 = (*(mat_temp + ((r_max-1) * n_cols) + c));  /*this cell*/
-                    t2 = (*(mat_temp + ((r_max-1) * n_cols) + c + 1)); /*cell at right*/
-                    temp_int = (t1 * (n_colors_in_image + 1)) + t2;
-                    (*(freq_ptr + temp_int))--;
-                }
-                /* add from the right, but looking left again */
-                for(c = c_max; c < new_c_max; c++)
-                {
-                    t1 = (*(mat_temp + (r * n_cols) + c));  /*this cell*/
-                    t2 = (*(mat_temp + (r * n_cols) + c - 1)); /*cell at left*/
-                    /* note the switch of order of t1,t2...see above */
-                    temp_int = (t2 * (n_colors_in_image + 1)) + t1;
-                    (*(freq_ptr + temp_int))++;
+            }
+            if(code_2 > 0)
+            {
+                specs->code_2 = (code_2 == code_1) ? 1 : 2;
+            }
+            if(code_1 > 0)
+            {
+                specs->code_1 = 1;
+            }
+            specs->n_colors_in_image = 3;
+            specs->array_length = 4;
+            if(specs->edge_freq == 1)
+            {
+                specs->array_length = 16;
+            }
+        }
+        else if(engine == 2)
+        {
+            printf("     - Summed-area tables are only used for rules 75-78 and 81-83, using the sliding window.\n");
+        }
+    }
+    if(engine == 4)
+    {
+        if(specs->n_colors_in_image <= 3)
+        {
+            printf("     - Engine: bit planes of %ld pixel values and missing.\n", specs->n_colors_in_image);
+            specs->engine = 4;
+        }
+        else
+        {
+            printf("     - Bit planes are only used for up to 3 pixel values besides missing, using the sliding window.\n");
+        }
+    }
+    specs->max_count = window_size * window_size;
+    if(specs->edge_freq == 1)
+    {
+        specs->max_count = 2 * window_size * (window_size - 1);
+    }
+    /* 2-byte counts while no count can pass 65535 (window sizes up to 255 for colors, 181 for edges),
+       twice as many fit in the cache as 4-byte counts; engine 2 keeps its few counts as 4-byte */
+    specs->count_width = 4;
+    if( (specs->max_count <= 65535) && (specs->engine != 2) )
+    {
+        specs->count_width = 2;
+    }
+    specs->clogc = NULL;
+    if(engine == 3)
+    {
+        if(n_tracked > 0)
+        {
+            printf("     - Engine: sliding window with metric accumulators.\n");
+            specs->engine = 3;
+            if( (specs->clogc = (double *)malloc( (specs->max_count + 1) * sizeof(double) ) ) == NULL )
+            {
+                printf("\nSpatcon: Error. Not enough memory for the metric accumulators.\n");
+                exit(53);
+            }
+            specs->clogc[0] = 0.0;
+            for(temp_int = 1; temp_int <= specs->max_count; temp_int++)
+            {
+                specs->clogc[temp_int] = temp_int * log(1.0 * temp_int);
+            }
+        }
+        if(n_tracked < n_rules)
+        {
+            printf("     - Metric accumulators are only used for rules 54 and 74, rules 51-53 and 71-73 with 32-bit output,\n");
+            printf("       rule 1 with at least 12 pixel values for each row of the window and rule 20 up to w 21;\n");
+            printf("       the other rules use the sliding window.\n");
+        }
+    }
+    if(specs->engine != 3)
+    {
+        for(index = 0; index < n_rules; index++)
+        {
+            specs->tracked[index] = 0;
+        }
+    }
+    /* rules 71-76 read the whole adjacency matrix, but a window has few edge types when there are */
+    /*   many colors; then the sliding window also keeps a bit for each cell whose count is not 0 */
+    /*   and the filters visit only those cells (see Store_Sparse_Value). Keeping the bits costs */
+    /*   about as much as reading the whole matrix when it has 4 cells for each edge of a window. */
+    specs->sparse = 0;
+    if( (specs->engine == 0) && (specs->edge_freq == 1) && (specs->array_length >= SPARSE_MIN_CELLS) &&
+            (specs->array_length >= 4 * specs->max_count) )
+    {
+        for(index = 0; index < n_rules; index++)
+        {
+            if( (rules[index] >= 71) && (rules[index] <= 76) )
+            {
+                specs->sparse = 1;
+            }
+        }
+    }
+    specs->freq_bytes = specs->array_length * specs->count_width;
+    specs->pair_offset = ( (specs->freq_bytes + 7) / 8) * 8;
+    specs->pair_words = (specs->array_length + 63) / 64;
+    if(specs->sparse == 1)
+    {
+        printf("     - Sparse adjacency matrix: only the occupied cells are visited.\n");
+        /* the cell bits, then one bit for each word of them */
+        specs->freq_bytes = specs->pair_offset +
+                            ( (specs->pair_words + ( (specs->pair_words + 63) / 64) ) * sizeof(unsigned long long) );
+    }
+    /* the scratch arenas of the threads: freq_ptr, then the count histogram of engine 3 and the */
+    /*   color bits of each count for rule 1 */
+    specs->hist_offset = ( (specs->freq_bytes + 63) / 64) * 64;
+    specs->colors_offset = specs->hist_offset + ( (specs->max_count + 1) * sizeof(long int) );
+    specs->color_words = (max(specs->n_colors_in_image, 1) + 64) / 64;
+    specs->scratch_bytes = specs->freq_bytes;
+    if(specs->engine == 3)
+    {
+        specs->scratch_bytes = specs->colors_offset;
+        for(index = 0; index < n_rules; index++)
+        {
+            if( (rules[index] == 1) && (specs->tracked[index] == 1) )
+            {
+                specs->scratch_bytes = specs->colors_offset +
+                                       ( (specs->max_count + 1) * specs->color_words * sizeof(unsigned long long) );
+            }
+        }
+    }
+    /* rules 6 and 7 read the class of a window from a table when it is small enough (see Mosaic_Table) */
+    specs->mosaic_table[0] = NULL;
+    specs->mosaic_table[1] = NULL;
+    for(index = 0; index < n_rules; index++)
+    {
+        if( ( (rules[index] == 6) || (rules[index] == 7) ) && (parameters.outfloat == 0) )
+        {
+            specs->mosaic_table[rules[index] - 6] = Mosaic_Table(rules[index], window_size);
+        }
+    }
+    specs->n_scratch = omp_get_max_threads();
+    if( (specs->scratch = (void **)calloc( specs->n_scratch, sizeof(void *) ) ) == NULL )
+    {
+        printf("\nSpatcon: Error. Memory allocation failed in parallel part of Freq_Conv.\n");
+        exit(28);
+    }
+    Select_Kernel(specs);
+}
+
+/*   **************
+     Use_Conv_Specs
+     **************
+    1.4.0, the filters read the window constants and the target codes from the globals constants
+    and parameters; set them for the window size and codes of specs before it is convolved.
+*/
+void Use_Conv_Specs(struct conv_specs *specs)
+{
+    Set_Window_Constants(specs->window_size);
+    parameters.code_1 = specs->code_1;
+    parameters.code_2 = specs->code_2;
+}
+
+/*   ********************
+     Set_Window_Constants
+     ********************
+    calculate some run-specific constants that depend on the window size (1.4.0, moved from main)
+*/
+void Set_Window_Constants(long int window_size)
+{
+    constants.window_area = window_size * window_size;
+    constants.window_area_inverse = 1.0 / constants.window_area;
+    constants.number_of_edges =
+        2. * ( window_size * (window_size - 1. ) );
+    if (constants.number_of_edges > 0)
+    {
+        constants.number_of_edges_inverse = 1.0 / constants.number_of_edges;
+    }
+    else
+    {
+        constants.number_of_edges_inverse = 0.;
+    }
+}
+
+/* 1.4.0, the sliding window helpers below take clamped, tracked and width as constants, which only
+   drop out of the loops if the helpers are inlined; gcc stops inlining the larger ones on its own */
+#if defined(__GNUC__)
+#define SLIDE_INLINE static inline __attribute__((always_inline))
+#else
+#define SLIDE_INLINE static inline
+#endif
+
+/* 1.4.0, local color code of the pixel in buffered column c of a window row (see Conv_Row).
+   clamped is a constant at every call, so the checks are compiled out of the fast path. */
+SLIDE_INLINE long int Window_Pixel(struct conv_specs *specs, unsigned char *row, long int c, int clamped)
+{
+    c = c - specs->buff_b;     /* column in the map */
+    if(clamped)
+    {
+        if( (row == NULL) || (c < 0) || (c >= specs->n_cols_in) )
+        {
+            return(0);
+        }
+    }
+    return(specs->color_lut[(*(row + c))]);
+}
+
+/* 1.4.0, the counts of freq_ptr (and the column histograms of engine 1) are 2-byte counters when
+   no count can pass 65535, else 4-byte, see specs->count_width. width is a constant at every call,
+   like clamped above, so each counter width gets its own copy of the loops. */
+SLIDE_INLINE long int Get_Count(void *counts, long int index, int width)
+{
+    if(width == 2)
+    {
+        return(*((unsigned short *)counts + index));
+    }
+    return(*((unsigned int *)counts + index));
+}
+
+SLIDE_INLINE void Add_Count(void *counts, long int index, long int change, int width)
+{
+    if(width == 2)
+    {
+        (*((unsigned short *)counts + index)) += change;
+    }
+    else
+    {
+        (*((unsigned int *)counts + index)) += change;
+    }
+}
+
+/* 1.4.0, with specs->sparse the counts of the adjacency matrix in freq_ptr are followed by one bit for
+   each cell, set while its count is not 0, and by one bit for each 64-bit word of those that is not 0 */
+static inline unsigned long long *Pair_Bits(struct conv_specs *specs, void *freq_ptr)
+{
+    return( (unsigned long long *)( (char *)freq_ptr + specs->pair_offset) );
+}
+
+/* 1.4.0, update the bits of cell after its count changed by 'change' to count */
+SLIDE_INLINE void Mark_Pair(struct conv_specs *specs, void *freq_ptr, long int cell, long int count,
+                            long int change)
+{
+    unsigned long long *bits, *summary;
+    long int word;
+    bits = Pair_Bits(specs, freq_ptr);
+    summary = bits + specs->pair_words;
+    word = cell >> 6;
+    if( (change > 0) && (count == 1) )
+    {
+        bits[word] |= 1ULL << (cell & 63);
+        summary[word >> 6] |= 1ULL << (word & 63);
+    }
+    if( (change < 0) && (count == 0) )
+    {
+        bits[word] &= ~(1ULL << (cell & 63));
+        if(bits[word] == 0)
+        {
+            summary[word >> 6] &= ~(1ULL << (word & 63));
+        }
+    }
+}
+
+/* 1.4.0, position of the lowest bit that is set, bits is not 0 */
+static inline long int Low_Bit(unsigned long long bits)
+{
+#if defined(__GNUC__)
+    return(__builtin_ctzll(bits));
+#else
+    long int position = 0;
+    while( (bits & 1) == 0)
+    {
+        bits >>= 1;
+        position++;
+    }
+    return(position);
+#endif
+}
+
+/* 1.4.0, the first occupied cell after cell (-1 for the first one), or -1 if there is none.
+   The cells come in increasing order, which is the order of the loops in Freq_Filters. */
+static inline long int Next_Pair(unsigned long long *bits, long int n_words, long int cell)
+{
+    unsigned long long *summary, word_bits;
+    long int word, group, n_groups;
+    summary = bits + n_words;
+    n_groups = (n_words + 63) >> 6;
+    cell++;
+    word = cell >> 6;
+    if(word >= n_words)
+    {
+        return(-1);
+    }
+    word_bits = bits[word] & (~0ULL << (cell & 63));
+    if(word_bits != 0)
+    {
+        return( (word << 6) + Low_Bit(word_bits) );
+    }
+    /* the next word with a bit set */
+    word++;
+    group = word >> 6;
+    if(group >= n_groups)
+    {
+        return(-1);
+    }
+    word_bits = summary[group] & (~0ULL << (word & 63));
+    while(word_bits == 0)
+    {
+        group++;
+        if(group >= n_groups)
+        {
+            return(-1);
+        }
+        word_bits = summary[group];
+    }
+    word = (group << 6) + Low_Bit(word_bits);
+    return( (word << 6) + Low_Bit(bits[word]) );
+}
+
+/* 1.4.0, engine 3, the largest count (rules 1, 54) after a count of color t2 (or of an edge) went from
+   c_old to c_new, kept with the count histogram (rule 54) and the colors of each count (rule 1) */
+SLIDE_INLINE void Track_Max(struct conv_specs *specs, struct metric_acc *acc, long int t2, long int c_old,
+                             long int c_new)
+{
+    unsigned long long bit, *bits;
+    long int word, empty;
+    if(acc->count_colors != NULL)
+    {
+        /* the color moves to the bits of its new count */
+        bit = 1ULL << (t2 & 63);
+        (*(acc->count_colors + (c_old * specs->color_words) + (t2 >> 6))) &= ~bit;
+        (*(acc->count_colors + (c_new * specs->color_words) + (t2 >> 6))) |= bit;
+    }
+    else if(acc->count_hist == NULL)
+    {
+        return;
+    }
+    if(acc->count_hist != NULL)
+    {
+        (*(acc->count_hist + c_old))--;
+        (*(acc->count_hist + c_new))++;
+    }
+    if(c_new > acc->max_count)
+    {
+        acc->max_count = c_new;
+    }
+    else if(c_old == acc->max_count)
+    {
+        /* the last color (or edge) with the largest count went down by one */
+        if(acc->count_hist != NULL)
+        {
+            empty = ( (*(acc->count_hist + c_old)) == 0);
+        }
+        else
+        {
+            bits = acc->count_colors + (c_old * specs->color_words);
+            empty = 1;
+            for(word = 0; word < specs->color_words; word++)
+            {
+                if(bits[word] != 0)
+                {
+                    empty = 0;
+                }
+            }
+        }
+        if(empty)
+        {
+            acc->max_count = c_new;
+        }
+    }
+}
+
+/* 1.4.0, engine 3, bring the metric accumulators up to date after the count in freq_ptr + index
+   changed by 'change' (+1 or -1). For colors t1 is 0 and t2 is the color, for edges t1 and t2 are
+   the colors of the pair in the order of the adjacency matrix. */
+SLIDE_INLINE void Track_Count(struct conv_specs *specs, void *freq_ptr, struct metric_acc *acc,
+                               long int index, long int t1, long int t2, long int change, int width)
+{
+    long int c_new, c_old, u_new;
+    /* only the counts that the metric uses */
+    if( (t2 < acc->start) || ( (specs->edge_freq == 1) && (t1 < acc->start) ) )
+    {
+        return;
+    }
+    c_new = Get_Count(freq_ptr, index, width);
+    c_old = c_new - change;
+    acc->total += change;
+    /* without a branch: the colors above and below the median are equally likely */
+    acc->below += (t2 < acc->median) * change;
+    if(acc->sums == 0)
+    {
+        Track_Max(specs, acc, t2, c_old, c_new);
+        return;
+    }
+    acc->sum_sq += change * (c_new + c_old);
+    acc->sum_clogc += specs->clogc[c_new] - specs->clogc[c_old];
+    if(specs->edge_freq == 1)
+    {
+        /* edge types are counted without regard to order */
+        u_new = c_new;
+        if(t1 != t2)
+        {
+            u_new += Get_Count(freq_ptr, (t2 * (specs->n_colors_in_image + 1)) + t1, width);
+        }
+        acc->n_nonzero += (u_new > 0) - ( (u_new - change) > 0);
+        if(t1 == t2)
+        {
+            acc->diagonal += change;
+        }
+    }
+    else
+    {
+        acc->n_nonzero += (c_new > 0) - (c_old > 0);
+    }
+    Track_Max(specs, acc, t2, c_old, c_new);
+}
+
+/* 1.4.0, engine 3, rule 1: the lowest color with the largest count, which is the one Freq_Filters
+   finds, in at most color_words steps instead of a scan of every color */
+SLIDE_INLINE long int Majority_Color(struct conv_specs *specs, struct metric_acc *acc)
+{
+    unsigned long long *bits;
+    long int word;
+    bits = acc->count_colors + (acc->max_count * specs->color_words);
+    for(word = 0; word < specs->color_words; word++)
+    {
+        if(bits[word] != 0)
+        {
+            return( (word << 6) + Low_Bit(bits[word]) );
+        }
+    }
+    return(1);
+}
+
+/* 1.4.0, engine 3, rule 20: the lowest color whose cumulative count from acc->start reaches position,
+   the one Freq_Filters finds. The median pointer only moves by as many colors as the median changed
+   since the last window (Huang 1979), acc->below being kept up to date by Track_Count. */
+SLIDE_INLINE long int Median_Color(struct conv_specs *specs, void *freq_ptr, struct metric_acc *acc,
+                                   long int position)
+{
+    while( (acc->median > acc->start) && (acc->below >= position) )
+    {
+        acc->median--;
+        acc->below -= Get_Count(freq_ptr, acc->median, specs->count_width);
+    }
+    while(acc->below + Get_Count(freq_ptr, acc->median, specs->count_width) < position)
+    {
+        acc->below += Get_Count(freq_ptr, acc->median, specs->count_width);
+        acc->median++;
+    }
+    return(acc->median);
+}
+
+/* 1.4.0, count one more (change = 1) or one less (change = -1) pixel of color t2 */
+SLIDE_INLINE void Count_Color(struct conv_specs *specs, void *freq_ptr, struct metric_acc *acc,
+                               long int t2, long int change, int tracked, int width)
+{
+    Add_Count(freq_ptr, t2, change, width);
+    if(tracked)
+    {
+        Track_Count(specs, freq_ptr, acc, t2, 0, t2, change, width);
+    }
+}
+
+/* 1.4.0, count one more or one less edge of type t1,t2 */
+SLIDE_INLINE void Count_Edge(struct conv_specs *specs, void *freq_ptr, struct metric_acc *acc,
+                              long int t1, long int t2, long int change, int tracked, int width)
+{
+    long int temp_int;
+    temp_int = (t1 * (specs->n_colors_in_image + 1)) + t2;
+    Add_Count(freq_ptr, temp_int, change, width);
+    if(specs->sparse)
+    {
+        Mark_Pair(specs, freq_ptr, temp_int, Get_Count(freq_ptr, temp_int, width), change);
+    }
+    if(tracked)
+    {
+        Track_Count(specs, freq_ptr, acc, temp_int, t1, t2, change, width);
+    }
+}
+
+/* 1.4.0, frequency distribution of colors or edges in the first window of a row, at placement grain_col */
+SLIDE_INLINE void Seed_Window(struct conv_specs *specs, unsigned char **rows, void *freq_ptr,
+                               struct metric_acc *acc, long int grain_col, int clamped, int tracked, int width)
+{
+    long int r, c, r_min, r_max, c_min, c_max, t1, t2;
+    c_min = grain_col;
+    r_min = 0;
+    c_max = c_min + specs->window_size;
+    r_max = r_min + specs->window_size;
+    /* Get a frequency distribution of colors or edges within the window*/
+    /*  the window goes from r_min,c_min to r_max-1,c_max-1 */
+    if(specs->color_freq)
+    {
+        for(r = r_min; r < r_max; r++)
+        {
+            for(c = c_min; c < c_max; c++)
+            {
+                t2 = Window_Pixel(specs, rows[r], c, clamped);
+                Count_Color(specs, freq_ptr, acc, t2, 1, tracked, width);
+            }
+        }
+    }
+    if(specs->edge_freq)     /* three loopsets used to avoid lots of if's */
+    {
+        for(r = r_min; r < r_max-1; r++)    /* all but last row in window*/
+        {
+            for(c = c_min; c < c_max-1; c++)    /* all but last col in window*/
+            {
+                t1 = Window_Pixel(specs, rows[r], c, clamped);  /*this cell*/
+                t2 = Window_Pixel(specs, rows[r+1], c, clamped); /*cell below*/
+                Count_Edge(specs, freq_ptr, acc, t1, t2, 1, tracked, width);
+                t2 = Window_Pixel(specs, rows[r], c + 1, clamped); /*cell at right*/
+                Count_Edge(specs, freq_ptr, acc, t1, t2, 1, tracked, width);
+            }
+        }
+        for(r = r_min; r < r_max-1; r++)    /* look at last column */
+        {
+            t1 = Window_Pixel(specs, rows[r], c_max-1, clamped);  /*this cell*/
+            t2 = Window_Pixel(specs, rows[r+1], c_max-1, clamped); /*cell below*/
+            Count_Edge(specs, freq_ptr, acc, t1, t2, 1, tracked, width);
+        }
+        for(c = c_min; c < c_max-1; c++)    /* look at last row */
+        {
+            t1 = Window_Pixel(specs, rows[r_max-1], c, clamped);  /*this cell*/
+            t2 = Window_Pixel(specs, rows[r_max-1], c + 1, clamped); /*cell at right*/
+            Count_Edge(specs, freq_ptr, acc, t1, t2, 1, tracked, width);
+        }
+    }
+}
+
+/* 1.4.0, move the window step columns to placement grain_col, for a step smaller than the window */
+SLIDE_INLINE void Slide_Window(struct conv_specs *specs, unsigned char **rows, void *freq_ptr,
+                                struct metric_acc *acc, long int grain_col, long int step, int clamped,
+                                int tracked, int width)
+{
+    long int r, c, k, r_min, r_max, c_min, c_max, new_c_min, new_c_max, t1, t2;
+    r_min = 0;
+    r_max = specs->window_size;
+    c_min = grain_col - step;
+    c_max = c_min + specs->window_size;
+    new_c_min = c_min + step;
+    new_c_max = c_max + step;
+    if(specs->color_freq)
+    {
+        for(r = r_min; r < r_max; r++)
+        {
+            /* column c_min + k leaves as column c_max + k enters */
+            for(k = 0; k < step; k++)
+            {
+                t1 = Window_Pixel(specs, rows[r], c_min + k, clamped);
+                t2 = Window_Pixel(specs, rows[r], c_max + k, clamped);
+                if(tracked && (t1 == t2) )
+                {
+                    /* the counts, and the accumulators, do not change if the same color leaves and enters */
+                    continue;
+                }
+                Count_Color(specs, freq_ptr, acc, t1, -1, tracked, width);
+                Count_Color(specs, freq_ptr, acc, t2, 1, tracked, width);
+            }
+        }
+    }
+    if(specs->edge_freq)
+    {
+        for(r = r_min; r < r_max-1; r++)    /* all but last row in window*/
+        {
+            /* subtract from the left, doing every old column */
+            for(c = c_min; c < new_c_min; c++)
+            {
+                t1 = Window_Pixel(specs, rows[r], c, clamped);  /*this cell*/
+                t2 = Window_Pixel(specs, rows[r+1], c, clamped); /*cell below*/
+                Count_Edge(specs, freq_ptr, acc, t1, t2, -1, tracked, width);
+                t2 = Window_Pixel(specs, rows[r], c + 1, clamped); /*cell at right*/
+                Count_Edge(specs, freq_ptr, acc, t1, t2, -1, tracked, width);
+            }
+            /* Add from the right, doing every new column, looking left and down */
+            /* the new material comes from the joins on the left*/
+            for(c = c_max; c < new_c_max; c++)
+            {
+                t1 = Window_Pixel(specs, rows[r], c, clamped);  /*this cell*/
+                t2 = Window_Pixel(specs, rows[r+1], c, clamped); /*cell below*/
+                Count_Edge(specs, freq_ptr, acc, t1, t2, 1, tracked, width);
+                t2 = Window_Pixel(specs, rows[r], c - 1, clamped); /*cell at left*/
+                /* note order of t1 and t2 switched in the following, the */
+                /*  reason...need to store in same order as they will be */
+                /*  deleted later... */
+                Count_Edge(specs, freq_ptr, acc, t2, t1, 1, tracked, width);
+            }
+        }
+        for(c = c_min; c < new_c_min; c++)    /* look at last row */
+        {
+            t1 = Window_Pixel(specs, rows[r_max-1], c, clamped);  /*this cell*/
+            t2 = Window_Pixel(specs, rows[r_max-1], c + 1, clamped); /*cell at right*/
+            Count_Edge(specs, freq_ptr, acc, t1, t2, -1, tracked, width);
+        }
+        /* add from the right, but looking left again */
+        for(c = c_max; c < new_c_max; c++)
+        {
+            t1 = Window_Pixel(specs, rows[r_max-1], c, clamped);  /*this cell*/
+            t2 = Window_Pixel(specs, rows[r_max-1], c - 1, clamped); /*cell at left*/
+            /* note the switch of order of t1,t2...see above */
+            Count_Edge(specs, freq_ptr, acc, t2, t1, 1, tracked, width);
+        }
+    }
+}
+
+/* 1.4.0, zero the freq distn again after the last placement grain_col of a row: only the counts of the
+   colors or edge types in that window can be more than 0. An edge type is cleared in both orders, and
+   the words of occupied cell bits that hold them, so the bits end up all 0 too. This is O(window area)
+   where zeroing all of freq_ptr was O(array_length), 128 KB or more for an adjacency matrix. */
+SLIDE_INLINE void Clear_Cell(struct conv_specs *specs, void *freq_ptr, long int cell, int width)
+{
+    unsigned long long *bits;
+    Add_Count(freq_ptr, cell, -Get_Count(freq_ptr, cell, width), width);
+    if(specs->sparse)
+    {
+        bits = Pair_Bits(specs, freq_ptr);
+        bits[cell >> 6] = 0;
+        bits[specs->pair_words + (cell >> 12)] = 0;
+    }
+}
+
+SLIDE_INLINE void Clear_Window(struct conv_specs *specs, unsigned char **rows, void *freq_ptr,
+                               long int grain_col, int width)
+{
+    long int r, c, r_max, c_min, c_max, n_cols, t1, t2;
+    n_cols = specs->n_colors_in_image + 1;
+    r_max = specs->window_size;
+    c_min = grain_col;
+    c_max = grain_col + specs->window_size;
+    if(specs->color_freq)
+    {
+        for(r = 0; r < r_max; r++)
+        {
+            for(c = c_min; c < c_max; c++)
+            {
+                Clear_Cell(specs, freq_ptr, Window_Pixel(specs, rows[r], c, 1), width);
+            }
+        }
+    }
+    if(specs->edge_freq)
+    {
+        for(r = 0; r < r_max; r++)
+        {
+            for(c = c_min; c < c_max; c++)
+            {
+                t1 = Window_Pixel(specs, rows[r], c, 1);  /*this cell*/
+                if(r < r_max - 1)
+                {
+                    t2 = Window_Pixel(specs, rows[r+1], c, 1); /*cell below*/
+                    Clear_Cell(specs, freq_ptr, (t1 * n_cols) + t2, width);
+                    Clear_Cell(specs, freq_ptr, (t2 * n_cols) + t1, width);
+                }
+                if(c < c_max - 1)
+                {
+                    t2 = Window_Pixel(specs, rows[r], c + 1, 1); /*cell at right*/
+                    Clear_Cell(specs, freq_ptr, (t1 * n_cols) + t2, width);
+                    Clear_Cell(specs, freq_ptr, (t2 * n_cols) + t1, width);
+                }
+            }
+        }
+    }
+}
+
+/* 1.4.0, call the convolution function for the window at placement grain_col, passing the distn.
+   The kernel for the rule, handle_missing and output format was chosen once by Select_Kernel.
+   With several rules each one is finished from the same distn into its own output band. */
+static inline void Store_Value(struct conv_specs *specs, void *freq_ptr,
+                               unsigned char *out_row, float *out_row_float, long int grain_col)
+{
+    long int index;
+    for(index = 0; index < specs->n_rules; index++)
+    {
+        specs->store[index](specs, freq_ptr, out_row, out_row_float, grain_col + specs->band_offsets[index]);
+    }
+}
+
+/* 1.4.0, engine 3, the same as Store_Value for rules 1, 51-54 and 71-74, but the metric is finished from
+   the accumulators in O(1) instead of rescanning freq_ptr. The formulas are those of Freq_Filters. */
+static inline void Store_Tracked_Value(struct conv_specs *specs, void *freq_ptr, struct metric_acc *acc,
+                                       long int mapping_rule, unsigned char *out_row, float *out_row_float,
+                                       long int grain_col)
+{
+    long int status, temp_int;
+    double total, n_types;
+    float temp_float, inverse;
+    if(mapping_rule == 1)
+    {
+        /* the majority, as its original color code (byte output only) */
+        (*(out_row + grain_col)) = specs->color_out[Majority_Color(specs, acc)];
+        return;
+    }
+    if(mapping_rule == 20)
+    {
+        /* the median, at the position of Freq_Filters: the upper middle of an odd number of pixels, */
+        /*   the lower middle of an even number */
+        temp_int = ( (specs->window_size * specs->window_size) / 2) + 1;
+        if(acc->start == 1)
+        {
+            temp_int = (acc->total + 1) / 2;
+        }
+        temp_int = Median_Color(specs, freq_ptr, acc, temp_int);
+        if(parameters.outfloat == 0)
+        {
+            (*(out_row + grain_col)) = temp_int;
+        }
+        else
+        {
+            /* Freq_Filters_Float takes a median of 0 for an error */
+            (*(out_row_float + grain_col)) = (temp_int == 0) ? -0.01 : (1.0 * temp_int);
+        }
+        return;
+    }
+    status = 0;     /* 0 = a value in temp_float, 1 = missing, 2 = only one color or edge type */
+    temp_float = 0.0;
+    total = acc->total;
+    n_types = acc->n_nonzero;
+    if(acc->start == 0)
+    {
+        total = constants.window_area;
+        if(specs->edge_freq == 1)
+        {
+            total = constants.number_of_edges;
+        }
+    }
+    if(acc->total == 0)
+    {
+        status = 1;
+    }
+    else
+    {
+        switch(mapping_rule)
+        {
+        case 51: /* Simpson diversity of colors, 1 - sum[(Pi)**2] */
+            temp_float = 1.0 - (acc->sum_sq / (total * total));
+            break;
+        case 52: /* Simpson evenness, diversity/max diversity */
+            if(acc->n_nonzero == 1)
+            {
+                status = 2;
+                break;
+            }
+            temp_float = 1.0 - (acc->sum_sq / (total * total));
+            temp_float = temp_float / (1.0 - (1.0 / n_types));
+            break;
+        case 53: /* shannon evenness, -sum[Pi ln(Pi)] = ln(total) - sum[ci ln(ci)] / total */
+            if(acc->n_nonzero == 1)
+            {
+                status = 2;
+                break;
+            }
+            temp_float = (log(total) - (acc->sum_clogc / total)) / log(n_types);
+            break;
+        case 54: /* Pmax, with the same single precision steps as Freq_Filters */
+            inverse = 1.0 / total;
+            if(acc->start == 0)
+            {
+                inverse = constants.window_area_inverse;
+            }
+            temp_float = (1.0 * acc->max_count) * inverse;
+            break;
+        case 71: /* angular second moment */
+            temp_float = acc->sum_sq / (total * total);
+            break;
+        case 72: /* Simpson edge-type evenness */
+            if(acc->n_nonzero == 1)
+            {
+                status = 2;
+                break;
+            }
+            temp_float = 1.0 - (acc->sum_sq / (total * total));
+            temp_float = 1.0 - (temp_float / (1.0 - (1.0 / (n_types * n_types))));
+            break;
+        case 73: /* shannon edge-type evenness, ie contagion */
+            if(acc->n_nonzero == 1)
+            {
+                status = 2;
+                break;
+            }
+            temp_float = log(total) - (acc->sum_clogc / total);
+            temp_float = 1.0 - (temp_float / (2.0 * log(n_types)));
+            break;
+        case 74: /* sum of diagonal of adjacency matrix, as in Freq_Filters */
+            temp_float = acc->diagonal / total;
+            if(acc->start == 0)
+            {
+                temp_float = acc->diagonal * constants.number_of_edges_inverse;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    /* the exact sums can land just below zero where the single precision sums of Freq_Filters give 0 */
+    if( fabs(temp_float) < EPSILON)
+    {
+        temp_float = 0.0;
+    }
+    if(parameters.outfloat == 0)
+    {
+        temp_int = (temp_float * 254.) + 1;
+        if(status == 1)
+        {
+            temp_int = 0;
+        }
+        if(status == 2)
+        {
+            temp_int = 255;
+        }
+        (*(out_row + grain_col)) = temp_int;
+    }
+    if(parameters.outfloat == 1)
+    {
+        if(status == 1)
+        {
+            temp_float = -0.01;
+        }
+        if(status == 2)
+        {
+            temp_float = 1.0;
+        }
+        (*(out_row_float + grain_col)) = temp_float;
+    }
+}
+
+/*   ******************
+     Store_Sparse_Value
+     ******************
+    1.4.0, rules 71-76 for the sparse adjacency matrix (specs->sparse), called by the kernels instead
+    of Freq_Filters (outfloat 0) or Freq_Filters_Float (outfloat 1). The sums over the adjacency matrix
+    visit only its occupied cells, in the order of the loops in Freq_Filters; the cells they skip add
+    nothing, so the output is the same. The formulas, and the single precision steps, are those of
+    Freq_Filters and Freq_Filters_Float.
+*/
+static inline void Store_Sparse_Value(struct conv_specs *specs, void *freq_ptr, int width, long int mapping_rule,
+                                      long int handle_missing, int outfloat, unsigned char *out_row,
+                                      float *out_row_float, long int grain_col)
+{
+    unsigned long long *bits;
+    long int status, cell, first, n_cols, ind1, ind2, index, count, temp_int, temp_int2, n_colors_in_window;
+    float temp_float, temp_float_2, temp_float_3;
+    bits = Pair_Bits(specs, freq_ptr);
+    n_cols = specs->n_colors_in_image + 1;
+    first = (handle_missing == 2) ? 0 : 1;     /* the first color of the cells that are counted */
+    status = 0;     /* 0 = a value in temp_float, 1 = missing, 2 = only one edge type */
+    temp_float = 0.;
+    /* the non-missing edges (temp_int2) and the number of edge types without regard to order */
+    temp_int2 = 0;
+    n_colors_in_window = 0;
+    if( (handle_missing == 1) || (mapping_rule == 72) || (mapping_rule == 73) )
+    {
+        for(cell = Next_Pair(bits, specs->pair_words, -1); cell >= 0; cell = Next_Pair(bits, specs->pair_words, cell))
+        {
+            ind1 = cell / n_cols;
+            ind2 = cell - (ind1 * n_cols);
+            if( (ind1 < first) || (ind2 < first) )
+            {
+                continue;
+            }
+            temp_int2 += Get_Count(freq_ptr, cell, width);
+            /* a type is counted once, at its first cell ind1,ind2 with ind1 <= ind2 */
+            if( (ind1 <= ind2) || (Get_Count(freq_ptr, (ind2 * n_cols) + ind1, width) == 0) )
+            {
+                n_colors_in_window++;
+            }
+        }
+        if( (handle_missing == 1) && (temp_int2 == 0) )
+        {
+            status = 1;
+        }
+        if( ( (mapping_rule == 72) || (mapping_rule == 73) ) && (n_colors_in_window == 1) )
+        {
+            status = 2;
+        }
+    }
+    if(status == 0)
+    {
+        switch(mapping_rule)
+        {
+        case 71: /* angular second moment */
+        case 72: /* Simpson edge-type evenness */
+            for(cell = Next_Pair(bits, specs->pair_words, -1); cell >= 0; cell = Next_Pair(bits, specs->pair_words, cell))
+            {
+                ind1 = cell / n_cols;
+                ind2 = cell - (ind1 * n_cols);
+                if( (ind1 < first) || (ind2 < first) )
+                {
+                    continue;
+                }
+                if(handle_missing == 2)
+                {
+                    temp_float_2 = (1.0 * Get_Count(freq_ptr, cell, width) ) *
+                                   constants.number_of_edges_inverse;
+                }
+                else
+                {
+                    temp_float_2 = (1.0 * Get_Count(freq_ptr, cell, width) ) / (1.0 * temp_int2);
+                }
+                temp_float += temp_float_2 * temp_float_2;
+            }
+            if(mapping_rule == 72)
+            {
+                temp_float = 1.0 - temp_float;
+                temp_float_2 = (1.0 - (1.0 / (1.0 * (n_colors_in_window * n_colors_in_window))));
+                temp_float = 1.0 - (temp_float / temp_float_2);
+            }
+            break;
+        case 73: /* shannon edge-type evenness, ie contagion */
+            for(cell = Next_Pair(bits, specs->pair_words, -1); cell >= 0; cell = Next_Pair(bits, specs->pair_words, cell))
+            {
+                ind1 = cell / n_cols;
+                ind2 = cell - (ind1 * n_cols);
+                if( (ind1 < first) || (ind2 < first) )
+                {
+                    continue;
+                }
+                if(handle_missing == 2)
+                {
+                    temp_float_2 = (1.0 * Get_Count(freq_ptr, cell, width) ) *
+                                   constants.number_of_edges_inverse;
+                }
+                else
+                {
+                    temp_float_2 = (1.0 * Get_Count(freq_ptr, cell, width) ) / (1.0 * temp_int2);
+                }
+                if(temp_float_2 > 0)
+                {
+                    temp_float += temp_float_2 * log(temp_float_2);
+                }
+            }
+            temp_float = -1.0 * temp_float;
+            temp_float_2 = 2.0 * log(1.0 * n_colors_in_window);
+            temp_float = 1.0 - (temp_float / temp_float_2);
+            break;
+        case 74: /* sum of diagonal of adjacency matrix */
+            count = 0;
+            for(index = first; index < n_cols; index++)
+            {
+                temp_int = (index * n_cols) + index;
+                temp_float += (1.0 * Get_Count(freq_ptr, temp_int, width) );
+                count += Get_Count(freq_ptr, temp_int, width);
+            }
+            if(handle_missing == 2)
+            {
+                /* Freq_Filters_Float sums the diagonal as integers */
+                if(outfloat == 1)
+                {
+                    temp_float = (1.0 * count) * constants.number_of_edges_inverse;
+                }
+                else
+                {
+                    temp_float = temp_float * constants.number_of_edges_inverse;
+                }
+            }
+            else
+            {
+                temp_float = temp_float / (1.0 * temp_int2);
+            }
+            break;
+        case 75: /* proportion of local edges which involve code_1 */
+            /* code_1's row, its column, less the diagonal cell that was counted twice */
+            for(index = first; index < n_cols; index++)
+            {
+                temp_int = (specs->code_1 * n_cols) + index;
+                temp_float += (1.0 * Get_Count(freq_ptr, temp_int, width) );
+            }
+            for(index = first; index < n_cols; index++)
+            {
+                temp_int = (index * n_cols) + specs->code_1;
+                temp_float += (1.0 * Get_Count(freq_ptr, temp_int, width) );
+            }
+            temp_int = (specs->code_1 * n_cols) + specs->code_1;
+            temp_float -= (1.0 * Get_Count(freq_ptr, temp_int, width) );
+            if(handle_missing == 2)
+            {
+                temp_float = temp_float * constants.number_of_edges_inverse;
+            }
+            else
+            {
+                temp_float = temp_float / (1.0 * temp_int2);
+            }
+            break;
+        case 76: /* proportion of edges between code_1 and code_2 */
+            temp_int = (specs->code_1 * n_cols) + specs->code_2;
+            temp_float = (1.0 * Get_Count(freq_ptr, temp_int, width) );
+            if(specs->code_1 != specs->code_2)
+            {
+                temp_int = (specs->code_2 * n_cols) + specs->code_1;
+                temp_float += (1.0 * Get_Count(freq_ptr, temp_int, width) );
+            }
+            if(handle_missing == 2)
+            {
+                temp_float = temp_float * constants.number_of_edges_inverse;
+            }
+            else
+            {
+                temp_float_3 = 1.0 / (1.0 * temp_int2);
+                temp_float = temp_float * temp_float_3;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    if(outfloat == 0)
+    {
+        temp_int = (temp_float * 254.) + 1;
+        if(status == 1)
+        {
+            temp_int = 0;
+        }
+        if(status == 2)
+        {
+            temp_int = 255;
+        }
+        (*(out_row + grain_col)) = temp_int;
+    }
+    if(outfloat == 1)
+    {
+        if(status == 1)
+        {
+            temp_float = -0.01;
+        }
+        if(status == 2)
+        {
+            temp_float = 1.0;
+        }
+        (*(out_row_float + grain_col)) = temp_float;
+    }
+}
+
+/* 1.4.0, store the result for placement grain_col, from the accumulators of engine 3 if tracked */
+static inline void Store_Window(struct conv_specs *specs, void *freq_ptr, struct metric_acc *acc,
+                                unsigned char *out_row, float *out_row_float, long int grain_col, int tracked)
+{
+    long int index;
+    if(tracked)
+    {
+        for(index = 0; index < specs->n_rules; index++)
+        {
+            if(specs->tracked[index])
+            {
+                Store_Tracked_Value(specs, freq_ptr, acc, specs->mapping_rules[index], out_row, out_row_float,
+                                    grain_col + specs->band_offsets[index]);
+            }
+            else
+            {
+                specs->store[index](specs, freq_ptr, out_row, out_row_float, grain_col + specs->band_offsets[index]);
+            }
+        }
+    }
+    else
+    {
+        Store_Value(specs, freq_ptr, out_row, out_row_float, grain_col);
+    }
+}
+
+/* 1.4.0, the metric accumulators of engine 3 for an empty window */
+SLIDE_INLINE void Reset_Tracked(struct conv_specs *specs, struct metric_acc *acc)
+{
+    long int temp_int;
+    acc->total = 0;
+    acc->sum_sq = 0;
+    acc->sum_clogc = 0.0;
+    acc->n_nonzero = 0;
+    acc->diagonal = 0;
+    acc->max_count = 0;
+    if(acc->median >= 0)
+    {
+        acc->median = acc->start;
+        acc->below = 0;
+    }
+    if(acc->count_hist != NULL)
+    {
+        for(temp_int = 0; temp_int <= specs->max_count; temp_int++)
+        {
+            (*(acc->count_hist + temp_int)) = 0;
+        }
+    }
+    if(acc->count_colors != NULL)
+    {
+        /* every color has count 0, color 1 even if the map has no colors (as in Freq_Filters) */
+        memset(acc->count_colors, 0, (specs->max_count + 1) * specs->color_words * sizeof(unsigned long long));
+        for(temp_int = acc->start; temp_int <= max(specs->n_colors_in_image, 1); temp_int++)
+        {
+            (*(acc->count_colors + (temp_int >> 6))) |= 1ULL << (temp_int & 63);
+        }
+    }
+}
+
+/* 1.4.0, slide the window to placements first ... end - 1 of a row, step columns at a time */
+SLIDE_INLINE void Slide_Places(struct conv_specs *specs, unsigned char **rows, void *freq_ptr,
+                                struct metric_acc *acc, unsigned char *out_row, float *out_row_float,
+                                long int first, long int end, long int step, int clamped, int tracked, int width)
+{
+    long int place;
+    for(place = first; place < end; place++)
+    {
+        Slide_Window(specs, rows, freq_ptr, acc, place * step, step, clamped, tracked, width);
+        Store_Window(specs, freq_ptr, acc, out_row, out_row_float, place, tracked);
+    }
+}
+
+/* 1.4.0, Conv_Row with the metric accumulators of engine 3 (tracked = 1) or without (tracked = 0) */
+SLIDE_INLINE void Conv_Row_Tracked(struct conv_specs *specs, unsigned char **rows, void *freq_ptr,
+                                    struct metric_acc *acc, unsigned char *out_row, float *out_row_float,
+                                    long int first_col, long int end_col, int tracked, int width)
+{
+    long int temp_int, step, first_interior, end_interior;
+    /* the freq distn is zero at the start of grain row (see Clear_Window) */
+    if(tracked)
+    {
+        Reset_Tracked(specs, acc);
+    }
+    /* Placements whose windows, and the columns that leave them, are inside the map on the left and right */
+    step = specs->grain;
+    first_interior = (specs->buff_b + step - 1) / step + 1;
+    end_interior = max(specs->n_cols_in - 1 - specs->buff_b, -1) / step + 1;
+    for(temp_int = 0; temp_int < specs->window_size; temp_int++)
+    {
+        if(rows[temp_int] == NULL)     /* a row above or below the map, no fast path in this row */
+        {
+            first_interior = specs->n_places_right;
+            break;
+        }
+    }
+    /* only the placements first_col ... end_col - 1 of the row */
+    first_interior = min(max(first_interior, first_col + 1), end_col);
+    end_interior = min(max(end_interior, first_interior), end_col);
+    /* Seed with the first placement on the left, which can stick out of the map */
+    /* placement place is the window centered at input column place * step */
+    Seed_Window(specs, rows, freq_ptr, acc, first_col * step, 1, tracked, width);
+    Store_Window(specs, freq_ptr, acc, out_row, out_row_float, first_col, tracked);
+    /* Proceed to the right, subtracting and adding from the freq distn */
+    if(step == 1)
+    {
+        /* the default grain: a constant step keeps the one column that leaves and enters out of loops */
+        Slide_Places(specs, rows, freq_ptr, acc, out_row, out_row_float,
+                     first_col + 1, first_interior, 1, 1, tracked, width);
+        Slide_Places(specs, rows, freq_ptr, acc, out_row, out_row_float,
+                     first_interior, end_interior, 1, 0, tracked, width);
+        Slide_Places(specs, rows, freq_ptr, acc, out_row, out_row_float,
+                     end_interior, end_col, 1, 1, tracked, width);
+    }
+    else if(step >= specs->window_size)
+    {
+        /* the windows do not overlap, each one starts over */
+        for(temp_int = first_col + 1; temp_int < end_col; temp_int++)
+        {
+            Clear_Window(specs, rows, freq_ptr, (temp_int - 1) * step, width);
+            if(tracked)
+            {
+                Reset_Tracked(specs, acc);
+            }
+            Seed_Window(specs, rows, freq_ptr, acc, temp_int * step, 1, tracked, width);
+            Store_Window(specs, freq_ptr, acc, out_row, out_row_float, temp_int, tracked);
+        }
+    }
+    else
+    {
+        Slide_Places(specs, rows, freq_ptr, acc, out_row, out_row_float,
+                     first_col + 1, first_interior, step, 1, tracked, width);
+        Slide_Places(specs, rows, freq_ptr, acc, out_row, out_row_float,
+                     first_interior, end_interior, step, 0, tracked, width);
+        Slide_Places(specs, rows, freq_ptr, acc, out_row, out_row_float,
+                     end_interior, end_col, step, 1, tracked, width);
+    }
+    Clear_Window(specs, rows, freq_ptr, (end_col - 1) * step, width);
+}
+
+/*   ********
+     Conv_Row
+     ********
+    1.4.0, one row of window placements, moved out of the big do loop in Freq_Conv.
+    rows[0] ... rows[window_size-1] point to the input rows under the window (input byte values,
+    n_cols_in columns), or are NULL for rows above or below the map. There is no buffered copy of
+    the map: pixels outside the map are read as the local missing code 0, and the other pixels are
+    changed to local color codes with specs->color_lut as they are read. Windows that are entirely
+    inside the map take the fast path without those checks, only the first and last buff_b
+    placements of a row, and rows near the top and bottom, take the clamped path.
+    Only placements first_col ... end_col - 1 are convolved, all of them for 0 ... specs->n_places_right
+    or a column strip (see Conv_Band). Placement p is the window centered at input column p * specs->grain
+    (parameter g). The result for placement p is stored in out_row[p] (8-bit output) or
+    out_row_float[p] (32-bit output), shifted by specs->band_offsets[k] for rule k.
+    freq_ptr has room for specs->array_length counts of specs->count_width bytes, and the occupied cell
+    bits if specs->sparse (specs->freq_bytes in all). It must be zero on entry and is zero again on
+    return, so one thread can use the same freq_ptr for all its rows (see Conv_Band).
+    acc is NULL, or the metric accumulators of engine 3 (see Store_Tracked_Value).
+*/
+void Conv_Row(struct conv_specs *specs, unsigned char **rows, void *freq_ptr, struct metric_acc *acc,
+              unsigned char *out_row, float *out_row_float, long int first_col, long int end_col)
+{
+    if( (acc == NULL) && (specs->count_width == 2) )
+    {
+        Conv_Row_Tracked(specs, rows, freq_ptr, NULL, out_row, out_row_float, first_col, end_col, 0, 2);
+    }
+    else if(acc == NULL)
+    {
+        Conv_Row_Tracked(specs, rows, freq_ptr, NULL, out_row, out_row_float, first_col, end_col, 0, 4);
+    }
+    else if(specs->count_width == 2)
+    {
+        Conv_Row_Tracked(specs, rows, freq_ptr, acc, out_row, out_row_float, first_col, end_col, 1, 2);
+    }
+    else
+    {
+        Conv_Row_Tracked(specs, rows, freq_ptr, acc, out_row, out_row_float, first_col, end_col, 1, 4);
+    }
+}
+
+/*   *********
+     Conv_Band
+     *********
+    1.4.0, convolve n_out_rows consecutive rows of window placements, in parallel.
+    rows[k] points to the input row under the top of the window of input row k, so output row k
+    uses rows[k * g] ... rows[k * g + window_size - 1] for grain g (parameter g, 1 unless given);
+    rows above or below the map are NULL (see Conv_Row).
+    The results for output row k start at out + k * out_stride (8-bit output) or
+    out_float + k * out_stride (32-bit output). Used by Freq_Conv and Freq_Conv_Stream.
+    The sliding window engines hand whole rows to the threads, or with parameter t column strips of
+    t placements, each one convolved from top to bottom: the rows under the window of the next output
+    row are then the same ones less one, still in cache, where a whole row of a wide map under a large
+    window (w rows of n_cols_in bytes) no longer fits. Parameter o picks the OpenMP schedule.
+*/
+void Conv_Band(struct conv_specs *specs, unsigned char **rows, long int n_out_rows,
+               unsigned char *out, float *out_float, long int out_stride)
+{
+    long int row, n_chunks, chunk, track_max, track_mode, track_median, track_sums, n_strips, strip, strip_cols;
+    omp_sched_t caller_kind;
+    int caller_chunk;
+    if( (specs->engine == 2) && (specs->edge_freq == 1) )
+    {
+        Conv_Summed_Area_Edges(specs, rows, n_out_rows, out, out_float, out_stride);
+        Check_Thread_Error();
+        return;
+    }
+    if(specs->engine == 2)
+    {
+        Conv_Summed_Area(specs, rows, n_out_rows, out, out_float, out_stride);
+        Check_Thread_Error();
+        return;
+    }
+    if(specs->engine == 4)
+    {
+        Conv_Bit_Planes(specs, rows, n_out_rows, out, out_float, out_stride);
+        Check_Thread_Error();
+        return;
+    }
+    if(specs->engine == 1)
+    {
+        /* column histograms: each thread moves down its own block of rows */
+        n_chunks = omp_get_max_threads();
+        if(n_chunks > n_out_rows)
+        {
+            n_chunks = n_out_rows;
+        }
+        #pragma omp parallel for private(chunk)
+        for(chunk = 0; chunk < n_chunks; chunk++)
+        {
+            void *freq_ptr = 0;
+            void *col_hist = 0;
+            if( ( (freq_ptr = calloc( specs->array_length, specs->count_width ) ) == NULL ) ||
+                    ( (col_hist = calloc( specs->n_cols_in * specs->array_length, specs->count_width ) ) == NULL ) )
+            {
+                Thread_Error(28, "\nSpatcon: Error. Memory allocation failed in parallel part of Freq_Conv.\n");
+            }
+            else
+            {
+                Conv_Column_Hist(specs, rows, (n_out_rows * chunk) / n_chunks, (n_out_rows * (chunk + 1)) / n_chunks,
+                                 col_hist, freq_ptr, out, out_float, out_stride);
+            }
+            free(col_hist);
+            free(freq_ptr);
+        }
+        Check_Thread_Error();
+        return;
+    }
+    /* engine 3 keeps the count histogram for rule 54, the colors of each count for rule 1 and the */
+    /*   median pointer for rule 20 */
+    track_max = 0;
+    track_mode = 0;
+    track_median = 0;
+    track_sums = 0;
+    for(row = 0; row < specs->n_rules; row++)
+    {
+        if(specs->tracked[row] == 0)
+        {
+            continue;
+        }
+        if( (specs->mapping_rules[row] != 1) && (specs->mapping_rules[row] != 20) )
+        {
+            track_sums = 1;
+        }
+        if(specs->mapping_rules[row] == 54)
+        {
+            track_max = 1;
+        }
+        if(specs->mapping_rules[row] == 1)
+        {
+            track_mode = 1;
+        }
+        if(specs->mapping_rules[row] == 20)
+        {
+            track_median = 1;
+        }
+    }
+    /* column strips of strip_cols placements, or whole rows */
+    strip_cols = specs->n_places_right;
+    if( (parameters.tile_cols > 0) && (parameters.tile_cols < specs->n_places_right) )
+    {
+        strip_cols = parameters.tile_cols;
+    }
+    n_strips = (specs->n_places_right + strip_cols - 1) / strip_cols;
+    /* the loops below take their schedule from omp_set_schedule (the caller's is put back after them);
+       strips take longer near the edges of the map, and a thread that is done with its strips takes
+       the next one that is left */
+    omp_get_schedule(&caller_kind, &caller_chunk);
+    if( (parameters.schedule == 1) || ( (parameters.schedule == 0) && (n_strips == 1) ) )
+    {
+        omp_set_schedule(omp_sched_static, 0);
+    }
+    else if(parameters.schedule == 3)
+    {
+        omp_set_schedule(omp_sched_guided, 1);
+    }
+    else
+    {
+        omp_set_schedule(omp_sched_dynamic, 1);
+    }
+    /* each thread keeps its freq distn in its scratch arena, which lasts as long as specs */
+    #pragma omp parallel private(row, strip)
+    {
+        void *freq_ptr;
+        struct metric_acc acc, *acc_ptr;
+        freq_ptr = Thread_Scratch(specs);
+        acc_ptr = NULL;
+        acc.count_hist = NULL;
+        acc.count_colors = NULL;
+        if( (specs->engine == 3) && (freq_ptr != NULL) )
+        {
+            acc_ptr = &acc;
+            acc.start = (specs->handle_missing == 2) ? 0 : 1;
+            acc.sums = track_sums;
+            acc.median = (track_median == 1) ? acc.start : -1;
+            if(track_max == 1)
+            {
+                acc.count_hist = (long int *)( (char *)freq_ptr + specs->hist_offset);
+            }
+            if(track_mode == 1)
+            {
+                acc.count_colors = (unsigned long long *)( (char *)freq_ptr + specs->colors_offset);
+            }
+        }
+        if(n_strips == 1)
+        {
+            #pragma omp for schedule(runtime)
+            for(row = 0; row < n_out_rows; row++)
+            {
+                if(freq_ptr == NULL)    /* no scratch arena, see Thread_Scratch */
+                {
+                    continue;
+                }
+                if(parameters.outfloat == 0)
+                {
+                    Conv_Row(specs, rows + (row * specs->grain), freq_ptr, acc_ptr, out + (row * out_stride), NULL,
+                             0, specs->n_places_right);
+                }
+                if(parameters.outfloat == 1)
+                {
+                    Conv_Row(specs, rows + (row * specs->grain), freq_ptr, acc_ptr, NULL, out_float + (row * out_stride),
+                             0, specs->n_places_right);
+                }
+            }
+        }
+        else
+        {
+            #pragma omp for schedule(runtime)
+            for(strip = 0; strip < n_strips; strip++)
+            {
+                long int first_col, end_col;
+                first_col = strip * strip_cols;
+                end_col = min(first_col + strip_cols, specs->n_places_right);
+                for(row = 0; (freq_ptr != NULL) && (row < n_out_rows); row++)
+                {
+                    if(parameters.outfloat == 0)
+                    {
+                        Conv_Row(specs, rows + (row * specs->grain), freq_ptr, acc_ptr, out + (row * out_stride), NULL,
+                                 first_col, end_col);
+                    }
+                    if(parameters.outfloat == 1)
+                    {
+                        Conv_Row(specs, rows + (row * specs->grain), freq_ptr, acc_ptr, NULL, out_float + (row * out_stride),
+                                 first_col, end_col);
+                    }
+                }
+            }
+        }
+    }
+    omp_set_schedule(caller_kind, caller_chunk);
+    Check_Thread_Error();
+}
+
+/*   **************
+     Thread_Scratch
+     **************
+    1.4.0, the scratch arena of the calling thread for specs, specs->scratch_bytes of memory that
+    is zero when it is first handed out. Conv_Row leaves freq_ptr zero again after each row, so the
+    arena is allocated once per thread and run instead of once per output row.
+    Returns NULL, after Thread_Error, if there is none.
+*/
+void *Thread_Scratch(struct conv_specs *specs)
+{
+    long int thread;
+    thread = omp_get_thread_num();
+    if( (thread < specs->n_scratch) && (specs->scratch[thread] == NULL) )
+    {
+        specs->scratch[thread] = Alloc_Scratch(specs->scratch_bytes);
+    }
+    if( (thread >= specs->n_scratch) || (specs->scratch[thread] == NULL) )
+    {
+        Thread_Error(28, "\nSpatcon: Error. Memory allocation failed in parallel part of Freq_Conv.\n");
+        return(NULL);
+    }
+    return(specs->scratch[thread]);
+}
+
+/*   ************
+     Thread_Error
+     ************
+    1.4.0, an error in a parallel region: exit() there would end the caller of the library build, and
+    a thread cannot leave the region. Keeps code and prints message (unless NULL) for the first error
+    only, the thread then skips its work and Check_Thread_Error exits after the region.
+*/
+void Thread_Error(int code, char *message)
+{
+    #pragma omp critical (spatcon_thread_error)
+    {
+        if(thread_error == 0)
+        {
+            thread_error = code;
+            if(message != NULL)
+            {
+                printf("%s", message);
+            }
+        }
+    }
+}
+
+/* 1.4.0, after a parallel region, exit with the code of an error in it (see Thread_Error) */
+void Check_Thread_Error(void)
+{
+    int code;
+    if(thread_error != 0)
+    {
+        code = thread_error;
+        thread_error = 0;
+        exit(code);
+    }
+}
+
+/*   ***************
+     Free_Conv_Specs
+     ***************
+    1.4.0, release the memory that Init_Conv_Specs and Thread_Scratch allocated for specs, also if
+    Init_Conv_Specs did not finish; specs can then be freed again or used for the next one.
+*/
+void Free_Conv_Specs(struct conv_specs *specs)
+{
+    long int thread;
+    free(specs->clogc);
+    free(specs->mosaic_table[0]);
+    free(specs->mosaic_table[1]);
+    for(thread = 0; (specs->scratch != NULL) && (thread < specs->n_scratch); thread++)
+    {
+        if(specs->scratch[thread] != NULL)
+        {
+            Free_Scratch(specs->scratch[thread]);
+        }
+    }
+    free(specs->scratch);
+    specs->clogc = NULL;
+    specs->mosaic_table[0] = NULL;
+    specs->mosaic_table[1] = NULL;
+    specs->scratch = NULL;
+    specs->n_scratch = 0;
+}
+
+/* 1.4.0, release what Freq_Conv allocated (see conv_state), after the convolution or an error */
+void Free_Conv_State(void)
+{
+    free(conv_state.rows);
+    conv_state.rows = NULL;
+    Free_Conv_Specs(&conv_state.specs);
+    Free_Sat_Tables();
+}
+
+/*   *************
+     Alloc_Scratch
+     *************
+    1.4.0, n_bytes of zeroed memory for one thread, aligned to and padded to whole cache lines so that
+    the scratch memory of two threads never shares a line, or NULL. Free it with Free_Scratch.
+*/
+void *Alloc_Scratch(long int n_bytes)
+{
+    void *scratch;
+    n_bytes = ( (n_bytes + 63) / 64) * 64;
+#if defined(_WIN32)
+    scratch = _aligned_malloc(n_bytes, 64);
+#else
+    if(posix_memalign(&scratch, 64, n_bytes) != 0)
+    {
+        scratch = NULL;
+    }
+#endif
+    if(scratch == NULL)
+    {
+        return(NULL);
+    }
+    memset(scratch, 0, n_bytes);
+    return(scratch);
+}
+
+void Free_Scratch(void *scratch)
+{
+#if defined(_WIN32)
+    _aligned_free(scratch);
+#else
+    free(scratch);
+#endif
+}
+
+/*   ****************
+     Conv_Column_Hist
+     ****************
+    1.4.0, engine 1 (parameter e), output rows first_row ... last_row - 1 of a band, see Conv_Band.
+    After Perreault and Hebert (2007), median filtering in constant time. col_hist keeps the
+    frequency distn of each map column over the window_size rows under the window; moving down a
+    row changes two pixels per column, and moving the window right subtracts the column on the left
+    and adds the column on the right. Columns outside the map are window_size missing pixels.
+    The cost per pixel is O(n_colors_in_image) for any window size, and freq_ptr holds exactly the
+    counts the sliding window of Conv_Row would, so the output is the same.
+    Only for rules that count pixels (specs->color_freq). col_hist has room for
+    specs->n_cols_in * specs->array_length counts and must be zero on entry; the counts of col_hist
+    and freq_ptr are specs->count_width bytes.
+*/
+static inline void Column_Hist_Rows(struct conv_specs *specs, unsigned char **rows, long int first_row,
+                                    long int last_row, void *col_hist, void *freq_ptr, unsigned char *out,
+                                    float *out_float, long int out_stride, int width)
+{
+    long int n_bins, n_cols_in, window_size, buff_b, row, c, k, grain_col, temp_int;
+    void *hist;
+    unsigned char *out_row;
+    float *out_row_float;
+    n_bins = specs->array_length;
+    n_cols_in = specs->n_cols_in;
+    window_size = specs->window_size;
+    buff_b = specs->buff_b;
+    out_row = NULL;
+    out_row_float = NULL;
+    /* the column histograms for the first output row */
+    for(k = 0; k < window_size; k++)
+    {
+        for(c = 0; c < n_cols_in; c++)
+        {
+            temp_int = Window_Pixel(specs, rows[first_row + k], c + buff_b, 1);
+            Add_Count(col_hist, (c * n_bins) + temp_int, 1, width);
+        }
+    }
+    for(row = first_row; row < last_row; row++)
+    {
+        if(row > first_row)
+        {
+            /* move the column histograms down one row */
+            for(c = 0; c < n_cols_in; c++)
+            {
+                hist = (char *)col_hist + (c * n_bins * width);
+                temp_int = Window_Pixel(specs, rows[row - 1], c + buff_b, 1);
+                Add_Count(hist, temp_int, -1, width);
+                temp_int = Window_Pixel(specs, rows[row + window_size - 1], c + buff_b, 1);
+                Add_Count(hist, temp_int, 1, width);
+            }
+        }
+        if(parameters.outfloat == 0)
+        {
+            out_row = out + (row * out_stride);
+        }
+        if(parameters.outfloat == 1)
+        {
+            out_row_float = out_float + (row * out_stride);
+        }
+        /* Seed with the first placement on the left, buff_b columns are outside the map */
+        memset(freq_ptr, 0, n_bins * width);
+        Add_Count(freq_ptr, 0, buff_b * window_size, width);
+        for(c = 0; c <= buff_b; c++)
+        {
+            hist = (char *)col_hist + (c * n_bins * width);
+            for(temp_int = 0; temp_int < n_bins; temp_int++)
+            {
+                Add_Count(freq_ptr, temp_int, Get_Count(hist, temp_int, width), width);
+            }
+        }
+        Store_Value(specs, freq_ptr, out_row, out_row_float, 0);
+        /* Proceed to the right, subtracting and adding whole columns */
+        for(grain_col = 1; grain_col < specs->n_places_right; grain_col++)
+        {
+            c = grain_col - 1 - buff_b;     /* the column leaving on the left */
+            if(c < 0)
+            {
+                Add_Count(freq_ptr, 0, -window_size, width);
+            }
+            else
+            {
+                hist = (char *)col_hist + (c * n_bins * width);
+                for(temp_int = 0; temp_int < n_bins; temp_int++)
+                {
+                    Add_Count(freq_ptr, temp_int, -Get_Count(hist, temp_int, width), width);
+                }
+            }
+            c = grain_col + buff_b;     /* the column entering on the right */
+            if(c >= n_cols_in)
+            {
+                Add_Count(freq_ptr, 0, window_size, width);
+            }
+            else
+            {
+                hist = (char *)col_hist + (c * n_bins * width);
+                for(temp_int = 0; temp_int < n_bins; temp_int++)
+                {
+                    Add_Count(freq_ptr, temp_int, Get_Count(hist, temp_int, width), width);
+                }
+            }
+            Store_Value(specs, freq_ptr, out_row, out_row_float, grain_col);
+        }
+    }
+}
+
+void Conv_Column_Hist(struct conv_specs *specs, unsigned char **rows, long int first_row, long int last_row,
+                      void *col_hist, void *freq_ptr, unsigned char *out, float *out_float,
+                      long int out_stride)
+{
+    if(specs->count_width == 2)
+    {
+        Column_Hist_Rows(specs, rows, first_row, last_row, col_hist, freq_ptr, out, out_float, out_stride, 2);
+    }
+    else
+    {
+        Column_Hist_Rows(specs, rows, first_row, last_row, col_hist, freq_ptr, out, out_float, out_stride, 4);
+    }
+}
+
+/* 1.4.0, total of the rectangle between table rows top and bottom (offsets into the table) and
+   table columns left and right of a summed-area table, see Conv_Summed_Area */
+static inline long int Table_Sum(unsigned int *plane, long int top, long int bottom, long int left, long int right)
+{
+    return( (unsigned int)( (*(plane + bottom + right)) - (*(plane + bottom + left))
+                            - (*(plane + top + right)) + (*(plane + top + left)) ) );
+}
+
+/*   ****************
+     Conv_Summed_Area
+     ****************
+    1.4.0, engine 2 (parameter e), rules 81, 82 and 83, a band of output rows as in Conv_Band.
+    The local color codes have been collapsed to 0 = missing, 1 = code_1, 2 = code_2, 3 = other (see
+    Init_Conv_Specs). Three summed-area tables (integral images) over the band and its window rows
+    hold the running totals of pixels that are not missing, code_1 and code_2, so the counts in any
+    window take four reads each. Rows and columns outside the map add nothing, which makes them missing.
+    The totals are unsigned 4-byte integers: they may wrap around on a large band, but a window
+    difference is less than 2^32 and unsigned arithmetic is modulo 2^32, so the counts are exact.
+*/
+void Conv_Summed_Area(struct conv_specs *specs, unsigned char **rows, long int n_out_rows,
+                      unsigned char *out, float *out_float, long int out_stride)
+{
+    long int n_sat_rows, n_sat_cols, plane_size, window_size, buff_b, n_cols_in, grain, row, col;
+    unsigned int *sat;
+    window_size = specs->window_size;
+    buff_b = specs->buff_b;
+    n_cols_in = specs->n_cols_in;
+    grain = specs->grain;
+    /* table row r, col c holds the totals of the first r rows and first c columns of the band */
+    n_sat_rows = ( (n_out_rows - 1) * grain) + window_size + 1;
+    n_sat_cols = n_cols_in + 1;
+    plane_size = n_sat_rows * n_sat_cols;
+    sat = Sat_Tables(3, plane_size, n_sat_cols);
+    /* running totals along each row... */
+    #pragma omp parallel for private(row, col)
+    for(row = 1; row < n_sat_rows; row++)
+    {
+        long int temp_int;
+        unsigned int n_valid, n_code_1, n_code_2;
+        unsigned int *sat_row;
+        unsigned char *row_in;
+        row_in = rows[row - 1];
+        sat_row = sat + (row * n_sat_cols);
+        if(row_in == NULL)     /* above or below the map, all zero */
+        {
+            memset(sat_row, 0, n_sat_cols * sizeof(unsigned int));
+            memset(sat_row + plane_size, 0, n_sat_cols * sizeof(unsigned int));
+            memset(sat_row + (2 * plane_size), 0, n_sat_cols * sizeof(unsigned int));
+            continue;
+        }
+        n_valid = 0;
+        n_code_1 = 0;
+        n_code_2 = 0;
+        for(col = 0; col < n_cols_in; col++)
+        {
+            temp_int = specs->color_lut[(*(row_in + col))];
+            n_valid += (temp_int != 0);
+            n_code_1 += (temp_int == 1);
+            n_code_2 += (temp_int == 2);
+            (*(sat_row + col + 1)) = n_valid;
+            (*(sat_row + plane_size + col + 1)) = n_code_1;
+            (*(sat_row + (2 * plane_size) + col + 1)) = n_code_2;
+        }
+    }
+    /* ...then down each column */
+    Sum_Table_Columns(sat, 3, plane_size, n_sat_rows, n_sat_cols);
+    /* the window of output row 'row' covers table rows row * grain ... row * grain + window_size */
+    #pragma omp parallel for private(row, col)
+    for(row = 0; row < n_out_rows; row++)
+    {
+        unsigned int freq_ptr[4];       /* 4-byte counts, see Init_Conv_Specs */
+        long int top, bottom, left, right, n_valid, place;
+        unsigned char *out_row;
+        float *out_row_float;
+        out_row = NULL;
+        out_row_float = NULL;
+        if(parameters.outfloat == 0)
+        {
+            out_row = out + (row * out_stride);
+        }
+        if(parameters.outfloat == 1)
+        {
+            out_row_float = out_float + (row * out_stride);
+        }
+        top = (row * grain) * n_sat_cols;
+        bottom = ( (row * grain) + window_size) * n_sat_cols;
+        for(place = 0; place < specs->n_places_right; place++)
+        {
+            col = place * grain;
+            /* the columns of the window that are in the map */
+            left = (col > buff_b) ? (col - buff_b) : 0;
+            right = ( (col + buff_b) < n_cols_in) ? (col + buff_b + 1) : n_cols_in;
+            n_valid = Table_Sum(sat, top, bottom, left, right);
+            freq_ptr[1] = Table_Sum(sat + plane_size, top, bottom, left, right);
+            freq_ptr[2] = Table_Sum(sat + (2 * plane_size), top, bottom, left, right);
+            freq_ptr[0] = (window_size * window_size) - n_valid;
+            freq_ptr[3] = n_valid - freq_ptr[1] - freq_ptr[2];
+            Store_Value(specs, freq_ptr, out_row, out_row_float, place);
+        }
+    }
+}
+
+/*   ***************
+     Conv_Bit_Planes
+     ***************
+    1.4.0, engine 4 (parameter e), maps with at most 3 pixel values besides missing, e.g. the 0/1/2 of
+    an MSPA-compliant map, or any map for rules 75-78 and 81-83 (which collapse it, see Init_Conv_Specs).
+    A band of output rows as in Conv_Band. Each row of the band and its window rows becomes one bit
+    plane per local color code, 64 buffered columns to a word (see Set_Row_Planes); the adjacencies of
+    colors a,b are the bits of plane a ANDed with plane b of the row below (vertical) or shifted one
+    column (horizontal). Each thread keeps the count of every plane in each column under the window.
+    Moving the window down a row only visits the bits that differ between the row (or pair of rows)
+    that leaves and the one that enters, so whole words of a patch or background are skipped, and
+    moving it right subtracts and adds whole columns as in Conv_Column_Hist. The cost per pixel is
+    independent of the window size, and freq_ptr holds exactly the counts of the sliding window, so
+    the output is the same. The planes take half a byte per pixel of the band for 4 codes.
+*/
+/* 1.4.0, engine 4, the bit planes of one buffered row: bit c of plane k is set if buffered column c is
+   local color k. Rows above or below the map and the buffer columns are missing (plane 0). */
+void Set_Row_Planes(struct conv_specs *specs, unsigned char *row_in, unsigned long long *row_planes,
+                    long int n_codes, long int n_words, long int n_buf_cols)
+{
+    long int word, bit, n_bits, code;
+    unsigned long long bits[4];
+    for(word = 0; (word * 64) < n_buf_cols; word++)
+    {
+        for(code = 0; code < n_codes; code++)
+        {
+            bits[code] = 0;
+        }
+        n_bits = min(64, n_buf_cols - (word * 64));
+        for(bit = 0; bit < n_bits; bit++)
+        {
+            code = Window_Pixel(specs, row_in, (word * 64) + bit, 1);
+            bits[code] |= 1ULL << bit;
+        }
+        for(code = 0; code < n_codes; code++)
+        {
+            (*(row_planes + (code * n_words) + word)) = bits[code];
+        }
+    }
+}
+
+/* 1.4.0, engine 4, add change to the column counts of the columns whose bits are set in word 'word' */
+SLIDE_INLINE void Count_Bits(unsigned int *counts, unsigned long long bits, long int word, int change)
+{
+    counts += word << 6;
+    while(bits != 0)
+    {
+        (*(counts + Low_Bit(bits))) += change;
+        bits &= bits - 1;
+    }
+}
+
+/* 1.4.0, engine 4, the column counts of a plane when the bits 'leaving' leave the window and the
+   bits 'entering' enter it; columns set in both keep their count */
+SLIDE_INLINE void Move_Bits(unsigned int *counts, unsigned long long leaving, unsigned long long entering,
+                            long int word)
+{
+    if(leaving != entering)
+    {
+        Count_Bits(counts, entering & (~leaving), word, 1);
+        Count_Bits(counts, leaving & (~entering), word, -1);
+    }
+}
+
+/* 1.4.0, engine 4, word 'word' of the bits of color a in band row 'row' that have color b on their right
+   (horizontal adjacencies, indexed by the left pixel) or below them (vertical, by the upper pixel).
+   A row of -1 has no bits. */
+static inline unsigned long long Pair_Word(unsigned long long *planes, long int n_codes, long int n_words,
+                                           long int row, long int a, long int b, long int word, int vertical)
+{
+    unsigned long long *plane_a, *plane_b;
+    if(row < 0)
+    {
+        return(0);
+    }
+    plane_a = planes + (( (row * n_codes) + a) * n_words);
+    if(vertical)
+    {
+        plane_b = planes + (( ( (row + 1) * n_codes) + b) * n_words);
+        return(plane_a[word] & plane_b[word]);
+    }
+    plane_b = planes + (( (row * n_codes) + b) * n_words);
+    return(plane_a[word] & ( (plane_b[word] >> 1) | (plane_b[word + 1] << 63) ) );
+}
+
+/* 1.4.0, engine 4, move the column counts from band row 'leave' to band row 'enter' (colors and
+   horizontal adjacencies) and from the vertical adjacencies of rows leave_pair, leave_pair + 1 to those
+   of enter_pair, enter_pair + 1. A row of -1 is nothing. */
+SLIDE_INLINE void Move_Down(struct conv_specs *specs, unsigned long long *planes, long int n_words,
+                            long int leave, long int enter, long int leave_pair, long int enter_pair,
+                            unsigned int *col_counts)
+{
+    long int n_codes, n_buf_cols, word, a, b, plane;
+    n_codes = specs->n_colors_in_image + 1;
+    n_buf_cols = specs->n_cols_in + specs->window_size - 1;
+    for(word = 0; word < n_words - 1; word++)
+    {
+        if(specs->color_freq)
+        {
+            for(a = 0; a < n_codes; a++)
+            {
+                Move_Bits(col_counts + (a * n_buf_cols),
+                          (leave < 0) ? 0 : planes[( (leave * n_codes) + a) * n_words + word],
+                          planes[( (enter * n_codes) + a) * n_words + word], word);
+            }
+            continue;
+        }
+        plane = 0;
+        for(a = 0; a < n_codes; a++)
+        {
+            for(b = 0; b < n_codes; b++)
+            {
+                Move_Bits(col_counts + (plane * n_buf_cols),
+                          Pair_Word(planes, n_codes, n_words, leave, a, b, word, 0),
+                          Pair_Word(planes, n_codes, n_words, enter, a, b, word, 0), word);
+                Move_Bits(col_counts + ( (plane + (n_codes * n_codes)) * n_buf_cols),
+                          Pair_Word(planes, n_codes, n_words, leave_pair, a, b, word, 1),
+                          Pair_Word(planes, n_codes, n_words, enter_pair, a, b, word, 1), word);
+                plane++;
+            }
+        }
+    }
+}
+
+/* 1.4.0, engine 4, output rows first_row ... last_row - 1 of a band, see Conv_Bit_Planes. col_counts has
+   room for the column counts of every plane and freq_ptr for specs->array_length counts, both zero. */
+static inline void Bit_Plane_Rows(struct conv_specs *specs, unsigned long long *planes, long int n_words,
+                                  long int first_row, long int last_row, unsigned int *col_counts,
+                                  void *freq_ptr, unsigned char *out, float *out_float, long int out_stride,
+                                  int width)
+{
+    long int row, grain_col, c, n_codes, n_cells, n_buf_cols, window_size, cell, change;
+    unsigned int *h_counts, *v_counts;
+    unsigned char *out_row;
+    float *out_row_float;
+    window_size = specs->window_size;
+    n_codes = specs->n_colors_in_image + 1;
+    n_cells = n_codes * n_codes;
+    n_buf_cols = specs->n_cols_in + window_size - 1;
+    h_counts = col_counts;
+    v_counts = col_counts + (n_cells * n_buf_cols);
+    /* the window of output row 'row' covers band rows row ... row + window_size - 1, and the vertical */
+    /*   adjacencies of rows row ... row + window_size - 2 with the row below */
+    for(row = first_row; row < first_row + window_size; row++)
+    {
+        Move_Down(specs, planes, n_words, -1, row, -1, (row > first_row) ? (row - 1) : -1, col_counts);
+    }
+    for(row = first_row; row < last_row; row++)
+    {
+        if(row > first_row)
+        {
+            Move_Down(specs, planes, n_words, row - 1, row + window_size - 1, row - 1, row + window_size - 2,
+                      col_counts);
+        }
+        out_row = NULL;
+        out_row_float = NULL;
+        if(parameters.outfloat == 0)
+        {
+            out_row = out + (row * out_stride);
+        }
+        if(parameters.outfloat == 1)
+        {
+            out_row_float = out_float + (row * out_stride);
+        }
+        /* the first placement: buffered columns 0 ... window_size - 1 */
+        for(cell = 0; cell < specs->array_length; cell++)
+        {
+            change = 0;
+            for(c = 0; c < window_size; c++)
+            {
+                if(specs->color_freq)
+                {
+                    change += col_counts[(cell * n_buf_cols) + c];
+                }
+                else
+                {
+                    change += v_counts[(cell * n_buf_cols) + c];
+                    if(c < window_size - 1)
+                    {
+                        change += h_counts[(cell * n_buf_cols) + c];
+                    }
+                }
+            }
+            Add_Count(freq_ptr, cell, change - Get_Count(freq_ptr, cell, width), width);
+        }
+        Store_Value(specs, freq_ptr, out_row, out_row_float, 0);
+        /* Proceed to the right, subtracting and adding whole columns */
+        for(grain_col = 1; grain_col < specs->n_places_right; grain_col++)
+        {
+            for(cell = 0; cell < specs->array_length; cell++)
+            {
+                if(specs->color_freq)
+                {
+                    change = (long int)col_counts[(cell * n_buf_cols) + grain_col + window_size - 1] -
+                             col_counts[(cell * n_buf_cols) + grain_col - 1];
+                }
+                else
+                {
+                    change = (long int)v_counts[(cell * n_buf_cols) + grain_col + window_size - 1] -
+                             v_counts[(cell * n_buf_cols) + grain_col - 1] +
+                             h_counts[(cell * n_buf_cols) + grain_col + window_size - 2] -
+                             h_counts[(cell * n_buf_cols) + grain_col - 1];
+                }
+                Add_Count(freq_ptr, cell, change, width);
+            }
+            Store_Value(specs, freq_ptr, out_row, out_row_float, grain_col);
+        }
+    }
+}
+
+void Conv_Bit_Planes(struct conv_specs *specs, unsigned char **rows, long int n_out_rows,
+                     unsigned char *out, float *out_float, long int out_stride)
+{
+    long int n_codes, n_band_rows, n_buf_cols, n_words, n_planes, n_chunks, chunk, row;
+    unsigned long long *planes;
+    n_codes = specs->n_colors_in_image + 1;
+    n_band_rows = n_out_rows + specs->window_size - 1;
+    n_buf_cols = specs->n_cols_in + specs->window_size - 1;
+    n_words = ( (n_buf_cols + 63) / 64) + 1;     /* and a zero word for the shift */
+    if( (planes = (unsigned long long *)calloc( n_band_rows * n_codes * n_words,
+                  sizeof(unsigned long long) ) ) == NULL )
+    {
+        printf("\nSpatcon: Error. Not enough memory for the bit planes.\n");
+        exit(57);
+    }
+    #pragma omp parallel for private(row)
+    for(row = 0; row < n_band_rows; row++)
+    {
+        Set_Row_Planes(specs, rows[row], planes + (row * n_codes * n_words), n_codes, n_words, n_buf_cols);
+    }
+    /* column counts of the colors, or of the horizontal then the vertical adjacencies */
+    n_planes = n_codes;
+    if(specs->edge_freq == 1)
+    {
+        n_planes = 2 * n_codes * n_codes;
+    }
+    /* each thread moves down its own block of rows */
+    n_chunks = omp_get_max_threads();
+    if(n_chunks > n_out_rows)
+    {
+        n_chunks = n_out_rows;
+    }
+    #pragma omp parallel for private(chunk)
+    for(chunk = 0; chunk < n_chunks; chunk++)
+    {
+        void *freq_ptr = 0;
+        unsigned int *col_counts = 0;
+        if( ( (freq_ptr = calloc( specs->array_length, specs->count_width ) ) == NULL ) ||
+                ( (col_counts = (unsigned int *)calloc( n_planes * n_buf_cols, sizeof(unsigned int) ) ) == NULL ) )
+        {
+            Thread_Error(28, "\nSpatcon: Error. Memory allocation failed in parallel part of Freq_Conv.\n");
+        }
+        else if(specs->count_width == 2)
+        {
+            Bit_Plane_Rows(specs, planes, n_words, (n_out_rows * chunk) / n_chunks,
+                           (n_out_rows * (chunk + 1)) / n_chunks, col_counts, freq_ptr, out, out_float,
+                           out_stride, 2);
+        }
+        else
+        {
+            Bit_Plane_Rows(specs, planes, n_words, (n_out_rows * chunk) / n_chunks,
+                           (n_out_rows * (chunk + 1)) / n_chunks, col_counts, freq_ptr, out, out_float,
+                           out_stride, 4);
+        }
+        free(col_counts);
+        free(freq_ptr);
+    }
+    free(planes);
+}
+
+/*   **********
+     Sat_Tables
+     **********
+    1.4.0, n_planes summed-area tables of plane_size entries, n_sat_cols to a row, for Conv_Summed_Area
+    and Conv_Summed_Area_Edges. The tables are kept in conv_state for the next band, column tile, window
+    size or rule group of the run and only grow when one needs more, so a streamed run allocates them
+    about once at the size Plan_Memory counted for. Row 0 and column 0 of each plane are set to zero;
+    the callers set every other entry.
+*/
+unsigned int *Sat_Tables(long int n_planes, long int plane_size, long int n_sat_cols)
+{
+    long int plane, row;
+    if(n_planes * plane_size > conv_state.sat_entries)
+    {
+        Free_Sat_Tables();
+        if( (conv_state.sat = (unsigned int *)malloc( n_planes * plane_size * sizeof(unsigned int) ) ) == NULL )
+        {
+            printf("\nSpatcon: Error. Not enough memory for the summed-area tables.\n");
+            exit(52);
+        }
+        conv_state.sat_entries = n_planes * plane_size;
+    }
+    for(plane = 0; plane < n_planes; plane++)
+    {
+        memset(conv_state.sat + (plane * plane_size), 0, n_sat_cols * sizeof(unsigned int));
+        for(row = 1; (row * n_sat_cols) < plane_size; row++)
+        {
+            (*(conv_state.sat + (plane * plane_size) + (row * n_sat_cols))) = 0;
+        }
+    }
+    return(conv_state.sat);
+}
+
+/* 1.4.0, release the summed-area tables at the end of a run or after an error */
+void Free_Sat_Tables(void)
+{
+    free(conv_state.sat);
+    conv_state.sat = NULL;
+    conv_state.sat_entries = 0;
+}
+
+/*   *****************
+     Sum_Table_Columns
+     *****************
+    1.4.0, second step of building n_planes summed-area tables: each table row already holds the
+    running totals along the row, add them down the columns. Table row 0 and column 0 are zero.
+*/
+void Sum_Table_Columns(unsigned int *sat, long int n_planes, long int plane_size, long int n_sat_rows,
+                       long int n_sat_cols)
+{
+    long int col;
+    #pragma omp parallel for private(col)
+    for(col = 1; col < n_sat_cols; col++)
+    {
+        long int plane, row, index;
+        for(row = 2; row < n_sat_rows; row++)
+        {
+            index = (row * n_sat_cols) + col;
+            for(plane = 0; plane < n_planes; plane++)
+            {
+                (*(sat + (plane * plane_size) + index)) += (*(sat + (plane * plane_size) + index - n_sat_cols));
+            }
+        }
+    }
+}
+
+/*   **********************
+     Conv_Summed_Area_Edges
+     **********************
+    1.4.0, engine 2 (parameter e), rules 75, 76, 77 and 78, a band of output rows as in Conv_Band.
+    With the local color codes collapsed as for Conv_Summed_Area (k1 = code_1, k2 = code_2), these rules
+    only read four numbers from the adjacency matrix, counting each edge once whatever its order:
+        D = edges k1-k1,
+        X = edges k1-k2 (rules 76 and 78, k2 different from k1),
+        A = edges between k1 and another code, not missing if missing values are ignored (h 1),
+        Q = edges with a missing pixel (h 1).
+    There is one summed-area table of each for the vertical edges, indexed by the upper pixel, and one
+    for the horizontal edges, indexed by the left pixel. The tables cover the buffered columns, because
+    edges between two pixels outside the map are missing-missing edges. For each window the four numbers
+    are put back into a 4x4 adjacency matrix that gives Freq_Filters the same row, column, cell and
+    non-missing totals as the full matrix would, so the output is the same.
+*/
+void Conv_Summed_Area_Edges(struct conv_specs *specs, unsigned char **rows, long int n_out_rows,
+                            unsigned char *out, float *out_float, long int out_stride)
+{
+    long int n_band_rows, n_band_cols, n_sat_rows, n_sat_cols, plane_size, window_size, grain, row, col;
+    long int k1, k2, start, use_x;
+    unsigned int *sat;
+    window_size = specs->window_size;
+    grain = specs->grain;
+    k1 = specs->code_1;
+    k2 = specs->code_2;
+    use_x = 0;
+    for(row = 0; row < specs->n_rules; row++)
+    {
+        if( (specs->mapping_rules[row] == 76) || (specs->mapping_rules[row] == 78) )
+        {
+            use_x = (k2 != k1);
+        }
+    }
+    start = 1;  /* don't count edges with missing */
+    if(specs->handle_missing == 2)
+    {
+        start = 0;    /*missing included*/
+    }
+    /* the band and its window rows, with the buffer columns on both sides */
+    n_band_rows = ( (n_out_rows - 1) * grain) + window_size;
+    n_band_cols = specs->n_cols_in + window_size - 1;
+    n_sat_rows = n_band_rows + 1;
+    n_sat_cols = n_band_cols + 1;
+    plane_size = n_sat_rows * n_sat_cols;
+    /* planes 0-3 are D, X, A, Q for vertical edges, planes 4-7 for horizontal edges */
+    sat = Sat_Tables(8, plane_size, n_sat_cols);
+    #pragma omp parallel for private(row, col)
+    for(row = 0; row < n_band_rows; row++)
+    {
+        long int t1, t2, plane, edge;
+        unsigned int totals[8];
+        unsigned int *sat_row;
+        for(plane = 0; plane < 8; plane++)
+        {
+            totals[plane] = 0;
+        }
+        sat_row = sat + ((row + 1) * n_sat_cols) + 1;
+        for(col = 0; col < n_band_cols; col++)
+        {
+            t1 = Window_Pixel(specs, rows[row], col, 1);  /*this cell*/
+            for(edge = 0; edge < 2; edge++)
+            {
+                if(edge == 0)
+                {
+                    if(row == n_band_rows - 1)
+                    {
+                        continue;
+                    }
+                    t2 = Window_Pixel(specs, rows[row + 1], col, 1); /*cell below*/
+                }
+                else
+                {
+                    if(col == n_band_cols - 1)
+                    {
+                        continue;
+                    }
+                    t2 = Window_Pixel(specs, rows[row], col + 1, 1); /*cell at right*/
+                }
+                plane = 4 * edge;
+                totals[plane] += ( (t1 == k1) && (t2 == k1) );
+                totals[plane + 1] += use_x && ( ( (t1 == k1) && (t2 == k2) ) || ( (t1 == k2) && (t2 == k1) ) );
+                totals[plane + 2] += ( (t1 == k1) && (t2 != k1) && (t2 >= start) ) ||
+                                     ( (t2 == k1) && (t1 != k1) && (t1 >= start) );
+                totals[plane + 3] += ( (t1 == 0) || (t2 == 0) );
+            }
+            for(plane = 0; plane < 8; plane++)
+            {
+                (*(sat_row + (plane * plane_size) + col)) = totals[plane];
+            }
+        }
+    }
+    Sum_Table_Columns(sat, 8, plane_size, n_sat_rows, n_sat_cols);
+    /* the window of output row 'row' and column 'place' covers buffered rows row * grain ... */
+    /*   row * grain + window_size - 1 and buffered columns col ... col + window_size - 1, col = place * grain */
+    #pragma omp parallel for private(row, col)
+    for(row = 0; row < n_out_rows; row++)
+    {
+        unsigned int freq_ptr[16];
+        long int counts[4], plane, temp_int, place;
+        long int v_top, v_bottom, h_top, h_bottom;
+        unsigned char *out_row;
+        float *out_row_float;
+        out_row = NULL;
+        out_row_float = NULL;
+        if(parameters.outfloat == 0)
+        {
+            out_row = out + (row * out_stride);
+        }
+        if(parameters.outfloat == 1)
+        {
+            out_row_float = out_float + (row * out_stride);
+        }
+        /* vertical edges start in the first window_size - 1 rows, horizontal edges in the first */
+        /*   window_size - 1 columns */
+        v_top = (row * grain) * n_sat_cols;
+        v_bottom = ( (row * grain) + window_size - 1) * n_sat_cols;
+        h_top = v_top;
+        h_bottom = ( (row * grain) + window_size) * n_sat_cols;
+        for(place = 0; place < specs->n_places_right; place++)
+        {
+            col = place * grain;
+            for(plane = 0; plane < 4; plane++)
+            {
+                counts[plane] = Table_Sum(sat + (plane * plane_size), v_top, v_bottom, col, col + window_size) +
+                                Table_Sum(sat + ((plane + 4) * plane_size), h_top, h_bottom, col, col + window_size - 1);
+            }
+            for(temp_int = 0; temp_int < 16; temp_int++)
+            {
+                freq_ptr[temp_int] = 0;
+            }
+            /* D in the diagonal cell, X in cell k1,k2 and the rest of A in cell k1,3 */
+            (*(freq_ptr + (k1 * 4) + k1)) = counts[0];
+            temp_int = counts[2];
+            if(use_x)
+            {
+                (*(freq_ptr + (k1 * 4) + k2)) = counts[1];
+                if(k2 >= start)
+                {
+                    temp_int -= counts[1];
+                }
+            }
+            (*(freq_ptr + (k1 * 4) + 3)) = temp_int;
+            if(start == 1)
+            {
+                /* cell 3,3 makes up the edges without missing pixels */
+                temp_int = constants.number_of_edges - counts[3];
+                if(k1 > 0)
+                {
+                    temp_int -= counts[0] + (*(freq_ptr + (k1 * 4) + 3));
+                    if(use_x && (k2 > 0) )
+                    {
+                        temp_int -= counts[1];
+                    }
+                }
+                (*(freq_ptr + 15)) = temp_int;
+            }
+            Store_Value(specs, freq_ptr, out_row, out_row_float, place);
+        }
+    }
+}
+
+/*   ****************
+     Freq_Conv_Stream
+     ****************
+    1.4.0, streaming version of Freq_Conv (parameter s > 0) for maps that do not fit in memory.
+    Only a ring of window_size + band_height input rows is kept. Each band of band_height
+    output rows is convolved in parallel with Conv_Band and written out before the next band is read,
+    so memory is O(n_cols * (window_size + band_height)) instead of O(n_rows * n_cols).
+    The input is read twice: a first pass finds the local color codes in the same order as
+    Freq_Conv would number them, so the output is identical to the whole-image convolution.
+    Its rows are read in blocks that fill the ring, and each block is looked over in parallel.
+    infile is NULL when the input and output are memory-mapped (parameter i = 1).
+    recode_table is NULL if no re-coding was requested.
+    Where there are threads (IO_THREADS) the next band of input rows is read by a reader thread and
+    the finished output rows are written by a writer thread while the current band is convolved, see
+    Start_Io_Pipe. The ring then has room for a second band of rows, and there are two band buffers.
+*/
+long int Freq_Conv_Stream(FILE *infile, FILE *outfile, long int n_rows_in, long int n_cols_in,
+                          long int *recode_table)
+{
+    long int counter, n_colors_in_image[2], preserve_original_colors, ret_val, missing, lm_rules,
+         window_size, max_window_size, band_height, ring_rows, n_windows, band, n_rules, n_groups, group, rule;
+    long int buff_b, temp_int, row, index, band_start, band_end, out_size, el_size, rows_size;
+    long int code_1, code_2, tile_out, n_tiles, tile, tile_first, tile_end, in_first, in_cols, ring_cols, direct;
+    long int job, block_rows, first_seen[256];
+    long int in_to_out[2][256], out_to_in[2][256];
+    unsigned char *ring, *row_buffer, *row_in, *slot, **rows;
+    float *out_float;
+    double compute_time, start_time;
+    struct conv_specs specs[MAX_WINDOWS][4];
+    struct rule_group groups[4];
+    struct io_pipe pipe;
+
+    missing = parameters.missing_value_code;
+    n_windows = parameters.n_windows;
+    n_rules = parameters.n_rules;
+    band_height = parameters.stream_rows;
+    max_window_size = 0;
+    for(band = 0; band < n_windows; band++)
+    {
+        max_window_size = max(max_window_size, parameters.window_sizes[band]);
+    }
+    n_groups = Group_Rules(groups);
+    preserve_original_colors = 1;
+    for(group = 0; group < n_groups; group++)
+    {
+        Init_Color_Tables(in_to_out[groups[group].preserve], out_to_in[groups[group].preserve],
+                          groups[group].rules[0], missing);
+        if(groups[group].preserve == 0)
+        {
+            preserve_original_colors = 0;   /* some rules need local color codes */
+        }
+    }
+    lm_rules = (Uses_Rule(6) == 1) || (Uses_Rule(7) == 1);
+    buff_b = (max_window_size - 1) / 2;  /* one side of image */
+    ring_rows = max_window_size + band_height + (IO_THREADS * band_height);
+    /* column tiles of tile_out output columns (see Plan_Memory), each read with the buff_b columns of */
+    /*   the map on either side, so that its windows see the same pixels as in the whole map */
+    tile_out = n_cols_in;
+    if( (parameters.stream_cols > 0) && (parameters.stream_cols < n_cols_in) )
+    {
+        tile_out = parameters.stream_cols;
+    }
+    n_tiles = (n_cols_in + tile_out - 1) / tile_out;
+    ring_cols = min(n_cols_in, tile_out + (2 * buff_b));
+    direct = (parameters.io_mode == 1) && (n_tiles == 1);
+    printf("Spatcon: Convolution specs:\n     - Streaming %ld rows at a time through a ring of %ld input rows of %ld cols.\n",
+           band_height, ring_rows, ring_cols);
+    if(n_tiles > 1)
+    {
+        printf("     - In %ld column tiles of %ld output columns.\n", n_tiles, tile_out);
+    }
+    row_buffer = NULL;
+    rows = NULL;
+    if( ( (ring = (unsigned char *)malloc( ring_rows * ring_cols ) ) == NULL ) ||
+            ( (row_buffer = (unsigned char *)malloc( n_cols_in ) ) == NULL ) ||
+            ( (rows = (unsigned char **)malloc( (ring_rows * sizeof(unsigned char *)) ) ) == NULL ) )
+    {
+        printf("\nSpatcon: Error. Not enough memory for the streaming buffers.\n");
+        exit(49);
+    }
+    /* First pass: check landscape mosaic codes and number the local color codes, as Load_Map and */
+    /*   Number_Colors do for the whole map. The rows are read into the ring a block at a time and */
+    /*   First_Seen_Rows looks them over in parallel; the ring holds at least one whole row */
+    counter = 0;
+    if( (preserve_original_colors == 0) || (lm_rules == 1) )
+    {
+        printf("          - first pass, finding color codes\n");
+        for(temp_int = 0; temp_int < 256; temp_int++)
+        {
+            first_seen[temp_int] = -1;
+        }
+        block_rows = max( (ring_rows * ring_cols) / n_cols_in, 1);
+        for(row = 0; row < n_rows_in; row += block_rows)
+        {
+            for(index = 0; (index < block_rows) && (row + index < n_rows_in); index++)
+            {
+                slot = (block_rows == 1) ? row_buffer : ring + (index * n_cols_in);
+                row_in = Get_Input_Row(infile, row + index, n_cols_in, 0, n_cols_in, NULL, slot);
+#if defined(SPATCON_GEOTIFF)
+                if(geotiff.read == 1)
+                {
+                    /* the decoded strip or tiles are replaced as the next rows are read */
+                    memcpy(slot, row_in, n_cols_in);
+                    row_in = slot;
+                }
+#endif
+                rows[index] = row_in;
+            }
+            First_Seen_Rows(rows, index, row, n_cols_in, recode_table, first_seen);
+        }
+        for(temp_int = 4; (lm_rules == 1) && (temp_int < 256); temp_int++)
+        {
+            if(first_seen[temp_int] >= 0)
+            {
+                printf("\nSpatcon: Error. Input byte value must be in range [0,3] for landscape mosaics.\n");
+                exit(21);
+            }
+        }
+        if(preserve_original_colors == 0)
+        {
+            Number_Colors(first_seen, missing, in_to_out[0], out_to_in[0], &counter);
+        }
+        if(infile != NULL)
+        {
+            rewind(infile);
+        }
+    }
+    /* the options are checked after the map, in the same order as main and Freq_Conv, so a map */
+    /*   with pixel values out of range for the landscape mosaics gives the same error here */
+    for(band = 0; band < n_windows; band++)
+    {
+        for(rule = 0; rule < n_rules; rule++)
+        {
+            if( (ret_val = Check_Conv_Options(n_rows_in, n_cols_in, parameters.window_sizes[band],
+                                              parameters.map_rules[rule], parameters.handle_missing)) != 0)
+            {
+                free(ring);
+                free(row_buffer);
+                free(rows);
+                return(ret_val);
+            }
+        }
+    }
+    n_colors_in_image[0] = counter;  /* does not include missing */
+    n_colors_in_image[1] = 255;
+    /* output rows of rule k go to the band buffer + k * rows_size, or straight into the mapped output */
+    rows_size = band_height * ring_cols;
+    if(direct == 1)
+    {
+        rows_size = n_rows_in * n_cols_in;
+    }
+    code_1 = parameters.code_1;     /* as given by the user */
+    code_2 = parameters.code_2;
+    for(group = 0; group < n_groups; group++)
+    {
+        parameters.code_1 = code_1;
+        parameters.code_2 = code_2;
+        preserve_original_colors = groups[group].preserve;
+        Set_Local_Target_Codes(out_to_in[preserve_original_colors], groups[group].n_rules, groups[group].rules);
+        /* one set of specs for each window size (output band) */
+        for(band = 0; band < n_windows; band++)
+        {
+            if(n_windows > 1)
+            {
+                printf("     - Window size %ld\n", parameters.window_sizes[band]);
+            }
+            Init_Conv_Specs(&specs[band][group], parameters.window_sizes[band], n_cols_in,
+                            n_colors_in_image[preserve_original_colors], groups[group].n_rules, groups[group].rules,
+                            parameters.handle_missing, parameters.code_1, parameters.code_2,
+                            out_to_in[preserve_original_colors]);
+            for(rule = 0; rule < groups[group].n_rules; rule++)
+            {
+                specs[band][group].band_offsets[rule] = groups[group].bands[rule] * rows_size;
+            }
+            for(temp_int = 0; temp_int < 256; temp_int++)
+            {
+                specs[band][group].color_out[temp_int] = (unsigned char)in_to_out[preserve_original_colors][temp_int];
+            }
+        }
+    }
+    /* Output rows go to the band buffers of the writer, or straight into the mapped output file */
+    /*   (whole rows only) */
+    el_size = 1;
+    if(parameters.outfloat == 1)
+    {
+        el_size = sizeof(float);
+    }
+    out_size = n_rows_in * n_cols_in * n_windows * n_rules * el_size;
+    if(parameters.io_mode == 1)
+    {
+        if(parameters.outfloat == 0)
+        {
+            mat_out = (unsigned char *)Map_Output_File(out_size);
+        }
+        if(parameters.outfloat == 1)
+        {
+            mat_outfloat = (float *)Map_Output_File(out_size);
+        }
+    }
+    pipe.infile = infile;
+    pipe.outfile = outfile;
+    pipe.recode_table = recode_table;
+    pipe.ring = ring;
+    pipe.row_buffer = row_buffer;
+    pipe.ring_rows = ring_rows;
+    pipe.ring_cols = ring_cols;
+    pipe.n_rows_in = n_rows_in;
+    pipe.n_cols_in = n_cols_in;
+    pipe.n_tiles = n_tiles;
+    pipe.tile_out = tile_out;
+    pipe.buff_b = buff_b;
+    pipe.n_windows = n_windows;
+    pipe.n_rules = n_rules;
+    pipe.el_size = el_size;
+    pipe.rows_size = rows_size;
+    pipe.n_jobs = 1 + IO_THREADS;
+    for(job = 0; job < 2; job++)
+    {
+        pipe.jobs[job].data = NULL;
+        pipe.jobs[job].full = 0;
+        if( (direct == 0) && (job < pipe.n_jobs) &&
+                ( (pipe.jobs[job].data = (unsigned char *)malloc( el_size * n_rules * rows_size ) ) == NULL ) )
+        {
+            if(parameters.outfloat == 1)
+            {
+                printf("\nSpatcon: Error. Not enough memory for float output data, try parameter f = 0.\n");
+                exit(27);
+            }
+            printf("\nSpatcon: Error. Not enough memory for byte output data.\n");
+            exit(26);
+        }
+    }
+    omp_set_num_threads(omp_get_max_threads());
+    printf("     - Parellel processing maximum number of threads (cores) = %d \n", omp_get_max_threads());
+    /* Second pass: Conv_Row does the local codes. Each column tile goes through all the rows of the */
+    /*   map in turn. */
+    Start_Io_Pipe(&pipe);
+    compute_time = 0.0;
+    job = 0;
+    for(tile = 0; tile < n_tiles; tile++)
+    {
+        Tile_Columns(&pipe, tile, &tile_first, &tile_end, &in_first, &in_cols);
+        for(band = 0; band < n_windows; band++)
+        {
+            for(group = 0; group < n_groups; group++)
+            {
+                specs[band][group].n_cols_in = in_cols;
+                specs[band][group].n_places_right = in_cols;
+            }
+        }
+        for(band_start = 0; band_start < n_rows_in; band_start += band_height)
+        {
+            band_end = min(band_start + band_height, n_rows_in);
+            /* output row 'row' needs input rows row - buff_b ... row + buff_b */
+            Wait_For_Rows(&pipe, (tile * n_rows_in) + min(band_end + buff_b, n_rows_in));
+            /* the rows of every window size are in the ring, convolve them for each in turn */
+            for(band = 0; band < n_windows; band++)
+            {
+                window_size = parameters.window_sizes[band];
+                for(temp_int = 0; temp_int < (band_end - band_start + window_size - 1); temp_int++)
+                {
+                    index = band_start + temp_int - ((window_size - 1) / 2);
+                    rows[temp_int] = NULL;     /* above or below the map */
+                    if( (index >= 0) && (index < n_rows_in) )
+                    {
+                        rows[temp_int] = ring + ((((tile * n_rows_in) + index) % ring_rows) * ring_cols);
+                    }
+                }
+                /* the rows go to a band buffer, or to their place in the mapped output file */
+                if(direct == 1)
+                {
+                    index = (band * n_rules * n_rows_in + band_start) * n_cols_in;
+                    slot = (parameters.outfloat == 0) ? mat_out + index : NULL;
+                    out_float = (parameters.outfloat == 1) ? mat_outfloat + index : NULL;
+                }
+                else
+                {
+                    Wait_For_Job(&pipe, job);
+                    slot = (parameters.outfloat == 0) ? pipe.jobs[job].data : NULL;
+                    out_float = (parameters.outfloat == 1) ? (float *)pipe.jobs[job].data : NULL;
+                }
+                start_time = omp_get_wtime();
+                for(group = 0; group < n_groups; group++)
+                {
+                    Use_Conv_Specs(&specs[band][group]);
+                    Conv_Band(&specs[band][group], rows, band_end - band_start, slot, out_float, in_cols);
+                }
+                compute_time += omp_get_wtime() - start_time;
+                /* hand the finished rows to the writer */
+                if(direct == 0)
+                {
+                    pipe.jobs[job].window = band;
+                    pipe.jobs[job].band_start = band_start;
+                    pipe.jobs[job].band_end = band_end;
+                    pipe.jobs[job].tile = tile;
+                    Submit_Job(&pipe, job);
+                    job = (job + 1) % pipe.n_jobs;
                 }
             }
-            /* Update c_min and c_max */
-            c_min = new_c_min;
-            c_max = new_c_max;
-            /* Call the convolution function for this window, passing the distn*/
-            if(parameters.outfloat == 0)
+            /* the rows above the window of the next band can be read over */
+            if(band_end < n_rows_in)
             {
-                map_value = Freq_Filters(color_freq, edge_freq, freq_ptr, n_colors_in_image,
-                                         mapping_rule, handle_missing, code_1, code_2);
-                /* Map the results back for this grain */
-                grain_start_row = r_min + buff_b;
-                grain_start_col = c_min + buff_b;
-                index = grain_start_row * n_cols;
-                (*(mat_out + index + grain_start_col)) = map_value;
+                Release_Rows(&pipe, (tile * n_rows_in) + max(0, band_end - buff_b));
             }
-            if(parameters.outfloat == 1)
+            else
+            {
+                Release_Rows(&pipe, (tile + 1) * n_rows_in);
+            }
+        }
+    }
+    Stop_Io_Pipe(&pipe);
+    printf("     - Convolution %.2f s. Reading %.2f s and writing %.2f s%s, waiting %.2f s for input and %.2f s for output.\n",
+           compute_time, pipe.read_time, pipe.write_time, (pipe.threads == 1) ? " in the background" : "",
+           pipe.input_wait, pipe.output_wait);
+    if(parameters.io_mode == 1)
+    {
+        Release_Input();
+        if(Unmap_Output_File(out_size) != 0)
+        {
+            printf("\nSpatcon: Error writing output file.\n");
+            exit(24);
+        }
+    }
+    free(pipe.jobs[0].data);
+    free(pipe.jobs[1].data);
+    for(band = 0; band < n_windows; band++)
+    {
+        for(group = 0; group < n_groups; group++)
+        {
+            Free_Conv_Specs(&specs[band][group]);
+        }
+    }
+    Free_Sat_Tables();
+    free(rows);
+    free(row_buffer);
+    free(ring);
+    return(0);
+}
+
+/*   *************
+     Start_Io_Pipe
+     *************
+    1.4.0, the second pass of Freq_Conv_Stream overlaps its reads and writes with the convolution.
+    A reader thread fills the ring with input rows as far ahead as the rows still in use allow
+    (read_limit, see Release_Rows), and a writer thread writes each band_job, in the order they were
+    submitted, while the next band is convolved into the other job. The threads only wait on the one
+    mutex and condition of the pipe; everything else they touch is their own. Without pthreads
+    (IO_THREADS 0) the same calls read and write in line, as before.
+*/
+void Start_Io_Pipe(struct io_pipe *pipe)
+{
+    pipe->next_read = 0;
+    pipe->read_limit = min(pipe->ring_rows, pipe->n_tiles * pipe->n_rows_in);
+    pipe->next_job = 0;
+    pipe->stop = 0;
+    pipe->threads = 0;
+    pipe->read_time = 0.0;
+    pipe->write_time = 0.0;
+    pipe->input_wait = 0.0;
+    pipe->output_wait = 0.0;
+#if IO_THREADS
+    pthread_mutex_init(&pipe->lock, NULL);
+    pthread_cond_init(&pipe->changed, NULL);
+    if( (pthread_create(&pipe->reader, NULL, Reader_Thread, pipe) != 0) ||
+            (pthread_create(&pipe->writer, NULL, Writer_Thread, pipe) != 0) )
+    {
+        printf("\nSpatcon: Error. Could not start the reader and writer threads.\n");
+        exit(59);
+    }
+    pipe->threads = 1;
+#endif
+}
+
+/* 1.4.0, wait for the last job to be written and for the reader and writer to finish */
+void Stop_Io_Pipe(struct io_pipe *pipe)
+{
+#if IO_THREADS
+    if(pipe->threads == 1)
+    {
+        pthread_mutex_lock(&pipe->lock);
+        pipe->stop = 1;
+        pthread_cond_broadcast(&pipe->changed);
+        pthread_mutex_unlock(&pipe->lock);
+        pthread_join(pipe->reader, NULL);
+        pthread_join(pipe->writer, NULL);
+        pthread_cond_destroy(&pipe->changed);
+        pthread_mutex_destroy(&pipe->lock);
+    }
+#endif
+}
+
+/* 1.4.0, columns of column tile 'tile': output columns tile_first ... tile_end - 1, read as the in_cols
+   columns from in_first on */
+void Tile_Columns(struct io_pipe *pipe, long int tile, long int *tile_first, long int *tile_end,
+                  long int *in_first, long int *in_cols)
+{
+    *tile_first = tile * pipe->tile_out;
+    *tile_end = min(*tile_first + pipe->tile_out, pipe->n_cols_in);
+    *in_first = max(0, *tile_first - pipe->buff_b);
+    *in_cols = min(pipe->n_cols_in, *tile_end + pipe->buff_b) - *in_first;
+}
+
+/* 1.4.0, read input row g = next_read into its ring row. Only the reader calls this. */
+void Read_Ring_Row(struct io_pipe *pipe)
+{
+    long int tile, row, tile_first, tile_end, in_first, in_cols;
+    unsigned char *row_in;
+    tile = pipe->next_read / pipe->n_rows_in;
+    row = pipe->next_read % pipe->n_rows_in;
+    Tile_Columns(pipe, tile, &tile_first, &tile_end, &in_first, &in_cols);
+    if( (pipe->infile != NULL) && (tile > 0) && (row == 0) )
+    {
+        rewind(pipe->infile);
+    }
+    row_in = Get_Input_Row(pipe->infile, row, pipe->n_cols_in, in_first, in_cols, pipe->recode_table,
+                           pipe->row_buffer);
+    memcpy(pipe->ring + ((pipe->next_read % pipe->ring_rows) * pipe->ring_cols), row_in, in_cols);
+}
+
+/* 1.4.0, return when the input rows g < g_needed are in the ring */
+void Wait_For_Rows(struct io_pipe *pipe, long int g_needed)
+{
+    double start_time;
+    start_time = omp_get_wtime();
+#if IO_THREADS
+    if(pipe->threads == 1)
+    {
+        pthread_mutex_lock(&pipe->lock);
+        while(pipe->next_read < g_needed)
+        {
+            pthread_cond_wait(&pipe->changed, &pipe->lock);
+        }
+        pthread_mutex_unlock(&pipe->lock);
+        pipe->input_wait += omp_get_wtime() - start_time;
+        return;
+    }
+#endif
+    while(pipe->next_read < g_needed)
+    {
+        Read_Ring_Row(pipe);
+        pipe->next_read++;
+    }
+    pipe->read_time += omp_get_wtime() - start_time;
+}
+
+/* 1.4.0, the input rows g < g_low are no longer used, their ring rows may be read over */
+void Release_Rows(struct io_pipe *pipe, long int g_low)
+{
+#if IO_THREADS
+    if(pipe->threads == 1)
+    {
+        pthread_mutex_lock(&pipe->lock);
+    }
+#endif
+    pipe->read_limit = min(g_low + pipe->ring_rows, pipe->n_tiles * pipe->n_rows_in);
+#if IO_THREADS
+    if(pipe->threads == 1)
+    {
+        pthread_cond_broadcast(&pipe->changed);
+        pthread_mutex_unlock(&pipe->lock);
+    }
+#endif
+}
+
+/* 1.4.0, return when job k has been written and its buffer can be filled again */
+void Wait_For_Job(struct io_pipe *pipe, long int k)
+{
+#if IO_THREADS
+    double start_time;
+    if(pipe->threads == 1)
+    {
+        start_time = omp_get_wtime();
+        pthread_mutex_lock(&pipe->lock);
+        while(pipe->jobs[k].full == 1)
+        {
+            pthread_cond_wait(&pipe->changed, &pipe->lock);
+        }
+        pthread_mutex_unlock(&pipe->lock);
+        pipe->output_wait += omp_get_wtime() - start_time;
+    }
+#endif
+}
+
+/* 1.4.0, job k is filled, write it (or have the writer write it) */
+void Submit_Job(struct io_pipe *pipe, long int k)
+{
+    double start_time;
+#if IO_THREADS
+    if(pipe->threads == 1)
+    {
+        pthread_mutex_lock(&pipe->lock);
+        pipe->jobs[k].full = 1;
+        pthread_cond_broadcast(&pipe->changed);
+        pthread_mutex_unlock(&pipe->lock);
+        return;
+    }
+#endif
+    start_time = omp_get_wtime();
+    Write_Band(pipe, &pipe->jobs[k]);
+    pipe->write_time += omp_get_wtime() - start_time;
+}
+
+/* 1.4.0, write the output rows of a band_job to their place in the output file (or its mapping). A
+   whole-width band is written rule by rule, from a column tile only the columns tile_first ...
+   tile_end - 1, a row at a time. */
+void Write_Band(struct io_pipe *pipe, struct band_job *job)
+{
+    long int rule, row, index, offset, n_pixels, tile_first, tile_end, in_first, in_cols, n_rows_in, el_size;
+    unsigned char *mapped;
+    n_rows_in = pipe->n_rows_in;
+    el_size = pipe->el_size;
+    for(rule = 0; rule < pipe->n_rules; rule++)
+    {
+        if(pipe->n_tiles == 1)
+        {
+            n_pixels = (job->band_end - job->band_start) * pipe->n_cols_in;
+            index = (((job->window * pipe->n_rules + rule) * n_rows_in) + job->band_start) * pipe->n_cols_in;
+            Write_Output_Rows(pipe->outfile, index * el_size, job->data + (rule * pipe->rows_size * el_size),
+                              n_pixels * el_size, pipe->n_windows * pipe->n_rules);
+            continue;
+        }
+        Tile_Columns(pipe, job->tile, &tile_first, &tile_end, &in_first, &in_cols);
+        mapped = (parameters.outfloat == 1) ? (unsigned char *)mat_outfloat : mat_out;
+        for(row = job->band_start; row < job->band_end; row++)
+        {
+            index = (((((job->window * pipe->n_rules) + rule) * n_rows_in) + row) * pipe->n_cols_in) + tile_first;
+            offset = (rule * pipe->rows_size) + ((row - job->band_start) * in_cols) + (tile_first - in_first);
+            if(parameters.io_mode == 1)
+            {
+                memcpy(mapped + (index * el_size), job->data + (offset * el_size), (tile_end - tile_first) * el_size);
+            }
+            else
+            {
+                Write_Output_Rows(pipe->outfile, index * el_size, job->data + (offset * el_size),
+                                  (tile_end - tile_first) * el_size, pipe->n_windows * pipe->n_rules * pipe->n_tiles);
+            }
+        }
+    }
+}
+
+#if IO_THREADS
+/* 1.4.0, the reader: read input rows into the ring as far as read_limit allows */
+void *Reader_Thread(void *arg)
+{
+    struct io_pipe *pipe;
+    double start_time;
+    pipe = (struct io_pipe *)arg;
+    pthread_mutex_lock(&pipe->lock);
+    while(pipe->next_read < (pipe->n_tiles * pipe->n_rows_in))
+    {
+        if(pipe->next_read >= pipe->read_limit)
+        {
+            pthread_cond_wait(&pipe->changed, &pipe->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&pipe->lock);
+        start_time = omp_get_wtime();
+        Read_Ring_Row(pipe);
+        pthread_mutex_lock(&pipe->lock);
+        pipe->read_time += omp_get_wtime() - start_time;
+        pipe->next_read++;
+        pthread_cond_broadcast(&pipe->changed);
+    }
+    pthread_mutex_unlock(&pipe->lock);
+    return(NULL);
+}
+
+/* 1.4.0, the writer: write the jobs in turn until Stop_Io_Pipe and the last one is written */
+void *Writer_Thread(void *arg)
+{
+    struct io_pipe *pipe;
+    struct band_job *job;
+    double start_time;
+    pipe = (struct io_pipe *)arg;
+    pthread_mutex_lock(&pipe->lock);
+    while(1)
+    {
+        job = &pipe->jobs[pipe->next_job];
+        if(job->full == 0)
+        {
+            if(pipe->stop == 1)
+            {
+                break;
+            }
+            pthread_cond_wait(&pipe->changed, &pipe->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&pipe->lock);
+        start_time = omp_get_wtime();
+        Write_Band(pipe, job);
+        pthread_mutex_lock(&pipe->lock);
+        pipe->write_time += omp_get_wtime() - start_time;
+        job->full = 0;
+        pipe->next_job = (pipe->next_job + 1) % pipe->n_jobs;
+        pthread_cond_broadcast(&pipe->changed);
+    }
+    pthread_mutex_unlock(&pipe->lock);
+    return(NULL);
+}
+#endif
+
+/*   ***********
+     Plan_Memory
+     ***********
+    1.4.0, parameter k, fit the run in about parameters.memory_mb megabytes. The whole map is kept in
+    memory if the input, the output bands and the tables of the engine fit. Otherwise the map is
+    streamed (parameters.stream_rows, unless an s line gave it) with the largest band that fits at
+    full width, at least one row per thread; if not even that fits, a band of max(threads, w) rows
+    is streamed in column tiles (parameters.stream_cols) as wide as fit, but at least w columns wide.
+    With e 2 and e 4 a band has at least w rows. The summed-area tables of e 2 are counted at 4 bytes
+    per plane for each pixel of the band and its window rows, as Sat_Tables allocates them once for the run.
+    The scratch memory of each thread (freq distns, column histograms) is not counted.
+*/
+void Plan_Memory(long int n_rows_in, long int n_cols_in)
+{
+    long int budget, el_size, n_bands, max_window_size, n_threads, band, band_height, per_row, in_cols;
+    long int n_groups, group, rule, all_sat, n_planes;
+    double table_bytes;
+    struct rule_group groups[4];
+    budget = parameters.memory_mb * 1048576;
+    el_size = (parameters.outfloat == 1) ? sizeof(float) : 1;
+    n_bands = parameters.n_windows * parameters.n_rules;
+    max_window_size = 0;
+    for(band = 0; band < parameters.n_windows; band++)
+    {
+        max_window_size = max(max_window_size, parameters.window_sizes[band]);
+    }
+    n_threads = omp_get_max_threads();
+    /* tables of the engine for each pixel of the map or band: summed-area tables, bit planes */
+    table_bytes = 0.0;
+    if(parameters.engine == 2)
+    {
+        /* the rule groups take turns with the tables (see Sat_Tables): 3 planes for rules 81-83, */
+        /*   8 for rules 75-78, of 4 bytes each, and none for a group with other rules */
+        n_groups = Group_Rules(groups);
+        n_planes = 0;
+        for(group = 0; group < n_groups; group++)
+        {
+            all_sat = 1;
+            for(rule = 0; rule < groups[group].n_rules; rule++)
+            {
+                if( (groups[group].rules[rule] < 75) || ( (groups[group].rules[rule] > 78) &&
+                                                          (groups[group].rules[rule] < 81) ) )
+                {
+                    all_sat = 0;
+                }
+            }
+            if(all_sat == 1)
+            {
+                n_planes = max(n_planes, (groups[group].edges == 1) ? 8 : 3);
+            }
+        }
+        table_bytes = 4.0 * n_planes;
+    }
+    if(parameters.engine == 4)
+    {
+        table_bytes = 0.5;
+    }
+    if( (parameters.stream_rows == 0) &&
+            ( ( (double)n_rows_in * n_cols_in * (1.0 + (n_bands * el_size) + table_bytes) ) <= budget) )
+    {
+        printf("Spatcon: The map fits in the memory budget of %ld MB.\n", parameters.memory_mb);
+        return;
+    }
+    /* a band of band_height rows: the ring of band_height + max_window_size input rows and their */
+    /*   tables, and band_height rows of each rule (several window sizes take turns). With the reader */
+    /*   and writer threads the ring has a second band of rows and there is a second output band. */
+    per_row = (long int)(table_bytes + ((1 + IO_THREADS) * (1.0 + (parameters.n_rules * el_size))));
+    band_height = parameters.stream_rows;
+    if(band_height == 0)
+    {
+        band_height = ( (budget / n_cols_in) - (long int)(max_window_size * (1.0 + table_bytes)) ) / per_row;
+        band_height = min(band_height, n_rows_in);
+        /* engines 2 and 4 build their tables over the window rows of each band again, so a band of */
+        /*   fewer than w rows would mostly be overlap; use column tiles instead */
+        if( (band_height < n_threads) ||
+                ( ( (parameters.engine == 2) || (parameters.engine == 4) ) && (band_height < max_window_size) ) )
+        {
+            band_height = min(max(n_threads, max_window_size), n_rows_in);
+        }
+    }
+    in_cols = budget / ( (band_height * per_row) + (long int)(max_window_size * (1.0 + table_bytes)) );
+    parameters.stream_rows = band_height;
+    parameters.stream_cols = 0;
+    if(in_cols < n_cols_in)
+    {
+        parameters.stream_cols = in_cols - (max_window_size - 1);
+        if(parameters.stream_cols < max_window_size)
+        {
+            /* the overlap would be most of the work */
+            printf("Spatcon: The memory budget of %ld MB is too small for window size %ld, using more.\n",
+                   parameters.memory_mb, max_window_size);
+            parameters.stream_cols = max_window_size;
+        }
+#if defined(SPATCON_GEOTIFF)
+        if(geotiff.write == 1)
+        {
+            /* whole tiles of the output GeoTIFF */
+            parameters.stream_cols = max(TIFF_TILE_SIZE, parameters.stream_cols - (parameters.stream_cols % TIFF_TILE_SIZE));
+        }
+#endif
+        printf("Spatcon: Memory budget of %ld MB, streaming %ld rows at a time in column tiles of %ld columns.\n",
+               parameters.memory_mb, band_height, parameters.stream_cols);
+        return;
+    }
+    printf("Spatcon: Memory budget of %ld MB, streaming %ld rows at a time.\n", parameters.memory_mb, band_height);
+}
+
+/*   *****************
+     Write_Output_Rows
+     *****************
+    1.4.0, write n_bytes of finished output rows at byte offset 'offset' of the output file.
+    With a single output band the rows come in order and are just appended; with several bands
+    (several window sizes) or column tiles each band or tile row has its own place in the file, so
+    the file is positioned first.
+*/
+void Write_Output_Rows(FILE *outfile, long int offset, void *data, long int n_bytes, long int n_bands)
+{
+    int ret_val;
+#if defined(SPATCON_GEOTIFF)
+    if(geotiff.write == 1)
+    {
+        Write_Tiff_Rows(offset, (unsigned char *)data, n_bytes);
+        return;
+    }
+#endif
+    ret_val = 0;
+    if(n_bands > 1)
+    {
+#if defined(_WIN32)
+        ret_val = _fseeki64(outfile, offset, SEEK_SET);
+#else
+        ret_val = fseeko(outfile, (off_t)offset, SEEK_SET);
+#endif
+    }
+    if( (ret_val != 0) || (fwrite(data, 1, n_bytes, outfile) != n_bytes) )
+    {
+        printf("\nSpatcon: Error writing output file.\n");
+        exit(24);
+    }
+}
+
+/*   *************
+     Get_Input_Row
+     *************
+    1.4.0, return a pointer to columns first_col ... first_col + n_cols - 1 of input row 'row', re-coded
+    if recode_table is not NULL. Without a memory-mapped input (infile != NULL) whole rows must be asked
+    for in order; part of a row (a column tile, see Freq_Conv_Stream) is found with a seek.
+*/
+unsigned char *Get_Input_Row(FILE *infile, long int row, long int n_cols_in, long int first_col, long int n_cols,
+                             long int *recode_table, unsigned char *row_buffer)
+{
+    long int col, offset;
+    int ret_val;
+    unsigned char *row_in;
+#if defined(SPATCON_GEOTIFF)
+    if(geotiff.read == 1)
+    {
+        row_in = Read_Tiff_Row(row, first_col);
+    }
+    else
+#endif
+    if(infile == NULL)
+    {
+        row_in = mat_in + (row * n_cols_in) + first_col;
+    }
+    else
+    {
+        ret_val = 0;
+        if(n_cols < n_cols_in)
+        {
+            offset = (row * n_cols_in) + first_col;
+#if defined(_WIN32)
+            ret_val = _fseeki64(infile, offset, SEEK_SET);
+#else
+            ret_val = fseeko(infile, (off_t)offset, SEEK_SET);
+#endif
+        }
+        if( (ret_val != 0) || (fread(row_buffer, 1, n_cols, infile) != n_cols) )
+        {
+            printf("\nSpatcon: Error reading input file. Incorrect file size.\n");
+            exit(20);
+        }
+        row_in = row_buffer;
+    }
+    if(recode_table != NULL)
+    {
+        for(col = 0; col < n_cols; col++)
+        {
+            (*(row_buffer + col)) = recode_table[(*(row_in + col))];
+        }
+        row_in = row_buffer;
+    }
+    return(row_in);
+}
+#if defined(SPATCON_GEOTIFF)
+/*   *************
+     GeoTIFF files
+     *************
+    1.4.0, compile with -DSPATCON_GEOTIFF and link with -ltiff -lz for GeoTIFF input and output (see Usage).
+    The input GeoTIFF is decoded a strip or a row of tiles at a time (geotiff.block), as Get_Input_Row asks
+    for its rows, so the streaming engine holds only its ring of rows and one block. The output is a tiled
+    GeoTIFF with one plane for each output band. Write_Output_Rows hands it the finished rows, which are
+    kept until a row of tiles of their band is complete (geotiff.rows); then the tiles are written,
+    DEFLATE tiles compressed in parallel with zlib, ZSTD tiles compressed by libtiff one at a time. The georeferencing tags
+    and geokeys of an input GeoTIFF are copied to the output. libtiff does not know these tags by itself,
+    so they are declared to it for every file it opens (Declare_Geo_Tags).
+*/
+static const TIFFFieldInfo geo_field_info[] =
+{
+    { TIFFTAG_GEOPIXELSCALE, TIFF_VARIABLE, TIFF_VARIABLE, TIFF_DOUBLE, FIELD_CUSTOM, 1, 1, "GeoPixelScale" },
+    { TIFFTAG_GEOTIEPOINTS, TIFF_VARIABLE, TIFF_VARIABLE, TIFF_DOUBLE, FIELD_CUSTOM, 1, 1, "GeoTiePoints" },
+    { TIFFTAG_GEOTRANSMATRIX, TIFF_VARIABLE, TIFF_VARIABLE, TIFF_DOUBLE, FIELD_CUSTOM, 1, 1, "GeoTransformationMatrix" },
+    { TIFFTAG_GEOKEYDIRECTORY, TIFF_VARIABLE, TIFF_VARIABLE, TIFF_SHORT, FIELD_CUSTOM, 1, 1, "GeoKeyDirectory" },
+    { TIFFTAG_GEODOUBLEPARAMS, TIFF_VARIABLE, TIFF_VARIABLE, TIFF_DOUBLE, FIELD_CUSTOM, 1, 1, "GeoDoubleParams" },
+    { TIFFTAG_GEOASCIIPARAMS, TIFF_VARIABLE, TIFF_VARIABLE, TIFF_ASCII, FIELD_CUSTOM, 1, 0, "GeoASCIIParams" }
+};
+static TIFFExtendProc parent_extender = NULL;
+static long int geo_tags_declared = 0;
+
+/* 1.4.0, libtiff calls this for every file it opens, see Declare_Geo_Tags */
+static void Tiff_Geo_Tags(TIFF *tif)
+{
+    TIFFMergeFieldInfo(tif, geo_field_info, sizeof(geo_field_info) / sizeof(geo_field_info[0]));
+    if(parent_extender != NULL)
+    {
+        (*parent_extender)(tif);
+    }
+}
+
+/* 1.4.0, have libtiff call Tiff_Geo_Tags, once, before the first file is opened */
+static void Declare_Geo_Tags(void)
+{
+    if(geo_tags_declared == 0)
+    {
+        parent_extender = TIFFSetTagExtender(Tiff_Geo_Tags);
+        geo_tags_declared = 1;
+    }
+}
+
+/* 1.4.0, returns 1 if the file name ends in .tif or .tiff, else 0 */
+long int Tiff_Name(char *filename)
+{
+    char *dot;
+    dot = strrchr(filename, '.');
+    if( (dot != NULL) && ( (strcmp(dot, ".tif") == 0) || (strcmp(dot, ".tiff") == 0) ||
+                           (strcmp(dot, ".TIF") == 0) || (strcmp(dot, ".TIFF") == 0) ) )
+    {
+        return(1);
+    }
+    return(0);
+}
+
+/*   ***************
+     Open_Tiff_Input
+     ***************
+    1.4.0, open the input GeoTIFF and return its size. It must have one 8-bit unsigned band, in strips
+    or in tiles.
+*/
+void Open_Tiff_Input(char *filename, long int *n_rows, long int *n_cols)
+{
+    uint32_t width, length, block_width, block_height;
+    uint16_t bits, samples, format;
+    Declare_Geo_Tags();
+    if( (geotiff.in = TIFFOpen(filename, "r") ) == NULL)
+    {
+        printf("\nSpatcon: Error opening input file %s\n", filename);
+        exit(15);
+    }
+    TIFFGetField(geotiff.in, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(geotiff.in, TIFFTAG_IMAGELENGTH, &length);
+    TIFFGetFieldDefaulted(geotiff.in, TIFFTAG_BITSPERSAMPLE, &bits);
+    TIFFGetFieldDefaulted(geotiff.in, TIFFTAG_SAMPLESPERPIXEL, &samples);
+    TIFFGetFieldDefaulted(geotiff.in, TIFFTAG_SAMPLEFORMAT, &format);
+    if( (bits != 8) || (samples != 1) || (format != SAMPLEFORMAT_UINT) )
+    {
+        printf("\nSpatcon: Error. Input GeoTIFF %s must have a single band of 8-bit unsigned pixels.\n", filename);
+        exit(60);
+    }
+    geotiff.in_rows = length;
+    geotiff.in_cols = width;
+    geotiff.tiled = TIFFIsTiled(geotiff.in);
+    block_width = width;
+    if(geotiff.tiled == 1)
+    {
+        TIFFGetField(geotiff.in, TIFFTAG_TILEWIDTH, &block_width);
+        TIFFGetField(geotiff.in, TIFFTAG_TILELENGTH, &block_height);
+    }
+    else
+    {
+        TIFFGetFieldDefaulted(geotiff.in, TIFFTAG_ROWSPERSTRIP, &block_height);
+        block_height = min(block_height, length);
+    }
+    geotiff.block_width = block_width;
+    geotiff.block_height = block_height;
+    geotiff.block_first = -1;
+    if( ( (geotiff.block = (unsigned char *)malloc( geotiff.block_height * geotiff.in_cols ) ) == NULL) ||
+            ( (geotiff.tile_in = (unsigned char *)malloc( geotiff.block_height * geotiff.block_width ) ) == NULL) )
+    {
+        printf("\nSpatcon: Error. Not enough memory for input data.\n");
+        exit(19);
+    }
+    *n_rows = geotiff.in_rows;
+    *n_cols = geotiff.in_cols;
+}
+
+/*   ****************
+     Open_Tiff_Output
+     ****************
+    1.4.0, create the output GeoTIFF: tiles of TIFF_TILE_SIZE x TIFF_TILE_SIZE, one plane for each output
+    band, byte or float, compressed as parameter c asks. BigTIFF if it might not fit in 4 GB.
+    n_rows and n_cols are the output size, the input size divided by the grain (parameter g).
+*/
+void Open_Tiff_Output(char *filename, long int n_rows, long int n_cols)
+{
+    long int band, index;
+    uint16_t count, *keys, extra[MAX_WINDOWS * MAX_RULES];
+    double *values, *scaled, offset;
+    char *text;
+    uint32_t geo_tags[4] = {TIFFTAG_GEOPIXELSCALE, TIFFTAG_GEOTIEPOINTS, TIFFTAG_GEOTRANSMATRIX, TIFFTAG_GEODOUBLEPARAMS};
+    Declare_Geo_Tags();
+    geotiff.out_rows = n_rows;
+    geotiff.out_cols = n_cols;
+    geotiff.n_bands = parameters.n_windows * parameters.n_rules;
+    geotiff.el_size = (parameters.outfloat == 1) ? sizeof(float) : 1;
+    if( (parameters.compression == 1) && (TIFFIsCODECConfigured(COMPRESSION_ZSTD) == 0) )
+    {
+        printf("\nSpatcon: Error. This libtiff has no ZSTD compression, use c 0 or c 2.\n");
+        exit(61);
+    }
+    if( (geotiff.out = TIFFOpen(filename, ( (n_rows * n_cols * geotiff.n_bands * geotiff.el_size) >
+                                            4000000000L) ? "w8" : "w") ) == NULL)
+    {
+        printf("\nSpatcon:Error opening output file %s\n", filename);
+        exit(16);
+    }
+    TIFFSetField(geotiff.out, TIFFTAG_IMAGEWIDTH, (uint32_t)n_cols);
+    TIFFSetField(geotiff.out, TIFFTAG_IMAGELENGTH, (uint32_t)n_rows);
+    TIFFSetField(geotiff.out, TIFFTAG_BITSPERSAMPLE, (int)(8 * geotiff.el_size));
+    TIFFSetField(geotiff.out, TIFFTAG_SAMPLEFORMAT, (parameters.outfloat == 1) ? SAMPLEFORMAT_IEEEFP : SAMPLEFORMAT_UINT);
+    TIFFSetField(geotiff.out, TIFFTAG_SAMPLESPERPIXEL, (int)geotiff.n_bands);
+    TIFFSetField(geotiff.out, TIFFTAG_PLANARCONFIG, PLANARCONFIG_SEPARATE);
+    TIFFSetField(geotiff.out, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+    if(geotiff.n_bands > 1)
+    {
+        /* the bands after the first are not colors */
+        memset(extra, 0, sizeof(extra));
+        TIFFSetField(geotiff.out, TIFFTAG_EXTRASAMPLES, (int)(geotiff.n_bands - 1), extra);
+    }
+    TIFFSetField(geotiff.out, TIFFTAG_TILEWIDTH, (uint32_t)TIFF_TILE_SIZE);
+    TIFFSetField(geotiff.out, TIFFTAG_TILELENGTH, (uint32_t)TIFF_TILE_SIZE);
+    TIFFSetField(geotiff.out, TIFFTAG_COMPRESSION, (parameters.compression == 0) ? COMPRESSION_ADOBE_DEFLATE :
+                 (parameters.compression == 1) ? COMPRESSION_ZSTD : COMPRESSION_NONE);
+    /* the georeferencing of the input GeoTIFF; with g > 1 output pixel R,C is centered on input pixel */
+    /*   R * g, C * g and is g times as large, so input raster position I is g * I' + offset */
+    offset = -0.5 * (parameters.grain - 1);     /* PixelIsArea, the default raster type */
+    if( (geotiff.in != NULL) && (TIFFGetField(geotiff.in, TIFFTAG_GEOKEYDIRECTORY, &count, &keys) == 1) )
+    {
+        TIFFSetField(geotiff.out, TIFFTAG_GEOKEYDIRECTORY, count, keys);
+        for(index = 4; (index + 3) < count; index += 4)
+        {
+            /* GTRasterTypeGeoKey = PixelIsPoint, the raster positions are the pixel centers */
+            if( (keys[index] == 1025) && (keys[index + 1] == 0) && (keys[index + 3] == 2) )
+            {
+                offset = 0.0;
+            }
+        }
+    }
+    for(band = 0; (geotiff.in != NULL) && (band < 4); band++)
+    {
+        if(TIFFGetField(geotiff.in, geo_tags[band], &count, &values) == 1)
+        {
+            if( (scaled = (double *)malloc( count * sizeof(double) ) ) == NULL)
+            {
+                printf("\nSpatcon: Error. Not enough memory for byte output data.\n");
+                exit(26);
+            }
+            memcpy(scaled, values, count * sizeof(double));
+            for(index = 0; (parameters.grain > 1) && (index < count); index++)
             {
-                map_value_float = Freq_Filters_Float(color_freq, edge_freq, freq_ptr, n_colors_in_image,
-                                                     mapping_rule, handle_missing, code_1, code_2);
-                /* Map the results back for this grain */
-                grain_start_row = r_min + buff_b;
-                grain_start_col = c_min + buff_b;
-                index = grain_start_row * n_cols;
-                (*(mat_outfloat + index + grain_start_col)) = map_value_float;
+                if( (geo_tags[band] == TIFFTAG_GEOPIXELSCALE) && (index < 2) )
+                {
+                    scaled[index] = values[index] * parameters.grain;
+                }
+                /* tiepoints I,J,K,X,Y,Z */
+                if( (geo_tags[band] == TIFFTAG_GEOTIEPOINTS) && ( (index % 6) < 2) )
+                {
+                    scaled[index] = (values[index] - offset) / parameters.grain;
+                }
+                /* the 4x4 matrix from I,J,K,1 to X,Y,Z,1 */
+                if( (geo_tags[band] == TIFFTAG_GEOTRANSMATRIX) && ( (index % 4) < 2) )
+                {
+                    scaled[index] = values[index] * parameters.grain;
+                }
+                if( (geo_tags[band] == TIFFTAG_GEOTRANSMATRIX) && ( (index % 4) == 3) )
+                {
+                    scaled[index] = values[index] + (offset * (values[index - 3] + values[index - 2]) );
+                }
             }
+            TIFFSetField(geotiff.out, geo_tags[band], count, scaled);
+            free(scaled);
         }
-// omp
-        free(freq_ptr);
-    } // end of omp parallel for loop
-    /* If majority filter, replace with original color codes*/
-    if(mapping_rule == 1)
+    }
+    if( (geotiff.in != NULL) && (TIFFGetField(geotiff.in, TIFFTAG_GEOASCIIPARAMS, &text) == 1) )
     {
-        for(row = 0; row < n_rows; row++)
+        TIFFSetField(geotiff.out, TIFFTAG_GEOASCIIPARAMS, text);
+    }
+    /* a row of tiles of each band */
+    if( (geotiff.rows = (unsigned char **)calloc( geotiff.n_bands, sizeof(unsigned char *) ) ) == NULL)
+    {
+        printf("\nSpatcon: Error. Not enough memory for byte output data.\n");
+        exit(26);
+    }
+    for(band = 0; band < geotiff.n_bands; band++)
+    {
+        if( (geotiff.rows[band] = (unsigned char *)malloc( TIFF_TILE_SIZE * n_cols * geotiff.el_size ) ) == NULL)
         {
-            index = row * n_cols;
-            for(col = 0; col < n_cols; col++)
-            {
-                temp_int = (*(mat_out + index + col));
-                (*(mat_out + index + col)) = in_to_out[temp_int];
-            }
+            printf("\nSpatcon: Error. Not enough memory for byte output data.\n");
+            exit(26);
         }
     }
-    /* Shift mat-out back to mat-in basis, i.e. remove the buffer and pads */
-    // this just moves the pixel values, one at a time, from the starting pixel at the middle
-    // of the memory block to a starting address at the origin of the same memory block.
-    // this way the same memory block can be shifted and the output cells are not over-written
-    // until after they have been copied to a location earlier in the memory block
-    if(parameters.outfloat == 0)
+}
+
+/* 1.4.0, columns first_col ... of input row 'row', decoding the strip or row of tiles it is in if need be */
+unsigned char *Read_Tiff_Row(long int row, long int first_col)
+{
+    long int first, n_block_rows, col, tile_cols, index;
+    if( (geotiff.block_first < 0) || (row < geotiff.block_first) || (row >= (geotiff.block_first + geotiff.block_height)) )
     {
-        for(row = buff_b; row < (buff_b + n_rows_in); row++)
+        first = (row / geotiff.block_height) * geotiff.block_height;
+        n_block_rows = min(geotiff.block_height, geotiff.in_rows - first);
+        if( (geotiff.tiled == 0) &&
+                (TIFFReadEncodedStrip(geotiff.in, TIFFComputeStrip(geotiff.in, first, 0), geotiff.block,
+                                      n_block_rows * geotiff.in_cols) != (n_block_rows * geotiff.in_cols) ) )
+        {
+            printf("\nSpatcon: Error reading input GeoTIFF.\n");
+            exit(20);
+        }
+        for(col = 0; (geotiff.tiled == 1) && (col < geotiff.in_cols); col += geotiff.block_width)
         {
-            index = row * n_cols;
-            for(col = buff_b; col < (buff_b + n_cols_in); col++)
+            if(TIFFReadTile(geotiff.in, geotiff.tile_in, col, first, 0, 0) < 0)
             {
-                /* equivalent position in mat_in */
-                pos_in = ((row - buff_b) * n_cols_in) + (col - buff_b);
-                (*(mat_out + pos_in)) = (*(mat_out + index + col));
+                printf("\nSpatcon: Error reading input GeoTIFF.\n");
+                exit(20);
             }
-        } // end parallel for
-    }
-    if(parameters.outfloat == 1)
-    {
-        for(row = buff_b; row < (buff_b + n_rows_in); row++)
-        {
-            index = row * n_cols;
-            for(col = buff_b; col < (buff_b + n_cols_in); col++)
+            tile_cols = min(geotiff.block_width, geotiff.in_cols - col);
+            for(index = 0; index < n_block_rows; index++)
             {
-                /* equivalent position in mat_in */
-                pos_in = ((row - buff_b) * n_cols_in) + (col - buff_b);
-                (*(mat_outfloat + pos_in)) = (*(mat_outfloat + index + col));
+                memcpy(geotiff.block + (index * geotiff.in_cols) + col, geotiff.tile_in + (index * geotiff.block_width),
+                       tile_cols);
             }
-        } // end parallel for
+        }
+        geotiff.block_first = first;
     }
-    free(mat_temp);
-    return(0);
+    return(geotiff.block + ((row - geotiff.block_first) * geotiff.in_cols) + first_col);
 }
-/*   **************
-     Freq_Filters.C
-     **************
-*/
-/* **********************************************************************
-  FREQ_FILTERS.C
-        Contains the functions which convolve from a frequency distribution.
-        Examples: Majority color code, Edge-type diversity, Color ratios.
-   Parameters:
-        color_freq = 1 if frequency distribution is number by color, else 0
-        edge_freq  = 1 if frequency distribution is number by edge type, else 0
-        freq_ptr   = pointer to frequency distribution
-        n_colors_in_image = sets the bounds for the size of freq_ptr matrix,
-                                  does not include missing
-        mapping_rule = same as in Freq_Conv
-        handle_missing = same as in Freq_Conv
-        code_1 = user-input altered in Freq_Conv to be the local code
-        code_2 =  ditto
-
-   Returns:
-        unsigned char value in range [1,255] because 0 is reserved for missing
-          values in the calling function.
-        What it means depends on the mapping rule, it could be a color
-          code or a discretized value of a continuous variable.
-
-   if(color_freq), then freq_ptr is one-dimensional array with the
-        count of missing values at (*(freq_ptr)) and the count of different
-        colors at (*(freq_ptr + 1)) ... (*(freq_ptr+n_colors_in_image)).
-        Some of the positions in that array could have zero counts, which
-        means those colors were not present in the sub-window of the image
-        which is being passed.
 
-   if(edge_freq), then freq_ptr is a two-dimensional array (adjacency matrix).
-        The 0 positions are for missing values.  The dimensions are based on
-        n_colors_in_image, but some of the rows/columns can have zero
-        marginals, which means that those colors were not present in the
-        sub-window which is being passed.  Each edge has been counted just
-        once in this array, that is, the counts are with regard to order
-        of pixels in pairs.
+/* 1.4.0, n_bytes of output rows at byte offset 'offset' of the band sequential output, see Write_Output_Rows.
+   A row of a column tile (see Freq_Conv_Stream) starts on a tile of the GeoTIFF, see Plan_Memory. */
+void Write_Tiff_Rows(long int offset, unsigned char *data, long int n_bytes)
+{
+    long int pixel, n_pixels, band, row, col, n_row_pixels, el_size;
+    el_size = geotiff.el_size;
+    pixel = offset / el_size;
+    n_pixels = n_bytes / el_size;
+    while(n_pixels > 0)
+    {
+        band = pixel / (geotiff.out_rows * geotiff.out_cols);
+        row = (pixel / geotiff.out_cols) % geotiff.out_rows;
+        col = pixel % geotiff.out_cols;
+        n_row_pixels = min(n_pixels, geotiff.out_cols - col);
+        memcpy(geotiff.rows[band] + ((((row % TIFF_TILE_SIZE) * geotiff.out_cols) + col) * el_size), data,
+               n_row_pixels * el_size);
+        if( ((row % TIFF_TILE_SIZE) == (TIFF_TILE_SIZE - 1)) || (row == (geotiff.out_rows - 1)) )
+        {
+            Write_Tiff_Tiles(band, row / TIFF_TILE_SIZE, col, col + n_row_pixels);
+        }
+        pixel += n_row_pixels;
+        n_pixels -= n_row_pixels;
+        data += n_row_pixels * el_size;
+    }
+}
 
-************************************************************************ */
-unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *freq_ptr, long int n_colors_in_image,
-                           long int mapping_rule, long int handle_missing, long int code_1, long int code_2)
+/* 1.4.0, write the tiles of row of tiles tile_row of band 'band' that cover columns first_col ... end_col - 1.
+   The tiles are cut out in parallel; DEFLATE tiles are also compressed in parallel and written raw, the
+   others go through TIFFWriteEncodedTile, so libtiff compresses ZSTD tiles serially */
+void Write_Tiff_Tiles(long int band, long int tile_row, long int first_col, long int end_col)
 {
-    unsigned char map_val;
-    long int index, start, temp_int, temp_int2, ind1, ind2, n_colors_in_window;
-    float temp_float, temp_float_2, temp_float_3;
-    float p_agr, p_for, p_dev;
-// changes to avoid warning messages in omp version
-    map_val = 0;
-    temp_int = 0;
-    temp_float = 0.0;
-    temp_float_2 = 0.0;
-//
-    switch(mapping_rule)
+    long int first_tile, n_tiles, tile_bytes, packed_bytes, index, n_failed;
+    uint32_t tile_number;
+    unsigned char *tiles;
+    uLongf *sizes;
+    first_tile = first_col / TIFF_TILE_SIZE;
+    n_tiles = ((end_col - 1) / TIFF_TILE_SIZE) - first_tile + 1;
+    tile_bytes = TIFF_TILE_SIZE * TIFF_TILE_SIZE * geotiff.el_size;
+    packed_bytes = (parameters.compression == 0) ? (long int)compressBound(tile_bytes) : 0;
+    if( ( (tiles = (unsigned char *)malloc( n_tiles * (tile_bytes + packed_bytes) ) ) == NULL) ||
+            ( (sizes = (uLongf *)malloc( n_tiles * sizeof(uLongf) ) ) == NULL) )
     {
-    case 1:   /* Return the most abundant color code in freq_ptr */
-        /* Seed max search with first element */
-        if(handle_missing == 2)   /*missing included*/
+        printf("\nSpatcon: Error. Not enough memory for byte output data.\n");
+        exit(26);
+    }
+    n_failed = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(+:n_failed)
+    for(index = 0; index < n_tiles; index++)
+    {
+        long int row, col, n_rows, n_cols;
+        unsigned char *tile;
+        tile = tiles + (index * (tile_bytes + packed_bytes));
+        col = (first_tile + index) * TIFF_TILE_SIZE;
+        n_cols = min(TIFF_TILE_SIZE, geotiff.out_cols - col);
+        n_rows = min(TIFF_TILE_SIZE, geotiff.out_rows - (tile_row * TIFF_TILE_SIZE));
+        memset(tile, 0, tile_bytes);
+        for(row = 0; row < n_rows; row++)
         {
-            temp_int = (*(freq_ptr));
-            start = 1;
-            map_val = 0;
+            memcpy(tile + (row * TIFF_TILE_SIZE * geotiff.el_size),
+                   geotiff.rows[band] + (((row * geotiff.out_cols) + col) * geotiff.el_size), n_cols * geotiff.el_size);
         }
-        if(handle_missing == 1)     /* missing not included */
+        sizes[index] = packed_bytes;
+        if( (parameters.compression == 0) &&
+                (compress2(tile + tile_bytes, &sizes[index], tile, tile_bytes, Z_DEFAULT_COMPRESSION) != Z_OK) )
         {
-            temp_int = (*(freq_ptr + 1));
-            start = 2;
-            map_val = 1;
+            n_failed++;
         }
-        for(index = start; index < (n_colors_in_image + 1); index++)
+    }
+    for(index = 0; (n_failed == 0) && (index < n_tiles); index++)
+    {
+        tile_number = TIFFComputeTile(geotiff.out, (first_tile + index) * TIFF_TILE_SIZE, tile_row * TIFF_TILE_SIZE, 0, band);
+        if(parameters.compression == 0)
         {
-            if( (*(freq_ptr + index)) > temp_int)
-            {
-                map_val = index;
-                temp_int = (*(freq_ptr + index));
-            }
+            n_failed += (TIFFWriteRawTile(geotiff.out, tile_number, tiles + (index * (tile_bytes + packed_bytes)) + tile_bytes,
+                                          sizes[index]) != (tmsize_t)sizes[index]);
         }
-        break;
+        else
+        {
+            n_failed += (TIFFWriteEncodedTile(geotiff.out, tile_number, tiles + (index * (tile_bytes + packed_bytes)),
+                                              tile_bytes) < 0);
+        }
+    }
+    if(n_failed > 0)
+    {
+        printf("\nSpatcon: Error writing output file.\n");
+        exit(24);
+    }
+    free(sizes);
+    free(tiles);
+}
+
+/* 1.4.0, finish the output GeoTIFF and close the GeoTIFFs */
+void Close_Tiff(void)
+{
+    long int band;
+    if(geotiff.out != NULL)
+    {
+        if(TIFFFlush(geotiff.out) != 1)
+        {
+            printf("\nSpatcon: Error writing output file.\n");
+            exit(24);
+        }
+        TIFFClose(geotiff.out);
+        geotiff.out = NULL;
+        for(band = 0; band < geotiff.n_bands; band++)
+        {
+            free(geotiff.rows[band]);
+        }
+        free(geotiff.rows);
+    }
+    if(geotiff.in != NULL)
+    {
+        TIFFClose(geotiff.in);
+        geotiff.in = NULL;
+        free(geotiff.block);
+        free(geotiff.tile_in);
+    }
+}
+#endif
+
+/* 1.4.0, count 'index' of the frequency distn freq_ptr, whose counts are count_width bytes.
+   count_width is a constant in the kernels (see Select_Kernel), so the test is compiled out. */
+#define FREQ(index) ( (count_width == 2) ? (long int)(*((unsigned short *)freq_ptr + (index))) : \
+                                          (long int)(*((unsigned int *)freq_ptr + (index))) )
+/*   ************
+     Mosaic_Class
+     ************
+    1.4.0, the landscape mosaic class (rules 6 and 7) of a window with n_missing missing pixels and n_agr,
+    n_for and n_dev pixels of agriculture, forest and developed. Moved from Freq_Filters, see Mosaic_Table.
+*/
+unsigned char Mosaic_Class(long int mapping_rule, long int n_missing, long int n_agr, long int n_for, long int n_dev)
+{
+    unsigned char map_val;
+    float temp_float;
+    float p_agr, p_for, p_dev;
+    map_val = 0;
+    switch(mapping_rule)
+    {
     case 6: /* lptmaker here */
         /* Modified July 27-06. Return missing ONLY if window is ALL missing*/
         /* modified Oct 31 - 06. Reduce from 19 to 16 classes */
@@ -1307,7 +6046,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         /* also cleaned up the description of the codes elsewhere in this program */
         // 1.3.4
         // if( (*(freq_ptr)) == constants.window_area)   /*they're all missing */
-        if( (fabs( (*(freq_ptr)) - constants.window_area)) < EPSILON)
+        if( (fabs( n_missing - constants.window_area)) < EPSILON)
         {
             map_val = 0;
             break;
@@ -1319,10 +6058,10 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
 			//p_for = (*(freq_ptr + 2)) / temp_float;
 			//p_dev = (*(freq_ptr + 3)) / temp_float;
 		// improve precision this way
-		temp_float = 1.0 / (1.0 * (constants.window_area - (*(freq_ptr))));
-		p_agr = (1.0 * (*(freq_ptr + 1)) ) * temp_float;
-		p_for = (1.0 * (*(freq_ptr + 2)) ) * temp_float;
-		p_dev = (1.0 * (*(freq_ptr + 3)) ) * temp_float;
+		temp_float = 1.0 / (1.0 * (constants.window_area - n_missing));
+		p_agr = (1.0 * n_agr ) * temp_float;
+		p_for = (1.0 * n_for ) * temp_float;
+		p_dev = (1.0 * n_dev ) * temp_float;
         /* it is possible that three additional maps will be output for pa, pd, pf, but that has to be handled
         	at the very end of the subroutine because a missing window caused a break above this line */
         if(p_for >= 0.60)      /* it's an F matrix */
@@ -1477,7 +6216,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         /* Added case 7 on July 2 2018. Used skeleton from rule 6 above*/
         // 1.3.4
         // if( (*(freq_ptr)) == constants.window_area)   /*they're all missing */
-        if( (fabs( (*(freq_ptr)) - constants.window_area)) < EPSILON)
+        if( (fabs( n_missing - constants.window_area)) < EPSILON)
         {
             map_val = 0;
             break;
@@ -1489,10 +6228,10 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
 			//p_for = (*(freq_ptr + 2)) / temp_float;
 			//p_dev = (*(freq_ptr + 3)) / temp_float;
 		// improve precision this way
-		temp_float = 1.0 / (1.0 * (constants.window_area - (*(freq_ptr))));
-		p_agr = (1.0 * (*(freq_ptr + 1)) ) * temp_float;
-		p_for = (1.0 * (*(freq_ptr + 2)) ) * temp_float;
-		p_dev = (1.0 * (*(freq_ptr + 3)) ) * temp_float;
+		temp_float = 1.0 / (1.0 * (constants.window_area - n_missing));
+		p_agr = (1.0 * n_agr ) * temp_float;
+		p_for = (1.0 * n_for ) * temp_float;
+		p_dev = (1.0 * n_dev ) * temp_float;
         /* Note that the output of three float maps is not handled with rule 7, use rule 6 instead */
         /* check the corners first */
         // 1.3.4
@@ -2015,6 +6754,147 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         }
         map_val = 171;
         break;
+    }
+    return(map_val);
+}
+
+/* 1.4.0, position of the counts n_agr, n_for, n_dev in a table of Mosaic_Table: the triples are in order
+   of their sum, then of n_agr + n_for, then of n_agr, so the sums below s take s(s+1)(s+2)/6 entries */
+static inline long int Mosaic_Index(long int n_agr, long int n_for, long int n_dev)
+{
+    long int sum, pair;
+    pair = n_agr + n_for;
+    sum = pair + n_dev;
+    return( ( (sum * (sum + 1) * (sum + 2) ) / 6) + ( (pair * (pair + 1) ) / 2) + n_agr);
+}
+
+/*   ************
+     Mosaic_Table
+     ************
+    1.4.0, the class of rule 6 or 7 for every window of window_size with only the codes 0 to 3: each
+    triple n_agr + n_for + n_dev <= window_size^2, the rest missing, at Mosaic_Index. Made once per
+    window size with Mosaic_Class, so the classes are the same as those of Freq_Filters, and a window
+    then costs one table read instead of three divisions and the chain of comparisons.
+    Returns NULL if the table would have more than MOSAIC_TABLE_MAX entries (w 13 is the largest): the
+    time to make a larger table, and its cache misses, cost more than the comparisons.
+*/
+unsigned char *Mosaic_Table(long int mapping_rule, long int window_size)
+{
+    long int area, n_entries, sum, pair, n_agr;
+    unsigned char *table;
+    area = window_size * window_size;
+    n_entries = Mosaic_Index(0, 0, area + 1);
+    if(n_entries > MOSAIC_TABLE_MAX)
+    {
+        return(NULL);
+    }
+    if( (table = (unsigned char *)malloc(n_entries)) == NULL)
+    {
+        return(NULL);
+    }
+    /* Mosaic_Class compares n_missing with the window area */
+    Set_Window_Constants(window_size);
+    #pragma omp parallel for private(pair, n_agr) schedule(dynamic, 8)
+    for(sum = 0; sum <= area; sum++)
+    {
+        for(pair = 0; pair <= sum; pair++)
+        {
+            for(n_agr = 0; n_agr <= pair; n_agr++)
+            {
+                table[Mosaic_Index(n_agr, pair - n_agr, sum - pair)] =
+                    Mosaic_Class(mapping_rule, area - sum, n_agr, pair - n_agr, sum - pair);
+            }
+        }
+    }
+    printf("     - Rule %ld classes read from a table of %ld entries.\n", mapping_rule, n_entries);
+    return(table);
+}
+
+/*   **************
+     Freq_Filters.C
+     **************
+*/
+/* **********************************************************************
+  FREQ_FILTERS.C
+        Contains the functions which convolve from a frequency distribution.
+        Examples: Majority color code, Edge-type diversity, Color ratios.
+   Parameters:
+        color_freq = 1 if frequency distribution is number by color, else 0
+        edge_freq  = 1 if frequency distribution is number by edge type, else 0
+        freq_ptr   = pointer to frequency distribution
+        count_width = size of the counts in freq_ptr in bytes, 2 or 4 (1.4.0, see Init_Conv_Specs)
+        n_colors_in_image = sets the bounds for the size of freq_ptr matrix,
+                                  does not include missing
+        mapping_rule = same as in Freq_Conv
+        handle_missing = same as in Freq_Conv
+        code_1 = user-input altered in Freq_Conv to be the local code
+        code_2 =  ditto
+
+   Returns:
+        unsigned char value in range [1,255] because 0 is reserved for missing
+          values in the calling function.
+        What it means depends on the mapping rule, it could be a color
+          code or a discretized value of a continuous variable.
+
+   if(color_freq), then freq_ptr is one-dimensional array with the
+        count of missing values at (*(freq_ptr)) and the count of different
+        colors at (*(freq_ptr + 1)) ... (*(freq_ptr+n_colors_in_image)).
+        Some of the positions in that array could have zero counts, which
+        means those colors were not present in the sub-window of the image
+        which is being passed.
+
+   if(edge_freq), then freq_ptr is a two-dimensional array (adjacency matrix).
+        The 0 positions are for missing values.  The dimensions are based on
+        n_colors_in_image, but some of the rows/columns can have zero
+        marginals, which means that those colors were not present in the
+        sub-window which is being passed.  Each edge has been counted just
+        once in this array, that is, the counts are with regard to order
+        of pixels in pairs.
+
+************************************************************************ */
+unsigned char Freq_Filters(long int color_freq, long int edge_freq, void *freq_ptr, long int count_width,
+                           long int n_colors_in_image, long int mapping_rule, long int handle_missing,
+                           long int code_1, long int code_2)
+{
+    unsigned char map_val;
+    long int index, start, temp_int, temp_int2, ind1, ind2, n_colors_in_window;
+    float temp_float, temp_float_2, temp_float_3;
+// changes to avoid warning messages in omp version
+    map_val = 0;
+    temp_int = 0;
+    temp_float = 0.0;
+    temp_float_2 = 0.0;
+//
+    switch(mapping_rule)
+    {
+    case 1:   /* Return the most abundant color code in freq_ptr */
+        /* Seed max search with first element */
+        if(handle_missing == 2)   /*missing included*/
+        {
+            temp_int = FREQ(0);
+            start = 1;
+            map_val = 0;
+        }
+        if(handle_missing == 1)     /* missing not included */
+        {
+            temp_int = FREQ(1);
+            start = 2;
+            map_val = 1;
+        }
+        for(index = start; index < (n_colors_in_image + 1); index++)
+        {
+            if( FREQ(index) > temp_int)
+            {
+                map_val = index;
+                temp_int = FREQ(index);
+            }
+        }
+        break;
+    case 6:
+    case 7:
+        /* 1.4.0, see Mosaic_Class */
+        map_val = Mosaic_Class(mapping_rule, FREQ(0), FREQ(1), FREQ(2), FREQ(3));
+        break;
     case 10:  /* Return the number of colors in freq_ptr */
         if(handle_missing == 2)   /*missing included*/
         {
@@ -2027,7 +6907,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         temp_int = 0;
         for(index = start; index < (n_colors_in_image + 1); index++)
         {
-            if( (*(freq_ptr + index)) > 0)
+            if( FREQ(index) > 0)
             {
                 temp_int++;
             }
@@ -2049,7 +6929,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         if(handle_missing == 1)     /* missing not included */
         {
             start = 1;
-            temp_int = constants.window_area - (*(freq_ptr));
+            temp_int = constants.window_area - FREQ(0);
             if( (temp_int % 2) != 0 )
             {
                 temp_int = (temp_int / 2) + 1;  /* actual */
@@ -2064,7 +6944,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         map_val = 0; /* seed it */
         for(index = start; index < (n_colors_in_image + 1); index++)
         {
-            temp_float_2 += (*(freq_ptr + index));
+            temp_float_2 += FREQ(index);
             if(temp_float_2 >= temp_int)
             {
                 map_val = index;
@@ -2081,16 +6961,16 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                          this by weighted average from the freq distn    */
         // 1.3.4
         // if( (*(freq_ptr)) == constants.window_area)   /*they're all missing */
-        if( (fabs( (*(freq_ptr)) - constants.window_area)) < EPSILON)
+        if( (fabs( FREQ(0) - constants.window_area)) < EPSILON)
        {
             map_val = 0;
             break;
         }
-        temp_float_2 = 1.0 / (1.0 *(constants.window_area - (*(freq_ptr)) ) );
+        temp_float_2 = 1.0 / (1.0 *(constants.window_area - FREQ(0) ) );
         temp_int = 0;
         for(index = 1; index < (n_colors_in_image + 1); index++)
         {
-            temp_int += (*(freq_ptr + index)) * index;
+            temp_int += FREQ(index) * index;
         }
         temp_float = temp_float_2 * (1.0 * temp_int);
         temp_int = temp_float + 0.5;
@@ -2108,20 +6988,20 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
             start = 1;
             // 1.3.4
             // if( (*(freq_ptr)) == constants.window_area)   /*they're all missing */
-            if( (fabs( (*(freq_ptr)) - constants.window_area)) < EPSILON)
+            if( (fabs( FREQ(0) - constants.window_area)) < EPSILON)
             {
                 map_val = 0;
                 break;
             }
             else
             {
-                temp_float_2 = 1.0 / (constants.window_area - (1.0 * (*(freq_ptr)) ) );
+                temp_float_2 = 1.0 / (constants.window_area - (1.0 * FREQ(0) ) );
             }
         }
         temp_float = 0.0;
         for(index = start; index < (n_colors_in_image + 1); index++)
         {
-            temp_float_3 = (1.0 * (*(freq_ptr + index)) ) * temp_float_2;
+            temp_float_3 = (1.0 * FREQ(index) ) * temp_float_2;
             temp_float += temp_float_3 * temp_float_3;
         }
         temp_float = 1.0 - temp_float; /* this is 'diversity'*/
@@ -2136,7 +7016,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
             temp_int2 = 0;  /*counter of number of colors in window*/
             for(index = start; index < (n_colors_in_image + 1); index++)
             {
-                if( (*(freq_ptr + index)) > 0)
+                if( FREQ(index) > 0)
                 {
                     temp_int2++;
                 }
@@ -2168,20 +7048,20 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
             start = 1;
             // 1.3.4
             // if( (*(freq_ptr)) == constants.window_area)   /*they're all missing */
-            if( (fabs( (*(freq_ptr)) - constants.window_area)) < EPSILON)
+            if( (fabs( FREQ(0) - constants.window_area)) < EPSILON)
             {
                 map_val = 0;
                 break;
             }
             else
             {
-                temp_float_2 = 1.0 / (1.0 * (constants.window_area - (*(freq_ptr)) ) );
+                temp_float_2 = 1.0 / (1.0 * (constants.window_area - FREQ(0) ) );
             }
         }
         temp_float = 0.0;
         for(index = start; index < (n_colors_in_image + 1); index++)
         {
-            temp_float_3 = (1.0 * (*(freq_ptr + index)) ) * temp_float_2;
+            temp_float_3 = (1.0 * FREQ(index) ) * temp_float_2;
             if(temp_float_3 > 0)
             {
                 temp_float += temp_float_3 * log(temp_float_3);
@@ -2191,7 +7071,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         temp_int2 = 0;  /*counter of number of colors in window*/
         for(index = start; index < (n_colors_in_image + 1); index++)
         {
-            if( (*(freq_ptr + index)) > 0)
+            if( FREQ(index) > 0)
             {
                 temp_int2++;
             }
@@ -2221,20 +7101,20 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
             start = 1;
             // 1.3.4
             // if( (*(freq_ptr)) == constants.window_area)   /*they're all missing */
-            if( (fabs( (*(freq_ptr)) - constants.window_area)) < EPSILON)
+            if( (fabs( FREQ(0) - constants.window_area)) < EPSILON)
             {
                 map_val = 0;
                 break;
             }
             else
             {
-                temp_float_2 = 1.0 / (1.0 * (constants.window_area - (*(freq_ptr)) ) );
+                temp_float_2 = 1.0 / (1.0 * (constants.window_area - FREQ(0) ) );
             }
         }
         temp_float = 0.0;
         for(index = start; index < (n_colors_in_image + 1); index++)
         {
-            temp_float_3 = (1.0 * (*(freq_ptr + index)) ) * temp_float_2;
+            temp_float_3 = (1.0 * FREQ(index) ) * temp_float_2;
             temp_float = max(temp_float, temp_float_3);
         }
         temp_int = (temp_float * 254.) + 1;
@@ -2249,7 +7129,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 0; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0 * (*(freq_ptr + temp_int)) ) *
+                    temp_float_2 = (1.0 * FREQ(temp_int) ) *
                                    constants.number_of_edges_inverse;
                     temp_float += temp_float_2 * temp_float_2;
                 }
@@ -2267,7 +7147,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 += (*(freq_ptr + temp_int));
+                    temp_int2 += FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -2282,7 +7162,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0 * (*(freq_ptr + temp_int)) )/ (1.0 * temp_int2);
+                    temp_float_2 = (1.0 * FREQ(temp_int) )/ (1.0 * temp_int2);
                     temp_float += temp_float_2 * temp_float_2;
                 }
             }
@@ -2322,8 +7202,8 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
                     temp_int2 = (ind2 * (n_colors_in_image + 1)) + ind1;
-                    if(  ( (*(freq_ptr + temp_int)) > 0) ||
-                            ( (*(freq_ptr + temp_int2)) > 0))
+                    if(  ( FREQ(temp_int) > 0) ||
+                            ( FREQ(temp_int2) > 0))
                     {
                         n_colors_in_window++;
                     }
@@ -2341,7 +7221,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 0; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0 * (*(freq_ptr + temp_int)) ) *
+                    temp_float_2 = (1.0 * FREQ(temp_int) ) *
                                    constants.number_of_edges_inverse;
                     temp_float += temp_float_2 * temp_float_2;
                 }
@@ -2382,8 +7262,8 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
                     temp_int2 = (ind2 * (n_colors_in_image + 1)) + ind1;
-                    if(  ( (*(freq_ptr + temp_int)) > 0) ||
-                            ( (*(freq_ptr + temp_int2)) > 0))
+                    if(  ( FREQ(temp_int) > 0) ||
+                            ( FREQ(temp_int2) > 0))
                     {
                         n_colors_in_window++;
                     }
@@ -2407,7 +7287,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 += (*(freq_ptr + temp_int));
+                    temp_int2 += FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -2422,7 +7302,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0 * (*(freq_ptr + temp_int)) ) / (1.0 * temp_int2);
+                    temp_float_2 = (1.0 * FREQ(temp_int) ) / (1.0 * temp_int2);
                     temp_float += temp_float_2 * temp_float_2;
                 }
             }
@@ -2445,8 +7325,8 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
                     temp_int2 = (ind2 * (n_colors_in_image + 1)) + ind1;
-                    if(  ( (*(freq_ptr + temp_int)) > 0) ||
-                            ( (*(freq_ptr + temp_int2)) > 0))
+                    if(  ( FREQ(temp_int) > 0) ||
+                            ( FREQ(temp_int2) > 0))
                     {
                         n_colors_in_window++;
                     }
@@ -2463,7 +7343,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 0; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0 * (*(freq_ptr + temp_int)) ) *
+                    temp_float_2 = (1.0 * FREQ(temp_int) ) *
                                    constants.number_of_edges_inverse;
                     if(temp_float_2 > 0)
                     {
@@ -2487,8 +7367,8 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
                     temp_int2 = (ind2 * (n_colors_in_image + 1)) + ind1;
-                    if(  ( (*(freq_ptr + temp_int)) > 0) ||
-                            ( (*(freq_ptr + temp_int2)) > 0))
+                    if(  ( FREQ(temp_int) > 0) ||
+                            ( FREQ(temp_int2) > 0))
                     {
                         n_colors_in_window++;
                     }
@@ -2511,7 +7391,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 += (*(freq_ptr + temp_int));
+                    temp_int2 += FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -2526,7 +7406,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0 * (*(freq_ptr + temp_int)) ) / (1.0 * temp_int2);
+                    temp_float_2 = (1.0 * FREQ(temp_int) ) / (1.0 * temp_int2);
                     if(temp_float_2 > 0)
                     {
                         temp_float = temp_float + (temp_float_2 * log(temp_float_2));
@@ -2549,7 +7429,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
             for(index = 0; index <= n_colors_in_image; index++)
             {
                 temp_int = (index * (n_colors_in_image + 1)) + index;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* and the proportion is... */
             temp_float = temp_float * constants.number_of_edges_inverse;
@@ -2566,7 +7446,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 += (*(freq_ptr + temp_int));
+                    temp_int2 += FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -2580,7 +7460,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
             for(index = 1; index <= n_colors_in_image; index++)
             {
                 temp_int = (index * (n_colors_in_image + 1)) + index;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* and the proportion is... */
             temp_float = temp_float / (1.0 * temp_int2);
@@ -2598,17 +7478,17 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
             for(index = 0; index <= n_colors_in_image; index++)
             {
                 temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + index;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* accumulate across code_1's column in the adjacency matrix */
             for(index = 0; index <= n_colors_in_image; index++)
             {
                 temp_int = (index * (n_colors_in_image + 1)) + parameters.code_1;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* the diagonal cell has been counted twice, so subtract one of them */
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_1;
-            temp_float -= (1.0 * (*(freq_ptr + temp_int)) );
+            temp_float -= (1.0 * FREQ(temp_int) );
             /* and the proportion is... */
             temp_float = temp_float * constants.number_of_edges_inverse;
             temp_int = (temp_float * 254.) + 1;
@@ -2624,7 +7504,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 += (*(freq_ptr + temp_int));
+                    temp_int2 += FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -2639,17 +7519,17 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
             for(index = 1; index <= n_colors_in_image; index++)
             {
                 temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + index;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* accumulate across code_1's column in the adjacency matrix */
             for(index = 1; index <= n_colors_in_image; index++)
             {
                 temp_int = (index * (n_colors_in_image + 1)) + parameters.code_1;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* the diagonal cell has been counted twice, so subtract one of them */
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_1;
-            temp_float = temp_float - (1.0 * (*(freq_ptr + temp_int)) );
+            temp_float = temp_float - (1.0 * FREQ(temp_int) );
             /* and the proportion is... (the divide by zero check happened above) */
             temp_float = temp_float / (1.0 * temp_int2);
             temp_int = (temp_float * 254.) + 1;
@@ -2663,13 +7543,13 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
             /* sum the i,j and j,i cells */
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) +
                        parameters.code_2;
-            temp_float = (1.0 * (*(freq_ptr + temp_int)) );
+            temp_float = (1.0 * FREQ(temp_int) );
             /* don't count a diagonal cell twice if self-joins were requested */
             if(parameters.code_1 != parameters.code_2)
             {
                 temp_int = (parameters.code_2 * (n_colors_in_image + 1)) +
                            parameters.code_1;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* and the proportion is... */
             temp_float = temp_float * constants.number_of_edges_inverse;
@@ -2686,7 +7566,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 += (*(freq_ptr + temp_int));
+                    temp_int2 += FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -2698,13 +7578,13 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
             /* sum the i,j and j,i cells */
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) +
                        parameters.code_2;
-            temp_float = (1.0 * (*(freq_ptr + temp_int)) );
+            temp_float = (1.0 * FREQ(temp_int) );
             /* don't count a diagonal cell twice if self-joins were requested */
             if(parameters.code_1 != parameters.code_2)
             {
                 temp_int = (parameters.code_2 * (n_colors_in_image + 1)) +
                            parameters.code_1;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* and the proportion is... (the divide by zero check happened above) */
             temp_float_3 = 1.0 / (1.0 * temp_int2);
@@ -2726,17 +7606,17 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         for(index = start; index <= n_colors_in_image; index++)
         {
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + index;
-            temp_float_2 += (*(freq_ptr + temp_int));
+            temp_float_2 += FREQ(temp_int);
         }
         /* accumulate across code_1's column in the adjacency matrix */
         for(index = start; index <= n_colors_in_image; index++)
         {
             temp_int = (index * (n_colors_in_image + 1)) + parameters.code_1;
-            temp_float_2 += (*(freq_ptr + temp_int));
+            temp_float_2 += FREQ(temp_int);
         }
         /* the diagonal cell has been counted twice, so subtract one of them */
         temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_1;
-        temp_float_2 -= (*(freq_ptr + temp_int));
+        temp_float_2 -= FREQ(temp_int);
         // 1.3.4
         // if(temp_float_2 == 0.)     /* set to missing if no edges with that color */
         if( fabs( temp_float_2) < EPSILON)
@@ -2746,7 +7626,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         }
         /* and the proportion is... */
         temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_1;
-        temp_float = (*(freq_ptr + temp_int));
+        temp_float = FREQ(temp_int);
         temp_float = (1.0 * temp_float) / (1.0 * temp_float_2);
         temp_int = (temp_float * 254.) + 1;
         map_val = temp_int;
@@ -2764,17 +7644,17 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         for(index = start; index <= n_colors_in_image; index++)
         {
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + index;
-            temp_float_2 += (*(freq_ptr + temp_int));
+            temp_float_2 += FREQ(temp_int);
         }
         /* accumulate across code_1's column in the adjacency matrix */
         for(index = start; index <= n_colors_in_image; index++)
         {
             temp_int = (index * (n_colors_in_image + 1)) + parameters.code_1;
-            temp_float_2 += (*(freq_ptr + temp_int));
+            temp_float_2 += FREQ(temp_int);
         }
         /* the diagonal cell has been counted twice, so subtract one of them */
         temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_1;
-        temp_float_2 -= (*(freq_ptr + temp_int));
+        temp_float_2 -= FREQ(temp_int);
         // 1.3.4
         // if(temp_float_2 == 0.)     /* set to missing if no edges with that color */
         if( fabs( temp_float_2) < EPSILON)
@@ -2786,13 +7666,13 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         temp_float_3 = 0.0;
         /* get the row entry */
         temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_2;
-        temp_float_3 +=  (*(freq_ptr + temp_int));
+        temp_float_3 +=  FREQ(temp_int);
         /* get the column entry and add it */
         /* but not if self joins were requested (don't count the diagonal twice) */
         if(parameters.code_1 != parameters.code_2)
         {
             temp_int =(parameters.code_2 * (n_colors_in_image + 1)) + parameters.code_1;
-            temp_float_3 += (*(freq_ptr + temp_int));
+            temp_float_3 += FREQ(temp_int);
         }
         /* and the proportion is... */
         temp_float = (1.0 * temp_float_3) / (1.0 * temp_float_2);
@@ -2802,7 +7682,7 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
     case 81: /* return local density of one particular color (code_1) */
         if(handle_missing == 2)   /*missing included*/
         {
-            temp_float = (*(freq_ptr + parameters.code_1)) *
+            temp_float = FREQ(parameters.code_1) *
                          constants.window_area_inverse;
         }
         if(handle_missing == 1)     /* missing not included */
@@ -2810,11 +7690,11 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
             temp_float_2 = 0.;
             for(index = 1; index < (n_colors_in_image + 1); index++)
             {
-                temp_float_2 +=  (*(freq_ptr + index));
+                temp_float_2 +=  FREQ(index);
             }
             if(temp_float_2 > 0)
             {
-                temp_float = (*(freq_ptr + parameters.code_1)) / temp_float_2;
+                temp_float = FREQ(parameters.code_1) / temp_float_2;
             }
             else     /* no non-missing pixels, set to missing */
             {
@@ -2827,29 +7707,29 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         break;
     case 82: /* return local ratio of two particular colors (code_1 / code_2) */
         /* set to missing if neither is present */
-        if( ( (*(freq_ptr + parameters.code_1)) == 0 ) &&
-                ( (*(freq_ptr + parameters.code_2)) == 0 )    )
+        if( ( FREQ(parameters.code_1) == 0 ) &&
+                ( FREQ(parameters.code_2) == 0 )    )
         {
             map_val = 0;
             break;
         }
         /* set to max if code1> 0 and code2= 0 */
-        if( ( (*(freq_ptr + parameters.code_1)) > 0 ) &&
-                ( (*(freq_ptr + parameters.code_2)) == 0 )    )
+        if( ( FREQ(parameters.code_1) > 0 ) &&
+                ( FREQ(parameters.code_2) == 0 )    )
         {
             map_val = 255;
             break;
         }
         /* set to min if code1= 0 and code2> 0 */
-        if( ( (*(freq_ptr + parameters.code_1)) == 0 ) &&
-                ( (*(freq_ptr + parameters.code_2)) > 0 )    )
+        if( ( FREQ(parameters.code_1) == 0 ) &&
+                ( FREQ(parameters.code_2) > 0 )    )
         {
             map_val = 1;
             break;
         }
         /* calculate ratio using code_1 in numerator */
-        temp_float_2 = (*(freq_ptr + parameters.code_1));
-        temp_float_2 = temp_float_2 / (*(freq_ptr + parameters.code_2));
+        temp_float_2 = FREQ(parameters.code_1);
+        temp_float_2 = temp_float_2 / FREQ(parameters.code_2);
         /* map that onto [129,254] if code_1 is larger */
         if(temp_float_2 > 1.0)
         {
@@ -2874,14 +7754,14 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
         }
         break;
     case 83:  /* return the ratio #code1 / (#code1 + #code2) */
-        temp_int2 = (*(freq_ptr + parameters.code_1)) +
-                       (*(freq_ptr + parameters.code_2));
+        temp_int2 = FREQ(parameters.code_1) +
+                       FREQ(parameters.code_2);
         if(temp_int2 == 0)
         {
             map_val = 0;
             break;
         }
-        temp_float =  (1.0 * (*(freq_ptr + parameters.code_1)) )/ (1.0 * temp_int2);
+        temp_float =  (1.0 * FREQ(parameters.code_1) )/ (1.0 * temp_int2);
         temp_int = (temp_float * 254.) + 1;
         map_val = temp_int;
         break;
@@ -2901,8 +7781,9 @@ unsigned char Freq_Filters(long int color_freq, long int edge_freq, long int *fr
 	and is only implemented for a few of the mapping rules.
 	Only important change is that the variable 'map_val' is declared a float here, instead of unsigned char.
 ************************************************************************ */
-float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq_ptr, long int n_colors_in_image,
-                         long int mapping_rule, long int handle_missing, long int code_1, long int code_2)
+float Freq_Filters_Float(long int color_freq, long int edge_freq, void *freq_ptr, long int count_width,
+                         long int n_colors_in_image, long int mapping_rule, long int handle_missing,
+                         long int code_1, long int code_2)
 {
     float map_val;
     long int index, start, temp_int, temp_int2, ind1, ind2, n_colors_in_window;
@@ -2923,8 +7804,8 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
     case 6:
     case 7:
     case 10:
-        printf("\nSpatcon: Error. Float output not available for this mapping rule.\n");
-        exit(30);
+        /* rejected by Check_Run_Parameters, this runs in the convolution threads */
+        Thread_Error(30, "\nSpatcon: Error. Float output not available for this mapping rule.\n");
         break;
 	case 20:  /* Return the median value 
                         No sorting is required because we already have the frequency
@@ -2941,7 +7822,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
         if(handle_missing == 1)     /* missing not included */
         {
             start = 1;
-            temp_int = constants.window_area - (*(freq_ptr));
+            temp_int = constants.window_area - FREQ(0);
             if( (temp_int % 2) != 0 )
             {
                 temp_int = (temp_int / 2) + 1;  /* actual */
@@ -2956,7 +7837,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
         map_val = 0.0; /* seed it */
         for(index = start; index < (n_colors_in_image + 1); index++)
         {
-            temp_int2 += (*(freq_ptr + index));
+            temp_int2 += FREQ(index);
             if(temp_int2 >= temp_int)
             {
                 map_val = 1.0 * index;
@@ -2973,16 +7854,16 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                          this by weighted average from the freq distn    */
         // 1.3.4
         // if( (*(freq_ptr)) == constants.window_area)   /*they're all missing */
-        if( (fabs( (*(freq_ptr)) - constants.window_area)) < EPSILON)
+        if( (fabs( FREQ(0) - constants.window_area)) < EPSILON)
         {
             map_val = -0.01;
             break;
         }
-        temp_float_2 = 1.0 / (1.0 *(constants.window_area - (*(freq_ptr)) ) );
+        temp_float_2 = 1.0 / (1.0 *(constants.window_area - FREQ(0) ) );
         temp_int = 0;
         for(index = 1; index < (n_colors_in_image + 1); index++)
         {
-            temp_int += (*(freq_ptr + index)) * index;
+            temp_int += FREQ(index) * index;
         }
         map_val = temp_float_2 * (1.0 * temp_int);
         break;
@@ -2999,20 +7880,20 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             start = 1;
             // 1.3.4
             // if( (*(freq_ptr)) == constants.window_area)   /*they're all missing */
-            if( (fabs( (*(freq_ptr)) - constants.window_area)) < EPSILON)
+            if( (fabs( FREQ(0) - constants.window_area)) < EPSILON)
             {
                 map_val = -0.01;
                 break;
             }
             else
             {
-                temp_float_2 = 1.0 / (1.0 * (constants.window_area - (*(freq_ptr)) ) );
+                temp_float_2 = 1.0 / (1.0 * (constants.window_area - FREQ(0) ) );
             }
         }
         temp_float = 0.0;
         for(index = start; index < (n_colors_in_image + 1); index++)
         {
-            temp_float_3 = (1.0 * (*(freq_ptr + index)) ) * temp_float_2;
+            temp_float_3 = (1.0 * FREQ(index) ) * temp_float_2;
             temp_float += temp_float_3 * temp_float_3;
         }
         temp_float = 1.0 - temp_float; /* this is 'diversity'*/
@@ -3026,7 +7907,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             temp_int = 0;  /*counter of number of colors in window*/
             for(index = start; index < (n_colors_in_image + 1); index++)
             {
-                if( (*(freq_ptr + index)) > 0)
+                if( FREQ(index) > 0)
                 {
                     temp_int++;
                 }
@@ -3057,20 +7938,20 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             start = 1;
             // 1.3.4
             // if( (*(freq_ptr)) == constants.window_area)   /*they're all missing */
-            if( (fabs( (*(freq_ptr)) - constants.window_area)) < EPSILON)
+            if( (fabs( FREQ(0) - constants.window_area)) < EPSILON)
             {
                 map_val = -0.01;
                 break;
             }
             else
             {
-                temp_float_2 = 1.0 / (1.0 * (constants.window_area - (*(freq_ptr)) ));
+                temp_float_2 = 1.0 / (1.0 * (constants.window_area - FREQ(0) ));
             }
         }
         temp_float = 0.0;
         for(index = start; index < (n_colors_in_image + 1); index++)
         {
-            temp_float_3 = (1.0* (*(freq_ptr + index)) ) * temp_float_2;
+            temp_float_3 = (1.0* FREQ(index) ) * temp_float_2;
             if(temp_float_3 > 0)
             {
                 temp_float += temp_float_3 * log(temp_float_3);
@@ -3080,7 +7961,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
         temp_int = 0;  /*counter of number of colors in window*/
         for(index = start; index < (n_colors_in_image + 1); index++)
         {
-            if( (*(freq_ptr + index)) > 0)
+            if( FREQ(index) > 0)
             {
                 temp_int++;
             }
@@ -3109,20 +7990,20 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             start = 1;
             // 1.3.4
             // if( (*(freq_ptr)) == constants.window_area)   /*they're all missing */
-            if( (fabs( (*(freq_ptr)) - constants.window_area)) < EPSILON)
+            if( (fabs( FREQ(0) - constants.window_area)) < EPSILON)
             {
                 map_val = -0.01;
                 break;
             }
             else
             {
-                temp_float_2 = 1.0 / (1.0 * (constants.window_area - (*(freq_ptr)) ));
+                temp_float_2 = 1.0 / (1.0 * (constants.window_area - FREQ(0) ));
             }
         }
         temp_float = 0.0;
         for(index = start; index < (n_colors_in_image + 1); index++)
         {
-            temp_float_3 = (1.0* (*(freq_ptr + index)) ) * temp_float_2;
+            temp_float_3 = (1.0* FREQ(index) ) * temp_float_2;
             temp_float = max(temp_float, temp_float_3);
         }
         map_val = temp_float;
@@ -3136,7 +8017,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 0; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0 * (*(freq_ptr + temp_int)) ) *
+                    temp_float_2 = (1.0 * FREQ(temp_int) ) *
                                    constants.number_of_edges_inverse;
                     temp_float += temp_float_2 * temp_float_2;
                 }
@@ -3153,7 +8034,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 += (*(freq_ptr + temp_int));
+                    temp_int2 += FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -3168,7 +8049,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0 * (*(freq_ptr + temp_int))) / (1.0*temp_int2);
+                    temp_float_2 = (1.0 * FREQ(temp_int)) / (1.0*temp_int2);
                     temp_float += temp_float_2 * temp_float_2;
                 }
             }
@@ -3207,8 +8088,8 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
                     temp_int2 = (ind2 * (n_colors_in_image + 1)) + ind1;
-                    if(  ( (*(freq_ptr + temp_int)) > 0) ||
-                            ( (*(freq_ptr + temp_int2)) > 0))
+                    if(  ( FREQ(temp_int) > 0) ||
+                            ( FREQ(temp_int2) > 0))
                     {
                         n_colors_in_window++;
                     }
@@ -3226,7 +8107,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 0; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0* (*(freq_ptr + temp_int)) ) *
+                    temp_float_2 = (1.0* FREQ(temp_int) ) *
                                    constants.number_of_edges_inverse;
                     temp_float += temp_float_2 * temp_float_2;
                 }
@@ -3266,8 +8147,8 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
                     temp_int2 = (ind2 * (n_colors_in_image + 1)) + ind1;
-                    if(  ( (*(freq_ptr + temp_int)) > 0) ||
-                            ( (*(freq_ptr + temp_int2)) > 0))
+                    if(  ( FREQ(temp_int) > 0) ||
+                            ( FREQ(temp_int2) > 0))
                     {
                         n_colors_in_window++;
                     }
@@ -3291,7 +8172,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 += (*(freq_ptr + temp_int));
+                    temp_int2 += FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -3306,7 +8187,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0* (*(freq_ptr + temp_int)) )/ (1.0*temp_int2);
+                    temp_float_2 = (1.0* FREQ(temp_int) )/ (1.0*temp_int2);
                     temp_float += temp_float_2 * temp_float_2;
                 }
             }
@@ -3328,8 +8209,8 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
                     temp_int2 = (ind2 * (n_colors_in_image + 1)) + ind1;
-                    if(  ( (*(freq_ptr + temp_int)) > 0) ||
-                            ( (*(freq_ptr + temp_int2)) > 0))
+                    if(  ( FREQ(temp_int) > 0) ||
+                            ( FREQ(temp_int2) > 0))
                     {
                         n_colors_in_window++;
                     }
@@ -3346,7 +8227,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 0; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0 * (*(freq_ptr + temp_int)) ) *
+                    temp_float_2 = (1.0 * FREQ(temp_int) ) *
                                    constants.number_of_edges_inverse;
                     if(temp_float_2 > 0)
                     {
@@ -3369,8 +8250,8 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
                     temp_int2 = (ind2 * (n_colors_in_image + 1)) + ind1;
-                    if(  ( (*(freq_ptr + temp_int)) > 0) ||
-                            ( (*(freq_ptr + temp_int2)) > 0))
+                    if(  ( FREQ(temp_int) > 0) ||
+                            ( FREQ(temp_int2) > 0))
                     {
                         n_colors_in_window++;
                     }
@@ -3393,7 +8274,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 +=  (*(freq_ptr + temp_int));
+                    temp_int2 +=  FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -3408,7 +8289,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_float_2 = (1.0 * (*(freq_ptr + temp_int)) ) / (1.0 * temp_int2);
+                    temp_float_2 = (1.0 * FREQ(temp_int) ) / (1.0 * temp_int2);
                     if(temp_float_2 > 0)
                     {
                         temp_float = temp_float + (temp_float_2 * log(temp_float_2));
@@ -3430,7 +8311,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             for(index = 0; index <= n_colors_in_image; index++)
             {
                 temp_int = (index * (n_colors_in_image + 1)) + index;
-                temp_int2 += (*(freq_ptr + temp_int));
+                temp_int2 += FREQ(temp_int);
             }
             /* and the proportion is... */
             temp_float = (1.0 * temp_int2) * constants.number_of_edges_inverse;
@@ -3446,7 +8327,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 += (*(freq_ptr + temp_int));
+                    temp_int2 += FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -3460,7 +8341,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             for(index = 1; index <= n_colors_in_image; index++)
             {
                 temp_int = (index * (n_colors_in_image + 1)) + index;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)));
+                temp_float += (1.0 * FREQ(temp_int));
             }
             /* and the proportion is... */
             temp_float = temp_float / (1.0 * temp_int2);
@@ -3477,17 +8358,17 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             for(index = 0; index <= n_colors_in_image; index++)
             {
                 temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + index;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* accumulate across code_1's column in the adjacency matrix */
             for(index = 0; index <= n_colors_in_image; index++)
             {
                 temp_int = (index * (n_colors_in_image + 1)) + parameters.code_1;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* the diagonal cell has been counted twice, so subtract one of them */
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_1;
-            temp_float -= (1.0 * (*(freq_ptr + temp_int)) );
+            temp_float -= (1.0 * FREQ(temp_int) );
             /* and the proportion is... */
             temp_float = temp_float * constants.number_of_edges_inverse;
             map_val = temp_float;
@@ -3502,7 +8383,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 += (*(freq_ptr + temp_int));
+                    temp_int2 += FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -3517,17 +8398,17 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             for(index = 1; index <= n_colors_in_image; index++)
             {
                 temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + index;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* accumulate across code_1's column in the adjacency matrix */
             for(index = 1; index <= n_colors_in_image; index++)
             {
                 temp_int = (index * (n_colors_in_image + 1)) + parameters.code_1;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* the diagonal cell has been counted twice, so subtract one of them */
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_1;
-            temp_float = temp_float - (1.0 * (*(freq_ptr + temp_int)) );
+            temp_float = temp_float - (1.0 * FREQ(temp_int) );
             /* and the proportion is... (the divide by zero check happened above) */
             temp_float =  temp_float / (1.0 * temp_int2);
             map_val = temp_float;
@@ -3542,13 +8423,13 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             /* sum the i,j and j,i cells */
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) +
                        parameters.code_2;
-            temp_float = (1.0 * (*(freq_ptr + temp_int)) );
+            temp_float = (1.0 * FREQ(temp_int) );
             /* don't count a diagonal cell twice if self-joins were requested */
             if(parameters.code_1 != parameters.code_2)
             {
                 temp_int = (parameters.code_2 * (n_colors_in_image + 1)) +
                            parameters.code_1;
-                temp_float +=  (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float +=  (1.0 * FREQ(temp_int) );
             }
             /* and the proportion is... */
             temp_float = temp_float * constants.number_of_edges_inverse;
@@ -3564,7 +8445,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
                 for(ind2 = 1; ind2 <= n_colors_in_image; ind2++)
                 {
                     temp_int = (ind1 * (n_colors_in_image + 1)) + ind2;
-                    temp_int2 += (*(freq_ptr + temp_int));
+                    temp_int2 += FREQ(temp_int);
                 }
             }
             /* return missing if there are no non-missing edges */
@@ -3576,13 +8457,13 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             /* sum the i,j and j,i cells */
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) +
                        parameters.code_2;
-            temp_float = (1.0 * (*(freq_ptr + temp_int)) );
+            temp_float = (1.0 * FREQ(temp_int) );
             /* don't count a diagonal cell twice if self-joins were requested */
             if(parameters.code_1 != parameters.code_2)
             {
                 temp_int = (parameters.code_2 * (n_colors_in_image + 1)) +
                            parameters.code_1;
-                temp_float += (1.0 * (*(freq_ptr + temp_int)) );
+                temp_float += (1.0 * FREQ(temp_int) );
             }
             /* and the proportion is... (the divide by zero check happened above) */
             temp_float_3 = 1.0 / (1.0 * temp_int2);
@@ -3603,17 +8484,17 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
         for(index = start; index <= n_colors_in_image; index++)
         {
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + index;
-            temp_float_2 += (*(freq_ptr + temp_int));
+            temp_float_2 += FREQ(temp_int);
         }
         /* accumulate across code_1's column in the adjacency matrix */
         for(index = start; index <= n_colors_in_image; index++)
         {
             temp_int = (index * (n_colors_in_image + 1)) + parameters.code_1;
-            temp_float_2 += (*(freq_ptr + temp_int));
+            temp_float_2 += FREQ(temp_int);
         }
         /* the diagonal cell has been counted twice, so subtract one of them */
         temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_1;
-        temp_float_2 -= (*(freq_ptr + temp_int));
+        temp_float_2 -= FREQ(temp_int);
         // 1.3.4
         // if(temp_float_2 == 0.)     /* set to missing if no edges with that color */
         if( fabs( temp_float_2) < EPSILON)
@@ -3623,7 +8504,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
         }
         /* and the proportion is... */
         temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_1;
-        temp_float = (*(freq_ptr + temp_int));
+        temp_float = FREQ(temp_int);
         temp_float = (1.0 * temp_float) / (1.0 * temp_float_2);
         map_val = temp_float;
         break;
@@ -3640,17 +8521,17 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
         for(index = start; index <= n_colors_in_image; index++)
         {
             temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + index;
-            temp_float_2 += (*(freq_ptr + temp_int));
+            temp_float_2 += FREQ(temp_int);
         }
         /* accumulate across code_1's column in the adjacency matrix */
         for(index = start; index <= n_colors_in_image; index++)
         {
             temp_int = (index * (n_colors_in_image + 1)) + parameters.code_1;
-            temp_float_2 += (*(freq_ptr + temp_int));
+            temp_float_2 += FREQ(temp_int);
         }
         /* the diagonal cell has been counted twice, so subtract one of them */
         temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_1;
-        temp_float_2 -= (*(freq_ptr + temp_int));
+        temp_float_2 -= FREQ(temp_int);
         // 1.3.4
         // if(temp_float_2 == 0.)     /* set to missing if no edges with that color */
         if( fabs( temp_float_2) < EPSILON)
@@ -3662,10 +8543,10 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
         temp_float_3 = 0.0;
         /* get the row entry */
         temp_int = (parameters.code_1 * (n_colors_in_image + 1)) + parameters.code_2;
-        temp_float_3 +=  (*(freq_ptr + temp_int));
+        temp_float_3 +=  FREQ(temp_int);
         /* get the column entry and add it */
         temp_int =(parameters.code_2 * (n_colors_in_image + 1)) + parameters.code_1;
-        temp_float_3 += (*(freq_ptr + temp_int));
+        temp_float_3 += FREQ(temp_int);
         /* and the proportion is... */
         temp_float = (1.0 * temp_float_3) / (1.0 * temp_float_2);
         map_val = temp_float;
@@ -3673,7 +8554,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
     case 81: /* return local density of one particular color (code_1) */
         if(handle_missing == 2)   /*missing included*/
         {
-            temp_float = (*(freq_ptr + parameters.code_1)) *
+            temp_float = FREQ(parameters.code_1) *
                          constants.window_area_inverse;
         }
         if(handle_missing == 1)     /* missing not included */
@@ -3681,11 +8562,11 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             temp_float_2 = 0.;
             for(index = 1; index < (n_colors_in_image + 1); index++)
             {
-                temp_float_2 +=  (*(freq_ptr + index));
+                temp_float_2 +=  FREQ(index);
             }
             if(temp_float_2 > 0)
             {
-                temp_float = (*(freq_ptr + parameters.code_1)) / temp_float_2;
+                temp_float = FREQ(parameters.code_1) / temp_float_2;
             }
             else     /* no non-missing pixels, set to missing */
             {
@@ -3697,27 +8578,27 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
         break;
 	  case 82: /* return local ratio of two particular colors (code_1 / code_2) */
         /* set to missing if neither is present */
-        if( ( (*(freq_ptr + parameters.code_1)) == 0 ) &&
-                ( (*(freq_ptr + parameters.code_2)) == 0 )    )
+        if( ( FREQ(parameters.code_1) == 0 ) &&
+                ( FREQ(parameters.code_2) == 0 )    )
         {
             map_val = -0.01;
             break;
         }
         /* set to missing if denominator code2= 0 */
-        if( ( (*(freq_ptr + parameters.code_2)) == 0 )    )
+        if( ( FREQ(parameters.code_2) == 0 )    )
         {
             map_val = -0.01;
             break;
         }
         
         /* calculate ratio using code_1 in numerator */
-        temp_float_2 = 1.0 * (*(freq_ptr + parameters.code_1));
-        temp_float_2 = temp_float_2 / (1.0 * (*(freq_ptr + parameters.code_2)));
+        temp_float_2 = 1.0 * FREQ(parameters.code_1);
+        temp_float_2 = temp_float_2 / (1.0 * FREQ(parameters.code_2));
         map_val = temp_float_2;
         break;
     case 83:  /* return the ratio #code1 / (#code1 + #code2) */
-        temp_float_2 = (*(freq_ptr + parameters.code_1)) +
-                       (*(freq_ptr + parameters.code_2));
+        temp_float_2 = FREQ(parameters.code_1) +
+                       FREQ(parameters.code_2);
 	// 1.3.4
         // if(temp_float_2 == 0.)     /* set to missing if no edges with that color */
         if( fabs( temp_float_2) < EPSILON)
@@ -3725,7 +8606,7 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
             map_val = -0.01;
             break;
         }
-        temp_float =  (*(freq_ptr + parameters.code_1)) / temp_float_2;
+        temp_float =  FREQ(parameters.code_1) / temp_float_2;
         map_val = temp_float;
         break;
     default:
@@ -3734,3 +8615,169 @@ float Freq_Filters_Float(long int color_freq, long int edge_freq, long int *freq
     }
     return(map_val);
 }
+/*   **************
+     Select_Kernel
+     **************
+*/
+/* **********************************************************************
+  1.4.0, one kernel per mapping rule, handle_missing and output format.
+	Each kernel calls Freq_Filters or Freq_Filters_Float with the rule, handle_missing and the size of
+	the counts (specs->count_width) as constants.
+	flatten makes gcc and clang inline the filter into the kernel, so the switch on the mapping rule
+	and the tests of handle_missing are resolved at compile time and only the code for that rule is left.
+	The kernels are aligned so the speed of their loops does not depend on where the linker puts them.
+	Select_Kernel looks up the kernels once per run and Store_Value calls them through specs->store.
+	Every rule in ok_mapping_rule must have its kernels in kernel_table.
+************************************************************************ */
+/* 1.4.0, rules 6 and 7 from the table of Mosaic_Table if there is one; the map only has the codes 0 to 3 */
+static inline unsigned char Mosaic_Value(struct conv_specs *specs, void *freq_ptr, int width, long int mapping_rule)
+{
+    long int n_missing, n_agr, n_for, n_dev;
+    unsigned char *table;
+    table = specs->mosaic_table[mapping_rule - 6];
+    n_missing = Get_Count(freq_ptr, 0, width);
+    n_agr = Get_Count(freq_ptr, 1, width);
+    n_for = Get_Count(freq_ptr, 2, width);
+    n_dev = Get_Count(freq_ptr, 3, width);
+    if(table != NULL)
+    {
+        return(table[Mosaic_Index(n_agr, n_for, n_dev)]);
+    }
+    return(Mosaic_Class(mapping_rule, n_missing, n_agr, n_for, n_dev));
+}
+
+#if defined(__GNUC__)
+#define KERNEL_ATTR static __attribute__((flatten, aligned(64)))
+#else
+#define KERNEL_ATTR static
+#endif
+
+#define DEFINE_KERNELS(rule, hm, edges, bits) \
+KERNEL_ATTR void Kernel_##rule##_##hm##_##bits##_byte(struct conv_specs *specs, void *freq_ptr, \
+                                                      unsigned char *out_row, float *out_row_float, long int grain_col) \
+{ \
+    unsigned char value; \
+    if( (rule == 6) || (rule == 7) ) \
+    { \
+        value = Mosaic_Value(specs, freq_ptr, bits / 8, rule); \
+    } \
+    else \
+    { \
+        value = Freq_Filters(1 - edges, edges, freq_ptr, bits / 8, specs->n_colors_in_image, \
+                             rule, hm, specs->code_1, specs->code_2); \
+    } \
+    (*(out_row + grain_col)) = (rule == 1) ? specs->color_out[value] : value; \
+} \
+KERNEL_ATTR void Kernel_##rule##_##hm##_##bits##_float(struct conv_specs *specs, void *freq_ptr, \
+                                                       unsigned char *out_row, float *out_row_float, long int grain_col) \
+{ \
+    (*(out_row_float + grain_col)) = Freq_Filters_Float(1 - edges, edges, freq_ptr, bits / 8, specs->n_colors_in_image, \
+                                                        rule, hm, specs->code_1, specs->code_2); \
+}
+#define DEFINE_RULE_KERNELS(rule, edges) \
+    DEFINE_KERNELS(rule, 1, edges, 16) DEFINE_KERNELS(rule, 2, edges, 16) \
+    DEFINE_KERNELS(rule, 1, edges, 32) DEFINE_KERNELS(rule, 2, edges, 32)
+/* rules 71-76 also have kernels for the sparse adjacency matrix, see Store_Sparse_Value */
+#define DEFINE_SPARSE_KERNELS(rule, hm, bits) \
+KERNEL_ATTR void Sparse_##rule##_##hm##_##bits##_byte(struct conv_specs *specs, void *freq_ptr, \
+                                                      unsigned char *out_row, float *out_row_float, long int grain_col) \
+{ \
+    Store_Sparse_Value(specs, freq_ptr, bits / 8, rule, hm, 0, out_row, out_row_float, grain_col); \
+} \
+KERNEL_ATTR void Sparse_##rule##_##hm##_##bits##_float(struct conv_specs *specs, void *freq_ptr, \
+                                                       unsigned char *out_row, float *out_row_float, long int grain_col) \
+{ \
+    Store_Sparse_Value(specs, freq_ptr, bits / 8, rule, hm, 1, out_row, out_row_float, grain_col); \
+}
+/* the matrix has at most 256 x 256 cells, fewer than the edges of a window with 4-byte counts, */
+/*   so the sparse matrix always has 2-byte counts (see Init_Conv_Specs) */
+#define DEFINE_SPARSE_RULE_KERNELS(rule) DEFINE_SPARSE_KERNELS(rule, 1, 16) DEFINE_SPARSE_KERNELS(rule, 2, 16)
+
+DEFINE_RULE_KERNELS(1, 0)
+DEFINE_RULE_KERNELS(6, 0)
+DEFINE_RULE_KERNELS(7, 0)
+DEFINE_RULE_KERNELS(10, 0)
+DEFINE_RULE_KERNELS(20, 0)
+DEFINE_RULE_KERNELS(21, 0)
+DEFINE_RULE_KERNELS(51, 0)
+DEFINE_RULE_KERNELS(52, 0)
+DEFINE_RULE_KERNELS(53, 0)
+DEFINE_RULE_KERNELS(54, 0)
+DEFINE_RULE_KERNELS(71, 1)
+DEFINE_RULE_KERNELS(72, 1)
+DEFINE_RULE_KERNELS(73, 1)
+DEFINE_RULE_KERNELS(74, 1)
+DEFINE_RULE_KERNELS(75, 1)
+DEFINE_RULE_KERNELS(76, 1)
+DEFINE_RULE_KERNELS(77, 1)
+DEFINE_RULE_KERNELS(78, 1)
+DEFINE_RULE_KERNELS(81, 0)
+DEFINE_RULE_KERNELS(82, 0)
+DEFINE_RULE_KERNELS(83, 0)
+DEFINE_SPARSE_RULE_KERNELS(71)
+DEFINE_SPARSE_RULE_KERNELS(72)
+DEFINE_SPARSE_RULE_KERNELS(73)
+DEFINE_SPARSE_RULE_KERNELS(74)
+DEFINE_SPARSE_RULE_KERNELS(75)
+DEFINE_SPARSE_RULE_KERNELS(76)
+
+struct filter_kernel
+{
+    long int mapping_rule;
+    void (*store_byte[4])(struct conv_specs *, void *, unsigned char *, float *, long int);
+    void (*store_float[4])(struct conv_specs *, void *, unsigned char *, float *, long int);
+};
+/* store_byte[0] and store_float[0] read 2-byte counts, [1] 4-byte counts, [2] and [3] the same with the
+   sparse adjacency matrix; the rules without sparse kernels ignore its occupied cells */
+#define KERNEL_ENTRY(rule, hm) \
+    {rule, {Kernel_##rule##_##hm##_16_byte, Kernel_##rule##_##hm##_32_byte, \
+            Kernel_##rule##_##hm##_16_byte, Kernel_##rule##_##hm##_32_byte}, \
+     {Kernel_##rule##_##hm##_16_float, Kernel_##rule##_##hm##_32_float, \
+      Kernel_##rule##_##hm##_16_float, Kernel_##rule##_##hm##_32_float}}
+#define SPARSE_ENTRY(rule, hm) \
+    {rule, {Kernel_##rule##_##hm##_16_byte, Kernel_##rule##_##hm##_32_byte, \
+            Sparse_##rule##_##hm##_16_byte, Kernel_##rule##_##hm##_32_byte}, \
+     {Kernel_##rule##_##hm##_16_float, Kernel_##rule##_##hm##_32_float, \
+      Sparse_##rule##_##hm##_16_float, Kernel_##rule##_##hm##_32_float}}
+#define KERNEL_ROW(hm) \
+    KERNEL_ENTRY(1, hm), KERNEL_ENTRY(6, hm), KERNEL_ENTRY(7, hm), KERNEL_ENTRY(10, hm), \
+    KERNEL_ENTRY(20, hm), KERNEL_ENTRY(21, hm), KERNEL_ENTRY(51, hm), KERNEL_ENTRY(52, hm), \
+    KERNEL_ENTRY(53, hm), KERNEL_ENTRY(54, hm), SPARSE_ENTRY(71, hm), SPARSE_ENTRY(72, hm), \
+    SPARSE_ENTRY(73, hm), SPARSE_ENTRY(74, hm), SPARSE_ENTRY(75, hm), SPARSE_ENTRY(76, hm), \
+    KERNEL_ENTRY(77, hm), KERNEL_ENTRY(78, hm), KERNEL_ENTRY(81, hm), KERNEL_ENTRY(82, hm), \
+    KERNEL_ENTRY(83, hm)
+/* kernel_table[handle_missing - 1][] */
+static const struct filter_kernel kernel_table[2][NUM_MAP_RULES_DEFINED] =
+{
+    {KERNEL_ROW(1)},
+    {KERNEL_ROW(2)}
+};
+
+void Select_Kernel(struct conv_specs *specs)
+{
+    long int index, rule, slot;
+    const struct filter_kernel *kernel;
+    for(rule = 0; rule < specs->n_rules; rule++)
+    {
+        specs->store[rule] = NULL;
+        for(index = 0; index < NUM_MAP_RULES_DEFINED; index++)
+        {
+            kernel = &kernel_table[specs->handle_missing - 1][index];
+            if(kernel->mapping_rule == specs->mapping_rules[rule])
+            {
+                slot = (specs->count_width == 2) ? 0 : 1;
+                if(specs->sparse == 1)
+                {
+                    slot += 2;
+                }
+                specs->store[rule] = (parameters.outfloat == 1) ? kernel->store_float[slot] : kernel->store_byte[slot];
+                break;
+            }
+        }
+        if(specs->store[rule] == NULL)
+        {
+            printf("\nSpatcon: Error. No filter kernel for mapping rule %ld.\n", specs->mapping_rules[rule]);
+            exit(54);
+        }
+    }
+}
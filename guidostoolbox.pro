@@ -23,7 +23,7 @@
 ;; GTB homepage: https://forest.jrc.ec.europa.eu/en/activities/lpa/gtb/
 ;; GitHub: https://github.com/ec-jrc/GTB
 ;;=======================================================================
-compile_opt idl2
+compile_opt idl2
 
 ;;=======================================================================
 ;; include required subroutines
@@ -869,8 +869,8 @@ IF my_os EQ 'windows' THEN BEGIN
   recode='..\spatcon\recode64.exe' & file_copy, recode, 'recode.exe', /overwrite
 ENDIF ELSE IF my_os EQ 'darwin' THEN BEGIN
   recode='../spatcon/recode_mac' & file_copy, recode, 'recode', /overwrite
-ENDIF ELSE IF my_os EQ 'apple' THEN BEGIN
-  recode='../spatcon/recodeARM_mac' & file_copy, recode, 'recode', /overwrite
+ENDIF ELSE IF my_os EQ 'apple' THEN BEGIN
+  recode='../spatcon/recodeARM_mac' & file_copy, recode, 'recode', /overwrite
 ENDIF ELSE BEGIN
   recode='../spatcon/recode_lin64' & file_copy, recode, 'recode', /overwrite
 ENDELSE
@@ -1321,6 +1321,39 @@ case strlowCase(metric) of ;; Mapping rules, see spatcon 483ff
 endcase
 
 
+;; in-process spatcon (spatcon.c compiled with -DSPATCON_LIBRARY), if installed: no files and no spawn.
+;; LM still runs the executable because its scoutput is recoded further from disk.
+IF my_os EQ 'windows' THEN BEGIN
+  sclib='..\spatcon\spatcon64.dll'
+ENDIF ELSE IF my_os EQ 'darwin' THEN BEGIN
+  sclib='../spatcon/libspatcon_mac.so'
+ENDIF ELSE IF my_os EQ 'apple' THEN BEGIN
+  sclib='../spatcon/libspatconARM_mac.so'
+ENDIF ELSE BEGIN
+  sclib='../spatcon/libspatcon_lin64.so'
+ENDELSE
+sclib = file_expand_path(sclib)
+if file_test(sclib) AND mstr ne '7' then begin
+  sz=size(scinput,/dim)
+  if mstr eq '78' then bval = 3 else if mstr eq '76' then bval = 2 else bval = 0
+  ;; the lines of scpars.txt: parameter codes and values
+  pcodes = byte('wrahbmf')
+  pvals = long64([kdim, fix(mstr), 2, 1, bval, 0, resfloat])
+  scoutput = bytarr(sz(0),sz(1))
+  if resfloat eq 1 then scoutput=float(scoutput)
+  res = call_external(sclib, 'Spatcon_IDL', scinput, long64(sz[1]), long64(sz[0]), $
+    pcodes, pvals, long64(n_elements(pvals)), scoutput, /cdecl)
+  ;; a failed run is an error, as a failed spawn is when scoutput cannot be read: no zero-filled result
+  if res ne 0 then begin
+    scoutput = 0 & tmp = temporary(scoutput)
+    popd
+    message, 'spatcon library error ' + strtrim(res,2) + ' (exit code of spatcon)'
+  endif
+  scinput=0
+  popd
+  return
+endif
+
 ;; we need these 3 files in tmp-directory: scsize.txt, scpars.txt, scinput (bsq-file) -> scoutput
 sz=size(scinput,/dim) & kstr = strtrim(kdim,2)
 ;; for spatcon: rows first, then columns!
@@ -1353,8 +1386,8 @@ IF my_os EQ 'windows' THEN BEGIN
   spatcon='..\spatcon\spatcon64.exe' & file_copy, spatcon, 'spatcon.exe', /overwrite
 ENDIF ELSE IF my_os EQ 'darwin' THEN BEGIN
   spatcon='../spatcon/spatcon_mac' & file_copy, spatcon, 'spatcon', /overwrite
-ENDIF ELSE IF my_os EQ 'apple' THEN BEGIN
-  spatcon='../spatcon/spatconARM_mac' & file_copy, spatcon, 'spatcon', /overwrite
+ENDIF ELSE IF my_os EQ 'apple' THEN BEGIN
+  spatcon='../spatcon/spatconARM_mac' & file_copy, spatcon, 'spatcon', /overwrite
 ENDIF ELSE BEGIN
   spatcon='../spatcon/spatcon_lin64' & file_copy, spatcon, 'spatcon', /overwrite
 ENDELSE
@@ -1576,11 +1609,11 @@ IF info.my_os EQ 'windows' THEN BEGIN
   gedit = info.windrive + ' & cd "' + info.dir_fwtools + '" & setfw.bat & '
   gedit = gedit + 'cd "' + info.dir_tmp + '" & gdal_edit -mo ' + tagsw
 ENDIF ELSE IF info.my_os EQ 'linux' THEN BEGIN
-  if strlen(info.sysgdal) gt 0 then $
-    gedit = 'unset LD_LIBRARY_PATH; gdal_edit.py -mo ' + tagsw else $
-  gedit = info.dir_fwtools + 'gdal_edit.py -mo ' + tagsw
+  if strlen(info.sysgdal) gt 0 then $
+    gedit = 'unset LD_LIBRARY_PATH; gdal_edit.py -mo ' + tagsw else $
+  gedit = info.dir_fwtools + 'gdal_edit.py -mo ' + tagsw
 ENDIF ELSE IF info.my_os EQ 'darwin' THEN BEGIN
-  gedit = '/Library/Frameworks/Python.framework/Versions/3.9/bin/gdal_edit.py -mo ' + tagsw
+  gedit = '/Library/Frameworks/Python.framework/Versions/3.9/bin/gdal_edit.py -mo ' + tagsw
 ENDIF ELSE BEGIN ;; apple
   gedit = '/opt/homebrew/bin/gdal_edit.py -mo ' + tagsw
 ENDELSE
@@ -1947,11 +1980,11 @@ CASE strlowCase(eventValue) OF
            tvlct, r, g, b
            info.ctbl = - 1 & info.autostretch_id = 0
          END
-         17:BEGIN ;; FOSchange
-           restore, info.dir_guidossub + 'foschangecolors.sav'
-           tvlct, r, g, b
-           info.ctbl = - 1 & info.autostretch_id = 0
-         END
+         17:BEGIN ;; FOSchange
+           restore, info.dir_guidossub + 'foschangecolors.sav'
+           tvlct, r, g, b
+           info.ctbl = - 1 & info.autostretch_id = 0
+         END
 
          18:BEGIN ;; user-defined
             ;; minimize Tlb and switch off interfering motion events
@@ -2139,9 +2172,9 @@ CASE strlowCase(eventValue) OF
               ENDIF ELSE IF info.my_os EQ 'darwin' THEN BEGIN
                 ggeo='../spatcon/ggeo_mac'
                 file_copy, ggeo, info.dir_tmp + 'ggeo', /overwrite
-              ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
-                ggeo='../spatcon/ggeoARM_mac'
-                file_copy, ggeo, info.dir_tmp + 'ggeo', /overwrite
+              ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
+                ggeo='../spatcon/ggeoARM_mac'
+                file_copy, ggeo, info.dir_tmp + 'ggeo', /overwrite
               ENDIF ELSE BEGIN
                 ggeo='../spatcon/ggeo_lin64'
                 file_copy, ggeo, info.dir_tmp + 'ggeo', /overwrite
@@ -2603,22 +2636,22 @@ CASE strlowCase(eventValue) OF
             restore, testfile
             IF info.is_influ GT 0 THEN BEGIN
               ;; maximum proximity range to show is either xmax or the selected max range (yellow) 
-              if proxmax eq 0 then dmax = xmax*1.1 else dmax = proxmax+2
-
-              a = barplot(duniq,yarr1,bottom_values=yarr0, fill_color='green', ytitle='CAG (min/max)', /buffer, $
-                xtitle='connector length [pixels]',window_title='Proximity: CAG range/distance',$
-                yrange=[ymin,ymax*1.1], xrange=[0, dmax], title=tit,histogram=0,width=0.5)
-
-              ;; overplot the median in yellow
-              a = plot(duniq[1:*],yarr2[1:*],symbol='*',color='Yellow', linestyle='none',/overplot)
-
-              ;; overplot the maximum with a red star symbol so we can see also the distance values
-              ;; which are encountered only once along the watershed (if they are encountered only
-              ;; once then the barplot is not visible at this location because max and min are the same
-              a = plot(duniq[1:*],yarr1[1:*],symbol='+',color='Red', linestyle='none',/overplot)
-              ;a = text(xmax*0.7,ymax*0.9,'*: Median',/data,/current,color='gold')
-              a = text(1,ymax*0.85,'*: Median',/data,/current,color='gold')
-              a = text(1,ymax*0.95,maxstr,/data,/current,color='red')
+              if proxmax eq 0 then dmax = xmax*1.1 else dmax = proxmax+2
+
+              a = barplot(duniq,yarr1,bottom_values=yarr0, fill_color='green', ytitle='CAG (min/max)', /buffer, $
+                xtitle='connector length [pixels]',window_title='Proximity: CAG range/distance',$
+                yrange=[ymin,ymax*1.1], xrange=[0, dmax], title=tit,histogram=0,width=0.5)
+
+              ;; overplot the median in yellow
+              a = plot(duniq[1:*],yarr2[1:*],symbol='*',color='Yellow', linestyle='none',/overplot)
+
+              ;; overplot the maximum with a red star symbol so we can see also the distance values
+              ;; which are encountered only once along the watershed (if they are encountered only
+              ;; once then the barplot is not visible at this location because max and min are the same
+              a = plot(duniq[1:*],yarr1[1:*],symbol='+',color='Red', linestyle='none',/overplot)
+              ;a = text(xmax*0.7,ymax*0.9,'*: Median',/data,/current,color='gold')
+              a = text(1,ymax*0.85,'*: Median',/data,/current,color='gold')
+              a = text(1,ymax*0.95,maxstr,/data,/current,color='red')
              
               ;; show them
               IF info.my_os EQ 'darwin' OR info.my_os EQ 'apple' THEN BEGIN
@@ -3626,8 +3659,8 @@ CASE strlowCase(eventValue) OF
         recode='..\spatcon\recode64.exe' & file_copy, recode, 'recode.exe', /overwrite
       ENDIF ELSE IF info.my_os EQ 'darwin' THEN BEGIN
         recode='../spatcon/recode_mac' & file_copy, recode, 'recode', /overwrite
-      ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
-        recode='../spatcon/recodeARM_mac' & file_copy, recode, 'recode', /overwrite
+      ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
+        recode='../spatcon/recodeARM_mac' & file_copy, recode, 'recode', /overwrite
       ENDIF ELSE BEGIN
         recode='../spatcon/recode_lin64' & file_copy, recode, 'recode', /overwrite
       ENDELSE
@@ -4476,10 +4509,10 @@ CASE strlowCase(eventValue) OF
             end          
          endcase
       ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN    
-      ;;===================================================
-        pushd, info.dir_data
-        spawn, info.dir_guidossub + 'startGTBterminal_macARM.sh &'
-        popd
+      ;;===================================================
+        pushd, info.dir_data
+        spawn, info.dir_guidossub + 'startGTBterminal_macARM.sh &'
+        popd
 
       ENDIF ELSE BEGIN ;; darwin
       ;;===================================================
@@ -4551,8 +4584,8 @@ CASE strlowCase(eventValue) OF
    'original image':  BEGIN  ;; xxxx
       set2original:
       ;; when FOSchange reset to original startup
-      condition = (info.title EQ 'FOSchange') OR (info.title EQ 'Simple change (A->B)') OR $
-        (strmid(info.title,0,13) eq 'MCD (A->B) FG') OR (strmid(info.title,0,38) EQ info.start_title)
+      condition = (info.title EQ 'FOSchange') OR (info.title EQ 'Simple change (A->B)') OR $
+        (strmid(info.title,0,13) eq 'MCD (A->B) FG') OR (strmid(info.title,0,38) EQ info.start_title)
       IF condition THEN goto, resetfront
         
       ;; reset the image and the title
@@ -4816,7 +4849,7 @@ CASE strlowCase(eventValue) OF
       
       widget_control, / hourglass
       ;; image properties
-      qmiss = where(image0 eq 0b, ctmiss, /l64, complement=ruarea) & n_ruarea = n_elements(ruarea)
+      qmiss = where(image0 eq 0b, ctmiss, /l64, complement=ruarea) & n_ruarea = n_elements(ruarea)
       q3b = where(image0 eq 3b, ct3b, /l64) & q4b = where(image0 eq 4b, ct4b, /l64) 
       BGmask = where(image0 EQ 1b, /l64) & FGmask = where(image0 eq 2b, /l64, fgarea)
       
@@ -4889,55 +4922,55 @@ CASE strlowCase(eventValue) OF
       fadru_av[5] = fad_av[5]*fgarea/n_ruarea      
       zz = (im EQ 100b) & intact(5) = total(zz)/fgarea*100.0
       zz = (im GE 90b) AND (im LT 100b) & interior(5) = total(zz)/fgarea*100.0
-      zz = (im GE 60b) AND (im LT 90b) & dominant(5) = total(zz)/fgarea*100.0
-      zz = (im GE 40b) AND (im LT 60b) & transitional(5) = total(zz)/fgarea*100.0
-      zz = (im GE 10b) AND (im LT 40b) & patchy(5) = total(zz)/fgarea*100.0
-      zz = (im LT 10b) & rare(5) = total(zz)/fgarea*100.0 & zz = 0
-
-      ;; the barplot popup window
-      scales = indgen(6)+1
-
-
-      ;; normal barplot
-      ;;==============================================================
-      b1 = BARPLOT(scales, intact, Fill_Color=[0,120,0], yrange=[-4,104], xrange=[0.2, 9.5], /buffer, $
-        ytitle='Foreground proportion [%]', xtitle='         Observation scale | MultiScale | Legend', $
-        xticklen=0.02,yticklen=0.02,xminor=1, xtickv=[1,2,3,4,5])
-      y2 = interior+intact & y1 = intact
-      b2 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[0,175,0],/overplot) & y1=y2 & y2 = dominant+y2
-      b3 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[140,200,100],/overplot) & y1=y2 & y2 = transitional+y2
-      b4 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[255,200,0],/overplot) & y1=y2 & y2 = patchy+y2
-      b5 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[250,140,90],/overplot) & y1=y2 & y2 = rare+y2
-      b6 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[215,50,40],/overplot)
-
-      ;; separator lines
-      a = plot([5.5, 5.5],[-4, 104], /data, color='Black',/overplot, thick=3)
-      a = plot([6.5, 6.5],[-4, 104], /data, color='Black',/overplot, thick=3)
-      a = text(6.7,95, fadtype, /data,/current)
-      a = text(6.7,90,'Fragmentation class: ',/data,/current)
-
-      ;; legend
-      c = symbol(6.9,85,'square',/data, /sym_filled, sym_color=[215,50,40],sym_size=2,LABEL_STRING='Rare')
-      c = symbol(6.9,78,'square',/data, /sym_filled, sym_color=[250,140,90],sym_size=2,LABEL_STRING='Patchy')
-      c = symbol(6.9,71,'square',/data, /sym_filled, sym_color=[255,200,0],sym_size=2,LABEL_STRING='Transitional')
-      c = symbol(6.9,64,'square',/data, /sym_filled, sym_color=[140,200,100],sym_size=2,LABEL_STRING='Dominant')
-      c = symbol(6.9,57,'square',/data, /sym_filled, sym_color=[0,175,0],sym_size=2,LABEL_STRING='Interior')
-      c = symbol(6.9,50,'square',/data, /sym_filled, sym_color=[0,120,0],sym_size=2,LABEL_STRING='Intact')
-
-      ;; info on special pixels
-      IF (ct4b GT 0) THEN BEGIN
-        a = text(6.7,40, 'Non-fragmenting',/data,/current)
-        a = text(6.7,35, 'BG pixels present',/data,/current)
-      ENDIF
-      str = '8-conn FG [pixels]:'
-      a = text(6.7,20,str,/data,/current)
-      z = strtrim(fgarea,2) & q = strmid(z,0,1,/reverse)
-      ;; remove the dot at the end if it exists
-      if q eq '.' then z = strmid(z,0,strlen(z)-1)
-      a = text(6.7,15,'Area: '+z,/data,/current)
-      a = text(6.7,10,z20,/data,/current)
-      a = text(6.7,5,z22,/data,/current)
-      b1.save,info.dir_tmp + 'barplot.png', resolution=300
+      zz = (im GE 60b) AND (im LT 90b) & dominant(5) = total(zz)/fgarea*100.0
+      zz = (im GE 40b) AND (im LT 60b) & transitional(5) = total(zz)/fgarea*100.0
+      zz = (im GE 10b) AND (im LT 40b) & patchy(5) = total(zz)/fgarea*100.0
+      zz = (im LT 10b) & rare(5) = total(zz)/fgarea*100.0 & zz = 0
+
+      ;; the barplot popup window
+      scales = indgen(6)+1
+
+
+      ;; normal barplot
+      ;;==============================================================
+      b1 = BARPLOT(scales, intact, Fill_Color=[0,120,0], yrange=[-4,104], xrange=[0.2, 9.5], /buffer, $
+        ytitle='Foreground proportion [%]', xtitle='         Observation scale | MultiScale | Legend', $
+        xticklen=0.02,yticklen=0.02,xminor=1, xtickv=[1,2,3,4,5])
+      y2 = interior+intact & y1 = intact
+      b2 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[0,175,0],/overplot) & y1=y2 & y2 = dominant+y2
+      b3 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[140,200,100],/overplot) & y1=y2 & y2 = transitional+y2
+      b4 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[255,200,0],/overplot) & y1=y2 & y2 = patchy+y2
+      b5 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[250,140,90],/overplot) & y1=y2 & y2 = rare+y2
+      b6 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[215,50,40],/overplot)
+
+      ;; separator lines
+      a = plot([5.5, 5.5],[-4, 104], /data, color='Black',/overplot, thick=3)
+      a = plot([6.5, 6.5],[-4, 104], /data, color='Black',/overplot, thick=3)
+      a = text(6.7,95, fadtype, /data,/current)
+      a = text(6.7,90,'Fragmentation class: ',/data,/current)
+
+      ;; legend
+      c = symbol(6.9,85,'square',/data, /sym_filled, sym_color=[215,50,40],sym_size=2,LABEL_STRING='Rare')
+      c = symbol(6.9,78,'square',/data, /sym_filled, sym_color=[250,140,90],sym_size=2,LABEL_STRING='Patchy')
+      c = symbol(6.9,71,'square',/data, /sym_filled, sym_color=[255,200,0],sym_size=2,LABEL_STRING='Transitional')
+      c = symbol(6.9,64,'square',/data, /sym_filled, sym_color=[140,200,100],sym_size=2,LABEL_STRING='Dominant')
+      c = symbol(6.9,57,'square',/data, /sym_filled, sym_color=[0,175,0],sym_size=2,LABEL_STRING='Interior')
+      c = symbol(6.9,50,'square',/data, /sym_filled, sym_color=[0,120,0],sym_size=2,LABEL_STRING='Intact')
+
+      ;; info on special pixels
+      IF (ct4b GT 0) THEN BEGIN
+        a = text(6.7,40, 'Non-fragmenting',/data,/current)
+        a = text(6.7,35, 'BG pixels present',/data,/current)
+      ENDIF
+      str = '8-conn FG [pixels]:'
+      a = text(6.7,20,str,/data,/current)
+      z = strtrim(fgarea,2) & q = strmid(z,0,1,/reverse)
+      ;; remove the dot at the end if it exists
+      if q eq '.' then z = strmid(z,0,strlen(z)-1)
+      a = text(6.7,15,'Area: '+z,/data,/current)
+      a = text(6.7,10,z20,/data,/current)
+      a = text(6.7,5,z22,/data,/current)
+      b1.save,info.dir_tmp + 'barplot.png', resolution=300
 
       ;; open barplot image
       IF info.my_os EQ 'darwin' OR info.my_os EQ 'apple' THEN BEGIN
@@ -4977,7 +5010,7 @@ CASE strlowCase(eventValue) OF
       printf, 12, format='(a14,6(f11.4))', 'Intact: ', intact       
       printf, 12, '================================================================================'
       printf, 12, format='(a14,6(f11.4))', 'FAD_av: ', fad_av
-      printf, 12, format='(a14,6(f11.4))', 'AVCON: ', fadru_av
+      printf, 12, format='(a14,6(f11.4))', 'AVCON: ', fadru_av
       close, 12
       
       ;; write csv output
@@ -5316,52 +5349,52 @@ CASE strlowCase(eventValue) OF
 
        ;; the barplot popup window
        ;; here in batch mode add the buffer keyword to not open a graphic window on the screen
-       ;; this is important because if the screensave kicks in then the graphic content can no lonnger be saved to a file
-       scales = indgen(6)+1
-
-
-       ;;==============================================================
-       b1 = BARPLOT(scales, intact, Fill_Color=[0,120,0], yrange=[-4,104], xrange=[0.2, 9.5], /buffer, $
-         ytitle='Foreground proportion [%]', xtitle='         Observation scale | MultiScale | Legend', $
-         xticklen=0.02,yticklen=0.02,xminor=1, xtickv=[1,2,3,4,5])
-       y2 = interior+intact & y1 = intact
-       b2 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[0,175,0],/overplot) & y1=y2 & y2 = dominant+y2
-       b3 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[140,200,100],/overplot) & y1=y2 & y2 = transitional+y2
-       b4 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[255,200,0],/overplot) & y1=y2 & y2 = patchy+y2
-       b5 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[250,140,90],/overplot) & y1=y2 & y2 = rare+y2
-       b6 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[215,50,40],/overplot)
-
-
-       ;; separator lines
-       a = plot([5.5, 5.5],[-4, 104], /data, color='Black',/overplot, thick=3)
-       a = plot([6.5, 6.5],[-4, 104], /data, color='Black',/overplot, thick=3)
-       a = text(6.7,95, fadtype, /data,/current)
-       a = text(6.7,90,'Fragmentation class: ',/data,/current)
-
-       ;; legend
-       c = symbol(6.9,85,'square',/data, /sym_filled, sym_color=[215,50,40],sym_size=2,LABEL_STRING='Rare')
-       c = symbol(6.9,78,'square',/data, /sym_filled, sym_color=[250,140,90],sym_size=2,LABEL_STRING='Patchy')
-       c = symbol(6.9,71,'square',/data, /sym_filled, sym_color=[255,200,0],sym_size=2,LABEL_STRING='Transitional')
-       c = symbol(6.9,64,'square',/data, /sym_filled, sym_color=[140,200,100],sym_size=2,LABEL_STRING='Dominant')
-       c = symbol(6.9,57,'square',/data, /sym_filled, sym_color=[0,175,0],sym_size=2,LABEL_STRING='Interior')
-       c = symbol(6.9,50,'square',/data, /sym_filled, sym_color=[0,120,0],sym_size=2,LABEL_STRING='Intact')
-
-
-       ;; info on special pixels
-       IF (ct4b GT 0) THEN BEGIN
-         a = text(6.7,40, 'Non-fragmenting',/data,/current)
-         a = text(6.7,35, 'BG pixels present',/data,/current)
-       ENDIF
-       str = conn_str + ' [pixels]:'
-       a = text(6.7,20,str,/data,/current)
-       z = strtrim(fgarea,2) & q = strmid(z,0,1,/reverse)
-       ;; remove the dot at the end if it exists
-       if q eq '.' then z = strmid(z,0,strlen(z)-1)
-       a = text(6.7,15,'Area: '+z,/data,/current)
-       a = text(6.7,10,z20,/data,/current)
-       a = text(6.7,5,z22,/data,/current)
-       fn_out = outdir + '/' + fbn + '_' + strlowcase(fadtype) + '_barplot.png'
-       b1.save,fn_out, resolution=300
+       ;; this is important because if the screensave kicks in then the graphic content can no lonnger be saved to a file
+       scales = indgen(6)+1
+
+
+       ;;==============================================================
+       b1 = BARPLOT(scales, intact, Fill_Color=[0,120,0], yrange=[-4,104], xrange=[0.2, 9.5], /buffer, $
+         ytitle='Foreground proportion [%]', xtitle='         Observation scale | MultiScale | Legend', $
+         xticklen=0.02,yticklen=0.02,xminor=1, xtickv=[1,2,3,4,5])
+       y2 = interior+intact & y1 = intact
+       b2 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[0,175,0],/overplot) & y1=y2 & y2 = dominant+y2
+       b3 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[140,200,100],/overplot) & y1=y2 & y2 = transitional+y2
+       b4 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[255,200,0],/overplot) & y1=y2 & y2 = patchy+y2
+       b5 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[250,140,90],/overplot) & y1=y2 & y2 = rare+y2
+       b6 = BARPLOT(scales,y2, BOTTOM_values=y1, Fill_Color=[215,50,40],/overplot)
+
+
+       ;; separator lines
+       a = plot([5.5, 5.5],[-4, 104], /data, color='Black',/overplot, thick=3)
+       a = plot([6.5, 6.5],[-4, 104], /data, color='Black',/overplot, thick=3)
+       a = text(6.7,95, fadtype, /data,/current)
+       a = text(6.7,90,'Fragmentation class: ',/data,/current)
+
+       ;; legend
+       c = symbol(6.9,85,'square',/data, /sym_filled, sym_color=[215,50,40],sym_size=2,LABEL_STRING='Rare')
+       c = symbol(6.9,78,'square',/data, /sym_filled, sym_color=[250,140,90],sym_size=2,LABEL_STRING='Patchy')
+       c = symbol(6.9,71,'square',/data, /sym_filled, sym_color=[255,200,0],sym_size=2,LABEL_STRING='Transitional')
+       c = symbol(6.9,64,'square',/data, /sym_filled, sym_color=[140,200,100],sym_size=2,LABEL_STRING='Dominant')
+       c = symbol(6.9,57,'square',/data, /sym_filled, sym_color=[0,175,0],sym_size=2,LABEL_STRING='Interior')
+       c = symbol(6.9,50,'square',/data, /sym_filled, sym_color=[0,120,0],sym_size=2,LABEL_STRING='Intact')
+
+
+       ;; info on special pixels
+       IF (ct4b GT 0) THEN BEGIN
+         a = text(6.7,40, 'Non-fragmenting',/data,/current)
+         a = text(6.7,35, 'BG pixels present',/data,/current)
+       ENDIF
+       str = conn_str + ' [pixels]:'
+       a = text(6.7,20,str,/data,/current)
+       z = strtrim(fgarea,2) & q = strmid(z,0,1,/reverse)
+       ;; remove the dot at the end if it exists
+       if q eq '.' then z = strmid(z,0,strlen(z)-1)
+       a = text(6.7,15,'Area: '+z,/data,/current)
+       a = text(6.7,10,z20,/data,/current)
+       a = text(6.7,5,z22,/data,/current)
+       fn_out = outdir + '/' + fbn + '_' + strlowcase(fadtype) + '_barplot.png'
+       b1.save,fn_out, resolution=300
        b1.close        
        
        ;; write out the statistics table
@@ -5385,7 +5418,7 @@ CASE strlowCase(eventValue) OF
        printf, 12, format='(a14,6(f11.4))', 'Intact: ', intact
        printf, 12, '================================================================================'
        printf, 12, format='(a14,6(f11.4))', 'FAD_av: ', fad_av
-       printf, 12, format='(a14,6(f11.4))', 'AVCON: ', fadru_av
+       printf, 12, format='(a14,6(f11.4))', 'AVCON: ', fadru_av
        close, 12
            
        ;; save stats summary in idl format for potential change analysis at some later point
@@ -5461,11 +5494,11 @@ CASE strlowCase(eventValue) OF
      res = dialog_message(msg, / information)
      ;; reset the colortable to the settings before the batch processing
      tvlct, rini, gini, bini
-     ;; clean up tmp
-     pushd, info.dir_tmp
-     list = file_search() & nl = n_elements(list)
-     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-     popd
+     ;; clean up tmp
+     pushd, info.dir_tmp
+     list = file_search() & nl = n_elements(list)
+     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+     popd
 
      GOTO, fin
    END
@@ -5563,7 +5596,7 @@ CASE strlowCase(eventValue) OF
      kdim = fix(* wdim) & kdim_str = * wdim
      fgconn_str = * conn
      tt1 = * fmethod & tt2 = * frep
-     fosclass = tt1 + '_' + tt2
+     fosclass = tt1 + '_' + tt2
      TT = ['Binary', 'Grayscale'] & fosinp = TT[* inpgray]
      grayt = byte(fix(*graythresh)) & grayt_str = *graythresh
           
@@ -5610,16 +5643,16 @@ CASE strlowCase(eventValue) OF
        IF info.mspa_param1_id EQ 1b THEN conn8 = 1 ELSE conn8 = 0
        ;; label FG only
        ext1 = label_region(temporary(ext1), all_neighbors=conn8, / ulong)
-       obj_area = histogram(ext1, /l64)
+       obj_area = histogram(ext1, /l64)
        obj_last=max(ext1) & z80 = strtrim(obj_last,2)
-       farea = total(obj_area[1:*]) & fareaperc=100.0/n_ruarea*farea
+       farea = total(obj_area[1:*]) & fareaperc=100.0/n_ruarea*farea
        aps = farea / obj_last & z81 = strtrim(aps,2) & obj_area = 0
        z20 = '# Patches: ' + z80 & z22 = 'APS: ' + z81
-       ;; get pixel indices by patch
-       ext1 = histogram(temporary(ext1), /l64)
-       ;; PCnum:= overall connectivity. Sum of [ (areas per component)^2 ]
-       pcnum = total(ext1(1: * )^2, / double) & ECA = sqrt(pcnum)
-       ECA_max = total(ext1(1: * ), / double) & COH = ECA/ECA_max*100.0
+       ;; get pixel indices by patch
+       ext1 = histogram(temporary(ext1), /l64)
+       ;; PCnum:= overall connectivity. Sum of [ (areas per component)^2 ]
+       pcnum = total(ext1(1: * )^2, / double) & ECA = sqrt(pcnum)
+       ECA_max = total(ext1(1: * ), / double) & COH = ECA/ECA_max*100.0
        COH_ru = ECA/n_ruarea*100.0 & ext1=0        
        ;; calculate FAD/FAC for the fixed observation scale
        IF ct4b GT 0 THEN image0[q4b] = 0b ;; specialBG - assign to missing
@@ -5647,16 +5680,16 @@ CASE strlowCase(eventValue) OF
        ;; label FG only
        ext1 = label_region(temporary(ext1), all_neighbors=conn8, / ulong)
        obj_area = histogram(ext1, /l64)
-       obj_area = histogram(ext1, /l64)
+       obj_area = histogram(ext1, /l64)
        obj_last=max(ext1) 
        farea = total(obj_area[1:*]) & fareaperc=100.0/n_ruarea*farea
        aps = farea / obj_last & z81 = strtrim(aps,2) & obj_area = 0 & z80 = strtrim(obj_last,2)
        z20 = '# Patches: ' + z80 & z22 = 'APS: ' + z81
-       ;; get pixel indices by patch
-       ext1 = histogram(temporary(ext1), /l64)
-       ;; PCnum:= overall connectivity. Sum of [ (areas per component)^2 ]
-       pcnum = total(ext1(1: * )^2, / double) & ECA = sqrt(pcnum)
-       ECA_max = total(ext1(1: * ), / double) & COH = ECA/ECA_max*100.0
+       ;; get pixel indices by patch
+       ext1 = histogram(temporary(ext1), /l64)
+       ;; PCnum:= overall connectivity. Sum of [ (areas per component)^2 ]
+       pcnum = total(ext1(1: * )^2, / double) & ECA = sqrt(pcnum)
+       ECA_max = total(ext1(1: * ), / double) & COH = ECA/ECA_max*100.0
        COH_ru = ECA/n_ruarea*100.0 & ext1=0      
        ;; calculate FAD/FED/FAC for the fixed observation scale
        IF ct3b GT 0 THEN image0[q3b] = 0b ;; set special BG to zero
@@ -5733,8 +5766,8 @@ CASE strlowCase(eventValue) OF
          spatcon=info.dir_guidossub +'spatcon\grayspatcon64.exe' & file_copy, spatcon, 'grayspatcon.exe', /overwrite
        ENDIF ELSE IF info.my_os EQ 'darwin' THEN BEGIN
          spatcon=info.dir_guidossub +'spatcon/grayspatcon_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
-       ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
-         spatcon=info.dir_guidossub +'spatcon/grayspatconARM_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
+       ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
+         spatcon=info.dir_guidossub +'spatcon/grayspatconARM_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
        ENDIF ELSE BEGIN
          spatcon=info.dir_guidossub +'spatcon/grayspatcon_lin64' & file_copy, spatcon, 'grayspatcon', /overwrite
        ENDELSE
@@ -5760,7 +5793,7 @@ CASE strlowCase(eventValue) OF
        popd
      ENDELSE
      
-     ;; calculate pixel-based fad_av BEFORE doing APP so they are consistent with non-APP
+     ;; calculate pixel-based fad_av BEFORE doing APP so they are consistent with non-APP
      fad_av = mean(im[qFG]) & fadru_av = fad_av * fgarea / n_ruarea
                         
      ;; add specialBG (105b), specialBG-Nf (106b), Missing (102b), background (101b)
@@ -5768,7 +5801,7 @@ CASE strlowCase(eventValue) OF
      if ct4b gt 0 then im[q4b] = 106b & q4b = 0
      if ctmiss gt 0 then im[qmiss] = 102b
      qmiss = 0
-     im[BGmask] = 101b & BGmask = 0
+     im[BGmask] = 101b & BGmask = 0
      
      ;; build histogram
      hist = histogram(im[qFG],/l64) & hist = hist[0:100] 
@@ -5784,11 +5817,11 @@ CASE strlowCase(eventValue) OF
      hist2 = float(hist)/n_elements(qfg)*100.0 & bmax = max(hist2) * 1.05       
      
      IF rep EQ '5class' THEN BEGIN       
-       bp = barplot(bins[0:9], hist2[0:9], fill_color=[215,50,40], xtitle=xtit, /buffer, thick=0, $
-         ytitle = 'Frequency [%]', title = tit, xrange = [0,105], yrange = [0, bmax],histogram=1, font_size=12) ;; very low
-       bp = barplot(bins[10:39], hist2[10:39], fill_color = [250,140,90],thick=0,histogram=1, /overplot) ;; low
-       bp = barplot(bins[40:59], hist2[40:59], fill_color = [255,200,0],thick=0,histogram=1, /overplot) ;; intermediate
-       bp = barplot(bins[60:89], hist2[60:89], fill_color = [140,200,100],thick=0,histogram=1, /overplot) ;; high
+       bp = barplot(bins[0:9], hist2[0:9], fill_color=[215,50,40], xtitle=xtit, /buffer, thick=0, $
+         ytitle = 'Frequency [%]', title = tit, xrange = [0,105], yrange = [0, bmax],histogram=1, font_size=12) ;; very low
+       bp = barplot(bins[10:39], hist2[10:39], fill_color = [250,140,90],thick=0,histogram=1, /overplot) ;; low
+       bp = barplot(bins[40:59], hist2[40:59], fill_color = [255,200,0],thick=0,histogram=1, /overplot) ;; intermediate
+       bp = barplot(bins[60:89], hist2[60:89], fill_color = [140,200,100],thick=0,histogram=1, /overplot) ;; high
        bp = barplot(bins[90:100], hist2[90:100], fill_color = [0,175,0],thick=0,histogram=1, /overplot) ;; very high        
 
      ENDIF ELSE IF rep EQ '6class' THEN BEGIN       
@@ -5800,7 +5833,7 @@ CASE strlowCase(eventValue) OF
        bp = barplot(bins[90:99], hist2[90:99], fill_color = [0,175,0],thick=0,histogram=1, /overplot) ;; very high
        bp = barplot(bins[100:100], hist2[100:100], fill_color = [0,120,0],thick=0,histogram=1, /overplot) ;; intact 
      ENDIF
-     
+     
      qFG = 0 & fx = info.dir_tmp + 'fos.png' & file_delete,fx,/allow_nonexistent,/quiet
      bp.save, fx, resolution=300 
      bp.close      
@@ -5855,8 +5888,8 @@ CASE strlowCase(eventValue) OF
      printf, 12, 'Summary analysis for image: '     
      printf, 12, fname
      printf, 12, '================================================================================'
-     IF fosinp EQ 'Binary' THEN tt = '[4b]' ELSE tt = '[104b]'
-     IF ct4b GT 0 THEN printf, 12, 'Non-fragmenting background pixels ' + tt + ' in input image'
+     IF fosinp EQ 'Binary' THEN tt = '[4b]' ELSE tt = '[104b]'
+     IF ct4b GT 0 THEN printf, 12, 'Non-fragmenting background pixels ' + tt + ' in input image'
      printf, 12, 'FOS parameter settings:'
      IF fosinp EQ 'Grayscale' THEN tt = 'Grayscale (FG threshold: ' + grayt_str + ')' ELSE tt = fosinp
      printf, 12, tt
@@ -5881,18 +5914,18 @@ CASE strlowCase(eventValue) OF
          printf, 12, format='(a55,f11.4)', 'Intact (' + method + '-pixel value: 100): ', intact    
        endif 
      endif
-     printf, 12, '================================================================================'
-     printf, 12, '================================================================================'
+     printf, 12, '================================================================================'
+     printf, 12, '================================================================================'
      printf, 12, 'A) Image summary:'
-     printf, 12, '================================================================================'
-     printf, 12, 'Reporting unit area [pixels]: ', strtrim(n_ruarea,2)
+     printf, 12, '================================================================================'
+     printf, 12, 'Reporting unit area [pixels]: ', strtrim(n_ruarea,2)
      printf, 12, 'Foreground area [pixels]: ', z
-     printf, 12, 'Foreground area [%]: ', strtrim(fareaperc,2)
-     printf, 12, 'Number of foreground patches: ',  z80
-     printf, 12, 'Average foreground patch size [pixels]: ', z81
-     printf, 12, '================================================================================'
-     printf, 12, 'B) Reporting levels'
-     printf, 12, '================================================================================'
+     printf, 12, 'Foreground area [%]: ', strtrim(fareaperc,2)
+     printf, 12, 'Number of foreground patches: ',  z80
+     printf, 12, 'Average foreground patch size [pixels]: ', z81
+     printf, 12, '================================================================================'
+     printf, 12, 'B) Reporting levels'
+     printf, 12, '================================================================================'
      printf, 12, 'Foreground (FG) connectivity is available at 3 reporting levels, B1 - B3:'
      printf, 12, 'B1) Pixel-level: method FAD/FED/FAC: check the FG pixel value on the map, or aggregated at'
      printf, 12, 'B2) Foreground-level: reference area = all foreground pixels'
@@ -5900,11 +5933,11 @@ CASE strlowCase(eventValue) OF
      sstr = '- Average ' + sss + ' at WS'+ kdim_str + ' [%]: ' 
      printf, 12, sstr + strtrim(fad_av,2)
      printf, 12, '- ECA (Equivalent Connected Area) [pixels]: ', strtrim(ECA,2)  
-     printf, 12, '- COH (Coherence = ECA/ECA_max*100) [%]: ', strtrim(COH,2)
-     printf, 12, 'B3) Reporting unit-level: reference area = entire reporting unit'
-     printf, 12, '- AVCON (average connectivity) at WS'+ kdim_str + ' [%]: ', strtrim(fadru_av,2)
-     printf, 12, '- COH_ru (ECA/Reporting unit area*100) [%]: ', strtrim(COH_ru,2)
-     printf, 12, '================================================================================'
+     printf, 12, '- COH (Coherence = ECA/ECA_max*100) [%]: ', strtrim(COH,2)
+     printf, 12, 'B3) Reporting unit-level: reference area = entire reporting unit'
+     printf, 12, '- AVCON (average connectivity) at WS'+ kdim_str + ' [%]: ', strtrim(fadru_av,2)
+     printf, 12, '- COH_ru (ECA/Reporting unit area*100) [%]: ', strtrim(COH_ru,2)
+     printf, 12, '================================================================================'
      printf, 12, '================================================================================'
      printf, 12, 'Histogram of FG-pixel values rounded to the nearest integer, FGcover[%] at window size:'
      printf, 12, 'Value   WS' + kdim_str 
@@ -5930,23 +5963,23 @@ CASE strlowCase(eventValue) OF
      endif 
      printf, 12, ''
      printf, 12, 'A) Image summary:'     
-     printf, 12, 'Reporting unit area [pixels]:, ' + strtrim(n_ruarea,2)
+     printf, 12, 'Reporting unit area [pixels]:, ' + strtrim(n_ruarea,2)
      printf, 12, 'Foreground area [pixels]:, ' + z
      printf, 12, 'Foreground area [%]:, ' + strtrim(fareaperc,2)
-     printf, 12, 'Number of foreground patches:, ' +  z80
+     printf, 12, 'Number of foreground patches:, ' +  z80
      printf, 12, 'Average foreground patch size [pixels]:, ' + z81
-     printf, 12, ' '
-     printf, 12, 'B) Reporting levels'
+     printf, 12, ' '
+     printf, 12, 'B) Reporting levels'
      printf, 12, 'B1) Pixel-level: method FAD/FED/FAC: check the FG pixel value on the map'  
      printf, 12, 'B2) Foreground-level:'
-     sss = strmid(method,0,3)
-     sstr = '- Average ' + sss + ' at WS'+ kdim_str + ' [%]:, '
+     sss = strmid(method,0,3)
+     sstr = '- Average ' + sss + ' at WS'+ kdim_str + ' [%]:, '
      printf, 12, sstr + strtrim(fad_av,2)
-     printf, 12, '- ECA [pixels]: ,' + strtrim(ECA,2)
-     printf, 12, '- COH [%]:, ' + strtrim(COH,2)
-     printf, 12, 'B3) Reporting unit-level: '
-     printf, 12, '- AVCON (average connectivity) at WS'+ kdim_str + ' [%]:, ' + strtrim(fadru_av,2)
-     printf, 12, '- COH_ru [%]: ,' + strtrim(COH_ru,2)
+     printf, 12, '- ECA [pixels]: ,' + strtrim(ECA,2)
+     printf, 12, '- COH [%]:, ' + strtrim(COH,2)
+     printf, 12, 'B3) Reporting unit-level: '
+     printf, 12, '- AVCON (average connectivity) at WS'+ kdim_str + ' [%]:, ' + strtrim(fadru_av,2)
+     printf, 12, '- COH_ru [%]: ,' + strtrim(COH_ru,2)
      printf, 12, ' '
      printf, 12, 'Histogram at window size: '+ kdim_str
      printf, 12, 'Pixel Value, FGcover[%]'
@@ -5966,7 +5999,7 @@ CASE strlowCase(eventValue) OF
      * info.fr_image = * info.process
      
      ;; get the appropriate colortable
-     if fostype eq 'FOS6' then begin
+     if fostype eq 'FOS6' then begin
        restore, info.dir_guidossub + 'fadcolors.sav' & info.disp_colors_id = 8 ;; FAD colors
      endif else if fostype eq 'FOS5' then begin
        restore, info.dir_guidossub + 'fadcolors5.sav' & info.disp_colors_id = 9 ;; FAD colors
@@ -5979,7 +6012,7 @@ CASE strlowCase(eventValue) OF
      info.is_mspa = 0 & info.mspa_stats_show = 0b & info.is_fragm = 3 & info.is_contort = 0
      info.do_mspa_stats_id = 0 & info.is_cs22 = 0 & info.is_nw = 0 & info.is_cost = 0
      info.do_label_groups_id = 0
-     skip_gsc00:
+     skip_gsc00:
 
 
    END
@@ -6060,7 +6093,7 @@ CASE strlowCase(eventValue) OF
      kdim = fix(* wdim) & kdim_str = * wdim
      fgconn_str = * conn
      tt1 = * fmethod & tt2 = * frep
-     fosclass = tt1 + '_' + tt2
+     fosclass = tt1 + '_' + tt2
      TT = ['Binary', 'Grayscale'] & fosinp = TT[* inpgray]
      grayt = byte(fix(*graythresh)) & grayt_str = *graythresh
 
@@ -6239,16 +6272,16 @@ CASE strlowCase(eventValue) OF
          ;; label FG only
          ext1 = label_region(temporary(ext1), all_neighbors=conn8, / ulong)
 ;         if strmid(fostype,0,7) eq 'FOS-APP' then obj_area = histogram(ext1, reverse_indices = rev, /l64) else obj_area = histogram(ext1, / l64)
-         obj_area = histogram(ext1, / l64)
+         obj_area = histogram(ext1, / l64)
          obj_last=max(ext1) & z80 = strtrim(obj_last,2) 
          farea = total(obj_area[1:*],/double) & fareaperc=100.0/n_ruarea*farea
          aps = farea / obj_last & z81 = strtrim(aps,2) & obj_area = 0 
          z20 = '# Patches: ' + z80 & z22 = 'APS: ' + z81
-         ;; get pixel indices by patch
-         ext1 = histogram(temporary(ext1), /l64)
-         ;; PCnum:= overall connectivity. Sum of [ (areas per component)^2 ]
-         pcnum = total(ext1(1: * )^2, / double) & ECA = sqrt(pcnum)
-         ECA_max = total(ext1(1: * ), / double) & COH = ECA/ECA_max*100.0
+         ;; get pixel indices by patch
+         ext1 = histogram(temporary(ext1), /l64)
+         ;; PCnum:= overall connectivity. Sum of [ (areas per component)^2 ]
+         pcnum = total(ext1(1: * )^2, / double) & ECA = sqrt(pcnum)
+         ECA_max = total(ext1(1: * ), / double) & COH = ECA/ECA_max*100.0
          COH_ru = ECA/n_ruarea*100.0 & ext1=0       
          ;; calculate FAD/FAC for the fixed observation scale
          IF ct4b GT 0 THEN image0[q4b] = 0b ;; specialBG - assign to missing        
@@ -6283,16 +6316,16 @@ CASE strlowCase(eventValue) OF
          ;; label FG only
          ext1 = label_region(ext1, all_neighbors=conn8, / ulong)
          obj_area = histogram(ext1, /l64)
-         obj_area = histogram(ext1, /l64)
+         obj_area = histogram(ext1, /l64)
          obj_last=max(ext1) 
          farea = total(obj_area[1:*]) & fareaperc=100.0/n_ruarea*farea
          aps = farea / obj_last & z81 = strtrim(aps,2) & obj_area = 0 & z80 = strtrim(obj_last,2)
          z20 = '# Patches: ' + z80 & z22 = 'APS: ' + z81
-         ;; get pixel indices by patch
-         ext1 = histogram(temporary(ext1), /l64)
-         ;; PCnum:= overall connectivity. Sum of [ (areas per component)^2 ]
-         pcnum = total(ext1(1: * )^2, / double) & ECA = sqrt(pcnum)
-         ECA_max = total(ext1(1: * ), / double) & COH = ECA/ECA_max*100.0
+         ;; get pixel indices by patch
+         ext1 = histogram(temporary(ext1), /l64)
+         ;; PCnum:= overall connectivity. Sum of [ (areas per component)^2 ]
+         pcnum = total(ext1(1: * )^2, / double) & ECA = sqrt(pcnum)
+         ECA_max = total(ext1(1: * ), / double) & COH = ECA/ECA_max*100.0
          COH_ru = ECA/n_ruarea*100.0 & ext1=0         
          ;; calculate FAD/FED/FAC for the fixed observation scale
          IF ct3b GT 0 THEN image0[q3b] = 0b ;; set special BG to zero
@@ -6369,8 +6402,8 @@ CASE strlowCase(eventValue) OF
            spatcon=info.dir_guidossub +'spatcon\grayspatcon64.exe' & file_copy, spatcon, 'grayspatcon.exe', /overwrite
          ENDIF ELSE IF info.my_os EQ 'darwin' THEN BEGIN
            spatcon=info.dir_guidossub +'spatcon/grayspatcon_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
-         ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
-           spatcon=info.dir_guidossub +'spatcon/grayspatconARM_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
+         ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
+           spatcon=info.dir_guidossub +'spatcon/grayspatconARM_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
          ENDIF ELSE BEGIN
            spatcon=info.dir_guidossub +'spatcon/grayspatcon_lin64' & file_copy, spatcon, 'grayspatcon', /overwrite
          ENDELSE
@@ -6394,7 +6427,7 @@ CASE strlowCase(eventValue) OF
          popd
        ENDELSE  
        
-       ;; calculate pixel-based fad_av BEFORE doing APP so they are consistent with non-APP
+       ;; calculate pixel-based fad_av BEFORE doing APP so they are consistent with non-APP
        fad_av = mean(im[qFG]) & fadru_av = fad_av * fgarea / n_ruarea  
        
        ;; add specialBG (105b), specialBG-Nf (106b), Missing (102b), background (101b)
@@ -6432,7 +6465,7 @@ CASE strlowCase(eventValue) OF
          bp = barplot(bins[90:99], hist2[90:99], fill_color = [0,175,0],thick=0,histogram=1, /overplot) ;; very high
          bp = barplot(bins[100:100], hist2[100:100], fill_color = [0,120,0],thick=0,histogram=1, /overplot) ;; intact
        ENDIF
-
+
        qFG = 0 
        fx = info.dir_tmp + 'fos.png' & file_delete,fx,/allow_nonexistent,/quiet
        bp.save, fx, resolution=300
@@ -6464,7 +6497,7 @@ CASE strlowCase(eventValue) OF
        file_mkdir, outdir
        pushd, outdir
        ;;if fostype eq 'FOS6' or fostype eq 'FOS-APP5' then begin
-       if fostype eq 'FOS6' then begin
+       if fostype eq 'FOS6' then begin
          restore, info.dir_guidossub + 'fadcolors.sav' & info.disp_colors_id = 8 ;; FAD colors
        endif else if fostype eq 'FOS5' then begin
          restore, info.dir_guidossub + 'fadcolors5.sav' & info.disp_colors_id = 9 ;; FAD colors
@@ -6494,13 +6527,13 @@ CASE strlowCase(eventValue) OF
 
        openw,12,fn_out
        printf, 12, 'Fragmentation analysis using Fixed Observation Scale (FOS)'
-       printf, 12, '(Fragmentation is complementary to Connectivity: Fragmentation = 100% - Connectivity)'
+       printf, 12, '(Fragmentation is complementary to Connectivity: Fragmentation = 100% - Connectivity)'
        printf, 12, 'Method options: FAD - FG Area Density; FED - FG Edge Density; FAC - FG Area Clustering; '
        printf, 12, 'Summary analysis for image: '
        printf, 12, input
        printf, 12, '================================================================================'
-       IF fosinp EQ 'Binary' THEN tt = '[4b]' ELSE tt = '[104b]'
-       IF ct4b GT 0 THEN printf, 12, 'Non-fragmenting background pixels ' + tt + ' in input image'
+       IF fosinp EQ 'Binary' THEN tt = '[4b]' ELSE tt = '[104b]'
+       IF ct4b GT 0 THEN printf, 12, 'Non-fragmenting background pixels ' + tt + ' in input image'
        printf, 12, 'FOS parameter settings:'
        IF fosinp EQ 'Grayscale' THEN tt = 'Grayscale (FG threshold: ' + grayt_str + ')' ELSE tt = fosinp
        printf, 12, tt       
@@ -6525,32 +6558,32 @@ CASE strlowCase(eventValue) OF
            printf, 12, format='(a55,f11.4)', 'Intact (' + method + '-pixel value: 100): ', intact
          endif
        endif 
-       printf, 12, '================================================================================'
-       printf, 12, '================================================================================'
-       printf, 12, 'A) Image summary:'
-       printf, 12, '================================================================================'
-       printf, 12, 'Reporting unit area [pixels]: ', strtrim(n_ruarea,2)
+       printf, 12, '================================================================================'
+       printf, 12, '================================================================================'
+       printf, 12, 'A) Image summary:'
+       printf, 12, '================================================================================'
+       printf, 12, 'Reporting unit area [pixels]: ', strtrim(n_ruarea,2)
        printf, 12, 'Foreground area [pixels]: ', z
-       printf, 12, 'Foreground area [%]: ', strtrim(fareaperc,2)
-       printf, 12, 'Number of foreground patches: ',  z80
-       printf, 12, 'Average foreground patch size [pixels]: ', z81
-       printf, 12, '================================================================================'
-       printf, 12, 'B) Reporting levels'
-       printf, 12, '================================================================================'
-       printf, 12, 'Foreground (FG) connectivity is available at 3 reporting levels, B1 - B3:'
-       printf, 12, 'B1) Pixel-level: method FAD/FED/FAC: check the FG pixel value on the map, or aggregated at'
+       printf, 12, 'Foreground area [%]: ', strtrim(fareaperc,2)
+       printf, 12, 'Number of foreground patches: ',  z80
+       printf, 12, 'Average foreground patch size [pixels]: ', z81
+       printf, 12, '================================================================================'
+       printf, 12, 'B) Reporting levels'
+       printf, 12, '================================================================================'
+       printf, 12, 'Foreground (FG) connectivity is available at 3 reporting levels, B1 - B3:'
+       printf, 12, 'B1) Pixel-level: method FAD/FED/FAC: check the FG pixel value on the map, or aggregated at'
        printf, 12, 'B2) Foreground-level: reference area = all foreground pixels'      
        sss = strmid(method,0,3) & sstr = '- Average ' + sss + ' at WS'+ kdim_str + ' [%]: ' 
-       printf, 12, sstr + strtrim(fad_av,2)
-       printf, 12, '- ECA (Equivalent Connected Area) [pixels]: ', strtrim(ECA,2)
-       printf, 12, '- COH (Coherence = ECA/ECA_max*100) [%]: ', strtrim(COH,2)
-       printf, 12, 'B3) Reporting unit-level: reference area = entire reporting unit'
-       printf, 12, '- AVCON (average connectivity) at WS'+ kdim_str + ' [%]: ', strtrim(fadru_av,2)
-       printf, 12, '- COH_ru (ECA/Reporting unit area*100) [%]: ', strtrim(COH_ru,2)
+       printf, 12, sstr + strtrim(fad_av,2)
+       printf, 12, '- ECA (Equivalent Connected Area) [pixels]: ', strtrim(ECA,2)
+       printf, 12, '- COH (Coherence = ECA/ECA_max*100) [%]: ', strtrim(COH,2)
+       printf, 12, 'B3) Reporting unit-level: reference area = entire reporting unit'
+       printf, 12, '- AVCON (average connectivity) at WS'+ kdim_str + ' [%]: ', strtrim(fadru_av,2)
+       printf, 12, '- COH_ru (ECA/Reporting unit area*100) [%]: ', strtrim(COH_ru,2)
        printf, 12, '================================================================================'      
        printf, 12, '================================================================================'
        printf, 12, 'Histogram of FG-pixel values rounded to the nearest integer, FGcover[%] at window size:'
-       printf, 12, 'Value   WS' + kdim_str
+       printf, 12, 'Value   WS' + kdim_str
        For id = 0, 100 do printf, 12, format='(a6, f10.4)', strtrim(id,2), hist2[id]
        close, 12
 
@@ -6577,8 +6610,8 @@ CASE strlowCase(eventValue) OF
        openw,12,fn_out
        IF fosinp EQ 'Grayscale' THEN tt = 'Grayscale (FG threshold: ' + grayt_str + ')' ELSE tt = fosinp
        printf,12, tt + ' ' + fosclass + ': FragmClass\ObsScale: '
-       printf, 12, 'Neighborhood area [pixels]:,'+ kdim_str + 'x' + kdim_str
-       printf, 12, 'Neighborhood area [hectares]:,'  + hec
+       printf, 12, 'Neighborhood area [pixels]:,'+ kdim_str + 'x' + kdim_str
+       printf, 12, 'Neighborhood area [hectares]:,'  + hec
        printf, 12, 'Neighborhood area [acres]:,' + acr       
        if strlen(fostype) eq 4 then begin
          if fostype eq 'FOS6' then printf, 12, 'FOS_6class: ' else printf, 12, 'FOS_5class: '
@@ -6588,28 +6621,28 @@ CASE strlowCase(eventValue) OF
          printf,12, 'Dominant:, ' + strtrim(dominant,2)
          printf,12, 'Interior:, ' + strtrim(interior,2)
          if fostype eq 'FOS6' then printf,12, 'Intact:, ' + strtrim(intact,2)
-       endif
-       printf, 12, ''
-       printf, 12, 'A) Image summary:'
-       printf, 12, 'Reporting unit area [pixels]:, ' + strtrim(n_ruarea,2)
-       printf, 12, 'Foreground area [pixels]:, ' + z
-       printf, 12, 'Foreground area [%]:, ' + strtrim(fareaperc,2)
-       printf, 12, 'Number of foreground patches:, ' +  z80
+       endif
+       printf, 12, ''
+       printf, 12, 'A) Image summary:'
+       printf, 12, 'Reporting unit area [pixels]:, ' + strtrim(n_ruarea,2)
+       printf, 12, 'Foreground area [pixels]:, ' + z
+       printf, 12, 'Foreground area [%]:, ' + strtrim(fareaperc,2)
+       printf, 12, 'Number of foreground patches:, ' +  z80
        printf, 12, 'Average foreground patch size [pixels]:, ' + z81
-       printf, 12, ' '
+       printf, 12, ' '
        printf, 12, 'B) Reporting levels'
-       printf, 12, 'B1) Pixel-level: method FAD/FED/FAC: check the FG pixel value on the map'      
+       printf, 12, 'B1) Pixel-level: method FAD/FED/FAC: check the FG pixel value on the map'      
        printf, 12, 'B2) Foreground-level:'
-       sss = strmid(method,0,3) & sstr = '- Average ' + sss + ' at WS'+ kdim_str + ' [%]:, '
-       printf, 12, sstr + strtrim(fad_av,2)
-       printf, 12, '- ECA [pixels]: ,' + strtrim(ECA,2)
-       printf, 12, '- COH [%]:, ' + strtrim(COH,2)
-       printf, 12, 'B3) Reporting unit-level: '
-       printf, 12, '- AVCON (average connectivity) at WS'+ kdim_str + ' [%]:, ' + strtrim(fadru_av,2)
-       printf, 12, '- COH_ru [%]: ,' + strtrim(COH_ru,2)
-       printf, 12, ' '
-       printf, 12, 'Histogram at window size: '+ kdim_str
-       printf, 12, 'Pixel Value, FGcover[%]'
+       sss = strmid(method,0,3) & sstr = '- Average ' + sss + ' at WS'+ kdim_str + ' [%]:, '
+       printf, 12, sstr + strtrim(fad_av,2)
+       printf, 12, '- ECA [pixels]: ,' + strtrim(ECA,2)
+       printf, 12, '- COH [%]:, ' + strtrim(COH,2)
+       printf, 12, 'B3) Reporting unit-level: '
+       printf, 12, '- AVCON (average connectivity) at WS'+ kdim_str + ' [%]:, ' + strtrim(fadru_av,2)
+       printf, 12, '- COH_ru [%]: ,' + strtrim(COH_ru,2)
+       printf, 12, ' '
+       printf, 12, 'Histogram at window size: '+ kdim_str
+       printf, 12, 'Pixel Value, FGcover[%]'
        For id = 0, 100 do printf, 12, strtrim(id,2) + ', ' + strtrim(hist2[id],2)
        close,12
        
@@ -6662,9 +6695,9 @@ CASE strlowCase(eventValue) OF
      ;; reset the colortable to the settings before the batch processing
      tvlct, rini, gini, bini
      ;; clean up tmp
-     pushd, info.dir_tmp
-     list = file_search() & nl = n_elements(list)
-     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+     pushd, info.dir_tmp
+     list = file_search() & nl = n_elements(list)
+     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
      popd
        
      GOTO, fin
@@ -7036,11 +7069,11 @@ CASE strlowCase(eventValue) OF
       res = dialog_message(msg, / information)
       ;; reset the colortable to the settings before the batch processing
       tvlct, rini, gini, bini
-      ;; clean up tmp
-      pushd, info.dir_tmp
-      list = file_search() & nl = n_elements(list)
-      if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-      popd
+      ;; clean up tmp
+      pushd, info.dir_tmp
+      list = file_search() & nl = n_elements(list)
+      if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+      popd
 
 
       ;; free and delete the temporary pointers
@@ -7420,10 +7453,10 @@ CASE strlowCase(eventValue) OF
       res = dialog_message(msg, / information)
       ;; reset the colortable to the settings before the batch processing
       tvlct, rini, gini, bini
-      ;; clean up tmp
-      pushd, info.dir_tmp
-      list = file_search() & nl = n_elements(list)
-      if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+      ;; clean up tmp
+      pushd, info.dir_tmp
+      list = file_search() & nl = n_elements(list)
+      if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
       popd
 
       ;; free and delete the temporary pointers
@@ -7802,10 +7835,10 @@ CASE strlowCase(eventValue) OF
      res = dialog_message(msg, / information)
      ;; reset the colortable to the settings before the batch processing
      tvlct, rini, gini, bini
-     ;; clean up tmp
-     pushd, info.dir_tmp
-     list = file_search() & nl = n_elements(list)
-     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+     ;; clean up tmp
+     pushd, info.dir_tmp
+     list = file_search() & nl = n_elements(list)
+     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
      popd
 
      ;; free and delete the temporary pointers
@@ -7919,8 +7952,8 @@ CASE strlowCase(eventValue) OF
        spatcon=info.dir_guidossub +'spatcon\grayspatcon64.exe' & file_copy, spatcon, 'grayspatcon.exe', /overwrite
      ENDIF ELSE IF info.my_os EQ 'darwin' THEN BEGIN
        spatcon=info.dir_guidossub +'spatcon/grayspatcon_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
-     ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
-       spatcon=info.dir_guidossub +'spatcon/grayspatconARM_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
+     ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
+       spatcon=info.dir_guidossub +'spatcon/grayspatconARM_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
      ENDIF ELSE BEGIN
        spatcon=info.dir_guidossub +'spatcon/grayspatcon_lin64' & file_copy, spatcon, 'grayspatcon', /overwrite
      ENDELSE
@@ -8249,8 +8282,8 @@ CASE strlowCase(eventValue) OF
          spatcon=info.dir_guidossub +'spatcon\grayspatcon64.exe' & file_copy, spatcon, 'grayspatcon.exe', /overwrite
        ENDIF ELSE IF info.my_os EQ 'darwin' THEN BEGIN
          spatcon=info.dir_guidossub +'spatcon/grayspatcon_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
-       ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
-         spatcon=info.dir_guidossub +'spatcon/grayspatconARM_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
+       ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
+         spatcon=info.dir_guidossub +'spatcon/grayspatconARM_mac' & file_copy, spatcon, 'grayspatcon', /overwrite
        ENDIF ELSE BEGIN
          spatcon=info.dir_guidossub +'spatcon/grayspatcon_lin64' & file_copy, spatcon, 'grayspatcon', /overwrite
        ENDELSE
@@ -8578,8 +8611,8 @@ CASE strlowCase(eventValue) OF
          file_copy, recode, 'recode.exe', /overwrite
        ENDIF ELSE IF info.my_os EQ 'darwin' THEN BEGIN
          recode=info.dir_guidossub +'spatcon/recode_mac' & file_copy, recode, 'recode', /overwrite
-       ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
-         recode=info.dir_guidossub +'spatcon/recodeARM_mac' & file_copy, recode, 'recode', /overwrite
+       ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
+         recode=info.dir_guidossub +'spatcon/recodeARM_mac' & file_copy, recode, 'recode', /overwrite
        ENDIF ELSE BEGIN
          recode=info.dir_guidossub +'spatcon/recode_lin64' & file_copy, recode, 'recode', /overwrite
        ENDELSE
@@ -8648,11 +8681,11 @@ CASE strlowCase(eventValue) OF
      res = dialog_message(msg, / information)
      ;; reset the colortable to the settings before the batch processing
      tvlct, rini, gini, bini
-     ;; clean up tmp
-     pushd, info.dir_tmp
-     list = file_search() & nl = n_elements(list)
-     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-     popd
+     ;; clean up tmp
+     pushd, info.dir_tmp
+     list = file_search() & nl = n_elements(list)
+     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+     popd
 
      GOTO, fin
    END
@@ -9053,10 +9086,10 @@ CASE strlowCase(eventValue) OF
       res = dialog_message(msg, / information)
       ;; reset the colortable to the settings before the batch processing
       tvlct, rini, gini, bini
-      ;; clean up tmp
-      pushd, info.dir_tmp
-      list = file_search() & nl = n_elements(list)
-      if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+      ;; clean up tmp
+      pushd, info.dir_tmp
+      list = file_search() & nl = n_elements(list)
+      if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
       popd
 
       GOTO, fin
@@ -9954,11 +9987,11 @@ CASE strlowCase(eventValue) OF
 
      ;; reset the colortable to the settings before the batch processing
      tvlct, rini, gini, bini
-     ;; clean up tmp
-     pushd, info.dir_tmp
-     list = file_search() & nl = n_elements(list)
-     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-     popd
+     ;; clean up tmp
+     pushd, info.dir_tmp
+     list = file_search() & nl = n_elements(list)
+     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+     popd
 
      goto,fin
    END
@@ -10056,9 +10089,9 @@ CASE strlowCase(eventValue) OF
       ;;get the result, update the GTB info, clean dir_tmp
       pushd, info.dir_tmp
       IF info.my_os EQ 'linux' THEN BEGIN
-        ;; Fedora-fix, for whatever reason they rename the output.tif to something else
-        fedora=(file_search('*outputmorph.tif'))[0]
-        file_move, fedora, 'outputmorph.tif',/overwrite,/allow_same
+        ;; Fedora-fix, for whatever reason they rename the output.tif to something else
+        fedora=(file_search('*outputmorph.tif'))[0]
+        file_move, fedora, 'outputmorph.tif',/overwrite,/allow_same
       ENDIF
       image0 = read_tiff('outputmorph.tif')
       file_delete, 'inputmorph.tif', 'outputmorph.tif', / quiet
@@ -10453,10 +10486,10 @@ CASE strlowCase(eventValue) OF
         'Successfully processed files: '+strtrim(okfile,2)+'/'+ strtrim(nr_im_files,2) + string(10b) + string(10b) + $
         'More information can be found in the logfile: ' + string(10b) + fn_logfile
       res = dialog_message(msg, / information)
-      ;; clean up tmp
-      pushd, info.dir_tmp
-      list = file_search() & nl = n_elements(list)
-      if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+      ;; clean up tmp
+      pushd, info.dir_tmp
+      list = file_search() & nl = n_elements(list)
+      if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
       popd
      
       ;; Show the dendrogram if these conditions are met
@@ -11204,10 +11237,10 @@ CASE strlowCase(eventValue) OF
        'Successfully processed files: '+strtrim(okfile,2)+'/'+ strtrim(nr_im_files,2) + string(10b) + string(10b) + $
        'More information can be found in the logfile: ' + string(10b) + fn_logfile
      res = dialog_message(msg, / information)
-     ;; clean up tmp
-     pushd, info.dir_tmp
-     list = file_search() & nl = n_elements(list)
-     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+     ;; clean up tmp
+     pushd, info.dir_tmp
+     list = file_search() & nl = n_elements(list)
+     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
      popd
      
    GOTO, fin
@@ -11440,7 +11473,7 @@ CASE strlowCase(eventValue) OF
             pushd, info.dir_tmp
             IF info.my_os EQ 'linux' THEN mspa_os = 'mspa_lin' 
             IF info.my_os EQ 'darwin' THEN mspa_os = 'mspa_mac'
-            IF info.my_os EQ 'apple' THEN mspa_os = 'mspa_mac'
+            IF info.my_os EQ 'apple' THEN mspa_os = 'mspa_mac'
             cmd = info.dir_guidossub + mspa_os + ' -graphfg ' + c_FGconn + $
                   ' -eew ' + c_size + ' -internal ' + c_intext + $
                   ' -disk -transition ' + c_trans + $
@@ -11562,11 +11595,11 @@ CASE strlowCase(eventValue) OF
 
       ;; reset the colortable to the settings before the batch processing
       tvlct, rini, gini, bini
-      ;; clean up tmp
-      pushd, info.dir_tmp
-      list = file_search() & nl = n_elements(list)
-      if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-      popd
+      ;; clean up tmp
+      pushd, info.dir_tmp
+      list = file_search() & nl = n_elements(list)
+      if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+      popd
 
       GOTO, fin
    END
@@ -11983,7 +12016,7 @@ CASE strlowCase(eventValue) OF
             pushd, info.dir_tmp
             IF info.my_os EQ 'linux' THEN mspa_os = 'mspa_lin' 
             IF info.my_os EQ 'darwin' THEN mspa_os = 'mspa_mac'
-            IF info.my_os EQ 'apple' THEN mspa_os = 'mspa_mac'
+            IF info.my_os EQ 'apple' THEN mspa_os = 'mspa_mac'
             cmd = info.dir_guidossub + mspa_os + ' -graphfg ' + c_FGconn + $
                   ' -eew ' + c_size + ' -internal ' + c_intext + $
                   ' -disk -transition ' + c_trans + $
@@ -13935,11 +13968,11 @@ CASE strlowCase(eventValue) OF
 
      ;; reset the colortable to the settings before the batch processing
      tvlct, rini, gini, bini
-     ;; clean up tmp
-     pushd, info.dir_tmp
-     list = file_search() & nl = n_elements(list)
-     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-     popd
+     ;; clean up tmp
+     pushd, info.dir_tmp
+     list = file_search() & nl = n_elements(list)
+     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+     popd
 
      goto,fin
    END
@@ -14060,9 +14093,9 @@ CASE strlowCase(eventValue) OF
       mev = 0
       if eventValue2 ne 'frag_hmc' then begin  ;; distance histogram
         
-        dhist = fltarr(n_elements(bins))
-        dhist[0:bgmax-1] = -reverse(bghist[1:*]) & dhist[bgmax+1:*]=fghist[1:*]
-        bptit = 'Distance histogram (' + info.title + ')'
+        dhist = fltarr(n_elements(bins))
+        dhist[0:bgmax-1] = -reverse(bghist[1:*]) & dhist[bgmax+1:*]=fghist[1:*]
+        bptit = 'Distance histogram (' + info.title + ')'
 
         ;; print out stats to a file which can then be saved later on
         openw,1,info.dir_tmp+'eucldist.txt' 
@@ -14072,30 +14105,30 @@ CASE strlowCase(eventValue) OF
         printf, 1, 'Foreground: average distance, number of objects, maximum distance: ' 
         printf, 1, ' ', strtrim(adf, 2), '   ', strtrim(fgo, 2), '   ', strtrim(adfmax, 2)
         printf, 1, 'Distance histogram (rounded to nearest integer, negative values for background)
-        printf, 1, '       bin ID     frequency'
-        for idx=0l, n_elements(bins)-1 do printf,1, bins(idx),long64(dhist(idx))
-        close, 1
-
-        a = barplot(bins, dhist, fill_color='blue', xtitle=xtit, /buffer, $
-          ytitle = 'Frequency', title = bptit, xrange = [-x1,x2], histogram=1)
-        ;; overplot the foreground histogram
-        z = dhist & z[0:bgmax-1]=0
-        a = barplot(bins,z,fill_color='green',/overplot,histogram=1)
-        a = text(2,-bghist[1]*0.2,'adf = ' + strtrim(adf, 2),/data,/current,color='green')
-        a = text(2,-bghist[1]*0.2,'adf',/data,/current,color='gold')
-        a = text(2,-bghist[1]*0.3,'fgo = ' + strtrim(fgo, 2),/data,/current,color='green')
-        a = text(2,-bghist[1]*0.4,'d_max = ' + strtrim(adfmax, 2),/data,/current,color='green')
-        px = -40 < (-bgmax)
-        a = text(px*0.8,fghist[1]*0.4,'adb = ' + strtrim(-adb, 2),/data,/current,color='blue')
-        a = text(px*0.8,fghist[1]*0.4,'adb',/data,/current,color='gold')
-        a = text(px*0.8,fghist[1]*0.3,'bgo = -' + strtrim(bgo, 2),/data,/current,color='blue')
-        a = text(px*0.8,fghist[1]*0.2,'d_max = ' + strtrim(adbmax, 2),/data,/current,color='blue')
-        ;; highlight the average distance bin
-        z2 = z*0 & bb = bgmax-round(adb) & z2[bb]=dhist[bb]
-        if adf gt 1.0 then bb = bgmax+round(adf) else bb = bgmax & z2[bb]=dhist[bb]
-        a = barplot(bins,z2,fill_color='gold',/overplot,histogram=1)
-        a.save,info.dir_tmp + 'barplot_dist.png', resolution=300
-        a.close
+        printf, 1, '       bin ID     frequency'
+        for idx=0l, n_elements(bins)-1 do printf,1, bins(idx),long64(dhist(idx))
+        close, 1
+
+        a = barplot(bins, dhist, fill_color='blue', xtitle=xtit, /buffer, $
+          ytitle = 'Frequency', title = bptit, xrange = [-x1,x2], histogram=1)
+        ;; overplot the foreground histogram
+        z = dhist & z[0:bgmax-1]=0
+        a = barplot(bins,z,fill_color='green',/overplot,histogram=1)
+        a = text(2,-bghist[1]*0.2,'adf = ' + strtrim(adf, 2),/data,/current,color='green')
+        a = text(2,-bghist[1]*0.2,'adf',/data,/current,color='gold')
+        a = text(2,-bghist[1]*0.3,'fgo = ' + strtrim(fgo, 2),/data,/current,color='green')
+        a = text(2,-bghist[1]*0.4,'d_max = ' + strtrim(adfmax, 2),/data,/current,color='green')
+        px = -40 < (-bgmax)
+        a = text(px*0.8,fghist[1]*0.4,'adb = ' + strtrim(-adb, 2),/data,/current,color='blue')
+        a = text(px*0.8,fghist[1]*0.4,'adb',/data,/current,color='gold')
+        a = text(px*0.8,fghist[1]*0.3,'bgo = -' + strtrim(bgo, 2),/data,/current,color='blue')
+        a = text(px*0.8,fghist[1]*0.2,'d_max = ' + strtrim(adbmax, 2),/data,/current,color='blue')
+        ;; highlight the average distance bin
+        z2 = z*0 & bb = bgmax-round(adb) & z2[bb]=dhist[bb]
+        if adf gt 1.0 then bb = bgmax+round(adf) else bb = bgmax & z2[bb]=dhist[bb]
+        a = barplot(bins,z2,fill_color='gold',/overplot,histogram=1)
+        a.save,info.dir_tmp + 'barplot_dist.png', resolution=300
+        a.close
       
         ;; calculate hypsometric curve
         ;;===========================================================
@@ -14103,79 +14136,79 @@ CASE strlowCase(eventValue) OF
         fghmcx=fghmc/max(fghmc) & bghmcx=bghmc/max(bghmc)
 
         ;; define hmc for background and foreground
-        hmc = fltarr(n_elements(bins))
-        hmc[0:bgmax-1] = -reverse(bghmcx) & hmc[bgmax+1:*]=fghmcx
-        bptit = 'Hypsometric curve (' + info.title + ')'
-
-        a = barplot(bins,hmc,fill_color='blue',xtitle = xtit, /buffer,$
-          ytitle='Normalized cumulative frequency',title=bptit,yrange=[-1.1,1.1],xrange=[-x1,x2],histogram=1)
-        z = hmc & z[0:bgmax-1]=0
-        a = barplot(bins,z,fill_color='green',/overplot,histogram=1)
-
-        ;; highlight the average distance bin
-        z = z*0 & bb = bgmax-round(adb) & z[bb]=hmc[bb]
-        if adf gt 1.0 then bb = bgmax+round(adf) else bb = bgmax
-        ; ensure it is not larger than the last entry of z which may happen in singular cases and rounding issues
-        xx = n_elements(z)-1 & bb = bb < xx & z[bb]=hmc[bb]
-        a = barplot(bins,z,fill_color='gold',/overplot,histogram=1)
-
-        ;; HI: Hypsometric Index
-        ;;
-        ;; HI = (E_mean - E_min)/(E_max - E_min) with
-        ;; E_min: minimum elevation value (outlet)
-        ;; E_max: maximum elevation value
-        ;; E_mean: mean (not median) elevation value
-
-        ;; HA: Hypsometric Area - integral area under the curve for FG, BG
-
-        hi_fg = 0 & hi_bg = 0 & ha_fg = 0 & ha_bg = 0
-        if adf gt 0 then begin
-          hi_fg = adf/adfmax
-          ha_fg = total(fghmcx)
-          fg_arep = (!PI * (adf^2)) ; typical area
-        endif
-        if adb gt 0 then begin
-          hi_bg = adb/adbmax
-          ha_bg = -total(bghmcx)
-          bg_arep = -(!PI * (adb^2)) ; typical area
-        endif
-
-        ;;Foreground
-        hi_fg_str = 'HI = ' + strtrim(hi_fg,2)
-        ha_fg_str = 'HA = ' + strtrim(ha_fg,2)
-        a = text(5,-0.2,hi_fg_str,/data,/current,color='green')
-        a = text(5,-0.3,ha_fg_str,/data,/current,color='green')
-        a = text(5,-0.5,'adf = ' + strtrim(adf, 2),/data,/current,color='green')
-        a = text(5,-0.5,'adf',/data,/current,color='gold')
-        a = text(5,-0.6,'fg_dmax = ' + strtrim(adfmax, 2),/data,/current,color='green')
-        a = text(5,-0.7,'fg_obj = ' + strtrim(fgo, 2),/data,/current,color='green')
-        a = text(5,-0.8,'fg_area = ' + strtrim(pfg*100, 2)+'%',/data,/current,color='green')
-        a = text(5,-0.9,'fg_Arep = ' + strtrim(fg_arep, 2),/data,/current,color='red')
-
-        ;; Background
-        hi_bg_str = 'HI = ' + strtrim(hi_bg,2)
-        ha_bg_str = 'HA = ' + strtrim(ha_bg,2)
-        a = text(-x1*0.9,0.9,hi_bg_str,/data,/current,color='blue')
-        a = text(-x1*0.9,0.8,ha_bg_str,/data,/current,color='blue')
-        a = text(-x1*0.9,0.6,'adb = ' + strtrim(-adb, 2),/data,/current,color='blue')
-        a = text(-x1*0.9,0.6,'adb',/data,/current,color='gold')
-        a = text(-x1*0.9,0.5,'bg_dmax = ' + strtrim(adbmax, 2),/data,/current,color='blue')
-        a = text(-x1*0.9,0.4,'bg_obj = -' + strtrim(bgo, 2),/data,/current,color='blue')
-        a = text(-x1*0.9,0.3,'bg_area = ' + strtrim(pbg*100, 2)+'%',/data,/current,color='blue')
-        a = text(-x1*0.9,0.2,'bg_Arep = ' + strtrim(bg_arep, 2),/data,/current,color='red')
-        a.save,info.dir_tmp + 'barplot_hmc.png', resolution=300
-        a.close
-
-        ;; print out HMC stats to a txt-file
-        fn_out = info.dir_tmp + 'dist_hmc.txt'
-        openw,1,fn_out
-        printf, 1, 'HI, HA, adb, bg_dmax, bg_obj, bg_area, bg_Arep (background indices)'
-        printf, 1, 'HI, HA, adf, fg_dmax, fg_obj, fg_area, fg_Arep (foreground indices)'
-        printf, 1, ' '
-        printf, 1, 'File: ' + info.fname_input
-        printf, 1, strtrim(abs(hi_bg),2),'  ',strtrim(abs(ha_bg),2), '  ',strtrim(adb,2),'  ', strtrim(abs(adbmax),2),$
-          '  ', strtrim(bgo,2), '  ', strtrim(pbg*100, 2), '  ', strtrim(abs(bg_arep),2)
-        printf, 1, strtrim(hi_fg,2), '  ', strtrim(ha_fg,2), '  ', strtrim(adf,2), '  ', strtrim(adfmax,2),'  ',$
+        hmc = fltarr(n_elements(bins))
+        hmc[0:bgmax-1] = -reverse(bghmcx) & hmc[bgmax+1:*]=fghmcx
+        bptit = 'Hypsometric curve (' + info.title + ')'
+
+        a = barplot(bins,hmc,fill_color='blue',xtitle = xtit, /buffer,$
+          ytitle='Normalized cumulative frequency',title=bptit,yrange=[-1.1,1.1],xrange=[-x1,x2],histogram=1)
+        z = hmc & z[0:bgmax-1]=0
+        a = barplot(bins,z,fill_color='green',/overplot,histogram=1)
+
+        ;; highlight the average distance bin
+        z = z*0 & bb = bgmax-round(adb) & z[bb]=hmc[bb]
+        if adf gt 1.0 then bb = bgmax+round(adf) else bb = bgmax
+        ; ensure it is not larger than the last entry of z which may happen in singular cases and rounding issues
+        xx = n_elements(z)-1 & bb = bb < xx & z[bb]=hmc[bb]
+        a = barplot(bins,z,fill_color='gold',/overplot,histogram=1)
+
+        ;; HI: Hypsometric Index
+        ;;
+        ;; HI = (E_mean - E_min)/(E_max - E_min) with
+        ;; E_min: minimum elevation value (outlet)
+        ;; E_max: maximum elevation value
+        ;; E_mean: mean (not median) elevation value
+
+        ;; HA: Hypsometric Area - integral area under the curve for FG, BG
+
+        hi_fg = 0 & hi_bg = 0 & ha_fg = 0 & ha_bg = 0
+        if adf gt 0 then begin
+          hi_fg = adf/adfmax
+          ha_fg = total(fghmcx)
+          fg_arep = (!PI * (adf^2)) ; typical area
+        endif
+        if adb gt 0 then begin
+          hi_bg = adb/adbmax
+          ha_bg = -total(bghmcx)
+          bg_arep = -(!PI * (adb^2)) ; typical area
+        endif
+
+        ;;Foreground
+        hi_fg_str = 'HI = ' + strtrim(hi_fg,2)
+        ha_fg_str = 'HA = ' + strtrim(ha_fg,2)
+        a = text(5,-0.2,hi_fg_str,/data,/current,color='green')
+        a = text(5,-0.3,ha_fg_str,/data,/current,color='green')
+        a = text(5,-0.5,'adf = ' + strtrim(adf, 2),/data,/current,color='green')
+        a = text(5,-0.5,'adf',/data,/current,color='gold')
+        a = text(5,-0.6,'fg_dmax = ' + strtrim(adfmax, 2),/data,/current,color='green')
+        a = text(5,-0.7,'fg_obj = ' + strtrim(fgo, 2),/data,/current,color='green')
+        a = text(5,-0.8,'fg_area = ' + strtrim(pfg*100, 2)+'%',/data,/current,color='green')
+        a = text(5,-0.9,'fg_Arep = ' + strtrim(fg_arep, 2),/data,/current,color='red')
+
+        ;; Background
+        hi_bg_str = 'HI = ' + strtrim(hi_bg,2)
+        ha_bg_str = 'HA = ' + strtrim(ha_bg,2)
+        a = text(-x1*0.9,0.9,hi_bg_str,/data,/current,color='blue')
+        a = text(-x1*0.9,0.8,ha_bg_str,/data,/current,color='blue')
+        a = text(-x1*0.9,0.6,'adb = ' + strtrim(-adb, 2),/data,/current,color='blue')
+        a = text(-x1*0.9,0.6,'adb',/data,/current,color='gold')
+        a = text(-x1*0.9,0.5,'bg_dmax = ' + strtrim(adbmax, 2),/data,/current,color='blue')
+        a = text(-x1*0.9,0.4,'bg_obj = -' + strtrim(bgo, 2),/data,/current,color='blue')
+        a = text(-x1*0.9,0.3,'bg_area = ' + strtrim(pbg*100, 2)+'%',/data,/current,color='blue')
+        a = text(-x1*0.9,0.2,'bg_Arep = ' + strtrim(bg_arep, 2),/data,/current,color='red')
+        a.save,info.dir_tmp + 'barplot_hmc.png', resolution=300
+        a.close
+
+        ;; print out HMC stats to a txt-file
+        fn_out = info.dir_tmp + 'dist_hmc.txt'
+        openw,1,fn_out
+        printf, 1, 'HI, HA, adb, bg_dmax, bg_obj, bg_area, bg_Arep (background indices)'
+        printf, 1, 'HI, HA, adf, fg_dmax, fg_obj, fg_area, fg_Arep (foreground indices)'
+        printf, 1, ' '
+        printf, 1, 'File: ' + info.fname_input
+        printf, 1, strtrim(abs(hi_bg),2),'  ',strtrim(abs(ha_bg),2), '  ',strtrim(adb,2),'  ', strtrim(abs(adbmax),2),$
+          '  ', strtrim(bgo,2), '  ', strtrim(pbg*100, 2), '  ', strtrim(abs(bg_arep),2)
+        printf, 1, strtrim(hi_fg,2), '  ', strtrim(ha_fg,2), '  ', strtrim(adf,2), '  ', strtrim(adfmax,2),'  ',$
         strtrim(fgo,2), '  ', strtrim(pfg*100, 2), '  ', strtrim(fg_arep,2)
         close, 1
 
@@ -14235,83 +14268,83 @@ CASE strlowCase(eventValue) OF
               
         ;; show reference hmc
         ;;;===================
-        bptit = 'Normalized hypsometric curve (' + info.title + ')'
-        xtit = 'Background               normalized distance               Foreground'
-
-        a = barplot([0,1],[1,1],fill_color='Red',xtitle = xtit, transparency=90, /buffer,$
-          ytitle='Normalized cumulative frequency',title=bptit,yrange=[-1.1,1.1],xrange=[-1,1],histogram=1)
-        a = barplot([-2,-1],[-1,-1],fill_color='Red',transparency=90,/overplot,histogram=1)
-        ;; add boundary info
-        a = text(-0.9,0.9,'Minimum fragmentation',/data,/current,color='Black')
-        a = text(-0.9,0.75,'Maximum fragmentation',/data,/current,color='Red')
-        a = plot([-1,0],[-1,-1],thick=3,/data,/current,/overplot,color='Red')
-        a = plot([0,1],[1,1],thick=3,/data,/current,/overplot,color='Red')
-        a = plot([0,0],[1,-1],thick=3,/data,/current,/overplot,color='Red')
-
-        ;; first oplot hmc of actual image
-        ;;=================================
-        ;; a) background
-        y = hmc[0:bgmax-1] & x = bins[0:bgmax-1] & xm = float(min(x))
-        bgarea = total(y)/n_elements(y) & x = -x/xm
-        a = barplot(x,y,fill_color='Blue', transparency=0,/overplot,histogram=1)
-        ;; b) foreground, here we shift the foreground range to the zero center line (x=x-1)
-        y = hmc[bgmax+1:*] & x = bins[bgmax+1:*] & x=x-1 & xm = float(max(x))
-        ;; test if only one element to avoid division by zero
-        if xm lt 1.0 then begin
-          fgarea = total(y) & x[0] = 0
-        endif else begin
-          fgarea = total(y)/n_elements(y) & x = x/xm
-        endelse
-        a = barplot(x,y,fill_color='Green', transparency=30,/overplot,histogram=1)
-
-        ;; next oplot hmc of the reference area
-        ;;=======================================
-        y = rhmc[0:rbgmax-1] & x = rbins[0:rbgmax-1] & xm = float(min(x))
-        rbgarea = total(y)/n_elements(y) & x = -x/xm
-        a = barplot(x,y,fill_color='Black',/overplot,histogram=1)
-        ;; now oplot the normalized FG
-        y = rhmc[rbgmax:*] & x = rbins[rbgmax:*] &  xm = float(max(x))
-        rfgarea = total(y)/n_elements(y) & x = x/xm
-        a = barplot(x,y,fill_color='Black',/overplot,histogram=1)
-
-        ;; define fragmentation in complementary area of area covered
-        ;; by the reference hmc
-        ;; a) background
-        ; d_bg = abs(bgarea) - abs(rbgarea)
-        d_bg = abs(abs(bgarea) - abs(rbgarea))
-        frag_bg = 100.0 / (1.0 - abs(rbgarea)) * d_bg
-        ;; round off to 1%
-        frag_bg = round(frag_bg*100)/100.0
-        ttbg = strtrim(frag_bg,2) & ttbg = strmid(ttbg, 0,strpos(ttbg,'.')+3)
-        frag_bg_str = 'bg_frag = ' + ttbg + '%'
-        a = text(-0.9,0.2,frag_bg_str,/data,/current,color='Blue')
-        ;; b) foreground
-        ;; potential fragmentation area limits
-        ;; 1.0 - rfgarea = 100  ;; green area
-        ;; rfgarea = 0  ;; black area
-        ;; d_fg = fgarea - rfgarea = area occupied by image := x% fragmentation
-        d_fg = fgarea - rfgarea
-        ;; due to the bining and calculation inprecision frag_fg might be slighly negative, reset to 0
-        frag_fg = 100.0 / (1.0 - rfgarea) * d_fg > 0.0
-        frag_fg = round(frag_fg*100)/100.0
-        ttfg = strtrim(frag_fg,2) & ttfg = strmid(ttfg, 0,strpos(ttfg,'.')+3)
-        frag_fg_str = 'fg_frag = ' + ttfg + '%'
-        a = text(0.1,-0.2,frag_fg_str,/data,/current,color='Green')
-        frag = pbg * frag_bg + pfg * frag_fg
-        frag = round(frag*100)/100.0
-        ttf = strtrim(frag,2) & ttf = strmid(ttf, 0,strpos(ttf,'.')+3)
-        frag_str = 'frag = ' + ttf + '%'
-        a = text(-0.9,0.6,'$\bf'+frag_str+'$',/data,/current,color='Orange')
-        a.save,info.dir_tmp + 'barplot2.png', resolution=300
-
-
-        ;; open barplot image
-        IF info.my_os EQ 'darwin' OR info.my_os EQ 'apple' THEN BEGIN
-          spawn, 'open ' + info.dir_tmp + 'barplot2.png'
-        ENDIF ELSE IF info.my_os EQ 'windows' THEN BEGIN
-          pushd, info.dir_tmp
-          spawn, 'start barplot2.png', / nowait
-          popd
+        bptit = 'Normalized hypsometric curve (' + info.title + ')'
+        xtit = 'Background               normalized distance               Foreground'
+
+        a = barplot([0,1],[1,1],fill_color='Red',xtitle = xtit, transparency=90, /buffer,$
+          ytitle='Normalized cumulative frequency',title=bptit,yrange=[-1.1,1.1],xrange=[-1,1],histogram=1)
+        a = barplot([-2,-1],[-1,-1],fill_color='Red',transparency=90,/overplot,histogram=1)
+        ;; add boundary info
+        a = text(-0.9,0.9,'Minimum fragmentation',/data,/current,color='Black')
+        a = text(-0.9,0.75,'Maximum fragmentation',/data,/current,color='Red')
+        a = plot([-1,0],[-1,-1],thick=3,/data,/current,/overplot,color='Red')
+        a = plot([0,1],[1,1],thick=3,/data,/current,/overplot,color='Red')
+        a = plot([0,0],[1,-1],thick=3,/data,/current,/overplot,color='Red')
+
+        ;; first oplot hmc of actual image
+        ;;=================================
+        ;; a) background
+        y = hmc[0:bgmax-1] & x = bins[0:bgmax-1] & xm = float(min(x))
+        bgarea = total(y)/n_elements(y) & x = -x/xm
+        a = barplot(x,y,fill_color='Blue', transparency=0,/overplot,histogram=1)
+        ;; b) foreground, here we shift the foreground range to the zero center line (x=x-1)
+        y = hmc[bgmax+1:*] & x = bins[bgmax+1:*] & x=x-1 & xm = float(max(x))
+        ;; test if only one element to avoid division by zero
+        if xm lt 1.0 then begin
+          fgarea = total(y) & x[0] = 0
+        endif else begin
+          fgarea = total(y)/n_elements(y) & x = x/xm
+        endelse
+        a = barplot(x,y,fill_color='Green', transparency=30,/overplot,histogram=1)
+
+        ;; next oplot hmc of the reference area
+        ;;=======================================
+        y = rhmc[0:rbgmax-1] & x = rbins[0:rbgmax-1] & xm = float(min(x))
+        rbgarea = total(y)/n_elements(y) & x = -x/xm
+        a = barplot(x,y,fill_color='Black',/overplot,histogram=1)
+        ;; now oplot the normalized FG
+        y = rhmc[rbgmax:*] & x = rbins[rbgmax:*] &  xm = float(max(x))
+        rfgarea = total(y)/n_elements(y) & x = x/xm
+        a = barplot(x,y,fill_color='Black',/overplot,histogram=1)
+
+        ;; define fragmentation in complementary area of area covered
+        ;; by the reference hmc
+        ;; a) background
+        ; d_bg = abs(bgarea) - abs(rbgarea)
+        d_bg = abs(abs(bgarea) - abs(rbgarea))
+        frag_bg = 100.0 / (1.0 - abs(rbgarea)) * d_bg
+        ;; round off to 1%
+        frag_bg = round(frag_bg*100)/100.0
+        ttbg = strtrim(frag_bg,2) & ttbg = strmid(ttbg, 0,strpos(ttbg,'.')+3)
+        frag_bg_str = 'bg_frag = ' + ttbg + '%'
+        a = text(-0.9,0.2,frag_bg_str,/data,/current,color='Blue')
+        ;; b) foreground
+        ;; potential fragmentation area limits
+        ;; 1.0 - rfgarea = 100  ;; green area
+        ;; rfgarea = 0  ;; black area
+        ;; d_fg = fgarea - rfgarea = area occupied by image := x% fragmentation
+        d_fg = fgarea - rfgarea
+        ;; due to the bining and calculation inprecision frag_fg might be slighly negative, reset to 0
+        frag_fg = 100.0 / (1.0 - rfgarea) * d_fg > 0.0
+        frag_fg = round(frag_fg*100)/100.0
+        ttfg = strtrim(frag_fg,2) & ttfg = strmid(ttfg, 0,strpos(ttfg,'.')+3)
+        frag_fg_str = 'fg_frag = ' + ttfg + '%'
+        a = text(0.1,-0.2,frag_fg_str,/data,/current,color='Green')
+        frag = pbg * frag_bg + pfg * frag_fg
+        frag = round(frag*100)/100.0
+        ttf = strtrim(frag,2) & ttf = strmid(ttf, 0,strpos(ttf,'.')+3)
+        frag_str = 'frag = ' + ttf + '%'
+        a = text(-0.9,0.6,'$\bf'+frag_str+'$',/data,/current,color='Orange')
+        a.save,info.dir_tmp + 'barplot2.png', resolution=300
+
+
+        ;; open barplot image
+        IF info.my_os EQ 'darwin' OR info.my_os EQ 'apple' THEN BEGIN
+          spawn, 'open ' + info.dir_tmp + 'barplot2.png'
+        ENDIF ELSE IF info.my_os EQ 'windows' THEN BEGIN
+          pushd, info.dir_tmp
+          spawn, 'start barplot2.png', / nowait
+          popd
         ENDIF ELSE BEGIN ;; Linux
           IF strlen(info.xdgop) EQ 0 THEN BEGIN
             st = "Please install xdg-open to automatically" + $
@@ -14589,32 +14622,32 @@ CASE strlowCase(eventValue) OF
        printf, 1, strtrim(-adb, 2), '  -', strtrim(bgo, 2), '  ', strtrim(adbmax, 2)
        printf, 1, 'Foreground: average distance, number of objects, maximum distance: '
        printf, 1, ' ', strtrim(adf, 2), '   ', strtrim(fgo, 2), '   ', strtrim(adfmax, 2)
-       printf, 1, 'Distance histogram (rounded to nearest integer, negative values for background)
-       printf, 1, '       bin ID     frequency'
-       for idx=0l, n_elements(bins)-1 do printf,1, bins(idx),long64(dhist(idx))
-       close, 1
-
-       a = barplot(bins, dhist, fill_color='blue', xtitle=xtit, /buffer, $
-         ytitle = 'Frequency', title = bptit, xrange = [-x1,x2], histogram=1)
-       ;; overplot the foreground histogram
-       z = dhist & z[0:bgmax-1]=0
-       a = barplot(bins,z,fill_color='green',/overplot,histogram=1)
-       a = text(2,-bghist[1]*0.2,'adf = ' + strtrim(adf, 2),/data,/current,color='green')
-       a = text(2,-bghist[1]*0.2,'adf',/data,/current,color='gold')
-       a = text(2,-bghist[1]*0.3,'fgo = ' + strtrim(fgo, 2),/data,/current,color='green')
-       a = text(2,-bghist[1]*0.4,'d_max = ' + strtrim(adfmax, 2),/data,/current,color='green')
-       px = -40 < (-bgmax)
-       a = text(px*0.8,fghist[1]*0.4,'adb = ' + strtrim(-adb, 2),/data,/current,color='blue')
-       a = text(px*0.8,fghist[1]*0.4,'adb',/data,/current,color='gold')
-       a = text(px*0.8,fghist[1]*0.3,'bgo = -' + strtrim(bgo, 2),/data,/current,color='blue')
-       a = text(px*0.8,fghist[1]*0.2,'d_max = ' + strtrim(adbmax, 2),/data,/current,color='blue')
-       ;; highlight the average distance bin
-       z2 = z*0 & bb = bgmax-round(adb) & z2[bb]=dhist[bb]
-       if adf gt 1.0 then bb = bgmax+round(adf) else bb = bgmax & z2[bb]=dhist[bb]
-       a = barplot(bins,z2,fill_color='gold',/overplot,histogram=1)
-       a.save,dir_batch + dir_res + res + '_dist_hist.png', resolution=300
-       a.close
-
+       printf, 1, 'Distance histogram (rounded to nearest integer, negative values for background)
+       printf, 1, '       bin ID     frequency'
+       for idx=0l, n_elements(bins)-1 do printf,1, bins(idx),long64(dhist(idx))
+       close, 1
+
+       a = barplot(bins, dhist, fill_color='blue', xtitle=xtit, /buffer, $
+         ytitle = 'Frequency', title = bptit, xrange = [-x1,x2], histogram=1)
+       ;; overplot the foreground histogram
+       z = dhist & z[0:bgmax-1]=0
+       a = barplot(bins,z,fill_color='green',/overplot,histogram=1)
+       a = text(2,-bghist[1]*0.2,'adf = ' + strtrim(adf, 2),/data,/current,color='green')
+       a = text(2,-bghist[1]*0.2,'adf',/data,/current,color='gold')
+       a = text(2,-bghist[1]*0.3,'fgo = ' + strtrim(fgo, 2),/data,/current,color='green')
+       a = text(2,-bghist[1]*0.4,'d_max = ' + strtrim(adfmax, 2),/data,/current,color='green')
+       px = -40 < (-bgmax)
+       a = text(px*0.8,fghist[1]*0.4,'adb = ' + strtrim(-adb, 2),/data,/current,color='blue')
+       a = text(px*0.8,fghist[1]*0.4,'adb',/data,/current,color='gold')
+       a = text(px*0.8,fghist[1]*0.3,'bgo = -' + strtrim(bgo, 2),/data,/current,color='blue')
+       a = text(px*0.8,fghist[1]*0.2,'d_max = ' + strtrim(adbmax, 2),/data,/current,color='blue')
+       ;; highlight the average distance bin
+       z2 = z*0 & bb = bgmax-round(adb) & z2[bb]=dhist[bb]
+       if adf gt 1.0 then bb = bgmax+round(adf) else bb = bgmax & z2[bb]=dhist[bb]
+       a = barplot(bins,z2,fill_color='gold',/overplot,histogram=1)
+       a.save,dir_batch + dir_res + res + '_dist_hist.png', resolution=300
+       a.close
+
     
        ;; calculate hypsometric curve
        ;;===========================================================
@@ -14622,75 +14655,75 @@ CASE strlowCase(eventValue) OF
        fghmcx=fghmc/max(fghmc) & bghmcx=bghmc/max(bghmc)
 
        ;; define hmc for background and foreground
-       hmc = fltarr(n_elements(bins))
-       hmc[0:bgmax-1] = -reverse(bghmcx) & hmc[bgmax+1:*]=fghmcx
-       bptit = 'Hypsometric curve (' + res + ')'
-
-       a = barplot(bins,hmc,fill_color='blue',xtitle = xtit, /buffer,$
-         ytitle='Normalized cumulative frequency',title=bptit,yrange=[-1.1,1.1],xrange=[-x1,x2],histogram=1)
-       z = hmc & z[0:bgmax-1]=0
-       a = barplot(bins,z,fill_color='green',/overplot,histogram=1)
-
-       ;; highlight the average distance bin
-       z = z*0 & bb = bgmax-round(adb) & z[bb]=hmc[bb]
-       if adf gt 1.0 then bb = bgmax+round(adf) else bb = bgmax
-       ; ensure it is not larger than the last entry of z which may happen in singular cases and rounding issues
-       xx = n_elements(z)-1 & bb = bb < xx & z[bb]=hmc[bb]
-       a = barplot(bins,z,fill_color='gold',/overplot,histogram=1)
-
-       ;; HI: Hypsometric Index
-       ;;
-       ;; HI = (E_mean - E_min)/(E_max - E_min) with
-       ;; E_min: minimum elevation value (outlet)
-       ;; E_max: maximum elevation value
-       ;; E_mean: mean (not median) elevation value
-
-       ;; HA: Hypsometric Area - integral area under the curve for FG, BG
-
-       hi_fg = 0 & hi_bg = 0 & ha_fg = 0 & ha_bg = 0
-       if adf gt 0 then begin
-         hi_fg = adf/adfmax
-         ha_fg = total(fghmcx)
-         fg_arep = (!PI * (adf^2)) ; typical area
-       endif
-       if adb gt 0 then begin
-         hi_bg = adb/adbmax
-         ha_bg = -total(bghmcx)
-         bg_arep = -(!PI * (adb^2)) ; typical area
-       endif
-
-       ;;Foreground
-       hi_fg_str = 'HI = ' + strtrim(hi_fg,2)
-       ha_fg_str = 'HA = ' + strtrim(ha_fg,2)
-       a = text(5,-0.2,hi_fg_str,/data,/current,color='green')
-       a = text(5,-0.3,ha_fg_str,/data,/current,color='green')
-       a = text(5,-0.5,'adf = ' + strtrim(adf, 2),/data,/current,color='green')
-       a = text(5,-0.5,'adf',/data,/current,color='gold')
-       a = text(5,-0.6,'fg_dmax = ' + strtrim(adfmax, 2),/data,/current,color='green')
-       a = text(5,-0.7,'fg_obj = ' + strtrim(fgo, 2),/data,/current,color='green')
-       a = text(5,-0.8,'fg_area = ' + strtrim(pfg*100, 2)+'%',/data,/current,color='green')
-       a = text(5,-0.9,'fg_Arep = ' + strtrim(fg_arep, 2),/data,/current,color='red')
-
-       ;; Background
-       hi_bg_str = 'HI = ' + strtrim(hi_bg,2)
-       ha_bg_str = 'HA = ' + strtrim(ha_bg,2)
-       a = text(-x1*0.9,0.9,hi_bg_str,/data,/current,color='blue')
-       a = text(-x1*0.9,0.8,ha_bg_str,/data,/current,color='blue')
-       a = text(-x1*0.9,0.6,'adb = ' + strtrim(-adb, 2),/data,/current,color='blue')
-       a = text(-x1*0.9,0.6,'adb',/data,/current,color='gold')
-       a = text(-x1*0.9,0.5,'bg_dmax = ' + strtrim(adbmax, 2),/data,/current,color='blue')
-       a = text(-x1*0.9,0.4,'bg_obj = -' + strtrim(bgo, 2),/data,/current,color='blue')
-       a = text(-x1*0.9,0.3,'bg_area = ' + strtrim(pbg*100, 2)+'%',/data,/current,color='blue')
-       a = text(-x1*0.9,0.2,'bg_Arep = ' + strtrim(bg_arep, 2),/data,/current,color='red')
-       a.save, dir_batch + dir_res + res + '_dist_hmc.png', resolution=300
-
-
-       ;; print out HMC stats to a txt-file
-       fn_out = dir_batch + dir_res + res + '_dist_hmc.txt'
-       openw,1,fn_out
-       printf, 1, 'HI, HA, adb, bg_dmax, bg_obj, bg_area, bg_Arep (background indices)'
-       printf, 1, 'HI, HA, adf, fg_dmax, fg_obj, fg_area, fg_Arep (foreground indices)'
-       printf, 1, ' '
+       hmc = fltarr(n_elements(bins))
+       hmc[0:bgmax-1] = -reverse(bghmcx) & hmc[bgmax+1:*]=fghmcx
+       bptit = 'Hypsometric curve (' + res + ')'
+
+       a = barplot(bins,hmc,fill_color='blue',xtitle = xtit, /buffer,$
+         ytitle='Normalized cumulative frequency',title=bptit,yrange=[-1.1,1.1],xrange=[-x1,x2],histogram=1)
+       z = hmc & z[0:bgmax-1]=0
+       a = barplot(bins,z,fill_color='green',/overplot,histogram=1)
+
+       ;; highlight the average distance bin
+       z = z*0 & bb = bgmax-round(adb) & z[bb]=hmc[bb]
+       if adf gt 1.0 then bb = bgmax+round(adf) else bb = bgmax
+       ; ensure it is not larger than the last entry of z which may happen in singular cases and rounding issues
+       xx = n_elements(z)-1 & bb = bb < xx & z[bb]=hmc[bb]
+       a = barplot(bins,z,fill_color='gold',/overplot,histogram=1)
+
+       ;; HI: Hypsometric Index
+       ;;
+       ;; HI = (E_mean - E_min)/(E_max - E_min) with
+       ;; E_min: minimum elevation value (outlet)
+       ;; E_max: maximum elevation value
+       ;; E_mean: mean (not median) elevation value
+
+       ;; HA: Hypsometric Area - integral area under the curve for FG, BG
+
+       hi_fg = 0 & hi_bg = 0 & ha_fg = 0 & ha_bg = 0
+       if adf gt 0 then begin
+         hi_fg = adf/adfmax
+         ha_fg = total(fghmcx)
+         fg_arep = (!PI * (adf^2)) ; typical area
+       endif
+       if adb gt 0 then begin
+         hi_bg = adb/adbmax
+         ha_bg = -total(bghmcx)
+         bg_arep = -(!PI * (adb^2)) ; typical area
+       endif
+
+       ;;Foreground
+       hi_fg_str = 'HI = ' + strtrim(hi_fg,2)
+       ha_fg_str = 'HA = ' + strtrim(ha_fg,2)
+       a = text(5,-0.2,hi_fg_str,/data,/current,color='green')
+       a = text(5,-0.3,ha_fg_str,/data,/current,color='green')
+       a = text(5,-0.5,'adf = ' + strtrim(adf, 2),/data,/current,color='green')
+       a = text(5,-0.5,'adf',/data,/current,color='gold')
+       a = text(5,-0.6,'fg_dmax = ' + strtrim(adfmax, 2),/data,/current,color='green')
+       a = text(5,-0.7,'fg_obj = ' + strtrim(fgo, 2),/data,/current,color='green')
+       a = text(5,-0.8,'fg_area = ' + strtrim(pfg*100, 2)+'%',/data,/current,color='green')
+       a = text(5,-0.9,'fg_Arep = ' + strtrim(fg_arep, 2),/data,/current,color='red')
+
+       ;; Background
+       hi_bg_str = 'HI = ' + strtrim(hi_bg,2)
+       ha_bg_str = 'HA = ' + strtrim(ha_bg,2)
+       a = text(-x1*0.9,0.9,hi_bg_str,/data,/current,color='blue')
+       a = text(-x1*0.9,0.8,ha_bg_str,/data,/current,color='blue')
+       a = text(-x1*0.9,0.6,'adb = ' + strtrim(-adb, 2),/data,/current,color='blue')
+       a = text(-x1*0.9,0.6,'adb',/data,/current,color='gold')
+       a = text(-x1*0.9,0.5,'bg_dmax = ' + strtrim(adbmax, 2),/data,/current,color='blue')
+       a = text(-x1*0.9,0.4,'bg_obj = -' + strtrim(bgo, 2),/data,/current,color='blue')
+       a = text(-x1*0.9,0.3,'bg_area = ' + strtrim(pbg*100, 2)+'%',/data,/current,color='blue')
+       a = text(-x1*0.9,0.2,'bg_Arep = ' + strtrim(bg_arep, 2),/data,/current,color='red')
+       a.save, dir_batch + dir_res + res + '_dist_hmc.png', resolution=300
+
+
+       ;; print out HMC stats to a txt-file
+       fn_out = dir_batch + dir_res + res + '_dist_hmc.txt'
+       openw,1,fn_out
+       printf, 1, 'HI, HA, adb, bg_dmax, bg_obj, bg_area, bg_Arep (background indices)'
+       printf, 1, 'HI, HA, adf, fg_dmax, fg_obj, fg_area, fg_Arep (foreground indices)'
+       printf, 1, ' '
      printf, 1, 'File: ' + input
        printf, 1, strtrim(abs(hi_bg),2),'  ',strtrim(abs(ha_bg),2), '  ',strtrim(adb,2),'  ', strtrim(abs(adbmax),2),$
          '  ', strtrim(bgo,2), '  ', strtrim(pbg*100, 2), '  ', strtrim(abs(bg_arep),2)
@@ -14749,11 +14782,11 @@ CASE strlowCase(eventValue) OF
 
      ;; reset the colortable to the settings before the batch processing
      tvlct, rini, gini, bini
-     ;; clean up tmp
-     pushd, info.dir_tmp
-     list = file_search() & nl = n_elements(list)
-     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-     popd
+     ;; clean up tmp
+     pushd, info.dir_tmp
+     list = file_search() & nl = n_elements(list)
+     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+     popd
 
      goto,fin
    END
@@ -15050,11 +15083,11 @@ CASE strlowCase(eventValue) OF
 
          ;; reset the colortable to the settings before the batch processing
          tvlct, rini, gini, bini
-         ;; clean up tmp
-         pushd, info.dir_tmp
-         list = file_search() & nl = n_elements(list)
-         if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-         popd
+         ;; clean up tmp
+         pushd, info.dir_tmp
+         list = file_search() & nl = n_elements(list)
+         if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+         popd
 
          goto,fin       
    END
@@ -16305,11 +16338,11 @@ CASE strlowCase(eventValue) OF
      res = dialog_message(msg, / information)
      ;; reset the colortable to the settings before the batch processing
      tvlct, rini, gini, bini
-     ;; clean up tmp
-     pushd, info.dir_tmp
-     list = file_search() & nl = n_elements(list)
-     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-     popd
+     ;; clean up tmp
+     pushd, info.dir_tmp
+     list = file_search() & nl = n_elements(list)
+     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+     popd
 
      info.is_cost = 0
      GOTO, fin
@@ -16850,9 +16883,9 @@ CASE strlowCase(eventValue) OF
       ENDIF ELSE IF info.my_os EQ 'darwin' THEN BEGIN
         ggeo='../spatcon/ggeo_mac'
         file_copy, ggeo, info.dir_tmp + 'ggeo', /overwrite
-      ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
-        ggeo='../spatcon/ggeoARM_mac'
-        file_copy, ggeo, info.dir_tmp + 'ggeo', /overwrite
+      ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
+        ggeo='../spatcon/ggeoARM_mac'
+        file_copy, ggeo, info.dir_tmp + 'ggeo', /overwrite
       ENDIF ELSE BEGIN
         ggeo='../spatcon/ggeo_lin64'
         file_copy, ggeo, info.dir_tmp + 'ggeo', /overwrite
@@ -17395,8 +17428,8 @@ CASE strlowCase(eventValue) OF
         file_copy, ggeo, 'ggeo.exe', /overwrite
       ENDIF ELSE IF info.my_os EQ 'darwin' THEN BEGIN
         ggeo='../spatcon/ggeo_mac' & file_copy, ggeo, 'ggeo', /overwrite
-      ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
-        ggeo='../spatcon/ggeoARM_mac' & file_copy, ggeo, 'ggeo', /overwrite
+      ENDIF ELSE IF info.my_os EQ 'apple' THEN BEGIN
+        ggeo='../spatcon/ggeoARM_mac' & file_copy, ggeo, 'ggeo', /overwrite
       ENDIF ELSE BEGIN
         ggeo='../spatcon/ggeo_lin64' & file_copy, ggeo, 'ggeo', /overwrite
       ENDELSE
@@ -18029,11 +18062,11 @@ CASE strlowCase(eventValue) OF
        
        ;; reset the colortable to the settings before the batch processing
        tvlct, rini, gini, bini
-       ;; clean up tmp
-       pushd, info.dir_tmp
-       list = file_search() & nl = n_elements(list)
-       if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-       popd
+       ;; clean up tmp
+       pushd, info.dir_tmp
+       list = file_search() & nl = n_elements(list)
+       if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+       popd
 
        goto,fin
    END
@@ -18407,11 +18440,11 @@ CASE strlowCase(eventValue) OF
 
      ;; reset the colortable to the settings before the batch processing
      tvlct, rini, gini, bini
-     ;; clean up tmp
-     pushd, info.dir_tmp
-     list = file_search() & nl = n_elements(list)
-     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-     popd
+     ;; clean up tmp
+     pushd, info.dir_tmp
+     list = file_search() & nl = n_elements(list)
+     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+     popd
 
      goto,fin
    END
@@ -18890,11 +18923,11 @@ CASE strlowCase(eventValue) OF
 
      ;; reset the colortable to the settings before the batch processing
      tvlct, rini, gini, bini
-     ;; clean up tmp
-     pushd, info.dir_tmp
-     list = file_search() & nl = n_elements(list)
-     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
-     popd
+     ;; clean up tmp
+     pushd, info.dir_tmp
+     list = file_search() & nl = n_elements(list)
+     if list[0] ne '' then for i = 0, nl -1 do file_delete, list[i] ,/ allow_nonexistent, / quiet, / recursive
+     popd
 
      goto,fin
    END   
@@ -18995,7 +19028,7 @@ CASE strlowCase(eventValue) OF
         
         IF qq ne 1 THEN BEGIN
  ;         msg = 'Please select a GTB-generated *_fad_mscale.tif OR *_fad-app5/2_mscale.tif image.' + string(10b) + 'Returning...'
-          msg = 'Please select a GTB-generated *_fad_mscale.tif image.' + string(10b) + 'Returning...'
+          msg = 'Please select a GTB-generated *_fad_mscale.tif image.' + string(10b) + 'Returning...'
           res = dialog_message(msg, / information)
           openu, unit, info.log,/append, /Get_lun & printf, unit, systime() + ', ERROR: ' + msg + info.bline & free_lun, unit
           GOTO, fin
@@ -19122,19 +19155,19 @@ CASE strlowCase(eventValue) OF
         qq1b = strmid(im1_file,14,/reverse_offset) eq '_fad_mscale.tif'
         qq = qq1b 
         IF qq ne 1 THEN BEGIN
-          msg = 'Please select a GTB-generated *_fad_mscale.tif image.' + string(10b) + 'Returning...'
+          msg = 'Please select a GTB-generated *_fad_mscale.tif image.' + string(10b) + 'Returning...'
           res = dialog_message(msg, / information)
           openu, unit, info.log,/append, /Get_lun & printf, unit, systime() + ', ERROR: ' + msg + info.bline & free_lun, unit
           GOTO, fin
         ENDIF
        ;; check that both images have the same FAD type
         res = (qq1a eq qq1b)          
-        IF res ne 1 THEN BEGIN
-          msg = 'These two FAD maps are not comparable.' + string(10b) + 'Returning...'
-          res = dialog_message(msg, / information)
-          openu, unit, info.log,/append, /Get_lun & printf, unit, systime() + ', ERROR: ' + msg + info.bline & free_lun, unit
-          GOTO, fin
-        ENDIF
+        IF res ne 1 THEN BEGIN
+          msg = 'These two FAD maps are not comparable.' + string(10b) + 'Returning...'
+          res = dialog_message(msg, / information)
+          openu, unit, info.log,/append, /Get_lun & printf, unit, systime() + ', ERROR: ' + msg + info.bline & free_lun, unit
+          GOTO, fin
+        ENDIF
         IF info.my_os EQ 'windows' THEN BEGIN
           cmd = 'cd "' + info.dir_fwtools + '" & setfw.bat & gdalinfo -noct "' + im2_file + '"'
         ENDIF ELSE BEGIN
@@ -19225,16 +19258,16 @@ CASE strlowCase(eventValue) OF
       restore, filename=im1_sav 
       if (size(fragtype))[1] eq 7 then begin ;; fragtype is used by GWB
         if strlen(fragtype) eq 9 then fostype = 'FOS'+strmid(fragtype,8)
-        if strlen(fragtype) eq 5 then fostype = 'FOS'+strmid(fragtype,4)
+        if strlen(fragtype) eq 5 then fostype = 'FOS'+strmid(fragtype,4)
       endif
       if (size(fadtype))[1] eq 7 then fostype = fadtype ;; fadtype used by FAD_MS 
       im1_fostype = fostype & s1len = strlen(im1_fostype)
                  
       im2_grayt_str = '' & im2_fosinp = '' & im2_fostype = ''      
       restore, filename=im2_sav 
-      if (size(fragtype))[1] eq 7 then begin ;; fragtype is used by GWB
-        if strlen(fragtype) eq 9 then fostype = 'FOS'+strmid(fragtype,8)
-        if strlen(fragtype) eq 5 then fostype = 'FOS'+strmid(fragtype,4)
+      if (size(fragtype))[1] eq 7 then begin ;; fragtype is used by GWB
+        if strlen(fragtype) eq 9 then fostype = 'FOS'+strmid(fragtype,8)
+        if strlen(fragtype) eq 5 then fostype = 'FOS'+strmid(fragtype,4)
       endif 
       if (size(fadtype))[1] eq 7 then fostype = fadtype ;; fadtype used by FAD_MS          
       im2_fostype = fostype & s2len = strlen(im2_fostype)   
@@ -19656,7 +19689,7 @@ CASE strlowCase(eventValue) OF
           ;; should contain the following variables:
           ;; GRAYT_STR, FOSINP, FOSTYPE, FOSCLASS, XDIM, YDIM, GEOTIFF_LOG, RARE, PATCHY, TRANSITIONAL, DOMINANT, INTERIOR, INTACT
           ;; SEPARATED, CONTINUOUS, FAD_AV, FADRU_AV, FGAREA, OBJ_LAST, CONN_STR, PIXRES_STR, KDIM_STR, HEC, ACR.
-          if (size(fragtype))[1] eq 7 then begin ;; fragtype is used by GWB
+          if (size(fragtype))[1] eq 7 then begin ;; fragtype is used by GWB
             ;; non-APP
             fostype = 'FOS'+strmid(fragtype,4)
             fosclass = fragtype + 'class'
@@ -19665,8 +19698,8 @@ CASE strlowCase(eventValue) OF
 ;            if strlen(fragtype) eq 9 then begin
 ;              fostype = 'FOS'+strmid(fragtype,8)
 ;              fosclass = fragtype + 'class'
-;              a_app = 1
-;            endif           
+;              a_app = 1
+;            endif           
           endif                          
           a_xdim=xdim & a_ydim=ydim & a_fostype = fostype & s1len = strlen(a_fostype)
           a_fosclass = fosclass & a_conn = conn_str & a_pres = pixres_str & a_kdim = kdim_str
@@ -19675,16 +19708,16 @@ CASE strlowCase(eventValue) OF
           ;; check if fad_av was saved, if so then use it
           a_tt = (size(fad_av))[1]
           if a_tt eq 4 then a_fad_av = fad_av
-          a2_tt = (size(fadru_av))[1]
-          if a2_tt eq 4 then a_fadru_av = fadru_av
+          a2_tt = (size(fadru_av))[1]
+          if a2_tt eq 4 then a_fadru_av = fadru_av
           
           b_grayt_str = '' & b_fostype = '' & b_app = 0
           restore, b_sav
-          if (size(fragtype))[1] eq 7 then begin ;; fragtype is used by GWB
-            ;; non-APP
-            fostype = 'FOS'+strmid(fragtype,4)
-            fosclass = fragtype + 'class'
-            b_app = 0
+          if (size(fragtype))[1] eq 7 then begin ;; fragtype is used by GWB
+            ;; non-APP
+            fostype = 'FOS'+strmid(fragtype,4)
+            fosclass = fragtype + 'class'
+            b_app = 0
           endif
           b_xdim=xdim & b_ydim=ydim & b_fostype = fostype & s2len = strlen(b_fostype)
           b_fosclass = fosclass & b_conn = conn_str & b_pres = pixres_str & b_kdim = kdim_str  
@@ -19693,20 +19726,20 @@ CASE strlowCase(eventValue) OF
           ;; check if fad_av was saved, if so then use it
           b_tt = (size(fad_av))[1]
           if b_tt eq 4 then b_fad_av = fad_av
-          b2_tt = (size(fadru_av))[1]
-          if b2_tt eq 4 then b_fadru_av = fadru_av
+          b2_tt = (size(fadru_av))[1]
+          if b2_tt eq 4 then b_fadru_av = fadru_av
           fad_avok = a_tt + b_tt
           fadru_avok = a2_tt + b2_tt
           
-          ;; grayscale stuff
-          IF a_grayt_str NE b_grayt_str THEN BEGIN
+          ;; grayscale stuff
+          IF a_grayt_str NE b_grayt_str THEN BEGIN
             msg = 'FOSchange analysis requires comparing maps with the same' + string(10b) + $
-              'grayscale threshold, which is not the case for the selected files:' + string(10b) + $
-              'Image A: ' + a_grayt_str + string(10b) + 'Image B: ' + b_grayt_str + string(10b) + 'Returning...'
-            res = dialog_message(msg, / information)
-            openu, unit, info.log,/append, /Get_lun & printf, unit, systime() + ', ERROR: ' + msg + info.bline & free_lun, unit
-            GOTO, fin
-          ENDIF
+              'grayscale threshold, which is not the case for the selected files:' + string(10b) + $
+              'Image A: ' + a_grayt_str + string(10b) + 'Image B: ' + b_grayt_str + string(10b) + 'Returning...'
+            res = dialog_message(msg, / information)
+            openu, unit, info.log,/append, /Get_lun & printf, unit, systime() + ', ERROR: ' + msg + info.bline & free_lun, unit
+            GOTO, fin
+          ENDIF
     
           res = (a_xdim eq b_xdim) + (a_ydim eq b_ydim) + (strmid(a_conn,0,6) eq strmid(b_conn,0,6)) + (a_pres eq b_pres) + $
             (a_kdim eq b_kdim) + (a_fostype eq b_fostype) + (a_fosclass eq b_fosclass)
@@ -19732,445 +19765,445 @@ CASE strlowCase(eventValue) OF
           ;; FOS image details for A, B
           ;;==============================================================  
           ;; FOSchange map is only useful when NOT doing APP!
-          ;; get topdir of im1_file which will be used to save the results
+          ;; get topdir of im1_file which will be used to save the results
           im1 = read_tiff(fn_a) & im2 = read_tiff(fn_b)
-          ;; test if maps are identical
-          q = where(im1 ne im2, ct, /l64) & q = 0
-          IF ct eq 0 THEN BEGIN
-            msg ='Pixel values of Images A and B are identical.' + string(10b) + 'Returning...'
-            res = dialog_message(msg, / information)
-            openu, unit, info.log,/append, /Get_lun & printf, unit, systime() + ', ERROR: ' + msg + info.bline & free_lun, unit
-            GOTO, fin
+          ;; test if maps are identical
+          q = where(im1 ne im2, ct, /l64) & q = 0
+          IF ct eq 0 THEN BEGIN
+            msg ='Pixel values of Images A and B are identical.' + string(10b) + 'Returning...'
+            res = dialog_message(msg, / information)
+            openu, unit, info.log,/append, /Get_lun & printf, unit, systime() + ', ERROR: ' + msg + info.bline & free_lun, unit
+            GOTO, fin
           ENDIF       
           ;; the frag datasets have values for forest [0, 100], BG [101], 
           ;; missing [102], special BG water [105], non-fragmenting BG [106]
-          q = where(im1 eq 106b, im1_nfBG, /l64) & im1_nfBG = im1_nfBG gt 0
-          q = where(im2 eq 106b, im2_nfBG, /l64) & im2_nfBG = im2_nfBG gt 0
-          IF im1_nfBG ne im2_nfBG THEN BEGIN
-            msg = 'One of the input images has non-fragmenting background pixels.' + string(10b) + $
-              'A FOSchange analysis is only meaningful if either both or none' + string(10b) + $
-              'of the two input images have non-fragmenting background pixels.' + string(10b) + 'Returning...'
-            res = dialog_message(msg, / information)
-            openu, unit, info.log,/append, /Get_lun & printf, unit, systime() + ', ERROR: ' + msg + info.bline & free_lun, unit
-            GOTO, fin
+          q = where(im1 eq 106b, im1_nfBG, /l64) & im1_nfBG = im1_nfBG gt 0
+          q = where(im2 eq 106b, im2_nfBG, /l64) & im2_nfBG = im2_nfBG gt 0
+          IF im1_nfBG ne im2_nfBG THEN BEGIN
+            msg = 'One of the input images has non-fragmenting background pixels.' + string(10b) + $
+              'A FOSchange analysis is only meaningful if either both or none' + string(10b) + $
+              'of the two input images have non-fragmenting background pixels.' + string(10b) + 'Returning...'
+            res = dialog_message(msg, / information)
+            openu, unit, info.log,/append, /Get_lun & printf, unit, systime() + ', ERROR: ' + msg + info.bline & free_lun, unit
+            GOTO, fin
           ENDIF
           
-          ;; data area
-          marea_a = (size(im1))[4] & marea_b = (size(im2))[4]
-          q_missa = where(im1 EQ 102b, miss_a, /l64) & q = where(im2 EQ 102b, miss_b, /l64) & q = 0
-          ;; status of A and B
-          q = histogram(im1,/l64) & rare_a = total(q[0:9],/double) & patchy_a = total(q[10:39],/double) & transitional_a = total(q[40:59],/double)
-          dominant_a = total(q[60:89],/double) & interior_a = total(q[90:99],/double) & intact_a = q[100] & interior5_a = interior_a + intact_a
-          q = histogram(im2,/l64) & rare_b = total(q[0:9],/double) & patchy_b = total(q[10:39],/double) & transitional_b = total(q[40:59],/double)
-          dominant_b = total(q[60:89],/double) & interior_b = total(q[90:99],/double) & intact_b = q[100] & interior5_b = interior_b + intact_b
-          q = 0
-          ;; foreground area
-          farea_a = rare_a + patchy_a + transitional_a + dominant_a + interior5_a
-          farea_b = rare_b + patchy_b + transitional_b + dominant_b + interior5_b
+          ;; data area
+          marea_a = (size(im1))[4] & marea_b = (size(im2))[4]
+          q_missa = where(im1 EQ 102b, miss_a, /l64) & q = where(im2 EQ 102b, miss_b, /l64) & q = 0
+          ;; status of A and B
+          q = histogram(im1,/l64) & rare_a = total(q[0:9],/double) & patchy_a = total(q[10:39],/double) & transitional_a = total(q[40:59],/double)
+          dominant_a = total(q[60:89],/double) & interior_a = total(q[90:99],/double) & intact_a = q[100] & interior5_a = interior_a + intact_a
+          q = histogram(im2,/l64) & rare_b = total(q[0:9],/double) & patchy_b = total(q[10:39],/double) & transitional_b = total(q[40:59],/double)
+          dominant_b = total(q[60:89],/double) & interior_b = total(q[90:99],/double) & intact_b = q[100] & interior5_b = interior_b + intact_b
+          q = 0
+          ;; foreground area
+          farea_a = rare_a + patchy_a + transitional_a + dominant_a + interior5_a
+          farea_b = rare_b + patchy_b + transitional_b + dominant_b + interior5_b
           nc = farea_b - farea_a
           
-          ;; the landcover change matrix for table 3 in the foschange.csv file
-          ;; we need fg,bg, missing on each map
-          lccmat = dblarr(3,3)
-          q = where(im1 lt 101b,/l64,ct) ;; fg
-          if ct gt 0 then begin
-            h=histogram(im2[q],/l64) & lccmat[0,0]=total(h[0:100],/double) & lccmat[1,0] = double(h[101])+h[105]+h[106]
-            lccmat[2,0] = double(h[102])
-          endif
-          q = 0
-          q = where(im1 gt 100b and im1 NE 102b,/l64,ct) ;; bg
-          if ct gt 0 then begin
-            h=histogram(im2[q],/l64) & lccmat[0,1]=total(h[0:100],/double) & lccmat[1,1] = double(h[101])+h[105]+h[106]
-            lccmat[2,1] = double(h[102])
-          endif
-          q = 0
-          if miss_a gt 0 then begin ;; missing
-            h = histogram(im2[q_missa],/l64) & lccmat[0,2]=total(h[0:100],/double) & lccmat[1,2] = double(h[101])+h[105]+h[106]
-            lccmat[2,2] = double(h[102])
-          endif
-          q_missa = 0
+          ;; the landcover change matrix for table 3 in the foschange.csv file
+          ;; we need fg,bg, missing on each map
+          lccmat = dblarr(3,3)
+          q = where(im1 lt 101b,/l64,ct) ;; fg
+          if ct gt 0 then begin
+            h=histogram(im2[q],/l64) & lccmat[0,0]=total(h[0:100],/double) & lccmat[1,0] = double(h[101])+h[105]+h[106]
+            lccmat[2,0] = double(h[102])
+          endif
+          q = 0
+          q = where(im1 gt 100b and im1 NE 102b,/l64,ct) ;; bg
+          if ct gt 0 then begin
+            h=histogram(im2[q],/l64) & lccmat[0,1]=total(h[0:100],/double) & lccmat[1,1] = double(h[101])+h[105]+h[106]
+            lccmat[2,1] = double(h[102])
+          endif
+          q = 0
+          if miss_a gt 0 then begin ;; missing
+            h = histogram(im2[q_missa],/l64) & lccmat[0,2]=total(h[0:100],/double) & lccmat[1,2] = double(h[101])+h[105]+h[106]
+            lccmat[2,2] = double(h[102])
+          endif
+          q_missa = 0
        
-          ;; color assignment idea: 3 categories of increase/decrease for year_a - year_b
-          ;; note FAD ~ connectivity, which is contrary direction to fragmentation
-          ;; example: FAD in year_a 20% and year_b 15%. year_a - year_b = +5 %, meaning fragmentation has increased by 5%
-          ;; to keep all as a byte array, to keep the file size small and permits using a pseudo colortable, we use an offset of 100b, which is indicative for no change
-          ;; then:
-          ;; [99, 101]: +/- 1% no/insignificant change {240,240,200}
-          ;; [90, 98], [102, 110]: LE 10% little change: {130,210,170} and {255,215,100}
-          ;; [80, 89], [111, 120]: GT 10% medium change: {90,170,130} and {255,150,40}
-          ;; [LT 80], [GT 120]: GT 20% strong change: {60,130,90} and {205,75,0}
-          ;; 250b: forest gain: (BG) 101 -> [0, 100] {0,255,0} bright green
-          ;; 251b: forest loss: [0, 100] -> 101 (BG) {0,0,0} black
-          ;; 252b: BG stable: 101 AND 101 {225,225,225} grey
-          ;; 253b: water: 105 OR 105, overplot {0,99,254} blue
-          ;; 254b: missing: 102 OR 102, overplot {255,255,255} white
-          ;; 255b: outside: 255 OR 255, overplot {255,255,255} white
-
-
-          IF (fostype EQ 'FOS5') OR (fostype EQ 'FOS6') THEN BEGIN
-            ;;===============================================
+          ;; color assignment idea: 3 categories of increase/decrease for year_a - year_b
+          ;; note FAD ~ connectivity, which is contrary direction to fragmentation
+          ;; example: FAD in year_a 20% and year_b 15%. year_a - year_b = +5 %, meaning fragmentation has increased by 5%
+          ;; to keep all as a byte array, to keep the file size small and permits using a pseudo colortable, we use an offset of 100b, which is indicative for no change
+          ;; then:
+          ;; [99, 101]: +/- 1% no/insignificant change {240,240,200}
+          ;; [90, 98], [102, 110]: LE 10% little change: {130,210,170} and {255,215,100}
+          ;; [80, 89], [111, 120]: GT 10% medium change: {90,170,130} and {255,150,40}
+          ;; [LT 80], [GT 120]: GT 20% strong change: {60,130,90} and {205,75,0}
+          ;; 250b: forest gain: (BG) 101 -> [0, 100] {0,255,0} bright green
+          ;; 251b: forest loss: [0, 100] -> 101 (BG) {0,0,0} black
+          ;; 252b: BG stable: 101 AND 101 {225,225,225} grey
+          ;; 253b: water: 105 OR 105, overplot {0,99,254} blue
+          ;; 254b: missing: 102 OR 102, overplot {255,255,255} white
+          ;; 255b: outside: 255 OR 255, overplot {255,255,255} white
+
+
+          IF (fostype EQ 'FOS5') OR (fostype EQ 'FOS6') THEN BEGIN
+            ;;===============================================
             ;; a) the FOSchange (delta FOS) difference map
-            ;;===============================================
-            im = (im1 + 100b) - im2
-            ;; now overplot all other types of forest-nonforest interactions
-            ;; 250: gain - from nonforest to forest
-            x = (im1 EQ 101b) * (im2 LE 100b) & im = (x EQ 1b)*250b + (x EQ 0b)*temporary(im)
-            ;; 251:loss - from forest to nonforest
-            x = (im1 LE 100b) * (im2 EQ 101b) & im = (x EQ 1b)*251b + (x EQ 0b)*temporary(im)
-            ;; 252: background at both times
-            x = (im1 EQ 101b) * (im2 EQ 101b) & im = (x EQ 1b)*252b + (x EQ 0b)*temporary(im)
-            ;; 253: special BG / water at either time
-            x = (im1 EQ 105b) OR (im2 EQ 105b) & im = (x EQ 1b)*253b + (x EQ 0b)*temporary(im)
-            ;; 254: Missing at either time
-            x = (im1 EQ 102b) OR (im2 EQ 102b) & im = (x EQ 1b)*254b + (x EQ 0b)*temporary(im)
-
-            restore, info.dir_guidossub + 'foschangecolors.sav' & tvlct, r, g, b
-            info.ctbl = - 1 & info.autostretch_id = 0 & info.disp_colors_id = 18 ;; foschangecolors
+            ;;===============================================
+            im = (im1 + 100b) - im2
+            ;; now overplot all other types of forest-nonforest interactions
+            ;; 250: gain - from nonforest to forest
+            x = (im1 EQ 101b) * (im2 LE 100b) & im = (x EQ 1b)*250b + (x EQ 0b)*temporary(im)
+            ;; 251:loss - from forest to nonforest
+            x = (im1 LE 100b) * (im2 EQ 101b) & im = (x EQ 1b)*251b + (x EQ 0b)*temporary(im)
+            ;; 252: background at both times
+            x = (im1 EQ 101b) * (im2 EQ 101b) & im = (x EQ 1b)*252b + (x EQ 0b)*temporary(im)
+            ;; 253: special BG / water at either time
+            x = (im1 EQ 105b) OR (im2 EQ 105b) & im = (x EQ 1b)*253b + (x EQ 0b)*temporary(im)
+            ;; 254: Missing at either time
+            x = (im1 EQ 102b) OR (im2 EQ 102b) & im = (x EQ 1b)*254b + (x EQ 0b)*temporary(im)
+
+            restore, info.dir_guidossub + 'foschangecolors.sav' & tvlct, r, g, b
+            info.ctbl = - 1 & info.autostretch_id = 0 & info.disp_colors_id = 18 ;; foschangecolors
             diffsim = temporary(im) & mev = 1 ;; enable motion events for foschange
             outdir = info.dir_tmp ;; write here to later save map and stats  
-            title = 'FOSchange'
+            title = 'FOSchange'
             info.title = title    
             
-            ;;===============================================
+            ;;===============================================
             ;; b) the foschange_colors.csv: show unique pixel values/colors of the map 
-            ;;===============================================
-            h = histogram(diffsim,/l64) & marea = (size(diffsim))[4]
-            h_rev = h & h_rev[0:200] = reverse(h[0:200])
-
-            ss = replicate('High decrease (red)',256) & ss[80:89] = 'Medium decrease (orange)'
-            ss[90:98] = 'Low decrease (yellow)' & ss[99:101] = 'Insignificant or no change (light gray)'
-            ss[102:110] = 'Low increase (light green)' & ss[111:120] = 'Medium increase (medium green)'
-            ss[121:200] = 'High increase (dark green)' & ss[201:249] = ' '
-            ss[250:*] = ['Foreground gain (BG->FG bright green)','Foreground loss (FG->BG black)','BG stable (BG->BG gray)',$
-              'Water at one/both time(s) (blue)','Missing at one/both time(s) (white)','Outside at one/both time(s) (white)']
-            ;; the delta value
-            ss2 = strtrim(indgen(256) - 100,2) & ss2[201:*] = ''
-
-            ;; the names in the _colors.csv
-            ss3 = replicate('High decrease',256) & ss3[80:89] = 'Medium decrease'
-            ss3[90:98] = 'Low decrease' & ss3[99:101] = 'Insignificant or no change'
-            ss3[102:110] = 'Low increase' & ss3[111:120] = 'Medium increase'
-            ss3[121:200] = 'High increase' & ss3[201:249] = ' '
-            ss3[250:*] = ['Foreground gain (BG->FG)','Foreground loss (FG->BG)','BG stable (BG->BG)',$
-              'Water at one/both time(s)','Missing at one/both time(s)','Outside at one/both time(s)']
-
-            ;; the colors in the _colors.csv
-            ss4 = replicate('RED',256) & ss4[80:89] = 'ORANGE' & ss4[90:98] = 'YELLOW' & ss4[99:101] = 'LIGHTGRAY'
-            ss4[102:110] = 'LIGHTGREEN' & ss4[111:120] = 'MEDIUMGREEN' & ss4[121:200] = 'DARKGREEN' & ss4[250] = 'BRIGHTGREEN'
-            ss4[251] = 'BLACK' & ss4[252] = 'GRAY' & ss4[253] = 'BLUE' & ss4[254:255] = 'WHITE'
-
-            if strlen(fosclass) eq 10 then method = strmid(fosclass,0,3) else method = strmid(fosclass,0,7)
-            f_out = outdir + 'FOSchange_colors.csv'
-            close,1 & openw,1, f_out
-            printf,1, 'PIXELVALUE,DELTA' + method + ',DESCRIPTION,COLOR,RGB'
-
-            ;; show only existing change entries of the histogram in [0, 200]
-            for i = 200, 0, -1 do begin
-              if h_rev[i] GT 0 then printf, 1, strtrim(200-i,2) + ',' + ss2[i] + ',' + ss3[i] +',' + ss4[i] + ',' + $
-                strtrim(fix(r[200-i]),2)+'/'+strtrim(fix(g[200-i]),2)+'/'+strtrim(fix(b[200-i]),2)
-            endfor
-            ;; skip the empty histogram entries, usually [201, 249] but if there are wrong ones then show them anyway
-            for i = 201, 255 do begin
-              if h_rev[i] gt 0 then printf, 1, strtrim(i,2) + ', ,' + ss3[i] + ',' + ss4[i] + ',' + $
-                strtrim(fix(r[i]),2)+'/'+strtrim(fix(g[i]),2)+'/'+strtrim(fix(b[i]),2)
-            endfor
-            close, 1
+            ;;===============================================
+            h = histogram(diffsim,/l64) & marea = (size(diffsim))[4]
+            h_rev = h & h_rev[0:200] = reverse(h[0:200])
+
+            ss = replicate('High decrease (red)',256) & ss[80:89] = 'Medium decrease (orange)'
+            ss[90:98] = 'Low decrease (yellow)' & ss[99:101] = 'Insignificant or no change (light gray)'
+            ss[102:110] = 'Low increase (light green)' & ss[111:120] = 'Medium increase (medium green)'
+            ss[121:200] = 'High increase (dark green)' & ss[201:249] = ' '
+            ss[250:*] = ['Foreground gain (BG->FG bright green)','Foreground loss (FG->BG black)','BG stable (BG->BG gray)',$
+              'Water at one/both time(s) (blue)','Missing at one/both time(s) (white)','Outside at one/both time(s) (white)']
+            ;; the delta value
+            ss2 = strtrim(indgen(256) - 100,2) & ss2[201:*] = ''
+
+            ;; the names in the _colors.csv
+            ss3 = replicate('High decrease',256) & ss3[80:89] = 'Medium decrease'
+            ss3[90:98] = 'Low decrease' & ss3[99:101] = 'Insignificant or no change'
+            ss3[102:110] = 'Low increase' & ss3[111:120] = 'Medium increase'
+            ss3[121:200] = 'High increase' & ss3[201:249] = ' '
+            ss3[250:*] = ['Foreground gain (BG->FG)','Foreground loss (FG->BG)','BG stable (BG->BG)',$
+              'Water at one/both time(s)','Missing at one/both time(s)','Outside at one/both time(s)']
+
+            ;; the colors in the _colors.csv
+            ss4 = replicate('RED',256) & ss4[80:89] = 'ORANGE' & ss4[90:98] = 'YELLOW' & ss4[99:101] = 'LIGHTGRAY'
+            ss4[102:110] = 'LIGHTGREEN' & ss4[111:120] = 'MEDIUMGREEN' & ss4[121:200] = 'DARKGREEN' & ss4[250] = 'BRIGHTGREEN'
+            ss4[251] = 'BLACK' & ss4[252] = 'GRAY' & ss4[253] = 'BLUE' & ss4[254:255] = 'WHITE'
+
+            if strlen(fosclass) eq 10 then method = strmid(fosclass,0,3) else method = strmid(fosclass,0,7)
+            f_out = outdir + 'FOSchange_colors.csv'
+            close,1 & openw,1, f_out
+            printf,1, 'PIXELVALUE,DELTA' + method + ',DESCRIPTION,COLOR,RGB'
+
+            ;; show only existing change entries of the histogram in [0, 200]
+            for i = 200, 0, -1 do begin
+              if h_rev[i] GT 0 then printf, 1, strtrim(200-i,2) + ',' + ss2[i] + ',' + ss3[i] +',' + ss4[i] + ',' + $
+                strtrim(fix(r[200-i]),2)+'/'+strtrim(fix(g[200-i]),2)+'/'+strtrim(fix(b[200-i]),2)
+            endfor
+            ;; skip the empty histogram entries, usually [201, 249] but if there are wrong ones then show them anyway
+            for i = 201, 255 do begin
+              if h_rev[i] gt 0 then printf, 1, strtrim(i,2) + ', ,' + ss3[i] + ',' + ss4[i] + ',' + $
+                strtrim(fix(r[i]),2)+'/'+strtrim(fix(g[i]),2)+'/'+strtrim(fix(b[i]),2)
+            endfor
+            close, 1
 
             ;;===============================================
-            ;; c) foschange_hist.csv: show full change histogram values/colors
-            ;;===============================================
-            ch_pref = 'fos-' + strlowcase(fosclass)+ '_' + a_kdim
+            ;; c) foschange_hist.csv: show full change histogram values/colors
+            ;;===============================================
+            ch_pref = 'fos-' + strlowcase(fosclass)+ '_' + a_kdim
             f_out = outdir +'FOSchange_hist.csv'
-            close, 1 & openw, 1, f_out
-            printf,1,'HISTOGRAM INDEX,PIXEL VALUE,DELTA' + method + ',FREQUENCY,CONNECTIVITY,COLOR,RGB'
-            ;; show the full change entries of the histogram in [0, 200]
-            for i = 0, 200 do printf, 1, strtrim(i,2) + ',' + strtrim(200-i,2)+ ',' + ss2[i] + ',' + strtrim(h_rev[i],2) + ',' +$
-              ss3[i] +',' + ss4[i] + ',' + strtrim(fix(r[200-i]),2)+'/'+strtrim(fix(g[200-i]),2)+'/'+strtrim(fix(b[200-i]),2)
+            close, 1 & openw, 1, f_out
+            printf,1,'HISTOGRAM INDEX,PIXEL VALUE,DELTA' + method + ',FREQUENCY,CONNECTIVITY,COLOR,RGB'
+            ;; show the full change entries of the histogram in [0, 200]
+            for i = 0, 200 do printf, 1, strtrim(i,2) + ',' + strtrim(200-i,2)+ ',' + ss2[i] + ',' + strtrim(h_rev[i],2) + ',' +$
+              ss3[i] +',' + ss4[i] + ',' + strtrim(fix(r[200-i]),2)+'/'+strtrim(fix(g[200-i]),2)+'/'+strtrim(fix(b[200-i]),2)
             close, 1
             
-            ;; calculate 7-class statistical summary for output 2d later on
-            x = indgen(201)-100 & y = h[0:200]
-            ;; forcom = forest area at both times, which is subject to fragmentation change
-            ;; equivalent to area under the histogram curve
-            forcom = total(y,/double)
-            dec3 = total(y[0:79],/double) & dec3n = dec3/forcom * 100.0 & if finite(dec3n) eq 0b then dec3n = 'NaN'
-            dec2 = total(y[80:89],/double) & dec2n = dec2/forcom * 100.0 & if finite(dec2n) eq 0b then dec2n = 'NaN'
-            dec1 = total(y[90:98],/double) & dec1n = dec1/forcom * 100.0 & if finite(dec1n) eq 0b then dec1n = 'NaN'
-            neu = total(y[99:101],/double) & neun = neu/forcom * 100.0 & if finite(neun) eq 0b then neun = 'NaN'
-            inc1 = total(y[102:110],/double) & inc1n = inc1/forcom * 100.0 & if finite(inc1n) eq 0b then inc1n = 'NaN'
-            inc2 = total(y[111:120],/double) & inc2n = inc2/forcom * 100.0 & if finite(inc2n) eq 0b then inc2n = 'NaN'
+            ;; calculate 7-class statistical summary for output 2d later on
+            x = indgen(201)-100 & y = h[0:200]
+            ;; forcom = forest area at both times, which is subject to fragmentation change
+            ;; equivalent to area under the histogram curve
+            forcom = total(y,/double)
+            dec3 = total(y[0:79],/double) & dec3n = dec3/forcom * 100.0 & if finite(dec3n) eq 0b then dec3n = 'NaN'
+            dec2 = total(y[80:89],/double) & dec2n = dec2/forcom * 100.0 & if finite(dec2n) eq 0b then dec2n = 'NaN'
+            dec1 = total(y[90:98],/double) & dec1n = dec1/forcom * 100.0 & if finite(dec1n) eq 0b then dec1n = 'NaN'
+            neu = total(y[99:101],/double) & neun = neu/forcom * 100.0 & if finite(neun) eq 0b then neun = 'NaN'
+            inc1 = total(y[102:110],/double) & inc1n = inc1/forcom * 100.0 & if finite(inc1n) eq 0b then inc1n = 'NaN'
+            inc2 = total(y[111:120],/double) & inc2n = inc2/forcom * 100.0 & if finite(inc2n) eq 0b then inc2n = 'NaN'
             inc3 = total(y[121:*],/double) & inc3n = inc3/forcom * 100.0 & if finite(inc3n) eq 0b then inc3n = 'NaN'
             
-            ;;==============================================================================
-            ;; do the foschange barplot
-            ;;==============================================================================
-            y100 = y[100] & y[100] = 0 & forcomc = total(y,/double)
-            xrg = 101 & wdt = 1.0 & y = h[0:200]
-            if total(y[50:150])/forcomc gt 0.97 then xrg=51 ; was 51, 41 , etc
-            if total(y[60:140])/forcomc gt 0.97 then xrg=41
-            if total(y[70:130])/forcomc gt 0.97 then xrg=31
-            if total(y[80:120])/forcomc gt 0.97 then xrg=21
-            if total(y[90:110])/forcomc gt 0.97 then xrg=11
-
-            y = h_rev[0:200]/forcom*100.0  ;; convert to %
-            ymax = max(y)*1.05 & if ymax lt 1.0 then ymax = 1.05
-            tit = 'FOSchange'
-
-            b0 = barplot(x[99:101], y[99:101], xrange = [-xrg,xrg], yrange = [0, ymax], xticklen=0.02, yticklen=0.02, $
-              title = tit, width=wdt, histogram = 0, ytitle = 'Frequency [%]', /buffer,thick=0, font_size=10, $
-              xtitle = '<- connectivity decrease [% points] | connectivity increase [% points] ->', fill_color = [240,240,200])
-            b0 = barplot(x[90:98], y[90:98], width=wdt, histogram = 0, fill_color = [255,215,100],thick=0, /overplot) ;; small increase
-            b0 = barplot(x[80:89], y[80:89],width=wdt, histogram = 0, fill_color = [255,150,40],thick=0, /overplot) ;; medium increase
-            b0 = barplot(x[0:79], y[0:79],width=wdt, histogram = 0, fill_color = [205,75,0],thick=0, /overplot) ;; strong increase
-            b0 = barplot(x[102:110], y[102:110], width=wdt, histogram = 0, fill_color = [130,210,170],thick=0, /overplot) ;; small decrease
-            b0 = barplot(x[111:120], y[111:120], width=wdt, histogram = 0, fill_color = [90,170,130],thick=0, /overplot) ;; medium decrease
-            b0 = barplot(x[121:200], y[121:200], width=wdt, histogram = 0, fill_color = [60,130,90],thick=0, /overplot) ;; strong decrease
-            ;; save and open barplot image
-            b0.save, outdir + 'FOSchange.png', resolution=300
-
-
-            IF info.my_os EQ 'darwin' OR info.my_os EQ 'apple' THEN BEGIN
-              spawn, 'open ' + outdir + 'FOSchange.png'
-            ENDIF ELSE IF info.my_os EQ 'windows' THEN BEGIN
-              pushd, info.dir_tmp
-              spawn, 'start ' + outdir + 'FOSchange.png', / nowait
-              popd
-            ENDIF ELSE BEGIN ;; Linux
-              IF strlen(info.xdgop) EQ 0 THEN BEGIN
-                st = "Please install xdg-open to automatically" + $
-                  "display barplots within GTB."
-                result = dialog_message(st, / information)
-              ENDIF ELSE BEGIN
-                spawn, info.xdgop + ' ' + outdir + 'FOSchange.png'
-              ENDELSE
-            ENDELSE
+            ;;==============================================================================
+            ;; do the foschange barplot
+            ;;==============================================================================
+            y100 = y[100] & y[100] = 0 & forcomc = total(y,/double)
+            xrg = 101 & wdt = 1.0 & y = h[0:200]
+            if total(y[50:150])/forcomc gt 0.97 then xrg=51 ; was 51, 41 , etc
+            if total(y[60:140])/forcomc gt 0.97 then xrg=41
+            if total(y[70:130])/forcomc gt 0.97 then xrg=31
+            if total(y[80:120])/forcomc gt 0.97 then xrg=21
+            if total(y[90:110])/forcomc gt 0.97 then xrg=11
+
+            y = h_rev[0:200]/forcom*100.0  ;; convert to %
+            ymax = max(y)*1.05 & if ymax lt 1.0 then ymax = 1.05
+            tit = 'FOSchange'
+
+            b0 = barplot(x[99:101], y[99:101], xrange = [-xrg,xrg], yrange = [0, ymax], xticklen=0.02, yticklen=0.02, $
+              title = tit, width=wdt, histogram = 0, ytitle = 'Frequency [%]', /buffer,thick=0, font_size=10, $
+              xtitle = '<- connectivity decrease [% points] | connectivity increase [% points] ->', fill_color = [240,240,200])
+            b0 = barplot(x[90:98], y[90:98], width=wdt, histogram = 0, fill_color = [255,215,100],thick=0, /overplot) ;; small increase
+            b0 = barplot(x[80:89], y[80:89],width=wdt, histogram = 0, fill_color = [255,150,40],thick=0, /overplot) ;; medium increase
+            b0 = barplot(x[0:79], y[0:79],width=wdt, histogram = 0, fill_color = [205,75,0],thick=0, /overplot) ;; strong increase
+            b0 = barplot(x[102:110], y[102:110], width=wdt, histogram = 0, fill_color = [130,210,170],thick=0, /overplot) ;; small decrease
+            b0 = barplot(x[111:120], y[111:120], width=wdt, histogram = 0, fill_color = [90,170,130],thick=0, /overplot) ;; medium decrease
+            b0 = barplot(x[121:200], y[121:200], width=wdt, histogram = 0, fill_color = [60,130,90],thick=0, /overplot) ;; strong decrease
+            ;; save and open barplot image
+            b0.save, outdir + 'FOSchange.png', resolution=300
+
+
+            IF info.my_os EQ 'darwin' OR info.my_os EQ 'apple' THEN BEGIN
+              spawn, 'open ' + outdir + 'FOSchange.png'
+            ENDIF ELSE IF info.my_os EQ 'windows' THEN BEGIN
+              pushd, info.dir_tmp
+              spawn, 'start ' + outdir + 'FOSchange.png', / nowait
+              popd
+            ENDIF ELSE BEGIN ;; Linux
+              IF strlen(info.xdgop) EQ 0 THEN BEGIN
+                st = "Please install xdg-open to automatically" + $
+                  "display barplots within GTB."
+                result = dialog_message(st, / information)
+              ENDIF ELSE BEGIN
+                spawn, info.xdgop + ' ' + outdir + 'FOSchange.png'
+              ENDELSE
+            ENDELSE
 
          
-            ;;==============================================================================
-            ;; 2d) do the foschange matrix
-            ;;==============================================================================
-            ;; exclude missing data from both maps, temporarily set them to 150b
-            q = where(im1 eq 102b or im2 eq 102b, ctmiss, /l64)
-            if ctmiss gt 0 then begin
-              im1[q]=150b & im2[q]=150b
-            endif
-            q = 0
-            ;; collapse all background types in im1 and im2, temporarily set them to 110b
-            q = where(im2 gt 100b and im2 lt 150b, ct, /l64) & if ct gt 0 then im2[q]=110b
-            q = where(im1 gt 100b and im1 lt 150b, ct, /l64) & if ct gt 0 then im1[q]=110b ;; q are the GB-pixels locations in im1
-
-            if fostype eq 'FOS5' then begin
-              change = dblarr(6, 6) & change0 = change & ch = change0 ; reset change vector
-              ;; get pixels of each class type in im1 and look what they changed to in im2
-              if ct gt 0 then begin ;; im1 has BG-pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
-                change[*,0] = ch
-              endif
-              ch = ch*0 & q = where(im1 lt 10b, ct, /l64)
-              if ct gt 0 then begin ;; im1 has rare pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
-                change[*,1] = ch
-              endif
-              ch = ch*0 & q = where(im1 ge 10b and im1 le 39b, ct, /l64)
-              if ct gt 0 then begin ;; im1 has patchy pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
-                change[*,2] = ch
-              endif
-              ch = ch*0 & q = where(im1 ge 40b and im1 le 59b, ct, /l64)
-              if ct gt 0 then begin ;; im1 has transitional pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
-                change[*,3] = ch
-              endif
-              ch = ch*0 & q = where(im1 ge 60b and im1 le 89b, ct, /l64)
-              if ct gt 0 then begin ;; im1 has dominant pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
-                change[*,4] = ch
-              endif
-              ch = ch*0 & q = where(im1 ge 90b and im1 le 100b, ct, /l64)
-              if ct gt 0 then begin ;; im1 has interior pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
-                change[*,5] = ch
-              endif
-            endif else begin  ;; FOS 6-class
-              change = dblarr(7, 7) & change0 = change & ch = change0 ; reset change vector
-              ;; get pixels of each class type in im1 and look what they changed to in im2
-              if ct gt 0 then begin ;; im1 has BG-pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
-                change[*,0] = ch
-              endif
-              ch = ch*0 & q = where(im1 lt 10b, ct, /l64)
-              if ct gt 0 then begin ;; im1 has rare pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
-                change[*,1] = ch
-              endif
-              ch = ch*0 & q = where(im1 ge 10b and im1 le 39b, ct, /l64)
-              if ct gt 0 then begin ;; im1 has patchy pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
-                change[*,2] = ch
-              endif
-              ch = ch*0 & q = where(im1 ge 40b and im1 le 59b, ct, /l64)
-              if ct gt 0 then begin ;; im1 has transitional pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
-                change[*,3] = ch
-              endif
-              ch = ch*0 & q = where(im1 ge 60b and im1 le 89b, ct, /l64)
-              if ct gt 0 then begin ;; im1 has dominant pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
-                change[*,4] = ch
-              endif
-              ch = ch*0 & q = where(im1 ge 90b and im1 lt 100b, ct, /l64)
-              if ct gt 0 then begin ;; im1 has interior pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
-                change[*,5] = ch
-              endif
-              ch = ch*0 & q = where(im1 eq 100b, ct, /l64)
-              if ct gt 0 then begin ;; im1 has 100-intact pixels
-                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
-                change[*,6] = ch
-              endif
-            endelse
-            q = 0
-
-            ;; calculate percentage of change in the sub-matrix of change
-            mch = change[1:*,1:*]
-            ;; null diagonal
-            diag = 0
-            if fostype eq 'FOS6' then nft = 5 else nft = 4
-            for ix = 0,nft do begin
-              for iy = 0,nft do begin
-                if ix eq iy then begin
-                  diag = diag + mch[ix,iy]
-                  mch[ix,iy] = 0
-                endif
-              endfor
-            endfor
-            chpix = total(mch)
-            perc = mch/chpix*100
-
-            ;; sum of percentage with connectivity increase = above matrix diagonal
-            sum_above = total(perc[0:*,0],/double) + total(perc[1:*,1],/double) + total(perc[2:*,2],/double) + total(perc[3:*,3],/double)
-            if fostype eq 'FOS6' then sum_above = sum_above + total(perc[4:*,4],/double)
-            ;; sum of percentage with connectivity decrease = below matrix diagonal
-            sum_below = total(perc,/double) - sum_above
-
-            uchange = strtrim(ulong64(change),2)
+            ;;==============================================================================
+            ;; 2d) do the foschange matrix
+            ;;==============================================================================
+            ;; exclude missing data from both maps, temporarily set them to 150b
+            q = where(im1 eq 102b or im2 eq 102b, ctmiss, /l64)
+            if ctmiss gt 0 then begin
+              im1[q]=150b & im2[q]=150b
+            endif
+            q = 0
+            ;; collapse all background types in im1 and im2, temporarily set them to 110b
+            q = where(im2 gt 100b and im2 lt 150b, ct, /l64) & if ct gt 0 then im2[q]=110b
+            q = where(im1 gt 100b and im1 lt 150b, ct, /l64) & if ct gt 0 then im1[q]=110b ;; q are the GB-pixels locations in im1
+
+            if fostype eq 'FOS5' then begin
+              change = dblarr(6, 6) & change0 = change & ch = change0 ; reset change vector
+              ;; get pixels of each class type in im1 and look what they changed to in im2
+              if ct gt 0 then begin ;; im1 has BG-pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
+                change[*,0] = ch
+              endif
+              ch = ch*0 & q = where(im1 lt 10b, ct, /l64)
+              if ct gt 0 then begin ;; im1 has rare pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
+                change[*,1] = ch
+              endif
+              ch = ch*0 & q = where(im1 ge 10b and im1 le 39b, ct, /l64)
+              if ct gt 0 then begin ;; im1 has patchy pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
+                change[*,2] = ch
+              endif
+              ch = ch*0 & q = where(im1 ge 40b and im1 le 59b, ct, /l64)
+              if ct gt 0 then begin ;; im1 has transitional pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
+                change[*,3] = ch
+              endif
+              ch = ch*0 & q = where(im1 ge 60b and im1 le 89b, ct, /l64)
+              if ct gt 0 then begin ;; im1 has dominant pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
+                change[*,4] = ch
+              endif
+              ch = ch*0 & q = where(im1 ge 90b and im1 le 100b, ct, /l64)
+              if ct gt 0 then begin ;; im1 has interior pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:100])]
+                change[*,5] = ch
+              endif
+            endif else begin  ;; FOS 6-class
+              change = dblarr(7, 7) & change0 = change & ch = change0 ; reset change vector
+              ;; get pixels of each class type in im1 and look what they changed to in im2
+              if ct gt 0 then begin ;; im1 has BG-pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
+                change[*,0] = ch
+              endif
+              ch = ch*0 & q = where(im1 lt 10b, ct, /l64)
+              if ct gt 0 then begin ;; im1 has rare pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
+                change[*,1] = ch
+              endif
+              ch = ch*0 & q = where(im1 ge 10b and im1 le 39b, ct, /l64)
+              if ct gt 0 then begin ;; im1 has patchy pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
+                change[*,2] = ch
+              endif
+              ch = ch*0 & q = where(im1 ge 40b and im1 le 59b, ct, /l64)
+              if ct gt 0 then begin ;; im1 has transitional pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
+                change[*,3] = ch
+              endif
+              ch = ch*0 & q = where(im1 ge 60b and im1 le 89b, ct, /l64)
+              if ct gt 0 then begin ;; im1 has dominant pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
+                change[*,4] = ch
+              endif
+              ch = ch*0 & q = where(im1 ge 90b and im1 lt 100b, ct, /l64)
+              if ct gt 0 then begin ;; im1 has interior pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
+                change[*,5] = ch
+              endif
+              ch = ch*0 & q = where(im1 eq 100b, ct, /l64)
+              if ct gt 0 then begin ;; im1 has 100-intact pixels
+                h=histogram(im2[q]) & ch = [h[110],total(h[0:9]),total(h[10:39]),total(h[40:59]),total(h[60:89]),total(h[90:99]),h[100]]
+                change[*,6] = ch
+              endif
+            endelse
+            q = 0
+
+            ;; calculate percentage of change in the sub-matrix of change
+            mch = change[1:*,1:*]
+            ;; null diagonal
+            diag = 0
+            if fostype eq 'FOS6' then nft = 5 else nft = 4
+            for ix = 0,nft do begin
+              for iy = 0,nft do begin
+                if ix eq iy then begin
+                  diag = diag + mch[ix,iy]
+                  mch[ix,iy] = 0
+                endif
+              endfor
+            endfor
+            chpix = total(mch)
+            perc = mch/chpix*100
+
+            ;; sum of percentage with connectivity increase = above matrix diagonal
+            sum_above = total(perc[0:*,0],/double) + total(perc[1:*,1],/double) + total(perc[2:*,2],/double) + total(perc[3:*,3],/double)
+            if fostype eq 'FOS6' then sum_above = sum_above + total(perc[4:*,4],/double)
+            ;; sum of percentage with connectivity decrease = below matrix diagonal
+            sum_below = total(perc,/double) - sum_above
+
+            uchange = strtrim(ulong64(change),2)
             ch_pref = 'fos-' + strlowcase(fosclass)+ '_' + a_kdim
             
-            ;;=================================================================================================
-            ;; 5) FOSchange.csv: save the tables as a csv-file
-            ;;=================================================================================================
-            z=strtrim(change,2) & areacom = total(change,/double)
+            ;;=================================================================================================
+            ;; 5) FOSchange.csv: save the tables as a csv-file
+            ;;=================================================================================================
+            z=strtrim(change,2) & areacom = total(change,/double)
             f_out = outdir + 'FOSchange.csv'
             
-            ;; test if forcom is defined, else calculate it
-            IF total(size(forcom)) LT 0.1 THEN BEGIN
-              forcom = total((im1 lE 100b)*(im2 LE 100b),/double)
-            ENDIF
-            close,12 & openw,12, f_out
+            ;; test if forcom is defined, else calculate it
+            IF total(size(forcom)) LT 0.1 THEN BEGIN
+              forcom = total((im1 lE 100b)*(im2 LE 100b),/double)
+            ENDIF
+            close,12 & openw,12, f_out
             ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-            printf, 12, '1) General info:'
-            printf,12, 'Change typ: ' + ch_pref + ': change from A -> B'
-            ;; try to write out more user-friendly
-            IF strmid(im1_file,0,6) EQ '$HOME/' THEN im1_file = '/home/'+getenv('USER')+strmid(im1_file,5)
-            IF strmid(im2_file,0,6) EQ '$HOME/' THEN im2_file = '/home/'+getenv('USER')+strmid(im2_file,5)
-            printf,12, 'A: ' + im1_file
-            printf,12, 'B: ' + im2_file
-            printf,12, 'Pixel resolution [m]:,' + pixres_str
-            printf,12, 'Window size:,' + kdim_str + 'x' + kdim_str
-            printf,12, 'Observation scale:,' + strtrim(hec,2) + ' hectares ~ ' + strtrim(acr,2) + ' acres'
-            printf,12, 'Map area [pixels]:,' + strtrim(marea,2)
-            printf,12, ' '
-
+            printf, 12, '1) General info:'
+            printf,12, 'Change typ: ' + ch_pref + ': change from A -> B'
+            ;; try to write out more user-friendly
+            IF strmid(im1_file,0,6) EQ '$HOME/' THEN im1_file = '/home/'+getenv('USER')+strmid(im1_file,5)
+            IF strmid(im2_file,0,6) EQ '$HOME/' THEN im2_file = '/home/'+getenv('USER')+strmid(im2_file,5)
+            printf,12, 'A: ' + im1_file
+            printf,12, 'B: ' + im2_file
+            printf,12, 'Pixel resolution [m]:,' + pixres_str
+            printf,12, 'Window size:,' + kdim_str + 'x' + kdim_str
+            printf,12, 'Observation scale:,' + strtrim(hec,2) + ' hectares ~ ' + strtrim(acr,2) + ' acres'
+            printf,12, 'Map area [pixels]:,' + strtrim(marea,2)
+            printf,12, ' '
+
             ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-            printf,12, '2) Land cover status of A and B'
-            printf,12, 'Land cover,Pixel value,A-Pixels,B-Pixels,A-%,B-%,Net change-Pixels'
-            printf,12, 'Foreground,[0 - 100],' + strtrim(farea_a,2) + ',' + strtrim(farea_b,2) + ',' + $
-              strtrim(farea_a*100.0/marea_a,2) + ',' + strtrim(farea_b*100.0/marea_b,2) + ',' + strtrim(nc,2)
-            bg_a = marea_a - farea_a - miss_a & bg_b = marea_b - farea_b - miss_b
-            printf,12, 'Background,[101 105 106],' + strtrim(bg_a,2) + ',' + strtrim(bg_b,2) + ',' + $
-              strtrim(bg_a*100.0/marea_a,2) + ',' + strtrim(bg_b*100.0/marea_b,2) + ',' + strtrim(bg_b - bg_a,2)
-            printf,12, 'Missing,[102],' + strtrim(miss_a,2) + ',' + strtrim(miss_b,2) + ',' + $
-              strtrim(miss_a*100.0/marea_a,2) + ',' + strtrim(miss_b*100.0/marea_b,2) + ',' + strtrim(miss_b - miss_a,2)
-            printf,12, ' '
-
+            printf,12, '2) Land cover status of A and B'
+            printf,12, 'Land cover,Pixel value,A-Pixels,B-Pixels,A-%,B-%,Net change-Pixels'
+            printf,12, 'Foreground,[0 - 100],' + strtrim(farea_a,2) + ',' + strtrim(farea_b,2) + ',' + $
+              strtrim(farea_a*100.0/marea_a,2) + ',' + strtrim(farea_b*100.0/marea_b,2) + ',' + strtrim(nc,2)
+            bg_a = marea_a - farea_a - miss_a & bg_b = marea_b - farea_b - miss_b
+            printf,12, 'Background,[101 105 106],' + strtrim(bg_a,2) + ',' + strtrim(bg_b,2) + ',' + $
+              strtrim(bg_a*100.0/marea_a,2) + ',' + strtrim(bg_b*100.0/marea_b,2) + ',' + strtrim(bg_b - bg_a,2)
+            printf,12, 'Missing,[102],' + strtrim(miss_a,2) + ',' + strtrim(miss_b,2) + ',' + $
+              strtrim(miss_a*100.0/marea_a,2) + ',' + strtrim(miss_b*100.0/marea_b,2) + ',' + strtrim(miss_b - miss_a,2)
+            printf,12, ' '
+
             ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-            printf,12, '3) Land cover change matrix'
-            printf,12, 'A->B [pixels],B-Foreground,B-Background,B-Missing'
-            printf,12, 'A-Foreground,' + strtrim(lccmat[0,0],2) + ',' + strtrim(lccmat[1,0],2) + ',' + strtrim(lccmat[2,0],2)
-            printf,12, 'A-Background,' + strtrim(lccmat[0,1],2) + ',' + strtrim(lccmat[1,1],2) + ',' + strtrim(lccmat[2,1],2)
-            printf,12, 'A-Missing,'  + strtrim(lccmat[0,2],2) + ',' + strtrim(lccmat[1,2],2) + ',' + strtrim(lccmat[2,2],2)
+            printf,12, '3) Land cover change matrix'
+            printf,12, 'A->B [pixels],B-Foreground,B-Background,B-Missing'
+            printf,12, 'A-Foreground,' + strtrim(lccmat[0,0],2) + ',' + strtrim(lccmat[1,0],2) + ',' + strtrim(lccmat[2,0],2)
+            printf,12, 'A-Background,' + strtrim(lccmat[0,1],2) + ',' + strtrim(lccmat[1,1],2) + ',' + strtrim(lccmat[2,1],2)
+            printf,12, 'A-Missing,'  + strtrim(lccmat[0,2],2) + ',' + strtrim(lccmat[1,2],2) + ',' + strtrim(lccmat[2,2],2)
             printf,12, 'AREACOM - common FG+BG at both times:,' + strtrim(total(lccmat[0:1,0:1]),2)
             printf,12, 'FORCOM - common FG at both times:,' + strtrim(lccmat[0,0],2)
             printf,12, 'FG gain:,' + strtrim(lccmat[0,1],2)
             printf,12, 'FG loss:,' + strtrim(lccmat[1,0],2)
-            printf,12, ' '
-
+            printf,12, ' '
+
             ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-            printf, 12, '4) ' + method + ' status: ' + strmid(fostype,3) + ' classes'
-            printf, 12, method + ',Foreground cover,Connectivity,Fragmentation,A-pixels,B-pixels,A-%,B-%'
-            printf, 12, '[0 9],Rare,Very low,Very high,' + strtrim(rare_a,2) + ',' + strtrim(rare_b,2) + ',' + strtrim(rare_a/farea_a*100.0,2) + ',' + strtrim(rare_b/farea_b*100.0,2)
-            printf, 12, '[10 39],Patchy,Low,High,' + strtrim(patchy_a,2) + ',' + strtrim(patchy_b,2) + ',' + strtrim(patchy_a/farea_a*100.0,2) + ',' + strtrim(patchy_b/farea_b*100.0,2)
-            printf, 12, '[40 59],Transitional,Intermediate,Intermediate,' + strtrim(transitional_a,2) + ',' + strtrim(transitional_b,2) + ',' + strtrim(transitional_a/farea_a*100.0,2) + ',' + strtrim(transitional_b/farea_b*100.0,2)
-            printf, 12, '[60 89],Dominant,High,Low,' + strtrim(dominant_a,2) + ',' + strtrim(dominant_b,2) + ',' + strtrim(dominant_a/farea_a*100.0,2) + ',' + strtrim(dominant_b/farea_b*100.0,2)
-            if fostype eq 'FOS6' then begin
-              printf,12, '[90 99],Interior,Very high,Very low,' + strtrim(interior_a,2) + ',' + strtrim(interior_b,2) + ',' + strtrim(interior_a/farea_a*100.0,2) + ',' + strtrim(interior_b/farea_b*100.0,2)
-              printf,12, '[100],Intact,Intact,None,' + strtrim(intact_a,2) + ',' + strtrim(intact_b,2) + ',' + strtrim(intact_a/farea_a*100.0,2) + ',' + strtrim(intact_b/farea_b*100.0,2)
-            endif else begin
-              printf,12, '[90 100],Interior,Very high,Very low,' + strtrim(interior5_a,2) + ',' + strtrim(interior5_b,2) + ',' + strtrim(interior5_a/farea_a*100.0,2) + ',' + strtrim(interior5_b/farea_b*100.0,2)
-            endelse
-            printf,12, ' '
-            printf, 12, 'Average Connectivity,A,B,Absolute difference,Relative difference'
-            printf, 12, 'AVCON [%],' + strtrim(a_fadru_av,2) + ',' + strtrim(b_fadru_av,2) + ',' + $
-              strtrim(b_fadru_av - a_fadru_av,2) + ',' + strtrim(100.0/a_fadru_av*b_fadru_av-100,2)
-            printf, 12, method + '_AV [%],'+ strtrim(a_fad_av,2) + ',' + strtrim(b_fad_av,2) + ',' + $
-              strtrim(b_fad_av - a_fad_av,2)+ ',' + strtrim(100.0/a_fad_av*b_fad_av-100,2)
-            printf,12, ' '
+            printf, 12, '4) ' + method + ' status: ' + strmid(fostype,3) + ' classes'
+            printf, 12, method + ',Foreground cover,Connectivity,Fragmentation,A-pixels,B-pixels,A-%,B-%'
+            printf, 12, '[0 9],Rare,Very low,Very high,' + strtrim(rare_a,2) + ',' + strtrim(rare_b,2) + ',' + strtrim(rare_a/farea_a*100.0,2) + ',' + strtrim(rare_b/farea_b*100.0,2)
+            printf, 12, '[10 39],Patchy,Low,High,' + strtrim(patchy_a,2) + ',' + strtrim(patchy_b,2) + ',' + strtrim(patchy_a/farea_a*100.0,2) + ',' + strtrim(patchy_b/farea_b*100.0,2)
+            printf, 12, '[40 59],Transitional,Intermediate,Intermediate,' + strtrim(transitional_a,2) + ',' + strtrim(transitional_b,2) + ',' + strtrim(transitional_a/farea_a*100.0,2) + ',' + strtrim(transitional_b/farea_b*100.0,2)
+            printf, 12, '[60 89],Dominant,High,Low,' + strtrim(dominant_a,2) + ',' + strtrim(dominant_b,2) + ',' + strtrim(dominant_a/farea_a*100.0,2) + ',' + strtrim(dominant_b/farea_b*100.0,2)
+            if fostype eq 'FOS6' then begin
+              printf,12, '[90 99],Interior,Very high,Very low,' + strtrim(interior_a,2) + ',' + strtrim(interior_b,2) + ',' + strtrim(interior_a/farea_a*100.0,2) + ',' + strtrim(interior_b/farea_b*100.0,2)
+              printf,12, '[100],Intact,Intact,None,' + strtrim(intact_a,2) + ',' + strtrim(intact_b,2) + ',' + strtrim(intact_a/farea_a*100.0,2) + ',' + strtrim(intact_b/farea_b*100.0,2)
+            endif else begin
+              printf,12, '[90 100],Interior,Very high,Very low,' + strtrim(interior5_a,2) + ',' + strtrim(interior5_b,2) + ',' + strtrim(interior5_a/farea_a*100.0,2) + ',' + strtrim(interior5_b/farea_b*100.0,2)
+            endelse
+            printf,12, ' '
+            printf, 12, 'Average Connectivity,A,B,Absolute difference,Relative difference'
+            printf, 12, 'AVCON [%],' + strtrim(a_fadru_av,2) + ',' + strtrim(b_fadru_av,2) + ',' + $
+              strtrim(b_fadru_av - a_fadru_av,2) + ',' + strtrim(100.0/a_fadru_av*b_fadru_av-100,2)
+            printf, 12, method + '_AV [%],'+ strtrim(a_fad_av,2) + ',' + strtrim(b_fad_av,2) + ',' + $
+              strtrim(b_fad_av - a_fad_av,2)+ ',' + strtrim(100.0/a_fad_av*b_fad_av-100,2)
+            printf,12, ' '
 
             ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-            printf, 12, '5) ' + method + ' change histogram: 7 classes listing the degree in Delta' + method + ' (= ' + method + ' change)'
-            printf, 12, 'Delta' + method + ',Connectivity,Color,Pixels,%'
-            printf, 12, '[-100 -21],High decrease,RED,' + strtrim(inc3,2) + ',' + strtrim(inc3n,2)
-            printf, 12, '[-20  -11],Medium decrease,ORANGE,' + strtrim(inc2,2) + ',' + strtrim(inc2n,2)
-            printf, 12, '[-10 -2],Low decrease,YELLOW,' + strtrim(inc1,2) + ',' + strtrim(inc1n,2)
-            printf, 12, '[-1 +1],Insignificant/No Change,GRAY,' + strtrim(neu,2) + ',' + strtrim(neun,2)
-            printf, 12, '[+2 +10],Low increase,LIGHT GREEN,' + strtrim(dec1,2) + ',' + strtrim(dec1n,2)
-            printf, 12, '[+11 +20],Medium increase,MEDIUM GREEN,' + strtrim(dec2,2) + ',' + strtrim(dec2n,2)
-            printf, 12, '[+21 +100],High increase,DARK GREEN,' + strtrim(dec3,2) + ',' + strtrim(dec3n,2)
-            printf, 12, 'Note: Change histogram is constrained to FORCOM [pixels]:,' + strtrim(forcom,2)
-            printf,12, ' '
+            printf, 12, '5) ' + method + ' change histogram: 7 classes listing the degree in Delta' + method + ' (= ' + method + ' change)'
+            printf, 12, 'Delta' + method + ',Connectivity,Color,Pixels,%'
+            printf, 12, '[-100 -21],High decrease,RED,' + strtrim(inc3,2) + ',' + strtrim(inc3n,2)
+            printf, 12, '[-20  -11],Medium decrease,ORANGE,' + strtrim(inc2,2) + ',' + strtrim(inc2n,2)
+            printf, 12, '[-10 -2],Low decrease,YELLOW,' + strtrim(inc1,2) + ',' + strtrim(inc1n,2)
+            printf, 12, '[-1 +1],Insignificant/No Change,GRAY,' + strtrim(neu,2) + ',' + strtrim(neun,2)
+            printf, 12, '[+2 +10],Low increase,LIGHT GREEN,' + strtrim(dec1,2) + ',' + strtrim(dec1n,2)
+            printf, 12, '[+11 +20],Medium increase,MEDIUM GREEN,' + strtrim(dec2,2) + ',' + strtrim(dec2n,2)
+            printf, 12, '[+21 +100],High increase,DARK GREEN,' + strtrim(dec3,2) + ',' + strtrim(dec3n,2)
+            printf, 12, 'Note: Change histogram is constrained to FORCOM [pixels]:,' + strtrim(forcom,2)
+            printf,12, ' '
 
             ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-            printf,12, '6a) AREACOM ' + method + ' change matrix: ' + strmid(fostype,3) + ' classes listing ' + method + ' status change from A->B'
-            if fostype eq 'FOS6' then begin
-              printf,12, 'A->B [pixels], B0-Background, B1-Rare, B2-Patchy, B3-Transitional, B4-Dominant, B5-Interior, B6-Intact'
-              printf,12, 'A0-Background,  '+z[0,0]+','+z[1,0]+','+z[2,0]+','+z[3,0]+','+z[4,0]+','+z[5,0]+','+z[6,0]
-              printf,12, 'A1-Rare,        '+z[0,1]+','+z[1,1]+','+z[2,1]+','+z[3,1]+','+z[4,1]+','+z[5,1]+','+z[6,1]
-              printf,12, 'A2-Patchy,      '+z[0,2]+','+z[1,2]+','+z[2,2]+','+z[3,2]+','+z[4,2]+','+z[5,2]+','+z[6,2]
-              printf,12, 'A3-Transitional,'+z[0,3]+','+z[1,3]+','+z[2,3]+','+z[3,3]+','+z[4,3]+','+z[5,3]+','+z[6,3]
-              printf,12, 'A4-Dominant,    '+z[0,4]+','+z[1,4]+','+z[2,4]+','+z[3,4]+','+z[4,4]+','+z[5,4]+','+z[6,4]
-              printf,12, 'A5-Interior,    '+z[0,5]+','+z[1,5]+','+z[2,5]+','+z[3,5]+','+z[4,5]+','+z[5,5]+','+z[6,5]
-              printf,12, 'A6-Intact,      '+z[0,6]+','+z[1,6]+','+z[2,6]+','+z[3,6]+','+z[4,6]+','+z[5,6]+','+z[6,6]
-              sum_ab = total(change[1:*,0],/double)+total(change[2:*,1],/double)+total(change[3:*,2],/double)+total(change[4:*,3],/double)+total(change[5:*,4],/double)+change[6,5]
-              sum_be = change[0,1]+total(change[0:1,2],/double)+total(change[0:2,3],/double)+total(change[0:3,4],/double)+total(change[0:4,5],/double)+total(change[0:5,6],/double)
-            endif else begin
-              printf,12, 'A->B [pixels], B0-Background, B1-Rare, B2-Patchy, B3-Transitional, B4-Dominant, B5-Interior'
-              printf,12, 'A0-Background,  '+z[0,0]+','+z[1,0]+','+z[2,0]+','+z[3,0]+','+z[4,0]+','+z[5,0]
-              printf,12, 'A1-Rare,        '+z[0,1]+','+z[1,1]+','+z[2,1]+','+z[3,1]+','+z[4,1]+','+z[5,1]
-              printf,12, 'A2-Patchy,      '+z[0,2]+','+z[1,2]+','+z[2,2]+','+z[3,2]+','+z[4,2]+','+z[5,2]
-              printf,12, 'A3-Transitional,'+z[0,3]+','+z[1,3]+','+z[2,3]+','+z[3,3]+','+z[4,3]+','+z[5,3]
-              printf,12, 'A4-Dominant,    '+z[0,4]+','+z[1,4]+','+z[2,4]+','+z[3,4]+','+z[4,4]+','+z[5,4]
-              printf,12, 'A5-Interior,    '+z[0,5]+','+z[1,5]+','+z[2,5]+','+z[3,5]+','+z[4,5]+','+z[5,5]
-              sum_ab = total(change[1:*,0],/double)+total(change[2:*,1],/double)+total(change[3:*,2],/double)+total(change[4:*,3],/double)+change[5,4]
-              sum_be = change[0,1]+total(change[0:1,2],/double)+total(change[0:2,3],/double)+total(change[0:3,4],/double)+total(change[0:4,5],/double)
-            endelse
-            printf,12, 'AREACOM change matrix [pixels]:,' + strtrim(areacom,2)
-            printf,12, 'Same status class - matrix diagonal [pixels]:,' + strtrim(diag+change[0,0],2)
+            printf,12, '6a) AREACOM ' + method + ' change matrix: ' + strmid(fostype,3) + ' classes listing ' + method + ' status change from A->B'
+            if fostype eq 'FOS6' then begin
+              printf,12, 'A->B [pixels], B0-Background, B1-Rare, B2-Patchy, B3-Transitional, B4-Dominant, B5-Interior, B6-Intact'
+              printf,12, 'A0-Background,  '+z[0,0]+','+z[1,0]+','+z[2,0]+','+z[3,0]+','+z[4,0]+','+z[5,0]+','+z[6,0]
+              printf,12, 'A1-Rare,        '+z[0,1]+','+z[1,1]+','+z[2,1]+','+z[3,1]+','+z[4,1]+','+z[5,1]+','+z[6,1]
+              printf,12, 'A2-Patchy,      '+z[0,2]+','+z[1,2]+','+z[2,2]+','+z[3,2]+','+z[4,2]+','+z[5,2]+','+z[6,2]
+              printf,12, 'A3-Transitional,'+z[0,3]+','+z[1,3]+','+z[2,3]+','+z[3,3]+','+z[4,3]+','+z[5,3]+','+z[6,3]
+              printf,12, 'A4-Dominant,    '+z[0,4]+','+z[1,4]+','+z[2,4]+','+z[3,4]+','+z[4,4]+','+z[5,4]+','+z[6,4]
+              printf,12, 'A5-Interior,    '+z[0,5]+','+z[1,5]+','+z[2,5]+','+z[3,5]+','+z[4,5]+','+z[5,5]+','+z[6,5]
+              printf,12, 'A6-Intact,      '+z[0,6]+','+z[1,6]+','+z[2,6]+','+z[3,6]+','+z[4,6]+','+z[5,6]+','+z[6,6]
+              sum_ab = total(change[1:*,0],/double)+total(change[2:*,1],/double)+total(change[3:*,2],/double)+total(change[4:*,3],/double)+total(change[5:*,4],/double)+change[6,5]
+              sum_be = change[0,1]+total(change[0:1,2],/double)+total(change[0:2,3],/double)+total(change[0:3,4],/double)+total(change[0:4,5],/double)+total(change[0:5,6],/double)
+            endif else begin
+              printf,12, 'A->B [pixels], B0-Background, B1-Rare, B2-Patchy, B3-Transitional, B4-Dominant, B5-Interior'
+              printf,12, 'A0-Background,  '+z[0,0]+','+z[1,0]+','+z[2,0]+','+z[3,0]+','+z[4,0]+','+z[5,0]
+              printf,12, 'A1-Rare,        '+z[0,1]+','+z[1,1]+','+z[2,1]+','+z[3,1]+','+z[4,1]+','+z[5,1]
+              printf,12, 'A2-Patchy,      '+z[0,2]+','+z[1,2]+','+z[2,2]+','+z[3,2]+','+z[4,2]+','+z[5,2]
+              printf,12, 'A3-Transitional,'+z[0,3]+','+z[1,3]+','+z[2,3]+','+z[3,3]+','+z[4,3]+','+z[5,3]
+              printf,12, 'A4-Dominant,    '+z[0,4]+','+z[1,4]+','+z[2,4]+','+z[3,4]+','+z[4,4]+','+z[5,4]
+              printf,12, 'A5-Interior,    '+z[0,5]+','+z[1,5]+','+z[2,5]+','+z[3,5]+','+z[4,5]+','+z[5,5]
+              sum_ab = total(change[1:*,0],/double)+total(change[2:*,1],/double)+total(change[3:*,2],/double)+total(change[4:*,3],/double)+change[5,4]
+              sum_be = change[0,1]+total(change[0:1,2],/double)+total(change[0:2,3],/double)+total(change[0:3,4],/double)+total(change[0:4,5],/double)
+            endelse
+            printf,12, 'AREACOM change matrix [pixels]:,' + strtrim(areacom,2)
+            printf,12, 'Same status class - matrix diagonal [pixels]:,' + strtrim(diag+change[0,0],2)
             chsum = sum_ab + sum_be
-            printf,12, 'Different status classes [pixels]:,' + strtrim(chsum,2)
+            printf,12, 'Different status classes [pixels]:,' + strtrim(chsum,2)
             printf,12, 'Above the matrix diagonal [pixels]:,' + strtrim(sum_ab,2)
-            printf,12, 'Below the matrix diagonal [pixels]:,' + strtrim(sum_be,2)
+            printf,12, 'Below the matrix diagonal [pixels]:,' + strtrim(sum_be,2)
             printf, 12, ''
-            
+            
             ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
             printf,12, '6b) FORCOM ' +method + ' change matrix:'
             if fostype eq 'FOS6' then begin
@@ -20227,11 +20260,11 @@ CASE strlowCase(eventValue) OF
             chsum = sum_ab + sum_be
             printf,12, 'Connectivity increase (=fragmentation decrease) - above the matrix diagonal [%]:,' + strtrim(sum_ab,2)
             printf,12, 'Connectivity decrease (=fragmentation increase) - below the matrix diagonal [%]:,' + strtrim(sum_be,2)
-            close,12  
+            close,12  
                
           ENDIF ELSE BEGIN ;; no map output for _APP, set viewport to welcome startup
             outdir = file_dirname(file_dirname(im1_file)) + info.os_sep
-            diffsim = rotate(* info.process,7)
+            diffsim = rotate(* info.process,7)
           ENDELSE                                
           goto, diffsim_finish                      
         endif        
@@ -20273,15 +20306,15 @@ CASE strlowCase(eventValue) OF
         ;; check if fad_av was saved, if so then use it
         a_tt = (size(fad_av))[1]
         if a_tt eq 6 then a_fad_av = fad_av
-        a_tt = (size(fadru_av))[1]
-        if a_tt eq 6 then a_fadru_av = fadru_av
+        a_tt = (size(fadru_av))[1]
+        if a_tt eq 6 then a_fadru_av = fadru_av
 
         restore, fn_b[7] & b_xdim=xdim & b_ydim=ydim & b_fadtype = fadtype 
         ;; check if fad_av was saved, if so then use it
         b_tt = (size(fad_av))[1]        
         if b_tt eq 6 then b_fad_av = fad_av
-        b_tt = (size(fadru_av))[1]
-        if b_tt eq 6 then b_fadru_av = fadru_av
+        b_tt = (size(fadru_av))[1]
+        if b_tt eq 6 then b_fadru_av = fadru_av
         fad_avok = a_tt + b_tt
         fadru_avok = a_tt + b_tt       
         res = (a_xdim eq b_xdim) + (a_ydim eq b_ydim) + (a_fadtype eq b_fadtype)
@@ -20363,75 +20396,75 @@ CASE strlowCase(eventValue) OF
           endif
                     
           ;; calculate percentage of change in the sub-matrix of change
-          mch = change[1:*,1:*]
-          ;; null diagonal
+          mch = change[1:*,1:*]
+          ;; null diagonal
           diag = 0 
-          for ix = 0,5 do begin
-            for iy = 0,5 do begin
-              if ix eq iy then begin
-                diag = diag + mch[ix,iy]
-                mch[ix,iy] = 0
-              endif
-            endfor
-          endfor
-          chpix = total(mch)
+          for ix = 0,5 do begin
+            for iy = 0,5 do begin
+              if ix eq iy then begin
+                diag = diag + mch[ix,iy]
+                mch[ix,iy] = 0
+              endif
+            endfor
+          endfor
+          chpix = total(mch)
           perc = mch/chpix*100
-          ;; sum of percentage with connectivity increase = above matrix diagonal
-          sum_above = total(perc[0:*,0],/double) + total(perc[1:*,1],/double) + total(perc[2:*,2],/double) + total(perc[3:*,3],/double) + total(perc[4:*,4],/double)
-          ;; sum of percentage with connectivity decrease = below matrix diagonal
+          ;; sum of percentage with connectivity increase = above matrix diagonal
+          sum_above = total(perc[0:*,0],/double) + total(perc[1:*,1],/double) + total(perc[2:*,2],/double) + total(perc[3:*,3],/double) + total(perc[4:*,4],/double)
+          ;; sum of percentage with connectivity decrease = below matrix diagonal
           sum_below = total(perc,/double) - sum_above 
           
           uchange = strtrim(ulong64(change),2) ; ;; get integer numbers      
-          ;; save the tables into tmp as a txt-file
-          close,12 & openw,12, info.dir_tmp + fadtype + '_change_' + ext + '.txt'
-          printf,12, fadtype + ': Fragmentation class change from A -> B at observation scale: ' + kstr[isc]
-          printf,12, 'A-' + fn_a[isc] + '   ->   '
-          printf,12, 'B-' + fn_b[isc]
-          printf,12, '=============================================================================================================================================='
-          printf,12, '# pixels A->B  :     B0-Background           B1-Rare         B2-Patchy    B3-Transitional      B4-Dominant       B5-Interior         B6-Intact'
-          printf,12, format='(a16,7(a18))','A0-Background  :', uchange[*,0]
-          printf,12, format='(a16,7(a18))','A1-Rare        :', uchange[*,1]
-          printf,12, format='(a16,7(a18))','A2-Patchy      :', uchange[*,2]
-          printf,12, format='(a16,7(a18))','A3-Transitional:', uchange[*,3]
-          printf,12, format='(a16,7(a18))','A4-Dominant    :', uchange[*,4]
-          printf,12, format='(a16,7(a18))','A5-Interior    :', uchange[*,5]
-          printf,12, format='(a16,7(a18))','A6-Intact      :', uchange[*,6]
-          printf,12, '  '
-          printf, 12, 'Foreground cover at time A [pixels]: ' + strtrim(farea_a,2)
-          printf, 12, 'Foreground cover at time B [pixels]: ' + strtrim(farea_b,2)
-          printf, 12, 'Net foreground cover change (A->B) [pixels]: ' + strtrim(nc,2)
-          if fad_avok eq 12 then begin
-            printf, 12, '========================================================================================='
-            printf, 12, 'Observation scale:        1          2           3           4           5         mscale'
-            printf, 12, 'Neighborhood area:       7x7       13x13       27x27       81x81      243x243'
-            deltafad_av = b_fad_av - a_fad_av
-            printf,12, format='(a18,7(a12))','Diff: FAD_AV(A->B):', deltafad_av
-          endif
-          if fadru_avok eq 12 then begin
-            deltafadru_av = b_fadru_av - a_fadru_av
-            printf,12, format='(a18,7(a12))','Diff: AVCON(A->B):', deltafadru_av
-          endif
-          printf,12, '  '
-          printf,12, 'Change matrix constrained to the ' + strtrim(chpix,2) + ' pixels in different fragmentation classes [%]: '
-          printf,12, 'Fragmentation decrease (=connectivity increase) - above the matrix diagonal [%]: ' + strtrim(sum_above,2)
-          printf,12, 'Fragmentation increase (=connectivity decrease) - below the matrix diagonal [%]: ' + strtrim(sum_below,2)
-          printf,12, 'A->B [%]     :         B1-Rare       B2-Patchy   B3-Transitional   B4-Dominant     B5-Interior       B6-Intact'
-          printf,12, format='(8(a16))','A1-Rare        :',perc[1:*,0]
-          printf,12, format='(8(a16))','A2-Patchy      :',perc[1:*,1]
-          printf,12, format='(8(a16))','A3-Transitional:',perc[1:*,2]
-          printf,12, format='(8(a16))','A4-Dominant    :',perc[1:*,3]
-          printf,12, format='(8(a16))','A5-Interior    :',perc[1:*,4]
-          printf,12, format='(8(a16))','A6-Intact      :',perc[1:*,5]
-          printf,12, '  '
-          close,12
+          ;; save the tables into tmp as a txt-file
+          close,12 & openw,12, info.dir_tmp + fadtype + '_change_' + ext + '.txt'
+          printf,12, fadtype + ': Fragmentation class change from A -> B at observation scale: ' + kstr[isc]
+          printf,12, 'A-' + fn_a[isc] + '   ->   '
+          printf,12, 'B-' + fn_b[isc]
+          printf,12, '=============================================================================================================================================='
+          printf,12, '# pixels A->B  :     B0-Background           B1-Rare         B2-Patchy    B3-Transitional      B4-Dominant       B5-Interior         B6-Intact'
+          printf,12, format='(a16,7(a18))','A0-Background  :', uchange[*,0]
+          printf,12, format='(a16,7(a18))','A1-Rare        :', uchange[*,1]
+          printf,12, format='(a16,7(a18))','A2-Patchy      :', uchange[*,2]
+          printf,12, format='(a16,7(a18))','A3-Transitional:', uchange[*,3]
+          printf,12, format='(a16,7(a18))','A4-Dominant    :', uchange[*,4]
+          printf,12, format='(a16,7(a18))','A5-Interior    :', uchange[*,5]
+          printf,12, format='(a16,7(a18))','A6-Intact      :', uchange[*,6]
+          printf,12, '  '
+          printf, 12, 'Foreground cover at time A [pixels]: ' + strtrim(farea_a,2)
+          printf, 12, 'Foreground cover at time B [pixels]: ' + strtrim(farea_b,2)
+          printf, 12, 'Net foreground cover change (A->B) [pixels]: ' + strtrim(nc,2)
+          if fad_avok eq 12 then begin
+            printf, 12, '========================================================================================='
+            printf, 12, 'Observation scale:        1          2           3           4           5         mscale'
+            printf, 12, 'Neighborhood area:       7x7       13x13       27x27       81x81      243x243'
+            deltafad_av = b_fad_av - a_fad_av
+            printf,12, format='(a18,7(a12))','Diff: FAD_AV(A->B):', deltafad_av
+          endif
+          if fadru_avok eq 12 then begin
+            deltafadru_av = b_fadru_av - a_fadru_av
+            printf,12, format='(a18,7(a12))','Diff: AVCON(A->B):', deltafadru_av
+          endif
+          printf,12, '  '
+          printf,12, 'Change matrix constrained to the ' + strtrim(chpix,2) + ' pixels in different fragmentation classes [%]: '
+          printf,12, 'Fragmentation decrease (=connectivity increase) - above the matrix diagonal [%]: ' + strtrim(sum_above,2)
+          printf,12, 'Fragmentation increase (=connectivity decrease) - below the matrix diagonal [%]: ' + strtrim(sum_below,2)
+          printf,12, 'A->B [%]     :         B1-Rare       B2-Patchy   B3-Transitional   B4-Dominant     B5-Interior       B6-Intact'
+          printf,12, format='(8(a16))','A1-Rare        :',perc[1:*,0]
+          printf,12, format='(8(a16))','A2-Patchy      :',perc[1:*,1]
+          printf,12, format='(8(a16))','A3-Transitional:',perc[1:*,2]
+          printf,12, format='(8(a16))','A4-Dominant    :',perc[1:*,3]
+          printf,12, format='(8(a16))','A5-Interior    :',perc[1:*,4]
+          printf,12, format='(8(a16))','A6-Intact      :',perc[1:*,5]
+          printf,12, '  '
+          close,12
                  
           ;; save the tables into tmp as a csv-file
           z=strtrim(change,2) & zp=strtrim(perc,2)           
           close,12 & openw,12, info.dir_tmp + fadtype + '_change_' + ext + '.csv'          
           printf,12, fadtype + ': Fragmentation class change: A-' + fn_a[isc] + '   ->   ' + 'B-' + fn_b[isc] + ' at observation scale: ' + kstr[isc]
-          printf,12, 'Change matrix constrained to FORCOM: common foreground cover at both times [pixels]: ' + strtrim(forcom,2)
-          printf,12, 'Number of pixels in the same fragmentation class (matrix diagonal): ' + strtrim(diag,2)
-          printf,12, 'Number of pixels in different fragmentation classes: ' + strtrim(chpix,2)
+          printf,12, 'Change matrix constrained to FORCOM: common foreground cover at both times [pixels]: ' + strtrim(forcom,2)
+          printf,12, 'Number of pixels in the same fragmentation class (matrix diagonal): ' + strtrim(diag,2)
+          printf,12, 'Number of pixels in different fragmentation classes: ' + strtrim(chpix,2)
           printf,12, 'A->B [pixels], B0-Background, B1-Rare, B2-Patchy, B3-Transitional, B4-Dominant, B5-Interior, B6-Intact'
           printf,12, 'A0-Background,  '+z[0,0]+', '+z[1,0]+', '+z[2,0]+', '+z[3,0]+', '+z[4,0]+', '+z[5,0]+', '+z[6,0]
           printf,12, 'A1-Rare,        '+z[0,1]+', '+z[1,1]+', '+z[2,1]+', '+z[3,1]+', '+z[4,1]+', '+z[5,1]+', '+z[6,1]
@@ -20441,8 +20474,8 @@ CASE strlowCase(eventValue) OF
           printf,12, 'A5-Interior,    '+z[0,5]+', '+z[1,5]+', '+z[2,5]+', '+z[3,5]+', '+z[4,5]+', '+z[5,5]+', '+z[6,5]
           printf,12, 'A6-Intact,      '+z[0,6]+', '+z[1,6]+', '+z[2,6]+', '+z[3,6]+', '+z[4,6]+', '+z[5,6]+', '+z[6,6]
           printf,12, '  '
-          printf, 12, 'Foreground cover at time A [pixels]: ' + strtrim(farea_a,2)
-          printf, 12, 'Foreground cover at time B [pixels]: ' + strtrim(farea_b,2)
+          printf, 12, 'Foreground cover at time A [pixels]: ' + strtrim(farea_a,2)
+          printf, 12, 'Foreground cover at time B [pixels]: ' + strtrim(farea_b,2)
           printf, 12, 'Net foreground cover change (A->B) [pixels]: ' + strtrim(nc,2)      
           if fad_avok eq 12 then begin
             z = strtrim(deltafad_av,2)
@@ -20450,28 +20483,28 @@ CASE strlowCase(eventValue) OF
             printf, 12, 'Neighborhood area:, 7x7, 13x13, 27x27, 81x81, 243x243,' 
             printf,12,'Diff: FAD_AV(A->B):, ' +z[0]+', '+z[1]+', '+z[2]+', '+z[3]+', '+z[4]+', '+z[5]
           endif      
-          if fadru_avok eq 12 then begin
-            z = strtrim(deltafadru_av,2)
-            printf,12,'Diff: AVCON(A->B):, ' +z[0]+', '+z[1]+', '+z[2]+', '+z[3]+', '+z[4]+', '+z[5]
-          endif
+          if fadru_avok eq 12 then begin
+            z = strtrim(deltafadru_av,2)
+            printf,12,'Diff: AVCON(A->B):, ' +z[0]+', '+z[1]+', '+z[2]+', '+z[3]+', '+z[4]+', '+z[5]
+          endif
                       
           printf,12, '  '
           printf,12, 'Change matrix constrained to the ' + strtrim(chpix,2) + ' pixels in different fragmentation classes [%]: '
           printf,12, 'Fragmentation decrease (=connectivity increase) - above the matrix diagonal [%]: ' + strtrim(sum_above,2)
           printf,12, 'Fragmentation increase (=connectivity decrease) - below the matrix diagonal [%]: ' + strtrim(sum_below,2)
-          printf,12, 'A->B [%], , B1-Rare, B2-Patchy, B3-Transitional, B4-Dominant, B5-Interior, B6-Intact'
-          printf,12, 'A1-Rare      ,  ,'+zp[0,0]+','+zp[1,0]+','+zp[2,0]+','+zp[3,0]+','+zp[4,0]+','+zp[5,0]
-          printf,12, 'A2-Patchy    ,  ,'+zp[0,1]+','+zp[1,1]+','+zp[2,1]+','+zp[3,1]+','+zp[4,1]+','+zp[5,1]
-          printf,12, 'A3-Transitional, ,'+zp[0,2]+','+zp[1,2]+','+zp[2,2]+','+zp[3,2]+','+zp[4,2]+','+zp[5,2]
-          printf,12, 'A4-Dominant   , ,'+zp[0,3]+','+zp[1,3]+','+zp[2,3]+','+zp[3,3]+','+zp[4,3]+','+zp[5,3]
-          printf,12, 'A5-Interior  ,  ,'+zp[0,4]+','+zp[1,4]+','+zp[2,4]+','+zp[3,4]+','+zp[4,4]+','+zp[5,4]
+          printf,12, 'A->B [%], , B1-Rare, B2-Patchy, B3-Transitional, B4-Dominant, B5-Interior, B6-Intact'
+          printf,12, 'A1-Rare      ,  ,'+zp[0,0]+','+zp[1,0]+','+zp[2,0]+','+zp[3,0]+','+zp[4,0]+','+zp[5,0]
+          printf,12, 'A2-Patchy    ,  ,'+zp[0,1]+','+zp[1,1]+','+zp[2,1]+','+zp[3,1]+','+zp[4,1]+','+zp[5,1]
+          printf,12, 'A3-Transitional, ,'+zp[0,2]+','+zp[1,2]+','+zp[2,2]+','+zp[3,2]+','+zp[4,2]+','+zp[5,2]
+          printf,12, 'A4-Dominant   , ,'+zp[0,3]+','+zp[1,3]+','+zp[2,3]+','+zp[3,3]+','+zp[4,3]+','+zp[5,3]
+          printf,12, 'A5-Interior  ,  ,'+zp[0,4]+','+zp[1,4]+','+zp[2,4]+','+zp[3,4]+','+zp[4,4]+','+zp[5,4]
           printf,12, 'A6-Intact    ,  ,'+zp[0,5]+','+zp[1,5]+','+zp[2,5]+','+zp[3,5]+','+zp[4,5]+','+zp[5,5]            
           close,12
 
         endfor ;; loop over observation scales
 
-        ;; show the summary image statistics
-        xdisplayfile, info.dir_tmp + fadtype + '_change_mscale.txt', title = 'FAD change for mscale image', width=100,/grow
+        ;; show the summary image statistics
+        xdisplayfile, info.dir_tmp + fadtype + '_change_mscale.txt', title = 'FAD change for mscale image', width=100,/grow
        
         ;;========================================================================================
         ;; 3) the FAD change chart
@@ -20484,77 +20517,77 @@ CASE strlowCase(eventValue) OF
         b_xdim=xdim & b_ydim=ydim & b_geotiff_log=geotiff_log & b_rare=rare & b_patchy=patchy & b_transitional=transitional
         b_dominant=dominant & b_interior=interior & b_intact=intact & b_fgarea=fgarea
 
-        restore, info.dir_guidossub + 'fadcolors.sav' & tvlct,r,g,b
-        info.ctbl = - 1 & info.autostretch_id = 0 & info.disp_colors_id = 8 ;; fad
-        scales = indgen(6)+1 & x_sum = [5.8, 6.2]
-
-
-        b1 = PLOT(scales[0:4], b_intact[0:4], Color=[0,120,0], thick=3, yrange=[-4,104], xrange=[0.2, 9.9],$
-          ytitle='Foreground proportion [%]', xtitle='              Observation scale | MultiScale | Legend', $
-          title='Change in ' +fadtype + ': A -> B', xticklen=0.02,yticklen=0.02,xminor=1, xtickv=[1,2,3,4,5],/buffer)
-        b1a = PLOT(x_sum, [b_intact[5],b_intact[5]], Color=[0,120,0], thick=3, /overplot)
-        y2 = b_interior+b_intact
-        b2 = PLOT(scales[0:4],y2[0:4], Color=[0,175,0], thick=3, /overplot)
-        b2a = PLOT(x_sum, [y2[5],y2[5]], Color=[0,175,0], thick=3, /overplot)
-        y2 = b_dominant+y2
-        b3 = PLOT(scales[0:4],y2[0:4], Color=[140,200,100], thick=3,/overplot)
-        b3a = PLOT(x_sum, [y2[5],y2[5]], Color=[140,200,100], thick=3, /overplot)
-        y2 = b_transitional+y2
-        b4 = PLOT(scales[0:4],y2[0:4], Color=[255,200,0], thick=3,/overplot)
-        b4a = PLOT(x_sum, [y2[5],y2[5]], Color=[255,200,0], thick=3, /overplot)
-        y2 = b_patchy+y2
-        b5 = PLOT(scales[0:4],y2[0:4], Color=[250,140,90], thick=3,/overplot)
-        b5a = PLOT(x_sum, [y2[5],y2[5]], Color=[250,140,90], thick=3, /overplot)
-        y2 = b_rare+y2
-        b6 = PLOT(scales[0:4],y2[0:4], Color=[215,50,40], thick=3,/overplot)
-        b6a = PLOT(x_sum, [y2[5],y2[5]], Color=[215,50,40], thick=3, /overplot)
-        a = plot([5.5, 5.5],[-4, 104], /data, color='Black',/overplot, thick=3)
-        a = plot([6.5, 6.5],[-4, 104], /data, color='Black',/overplot, thick=3)
-        a = text(6.7,95, fadtype, /data,/current)
-        a = text(6.7,90,'Fragmentation class: ',/data,/current)
-        c = symbol(6.9,85,'square',/data, /sym_filled, sym_color=[215,50,40],sym_size=2,LABEL_STRING='Rare')
-        c = symbol(6.9,78,'square',/data, /sym_filled, sym_color=[250,140,90],sym_size=2,LABEL_STRING='Patchy')
-        c = symbol(6.9,71,'square',/data, /sym_filled, sym_color=[255,200,0],sym_size=2,LABEL_STRING='Transitional')
-        c = symbol(6.9,64,'square',/data, /sym_filled, sym_color=[140,200,100],sym_size=2,LABEL_STRING='Dominant')
-        c = symbol(6.9,57,'square',/data, /sym_filled, sym_color=[0,175,0],sym_size=2,LABEL_STRING='Interior')
-        c = symbol(6.9,50,'square',/data, /sym_filled, sym_color=[0,120,0],sym_size=2,LABEL_STRING='Intact')
-        q = plot([6.8, 7.2],[40, 40], /data, color='Black',/overplot, thick=2, linestyle=1)
-        a = text(7.4, 39, 'Time A',/data)
-        q = plot([6.8, 7.2],[34, 34], /data, color='Black',/overplot, thick=2)
-        a = text(7.4, 33, 'Time B',/data)
-        ;; now the time A stats
-        b1 = PLOT(scales[0:4], a_intact[0:4], Color=[0,120,0], thick=3, linestyle=1, /overplot)
-        b1a = PLOT(x_sum, [a_intact[5],a_intact[5]], Color=[0,120,0], thick=3, linestyle=1, /overplot)
-        y2 = a_interior+a_intact
-        b2 = PLOT(scales[0:4],y2[0:4], Color=[0,175,0], thick=3, linestyle=1, /overplot)
-        b2a = PLOT(x_sum, [y2[5],y2[5]], Color=[0,175,0], thick=3, linestyle=1, /overplot)
-        y2 = a_dominant+y2
-        b3 = PLOT(scales[0:4],y2[0:4], Color=[140,200,100], thick=3, linestyle=1,/overplot)
-        b3a = PLOT(x_sum, [y2[5],y2[5]], Color=[140,200,100], thick=3, linestyle=1, /overplot)
-        y2 = a_transitional+y2
-        b4 = PLOT(scales[0:4],y2[0:4], Color=[255,200,0], thick=3, linestyle=1,/overplot)
-        b4a = PLOT(x_sum, [y2[5],y2[5]], Color=[255,200,0], thick=3, linestyle=1, /overplot)
-        y2 = a_patchy+y2
-        b5 = PLOT(scales[0:4],y2[0:4], Color=[250,140,90], thick=3, linestyle=1,/overplot)
-        b5a = PLOT(x_sum, [y2[5],y2[5]], Color=[250,140,90], thick=3, linestyle=1, /overplot)
-        y2 = a_rare+y2
-        b6 = PLOT(scales[0:4],y2[0:4], Color=[215,50,40], thick=3, linestyle=1,/overplot)
-        b6a = PLOT(x_sum, [y2[5],y2[5]], Color=[215,50,40], thick=3, linestyle=1, /overplot)
-
-        ;; area change
-        str = long64(b_fgarea) - long64(a_fgarea) & str = strtrim(str,2)
-        a = text(6.7,20,'FG-Area change [pixels]:',/data,/current)
-        a = text(6.7,15, str, /data, /current)
-        b1.save,info.dir_tmp + fadtype + '_change_barplot.png', resolution=300
-
-
-        ;; open barplot image
-        IF info.my_os EQ 'darwin' OR info.my_os EQ 'apple' THEN BEGIN
-          spawn, 'open ' + info.dir_tmp + fadtype + '_change_barplot.png'
-        ENDIF ELSE IF info.my_os EQ 'windows' THEN BEGIN
-          pushd, info.dir_tmp
-          spawn, 'start ' + fadtype + '_change_barplot.png', / nowait
-          popd
+        restore, info.dir_guidossub + 'fadcolors.sav' & tvlct,r,g,b
+        info.ctbl = - 1 & info.autostretch_id = 0 & info.disp_colors_id = 8 ;; fad
+        scales = indgen(6)+1 & x_sum = [5.8, 6.2]
+
+
+        b1 = PLOT(scales[0:4], b_intact[0:4], Color=[0,120,0], thick=3, yrange=[-4,104], xrange=[0.2, 9.9],$
+          ytitle='Foreground proportion [%]', xtitle='              Observation scale | MultiScale | Legend', $
+          title='Change in ' +fadtype + ': A -> B', xticklen=0.02,yticklen=0.02,xminor=1, xtickv=[1,2,3,4,5],/buffer)
+        b1a = PLOT(x_sum, [b_intact[5],b_intact[5]], Color=[0,120,0], thick=3, /overplot)
+        y2 = b_interior+b_intact
+        b2 = PLOT(scales[0:4],y2[0:4], Color=[0,175,0], thick=3, /overplot)
+        b2a = PLOT(x_sum, [y2[5],y2[5]], Color=[0,175,0], thick=3, /overplot)
+        y2 = b_dominant+y2
+        b3 = PLOT(scales[0:4],y2[0:4], Color=[140,200,100], thick=3,/overplot)
+        b3a = PLOT(x_sum, [y2[5],y2[5]], Color=[140,200,100], thick=3, /overplot)
+        y2 = b_transitional+y2
+        b4 = PLOT(scales[0:4],y2[0:4], Color=[255,200,0], thick=3,/overplot)
+        b4a = PLOT(x_sum, [y2[5],y2[5]], Color=[255,200,0], thick=3, /overplot)
+        y2 = b_patchy+y2
+        b5 = PLOT(scales[0:4],y2[0:4], Color=[250,140,90], thick=3,/overplot)
+        b5a = PLOT(x_sum, [y2[5],y2[5]], Color=[250,140,90], thick=3, /overplot)
+        y2 = b_rare+y2
+        b6 = PLOT(scales[0:4],y2[0:4], Color=[215,50,40], thick=3,/overplot)
+        b6a = PLOT(x_sum, [y2[5],y2[5]], Color=[215,50,40], thick=3, /overplot)
+        a = plot([5.5, 5.5],[-4, 104], /data, color='Black',/overplot, thick=3)
+        a = plot([6.5, 6.5],[-4, 104], /data, color='Black',/overplot, thick=3)
+        a = text(6.7,95, fadtype, /data,/current)
+        a = text(6.7,90,'Fragmentation class: ',/data,/current)
+        c = symbol(6.9,85,'square',/data, /sym_filled, sym_color=[215,50,40],sym_size=2,LABEL_STRING='Rare')
+        c = symbol(6.9,78,'square',/data, /sym_filled, sym_color=[250,140,90],sym_size=2,LABEL_STRING='Patchy')
+        c = symbol(6.9,71,'square',/data, /sym_filled, sym_color=[255,200,0],sym_size=2,LABEL_STRING='Transitional')
+        c = symbol(6.9,64,'square',/data, /sym_filled, sym_color=[140,200,100],sym_size=2,LABEL_STRING='Dominant')
+        c = symbol(6.9,57,'square',/data, /sym_filled, sym_color=[0,175,0],sym_size=2,LABEL_STRING='Interior')
+        c = symbol(6.9,50,'square',/data, /sym_filled, sym_color=[0,120,0],sym_size=2,LABEL_STRING='Intact')
+        q = plot([6.8, 7.2],[40, 40], /data, color='Black',/overplot, thick=2, linestyle=1)
+        a = text(7.4, 39, 'Time A',/data)
+        q = plot([6.8, 7.2],[34, 34], /data, color='Black',/overplot, thick=2)
+        a = text(7.4, 33, 'Time B',/data)
+        ;; now the time A stats
+        b1 = PLOT(scales[0:4], a_intact[0:4], Color=[0,120,0], thick=3, linestyle=1, /overplot)
+        b1a = PLOT(x_sum, [a_intact[5],a_intact[5]], Color=[0,120,0], thick=3, linestyle=1, /overplot)
+        y2 = a_interior+a_intact
+        b2 = PLOT(scales[0:4],y2[0:4], Color=[0,175,0], thick=3, linestyle=1, /overplot)
+        b2a = PLOT(x_sum, [y2[5],y2[5]], Color=[0,175,0], thick=3, linestyle=1, /overplot)
+        y2 = a_dominant+y2
+        b3 = PLOT(scales[0:4],y2[0:4], Color=[140,200,100], thick=3, linestyle=1,/overplot)
+        b3a = PLOT(x_sum, [y2[5],y2[5]], Color=[140,200,100], thick=3, linestyle=1, /overplot)
+        y2 = a_transitional+y2
+        b4 = PLOT(scales[0:4],y2[0:4], Color=[255,200,0], thick=3, linestyle=1,/overplot)
+        b4a = PLOT(x_sum, [y2[5],y2[5]], Color=[255,200,0], thick=3, linestyle=1, /overplot)
+        y2 = a_patchy+y2
+        b5 = PLOT(scales[0:4],y2[0:4], Color=[250,140,90], thick=3, linestyle=1,/overplot)
+        b5a = PLOT(x_sum, [y2[5],y2[5]], Color=[250,140,90], thick=3, linestyle=1, /overplot)
+        y2 = a_rare+y2
+        b6 = PLOT(scales[0:4],y2[0:4], Color=[215,50,40], thick=3, linestyle=1,/overplot)
+        b6a = PLOT(x_sum, [y2[5],y2[5]], Color=[215,50,40], thick=3, linestyle=1, /overplot)
+
+        ;; area change
+        str = long64(b_fgarea) - long64(a_fgarea) & str = strtrim(str,2)
+        a = text(6.7,20,'FG-Area change [pixels]:',/data,/current)
+        a = text(6.7,15, str, /data, /current)
+        b1.save,info.dir_tmp + fadtype + '_change_barplot.png', resolution=300
+
+
+        ;; open barplot image
+        IF info.my_os EQ 'darwin' OR info.my_os EQ 'apple' THEN BEGIN
+          spawn, 'open ' + info.dir_tmp + fadtype + '_change_barplot.png'
+        ENDIF ELSE IF info.my_os EQ 'windows' THEN BEGIN
+          pushd, info.dir_tmp
+          spawn, 'start ' + fadtype + '_change_barplot.png', / nowait
+          popd
         ENDIF ELSE BEGIN ;; Linux
           IF strlen(info.xdgop) EQ 0 THEN BEGIN
             st = "Please install xdg-open to automatically" + $
@@ -21864,8 +21897,8 @@ CASE strlowCase(eventValue) OF
      ENDIF
 
      oUrl = OBJ_NEW('IDLnetUrl')
-     oUrl -> SetProperty, URL_SCHEME = 'https'
-     oUrl -> SetProperty, PROXY_HOSTNAME = info.proxhost
+     oUrl -> SetProperty, URL_SCHEME = 'https'
+     oUrl -> SetProperty, PROXY_HOSTNAME = info.proxhost
      oUrl -> SetProperty, PROXY_PORT = info.proxport
      oUrl -> SetProperty, URL_HOST = 'forest.jrc.ec.europa.eu'
      oUrl -> SetProperty, URL_PATH = 'guidos/news'
@@ -22005,8 +22038,8 @@ CASE strlowCase(eventValue) OF
       ENDIF    
 
       oUrl = OBJ_NEW('IDLnetUrl')
-      oUrl -> SetProperty, URL_SCHEME = 'https'
-      oUrl -> SetProperty, PROXY_HOSTNAME = info.proxhost
+      oUrl -> SetProperty, URL_SCHEME = 'https'
+      oUrl -> SetProperty, PROXY_HOSTNAME = info.proxhost
       oUrl -> SetProperty, PROXY_PORT = info.proxport
       oUrl -> SetProperty, URL_HOST = 'ies-ows.jrc.ec.europa.eu'
       oUrl -> SetProperty, URL_PATH = 'gtb/version.txt'
@@ -22083,11 +22116,11 @@ CASE strlowCase(eventValue) OF
                 oProgressbar->Destroy
                                       
                 ;; b) extract it and run update
-                IF info.isBDAP THEN BEGIN
-                  file_mkdir, 'bdap/bdap'
+                IF info.isBDAP THEN BEGIN
+                  file_mkdir, 'bdap/bdap'
                   file_move, gws_archive, 'bdap/bdap/'
-                  cd, 'bdap/bdap/'
-                ENDIF
+                  cd, 'bdap/bdap/'
+                ENDIF
 
                 file_unzip, gws_archive
                 IF info.my_os EQ 'windows' THEN BEGIN
@@ -22314,9 +22347,9 @@ CASE strlowCase(eventValue) OF
                ENDIF
                ginst_file = downdir + 'GuidosToolbox_Installation.pdf'
                oUrl = OBJ_NEW('IDLnetUrl')
-               oUrl -> SetProperty, URL_SCHEME = 'https'
-               oUrl -> SetProperty, PROXY_HOSTNAME = info.proxhost
-               oUrl -> SetProperty, PROXY_PORT = info.proxport
+               oUrl -> SetProperty, URL_SCHEME = 'https'
+               oUrl -> SetProperty, PROXY_HOSTNAME = info.proxhost
+               oUrl -> SetProperty, PROXY_PORT = info.proxport
                oUrl -> SetProperty, URL_HOST = 'ies-ows.jrc.ec.europa.eu'
                oUrl -> SetProperty, URL_PATH = 'gtb/GTB/GuidosToolbox_Installation.pdf'
                fn = oUrl -> Get(FILENAME = ginst_file)
@@ -22324,34 +22357,34 @@ CASE strlowCase(eventValue) OF
                OBJ_DESTROY, oUrl
                
                if info.my_os ne 'linux' then begin ;; download the unique macOS or Windows installer
-                 ;; If the url object throws an error it will be caught here
-                 CATCH, errorStatus
-                 IF (errorStatus NE 0) THEN BEGIN
-                   CATCH, / CANCEL
-                   goto, url_cont7
-                 ENDIF
-
-                 oProgressbar = Obj_New('cgprogressbar', TITLE='Downloading new GTB release')
-                 oUrl = OBJ_NEW('IDLnetUrl', URL_SCHEME = 'https', PROXY_HOSTNAME = info.proxhost, PROXY_PORT = info.proxport, $
-                   URL_HOSTNAME = 'ies-ows.jrc.ec.europa.eu/gtb/GTB/'+GTB_archive,$
-                   URL_USERNAME = '', URL_PASSWORD = '', CALLBACK_FUNCTION ='UrlBigFileGetCallbackStatus', $
-                   CALLBACK_DATA=oProgressbar)
-                 VersionFileName = GTB_file
-                 oProgressbar->Start
-                 retrievedFilePath = oUrl->Get(FILENAME=VersionFileName)
-                 oUrl->GetProperty, RESPONSE_CODE=RespCode
-                 oUrl->CloseConnections
-                 url_cont7:
-                 OBJ_DESTROY, oUrl
+                 ;; If the url object throws an error it will be caught here
+                 CATCH, errorStatus
+                 IF (errorStatus NE 0) THEN BEGIN
+                   CATCH, / CANCEL
+                   goto, url_cont7
+                 ENDIF
+
+                 oProgressbar = Obj_New('cgprogressbar', TITLE='Downloading new GTB release')
+                 oUrl = OBJ_NEW('IDLnetUrl', URL_SCHEME = 'https', PROXY_HOSTNAME = info.proxhost, PROXY_PORT = info.proxport, $
+                   URL_HOSTNAME = 'ies-ows.jrc.ec.europa.eu/gtb/GTB/'+GTB_archive,$
+                   URL_USERNAME = '', URL_PASSWORD = '', CALLBACK_FUNCTION ='UrlBigFileGetCallbackStatus', $
+                   CALLBACK_DATA=oProgressbar)
+                 VersionFileName = GTB_file
+                 oProgressbar->Start
+                 retrievedFilePath = oUrl->Get(FILENAME=VersionFileName)
+                 oUrl->GetProperty, RESPONSE_CODE=RespCode
+                 oUrl->CloseConnections
+                 url_cont7:
+                 OBJ_DESTROY, oUrl
                  oProgressbar->Destroy                
                endif
 
                if info.my_os ne 'linux' then begin
-                 ;; b) inform about the new release
-                 msg = 'New release ' + newGTB  + string(10b) + $
-                   'has been downloaded into the directory: ' + string(10b) + downdir + string(10b) + string(10b) + $
-                   'Please read the installation instructions ' + string(10b) + $
-                   'before upgrading to the new version.'
+                 ;; b) inform about the new release
+                 msg = 'New release ' + newGTB  + string(10b) + $
+                   'has been downloaded into the directory: ' + string(10b) + downdir + string(10b) + string(10b) + $
+                   'Please read the installation instructions ' + string(10b) + $
+                   'before upgrading to the new version.'
                  res = dialog_message(title = 'GTB update information', / information, msg)
                  openu, unit, info.log,/append, /Get_lun & printf, unit, systime() + ': ' + msg + info.bline & free_lun, unit
                endif 
@@ -22376,7 +22409,7 @@ CASE strlowCase(eventValue) OF
                ENDIF ELSE BEGIN ;; Linux
                  cmd = info.pdf_exe + ' "' + ginst_file + '"'
                  spawn, cmd + ' &'
-                 res = dialog_message(title = 'GTB update information', $
+                 res = dialog_message(title = 'GTB update information', $
                    / information, 'Please download your OS-specific GTB installer and follow the installation instructions')
                ENDELSE
                popd      
@@ -22519,19 +22552,19 @@ CASE strlowCase(eventValue) OF
             spawn, 'sw_vers -productVersion', res & res = res[0]
             osd = 'Mac OS X [' + res + ']'
          END
-         'apple':BEGIN
-           spawn,'/opt/homebrew/bin/gdalinfo --version', res & res = res[0]
-           res = (strsplit(res,',',/extract))[0]
-           gdd = '- ' + res + ' (Homebrew: https://brew.sh)'
-           IF strlen(info.qgis_exe) GT 0 THEN BEGIN
-             q = strpos(info.qgis_exe,'Contents') & plist = strmid(info.qgis_exe,0,q+9) + 'Info.plist'
-             cmd = 'echo $(/usr/libexec/PlistBuddy -c "print CFBundleShortVersionString" "' + plist + '")'
-               spawn, cmd, res & res = res[0]
-             gdd = gdd + string(10b) + '- QGIS ' + res + ' (https://www.qgis.org)'
-           ENDIF
-           spawn, 'sw_vers -productVersion', res & res = res[0]
-           osd = 'Mac OS X [' + res + ']'
-         END
+         'apple':BEGIN
+           spawn,'/opt/homebrew/bin/gdalinfo --version', res & res = res[0]
+           res = (strsplit(res,',',/extract))[0]
+           gdd = '- ' + res + ' (Homebrew: https://brew.sh)'
+           IF strlen(info.qgis_exe) GT 0 THEN BEGIN
+             q = strpos(info.qgis_exe,'Contents') & plist = strmid(info.qgis_exe,0,q+9) + 'Info.plist'
+             cmd = 'echo $(/usr/libexec/PlistBuddy -c "print CFBundleShortVersionString" "' + plist + '")'
+               spawn, cmd, res & res = res[0]
+             gdd = gdd + string(10b) + '- QGIS ' + res + ' (https://www.qgis.org)'
+           ENDIF
+           spawn, 'sw_vers -productVersion', res & res = res[0]
+           osd = 'Mac OS X [' + res + ']'
+         END
       ENDCASE     
       aa = ', Revision '  + strvrev       
       str_about = '           GTB ' + vbase + aa + string(10b) + $
@@ -22560,12 +22593,12 @@ CASE strlowCase(eventValue) OF
       endif 
       
       IF info.my_os EQ 'windows' then begin
-        sstr = '- For MSPA-processing of larger images please use:' + string(10b) + $
-               '    the Linux or macOS version of GTB or ' + string(10b) + $
+        sstr = '- For MSPA-processing of larger images please use:' + string(10b) + $
+               '    the Linux or macOS version of GTB or ' + string(10b) + $
                '    use GWB for operational processing.' + string(10b) 
       ENDIF ELSE BEGIN
-        sstr = '- For MSPA-processing of larger images please' + string(10b) + $
-               '    use GWB for operational processing.' + string(10b)         
+        sstr = '- For MSPA-processing of larger images please' + string(10b) + $
+               '    use GWB for operational processing.' + string(10b)         
       ENDELSE     
       
       str_about = str_about + string(10b) + string(10b) + 'Maximum map dimension [pixels]: ' + string(10b) + $
@@ -22654,11 +22687,11 @@ CASE strlowCase(eventValue) OF
              for id = 0, n_elements(osd) -1 do printf, 11, osd[id]
           END
 
-          'apple':BEGIN
-            spawn, 'system_profiler SPHardwareDataType', osd
+          'apple':BEGIN
+            spawn, 'system_profiler SPHardwareDataType', osd
             for id = 0, n_elements(osd) -1 do printf, 11, osd[id]
-            spawn,'sysctl -n machdep.cpu.brand_string', res & res = res[0] & printf, 11, 'Chip: ' + res 
-          END
+            spawn,'sysctl -n machdep.cpu.brand_string', res & res = res[0] & printf, 11, 'Chip: ' + res 
+          END
         ENDCASE
         show_info:
         
@@ -22721,9 +22754,9 @@ CASE strlowCase(eventValue) OF
           'darwin':BEGIN
             spawn, 'open -e ' + GTBreport
           END
-          'apple':BEGIN
-            spawn, 'open -e ' + GTBreport
-          END
+          'apple':BEGIN
+            spawn, 'open -e ' + GTBreport
+          END
         ENDCASE
         ;; switch motion events back on
         widget_control, info.w_draw, Draw_Motion_Events = 1
@@ -22791,14 +22824,14 @@ info.disp_colors_id = 19
 info.disp_range_id = 0
 info.selsubregion_id = 0
 info.autostretch_id = 1b 
-condition = (info.title EQ 'FOSchange') OR (info.title EQ 'Simple change (A->B)') OR $
+condition = (info.title EQ 'FOSchange') OR (info.title EQ 'Simple change (A->B)') OR $
   (strmid(info.title,0,13) eq 'MCD (A->B) FG') OR (strmid(info.title,0,38) EQ info.start_title)
 IF condition THEN BEGIN
   info.title = info.start_title 
   cmd = 'Move cursor in display to read out location and value.'
 ENDIF ELSE BEGIN
   info.title = title
-  cmd = 'Please wait for ' + title + ' to finish.'
+  cmd = 'Please wait for ' + title + ' to finish.'
 ENDELSE
 info.add_title = ''
 info.is_mspa = 0 & info.is_contort = 0
@@ -23647,9 +23680,9 @@ CASE fileaction OF
         17:BEGIN ;; LM_ANT
           restore, info.dir_guidossub + 'lmcolors_ANT.sav'
         END      
-        18:BEGIN ;; FOSchange
-          restore, info.dir_guidossub + 'foschangecolors.sav'
-        END
+        18:BEGIN ;; FOSchange
+          restore, info.dir_guidossub + 'foschangecolors.sav'
+        END
       ENDCASE   
       tvlct, r, g, b
       
@@ -25665,35 +25698,35 @@ IF strmid(fileaction, 0, 4) EQ 'save' THEN BEGIN
       ENDIF ;; only for fullres
    ENDIF  ;; end of CS22
    
-   ;; add FOSchange
-   IF info.title EQ 'FOSchange' THEN BEGIN
-     fosbname = strmid(z,0,strpos(z,'.tif',/reverse_search))
-     ;; add statistics from tmp
-     tt = file_search(info.dir_tmp + 'FOSchange.csv') & q = strlen(tt[0])
-     IF q GT 0 THEN BEGIN
-       fn = tt[0] & file_copy, fn, fosbname + '.csv',/overwrite
-       z = fosbname + '.csv'
-       fnsaves = fnsaves + z + string(10b)
-     ENDIF
-     tt = file_search(info.dir_tmp + 'FOSchange.png') & q = strlen(tt[0])
-     IF q GT 0 THEN BEGIN
-       fn = tt[0] & file_copy, fn, fosbname + '.png',/overwrite
-       z = fosbname + '.png'
-       fnsaves = fnsaves + z + string(10b)
+   ;; add FOSchange
+   IF info.title EQ 'FOSchange' THEN BEGIN
+     fosbname = strmid(z,0,strpos(z,'.tif',/reverse_search))
+     ;; add statistics from tmp
+     tt = file_search(info.dir_tmp + 'FOSchange.csv') & q = strlen(tt[0])
+     IF q GT 0 THEN BEGIN
+       fn = tt[0] & file_copy, fn, fosbname + '.csv',/overwrite
+       z = fosbname + '.csv'
+       fnsaves = fnsaves + z + string(10b)
      ENDIF
-     tt = file_search(info.dir_tmp + 'FOSchange_hist.csv') & q = strlen(tt[0])
-     IF q GT 0 THEN BEGIN
-       fn = tt[0] & file_copy, fn, fosbname + '_hist.csv',/overwrite
-       z = fosbname + '_hist.csv'
-       fnsaves = fnsaves + z + string(10b)
+     tt = file_search(info.dir_tmp + 'FOSchange.png') & q = strlen(tt[0])
+     IF q GT 0 THEN BEGIN
+       fn = tt[0] & file_copy, fn, fosbname + '.png',/overwrite
+       z = fosbname + '.png'
+       fnsaves = fnsaves + z + string(10b)
      ENDIF
-     tt = file_search(info.dir_tmp + 'FOSchange_colors.csv') & q = strlen(tt[0])
-     IF q GT 0 THEN BEGIN
-       fn = tt[0] & file_copy, fn, fosbname + '_colors.csv',/overwrite
-       z = fosbname + '_colors.csv'
-       fnsaves = fnsaves + z + string(10b)
-     ENDIF
-     
+     tt = file_search(info.dir_tmp + 'FOSchange_hist.csv') & q = strlen(tt[0])
+     IF q GT 0 THEN BEGIN
+       fn = tt[0] & file_copy, fn, fosbname + '_hist.csv',/overwrite
+       z = fosbname + '_hist.csv'
+       fnsaves = fnsaves + z + string(10b)
+     ENDIF
+     tt = file_search(info.dir_tmp + 'FOSchange_colors.csv') & q = strlen(tt[0])
+     IF q GT 0 THEN BEGIN
+       fn = tt[0] & file_copy, fn, fosbname + '_colors.csv',/overwrite
+       z = fosbname + '_colors.csv'
+       fnsaves = fnsaves + z + string(10b)
+     ENDIF
+     
    ENDIF
 
    ;;=====================================================
@@ -26240,19 +26273,19 @@ IF event.type EQ 2 AND info.set_zoom EQ 0 THEN BEGIN
            else: cmd2 = '  invalid setting: ' + strtrim(zm, 2)
          endcase
 
-       ENDIF ELSE IF is_mcd EQ 1 THEN BEGIN
-         ;; morph change
-         zm = ( * info.fr_image)[xm, ym] + 0
-         case zm of
-           11: cmd2 = '   BG-stable: ' + strtrim(zm, 2)
-           22: cmd2 = '   FG-stable: ' + strtrim(zm, 2)
-           21: cmd2 = '   Loss: ' + strtrim(zm, 2)
-           12: cmd2 = '   Gain: ' + strtrim(zm, 2)
-           176: cmd2 = '   spurious: ' + strtrim(zm, 2)
-           255: cmd2 = '   missing: ' + strtrim(zm, 2)
-           else: cmd2 = '   invalid setting: ' + strtrim(zm, 2)
-         endcase
-
+       ENDIF ELSE IF is_mcd EQ 1 THEN BEGIN
+         ;; morph change
+         zm = ( * info.fr_image)[xm, ym] + 0
+         case zm of
+           11: cmd2 = '   BG-stable: ' + strtrim(zm, 2)
+           22: cmd2 = '   FG-stable: ' + strtrim(zm, 2)
+           21: cmd2 = '   Loss: ' + strtrim(zm, 2)
+           12: cmd2 = '   Gain: ' + strtrim(zm, 2)
+           176: cmd2 = '   spurious: ' + strtrim(zm, 2)
+           255: cmd2 = '   missing: ' + strtrim(zm, 2)
+           else: cmd2 = '   invalid setting: ' + strtrim(zm, 2)
+         endcase
+
        ENDIF ELSE IF is_mcd EQ 2 THEN BEGIN
          ;; simple change
          zm = ( * info.fr_image)[xm, ym] + 0
@@ -26666,24 +26699,24 @@ IF event.type EQ 2 AND info.set_zoom EQ 0 THEN BEGIN
            else: cmd2 = '   invalid setting: ' + strtrim(zm, 2)
          endcase
 
-       ENDIF ELSE IF info.title EQ 'FOSchange' THEN BEGIN
-         ;; FOS change
-         zm = ( * info.fr_image)[xm, ym] + 0 & zm2 = 100 - zm
-         case 1 of
-           (zm LT 80): cmd2 = '  High connectivity increase: ' + strtrim(zm2, 2) + ' percentage points'
-           (zm GE 80) AND (zm LE 89): cmd2 = '  Medium connectivity increase: ' + strtrim(zm2, 2) + ' percentage points'
-           (zm GE 90) AND (zm LE 98): cmd2 = '  Low connectivity increase: ' + strtrim(zm2, 2) + ' percentage points'
-           (zm GE 99) AND (zm LE 101): cmd2 = '  Insignificant or no change: ' + strtrim(zm2, 2) + ' percentage points'
-           (zm GE 102) AND (zm LE 110): cmd2 = '  Low connectivity decrease: ' + strtrim(zm2, 2) + ' percentage points'
-           (zm GE 111) AND (zm LE 120): cmd2 = '  Medium connectivity decrease: ' + strtrim(zm2, 2) + ' percentage points'
-           (zm GE 120) AND (zm LE 200): cmd2 = '  High connectivity decrease: ' + strtrim(zm2, 2) + ' percentage points'
-           (zm EQ 250): cmd2 = '  Foreground gain (BG->FG)'
-           (zm EQ 251): cmd2 = '  Foreground loss (FG->BG)'
-           (zm EQ 252): cmd2 = '  BG stable (BG->BG)'
-           (zm EQ 253): cmd2 = '  Water at one/both time(s)'
-           (zm EQ 254): cmd2 = '  Missing at one/both time(s)'
-           (zm EQ 255): cmd2 = '  Outside at one/both time(s)'
-           else: cmd2 = '  invalid setting: ' + strtrim(zm, 2)
+       ENDIF ELSE IF info.title EQ 'FOSchange' THEN BEGIN
+         ;; FOS change
+         zm = ( * info.fr_image)[xm, ym] + 0 & zm2 = 100 - zm
+         case 1 of
+           (zm LT 80): cmd2 = '  High connectivity increase: ' + strtrim(zm2, 2) + ' percentage points'
+           (zm GE 80) AND (zm LE 89): cmd2 = '  Medium connectivity increase: ' + strtrim(zm2, 2) + ' percentage points'
+           (zm GE 90) AND (zm LE 98): cmd2 = '  Low connectivity increase: ' + strtrim(zm2, 2) + ' percentage points'
+           (zm GE 99) AND (zm LE 101): cmd2 = '  Insignificant or no change: ' + strtrim(zm2, 2) + ' percentage points'
+           (zm GE 102) AND (zm LE 110): cmd2 = '  Low connectivity decrease: ' + strtrim(zm2, 2) + ' percentage points'
+           (zm GE 111) AND (zm LE 120): cmd2 = '  Medium connectivity decrease: ' + strtrim(zm2, 2) + ' percentage points'
+           (zm GE 120) AND (zm LE 200): cmd2 = '  High connectivity decrease: ' + strtrim(zm2, 2) + ' percentage points'
+           (zm EQ 250): cmd2 = '  Foreground gain (BG->FG)'
+           (zm EQ 251): cmd2 = '  Foreground loss (FG->BG)'
+           (zm EQ 252): cmd2 = '  BG stable (BG->BG)'
+           (zm EQ 253): cmd2 = '  Water at one/both time(s)'
+           (zm EQ 254): cmd2 = '  Missing at one/both time(s)'
+           (zm EQ 255): cmd2 = '  Outside at one/both time(s)'
+           else: cmd2 = '  invalid setting: ' + strtrim(zm, 2)
          endcase
        
        ENDIF ELSE IF is_mcd EQ 1 THEN BEGIN
@@ -27856,7 +27889,7 @@ my_os = !version.os & sysarch = !version.memory_bits
 ;; make sure to properly detect M-processors on macOS, which may be falsely detected due to Rosetta2 translation
 IF my_os EQ 'darwin' THEN BEGIN
   spawn,'sysctl -n machdep.cpu.brand_string', res & res = res[0] 
-  if strmid(res,0,5) eq 'Apple' then my_os = 'apple'
+  if strmid(res,0,5) eq 'Apple' then my_os = 'apple'
 ENDIF
 
 ;; test on widget availability, current device name
@@ -27985,54 +28018,54 @@ IF res EQ 0b THEN BEGIN ;; if that file does not exist, go ahead with the proxy
   ENDELSE
 ENDIF
 ;;---------------------------------------------------------------------------------------------------------------------------------
-;; Linux: test user copy versus system default and update if needed
-;; this is only applicable for non-standard setups like on BDAP
-;; where the %posttrans script of the GTB-spec is not executed
-;;============================================================
+;; Linux: test user copy versus system default and update if needed
+;; this is only applicable for non-standard setups like on BDAP
+;; where the %posttrans script of the GTB-spec is not executed
+;;============================================================
 IF my_os EQ 'linux' THEN BEGIN
   cd, dir_guidos
-  pushd, '../..'
-  cd, current = basedir
+  pushd, '../..'
+  cd, current = basedir
   basedir = basedir + OS_sep
   popd
-  res = (file_info('/opt/GTB/changelog.txt')).exists ;check if system install exists
-  IF res EQ 1 THEN BEGIN ;; we have a system installation
-    ;; extract and compare system GTB-version versus user GTB-version
-    spawn, "cat /opt/GTB/changelog.txt |grep -m 1 Version| cut -d' ' -f2", sys_version & sys_version = float(sys_version[0])
+  res = (file_info('/opt/GTB/changelog.txt')).exists ;check if system install exists
+  IF res EQ 1 THEN BEGIN ;; we have a system installation
+    ;; extract and compare system GTB-version versus user GTB-version
+    spawn, "cat /opt/GTB/changelog.txt |grep -m 1 Version| cut -d' ' -f2", sys_version & sys_version = float(sys_version[0])
     res = (gtb_version - sys_version) LT 0.0
-    curruser = getenv('USER')
-    ;; for all others but myself...
-    IF curruser NE 'pinoc64' AND res EQ 1b THEN BEGIN 
+    curruser = getenv('USER')
+    ;; for all others but myself...
+    IF curruser NE 'pinoc64' AND res EQ 1b THEN BEGIN 
       ;; sys_version is newer than user version:
-      ;; inform user to run the upgrade script, which will copy over the current GTB sys_version from the system installation
+      ;; inform user to run the upgrade script, which will copy over the current GTB sys_version from the system installation
       ;; we are in dir_guidos, set up a self-destructing script here to update the user's outdated version   
-      pushd, basedir & close, 1
+      pushd, basedir & close, 1
       openw, 1, 'update_myGTB.sh'
-      printf, 1, "#!/bin/sh "
-      printf, 1, "# update local GTB to system GTB version "
+      printf, 1, "#!/bin/sh "
+      printf, 1, "# update local GTB to system GTB version "
       printf, 1, " "
-      printf, 1, "topdir=`dirname $0` "
-      printf, 1, 'if (test $topdir = ".") ; then '
+      printf, 1, "topdir=`dirname $0` "
+      printf, 1, 'if (test $topdir = ".") ; then '
       printf, 1, "   topdir=$PWD; "
-      printf, 1, "fi "
+      printf, 1, "fi "
       printf, 1, "cd $topdir "            
       printf, 1, "cp -fr /opt/GTB/* . "
       printf, 1, "echo Please restart GTB"  
       printf, 1, "rm -f $topdir/update_myGTB.sh "      
-      printf, 1, "exit  "
+      printf, 1, "exit  "
       close, 1
       file_chmod, 'update_myGTB.sh', /A_EXECUTE
       msg = 'Your local GTB copy is outdated.' + string(10b) + $
         'Please open a terminal in the directory: ' + basedir + string(10b) + $
         "and run the script 'update_myGTB.sh' to upgrade your local copy " + string(10b) + $
-        'of GTB to the system-provided version of GTB' + string(10b) + string(10b) + 'Returning...'
+        'of GTB to the system-provided version of GTB' + string(10b) + string(10b) + 'Returning...'
       res = dialog_message(msg,title='GTB startup check:', / error)
-      popd
-      exit
-    ENDIF
-  ENDIF
-ENDIF
-;;---------------------------------------------------------------------------------------------------------------------------------
+      popd
+      exit
+    ENDIF
+  ENDIF
+ENDIF
+;;---------------------------------------------------------------------------------------------------------------------------------
 
 ;;=======================================================
 ;; automatic test for newer version/bugfix and GWS release
@@ -28528,9 +28561,9 @@ button = $
 ;tls = ['grayscale', 'Rainbow', 'Temperature', 'Classification', $
 ;  'Distance', 'Normalized', 'Contortion', 'LM', 'FOS_6', 'FOS_5', 'FOS-APP_2', 'Resistance', $
 ;  'LM_AGR', 'LM_NAT', 'LM_DEV', 'LM_BGR', 'LM_DIV', 'LM_ANT', 'FOSchange', 'User-defined', 'Save/Restore']
-tls = ['grayscale', 'Rainbow', 'Temperature', 'Classification', $
-    'Distance', 'Normalized', 'Contortion', 'LM', 'FOS_6', 'FOS_5', 'Resistance', $
-    'LM_AGR', 'LM_NAT', 'LM_DEV', 'LM_BGR', 'LM_DIV', 'LM_ANT', 'FOSchange', 'User-defined', 'Save/Restore']
+tls = ['grayscale', 'Rainbow', 'Temperature', 'Classification', $
+    'Distance', 'Normalized', 'Contortion', 'LM', 'FOS_6', 'FOS_5', 'Resistance', $
+    'LM_AGR', 'LM_NAT', 'LM_DEV', 'LM_BGR', 'LM_DIV', 'LM_ANT', 'FOSchange', 'User-defined', 'Save/Restore']
 w_disp_colors  = Widget_Combobox(w_ctbl, Value = tls, UVALUE = 'disp_colors')
 
 ;; zoom factor and factor
@@ -28708,10 +28741,10 @@ CASE my_os OF
     fm_view = ['dolphin', 'konqueror', 'mate-file-manager', 'caja', 'nemo', 'pcmanfm', $
       'nautilus', 'thunar', 'krusader', 'mc', 'doublecmd-gtk']
     FOR idx = 0, n_elements(fm_view)-1 DO BEGIN
-      spawn, 'unset LD_LIBRARY_PATH; which ' + fm_view[idx] + ' 2>/dev/null', res &  res = res[0]
-      IF strmid(res, 0, 1) EQ '/' THEN BEGIN ;; application found
-        fmanager = 'unset LD_LIBRARY_PATH; ' + res & GOTO, html_check1
-      ENDIF
+      spawn, 'unset LD_LIBRARY_PATH; which ' + fm_view[idx] + ' 2>/dev/null', res &  res = res[0]
+      IF strmid(res, 0, 1) EQ '/' THEN BEGIN ;; application found
+        fmanager = 'unset LD_LIBRARY_PATH; ' + res & GOTO, html_check1
+      ENDIF
     ENDFOR
     html_check1:
     if fmanager eq '' then begin
@@ -28729,19 +28762,19 @@ CASE my_os OF
     html_view = ['firefox', 'konqueror', 'google-chrome', 'chrome', 'chromium', 'netscape', 'iceweasel', $
       'opera', 'mozilla', 'flock', 'galeon', 'dillo', 'epiphany', 'seamonkey']
     FOR idx = 0, n_elements(html_view)-1 DO BEGIN
-      spawn, 'unset LD_LIBRARY_PATH; which ' + html_view[idx] + ' 2>/dev/null', res &  res = res[0]
-      IF strmid(res, 0, 1) EQ '/' THEN BEGIN ;; application found
-        html_exe = 'unset LD_LIBRARY_PATH; ' + res & GOTO, pdf_check1
-      ENDIF
+      spawn, 'unset LD_LIBRARY_PATH; which ' + html_view[idx] + ' 2>/dev/null', res &  res = res[0]
+      IF strmid(res, 0, 1) EQ '/' THEN BEGIN ;; application found
+        html_exe = 'unset LD_LIBRARY_PATH; ' + res & GOTO, pdf_check1
+      ENDIF
     ENDFOR
-    pdf_check1:
-    if html_exe eq '' then begin
-      msg='No web browser found. Please install any of: ' + string(10b) + $
-        'firefox, konqueror, google-chrome, netscape, iceweasel, opera'  + string(10b) + $
-        'mozilla, flock, galeon, dillo, epiphany, seamonkey' + string(10b) + $
-        'or let me know which different web browser you use!' + string(10b) + 'Exiting...'
-      res = dialog_message(msg, title='GTB startup check:',/ error)
-      exit
+    pdf_check1:
+    if html_exe eq '' then begin
+      msg='No web browser found. Please install any of: ' + string(10b) + $
+        'firefox, konqueror, google-chrome, netscape, iceweasel, opera'  + string(10b) + $
+        'mozilla, flock, galeon, dillo, epiphany, seamonkey' + string(10b) + $
+        'or let me know which different web browser you use!' + string(10b) + 'Exiting...'
+      res = dialog_message(msg, title='GTB startup check:',/ error)
+      exit
     endif
     
     ;; check for pdf, use a list of apps
@@ -28817,7 +28850,7 @@ CASE my_os OF
       st = "IMPORTANT: GDAL libraries are required but were NOT found. " + $
         string(10b) + "Please install the latest package: " + $
         string(10b) + "GDAL Complete 3.2 (requiring Python 3.9) " + $
-        string(10b) + "available at the following URL:" + $
+        string(10b) + "available at the following URL:" + $
         string(10b) + "https://www.kyngchaos.com/software/archive/gdal-complete/" + $
         string(10b) + "  " + $
         string(10b) + "GTB will now exit."
@@ -28854,52 +28887,52 @@ CASE my_os OF
     EULA = dir_guidos + '../../../../../EULA_GTB.pdf'
   END
 
-  'apple':BEGIN
-    ;;================================================================================================
-    ;; test for macOS 12 Monterey or later
-    spawn, 'sw_vers -productVersion', res & res=res[0]
-    os1 = fix((strsplit(res,'.',/extract))[0]) & os2 = fix((strsplit(res,'.',/extract))[1])
-    IF (os1 EQ 12) AND (os2 GE 0) THEN BEGIN
-      res = dialog_message('GTB requires Yosemite (OSX 10.10) or newer' + string(10b) + 'Exiting...', title='GTB startup check:',/ error)
-      exit
-    ENDIF
-    ;; test for gdal installation
-    osxgdal = file_test('/opt/homebrew/bin', /Directory)
-    IF osxgdal eq 0 THEN BEGIN
-      st = "IMPORTANT: GDAL libraries are required but were NOT found. " + $
-        string(10b) + "Please install gdal via Homebrew (https://brew.sh) " + $
-        string(10b) + "GTB will now exit."
-      res = dialog_message(st, title='GTB startup check:',/ error)
-      spawn, 'open https://brew.sh'
-      exit
-    ENDIF    
-
-    ;; maximum image size for MSPA
-    ;; use command "vm_stat" and get amounts for
-    ;; TOTAL = FREE_BLOCKS + INACTIVE_BLOCKS + SPECULATIVE_BLOCKS + PURGEABLE
-    ;; see http://apple.stackexchange.com/questions/4286/is-there-a-mac-os-x-terminal-version-of-the-free-command-in-linux-systems
-    spawn, "vm_stat | grep free | awk '{ print $3 }' | sed 's/\.//'",fra & fra=float(fra[0])
-      spawn,"vm_stat | grep inactive | awk '{ print $3 }' | sed 's/\.//'", frb & frb=float(frb[0])
-      spawn,"vm_stat | grep speculative | awk '{ print $3 }' | sed 's/\.//'", frc & frc=float(frc[0])
-      spawn,"vm_stat | grep purgeable | awk '{ print $3 }' | sed 's/\.//'",frd & frd=float(frd[0])
-      mbavail = (fra+frb+frc+frd)*4096/1048576
-    immaxsize = uint(mbavail/19)
-    fn = dir_guidossub + 'mspa_mac'
-    file_copy, dir_guidos + 'MSPAstandalone/mspaARM_mac', fn, / overwrite
-    dir_fwtools = '/opt/homebrew/bin/'
-    ;; check for osx first start
-    fn = dir_guidossub + 'firststart.txt'
-    if file_test(fn) then begin
-      ;; we are in save_add
-      spawn, '../../../../../mkShortcuts'
-      spawn, 'open ../../../../../quickstart.rtf'
-      file_delete, fn
-    endif
-
-    ;; find out if nolimits is set
-    res = file_info('../../../../../data/nolimits.txt') & res = res.exists
-    IF res EQ 1b THEN immaxsizeg = 1.0e12
-    EULA = dir_guidos + '../../../../../EULA_GTB.pdf'
+  'apple':BEGIN
+    ;;================================================================================================
+    ;; test for macOS 12 Monterey or later
+    spawn, 'sw_vers -productVersion', res & res=res[0]
+    os1 = fix((strsplit(res,'.',/extract))[0]) & os2 = fix((strsplit(res,'.',/extract))[1])
+    IF (os1 EQ 12) AND (os2 GE 0) THEN BEGIN
+      res = dialog_message('GTB requires Yosemite (OSX 10.10) or newer' + string(10b) + 'Exiting...', title='GTB startup check:',/ error)
+      exit
+    ENDIF
+    ;; test for gdal installation
+    osxgdal = file_test('/opt/homebrew/bin', /Directory)
+    IF osxgdal eq 0 THEN BEGIN
+      st = "IMPORTANT: GDAL libraries are required but were NOT found. " + $
+        string(10b) + "Please install gdal via Homebrew (https://brew.sh) " + $
+        string(10b) + "GTB will now exit."
+      res = dialog_message(st, title='GTB startup check:',/ error)
+      spawn, 'open https://brew.sh'
+      exit
+    ENDIF    
+
+    ;; maximum image size for MSPA
+    ;; use command "vm_stat" and get amounts for
+    ;; TOTAL = FREE_BLOCKS + INACTIVE_BLOCKS + SPECULATIVE_BLOCKS + PURGEABLE
+    ;; see http://apple.stackexchange.com/questions/4286/is-there-a-mac-os-x-terminal-version-of-the-free-command-in-linux-systems
+    spawn, "vm_stat | grep free | awk '{ print $3 }' | sed 's/\.//'",fra & fra=float(fra[0])
+      spawn,"vm_stat | grep inactive | awk '{ print $3 }' | sed 's/\.//'", frb & frb=float(frb[0])
+      spawn,"vm_stat | grep speculative | awk '{ print $3 }' | sed 's/\.//'", frc & frc=float(frc[0])
+      spawn,"vm_stat | grep purgeable | awk '{ print $3 }' | sed 's/\.//'",frd & frd=float(frd[0])
+      mbavail = (fra+frb+frc+frd)*4096/1048576
+    immaxsize = uint(mbavail/19)
+    fn = dir_guidossub + 'mspa_mac'
+    file_copy, dir_guidos + 'MSPAstandalone/mspaARM_mac', fn, / overwrite
+    dir_fwtools = '/opt/homebrew/bin/'
+    ;; check for osx first start
+    fn = dir_guidossub + 'firststart.txt'
+    if file_test(fn) then begin
+      ;; we are in save_add
+      spawn, '../../../../../mkShortcuts'
+      spawn, 'open ../../../../../quickstart.rtf'
+      file_delete, fn
+    endif
+
+    ;; find out if nolimits is set
+    res = file_info('../../../../../data/nolimits.txt') & res = res.exists
+    IF res EQ 1b THEN immaxsizeg = 1.0e12
+    EULA = dir_guidos + '../../../../../EULA_GTB.pdf'
   END
 ENDCASE
 
@@ -28993,14 +29026,14 @@ boxcolor = !d.n_colors - 1
 ;; we should not use several instances of GTB because they may mix up the
 ;; intermediate files in mspatmp and result in crashes
 CASE my_OS OF
-  'darwin': BEGIN
-    spawn,'ps -ef|grep -c guidostoolbox.sav',res & ct = fix(res[0])
-    if ct gt 4 then begin
-      res = dialog_message('Existing IDL runtime process detected.' + string(10b) + $
-        'Running more than 1 instance of GTB' + string(10b) + $
-        'from the SAME GTB directory' + string(10b) + $
-        'may result in program crashes or incorrect results.', title='GTB startup check:' )
-    endif
+  'darwin': BEGIN
+    spawn,'ps -ef|grep -c guidostoolbox.sav',res & ct = fix(res[0])
+    if ct gt 4 then begin
+      res = dialog_message('Existing IDL runtime process detected.' + string(10b) + $
+        'Running more than 1 instance of GTB' + string(10b) + $
+        'from the SAME GTB directory' + string(10b) + $
+        'may result in program crashes or incorrect results.', title='GTB startup check:' )
+    endif
   END
   'apple': BEGIN
     spawn,'ps -ef|grep -c guidostoolbox.sav',res & ct = fix(res[0])
@@ -29034,15 +29067,15 @@ ENDCASE
 
 ;; set the default path to the data directory
 CASE my_OS OF
-  'darwin': BEGIN
-    pushd, '../../../../../data' & cd, current = datapath & popd
+  'darwin': BEGIN
+    pushd, '../../../../../data' & cd, current = datapath & popd
   END
   'apple': BEGIN
     pushd, '../../../../../data' & cd, current = datapath & popd
   END
   'linux': BEGIN
     IF isBDAP THEN pushd, 'data' ELSE pushd, '../../data'
-    cd, current = datapath & popd
+    cd, current = datapath & popd
   END
   'windows': BEGIN
     datapath = dir_guidos + 'data' 